@@ -25,6 +25,7 @@
 #include "OnDiskWrapper.h"
 #include "moses/Factor.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 
 using namespace std;
 
@@ -42,9 +43,9 @@ OnDiskWrapper::~OnDiskWrapper()
   delete m_rootSourceNode;
 }
 
-void OnDiskWrapper::BeginLoad(const std::string &filePath)
+void OnDiskWrapper::BeginLoad(const std::string &filePath, util::LoadMethod loadMethod)
 {
-  if (!OpenForLoad(filePath)) {
+  if (!OpenForLoad(filePath, loadMethod)) {
     UTIL_THROW(util::FileOpenException, "Couldn't open for loading: " << filePath);
   }
 
@@ -55,22 +56,11 @@ void OnDiskWrapper::BeginLoad(const std::string &filePath)
   m_rootSourceNode = new PhraseNode(rootFilePos, *this);
 }
 
-bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
+bool OnDiskWrapper::OpenForLoad(const std::string &filePath, util::LoadMethod loadMethod)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileSource.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/Source.dat");
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetInd.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetInd.dat");
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetColl.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetColl.dat");
+  MapForLoad(filePath + "/Source.dat", loadMethod, m_memSource);
+  MapForLoad(filePath + "/TargetInd.dat", loadMethod, m_memTargetInd);
+  MapForLoad(filePath + "/TargetColl.dat", loadMethod, m_memTargetColl);
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   UTIL_THROW_IF(!m_fileVocab.is_open(),
@@ -91,6 +81,12 @@ bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
   return true;
 }
 
+void OnDiskWrapper::MapForLoad(const std::string &path, util::LoadMethod loadMethod, util::scoped_memory &mem)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  util::MapRead(loadMethod, file.get(), 0, util::CheckOverflow(util::SizeOrThrow(file.get())), mem);
+}
+
 bool OnDiskWrapper::LoadMisc()
 {
   char line[100000];
@@ -18,11 +18,13 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
+#include <cassert>
 #include <string>
 #include <fstream>
 #include "Vocab.h"
 #include "PhraseNode.h"
 #include "moses/Word.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -40,13 +42,22 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // when loading, the source tree and target phrases are read-only mappings.
+  // Lookups read them in place, so one object can be shared by all threads
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
   std::map<std::string, uint64_t> m_miscInfo;
 
   void SaveMisc();
-  bool OpenForLoad(const std::string &filePath);
+  bool OpenForLoad(const std::string &filePath, util::LoadMethod loadMethod);
+  static void MapForLoad(const std::string &path, util::LoadMethod loadMethod, util::scoped_memory &mem);
+  static const char *GetMem(const util::scoped_memory &mem, uint64_t filePos) {
+    assert(filePos < mem.size());
+    return static_cast<const char*>(mem.get()) + filePos;
+  }
   bool LoadMisc();
 
 public:
@@ -55,7 +66,9 @@ public:
   OnDiskWrapper();
   ~OnDiskWrapper();
 
-  void BeginLoad(const std::string &filePath);
+  /** open a saved table for lookups. With util::LAZY, pages are read on first
+   * access; util::POPULATE_OR_READ loads the whole table up front */
+  void BeginLoad(const std::string &filePath, util::LoadMethod loadMethod = util::LAZY);
 
   void BeginSave(const std::string &filePath
                  , int numSourceFactors, int	numTargetFactors, int numScores);
@@ -84,6 +97,17 @@ public:
     return m_fileVocab;
   }
 
+  //! data at filePos of Source.dat, TargetInd.dat and TargetColl.dat of a loaded table
+  const char *GetMemSource(uint64_t filePos) const {
+    return GetMem(m_memSource, filePos);
+  }
+  const char *GetMemTargetInd(uint64_t filePos) const {
+    return GetMem(m_memTargetInd, filePos);
+  }
+  const char *GetMemTargetColl(uint64_t filePos) const {
+    return GetMem(m_memTargetColl, filePos);
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "moses/Util.h"
 #include "moses/TargetPhraseCollection.h"
@@ -148,34 +149,28 @@ Moses::TargetPhraseCollection *TargetPhraseCollection::ConvertToMoses(const std:
 
 }
 
-void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, OnDiskWrapper &onDiskWrapper)
+void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, const OnDiskWrapper &onDiskWrapper)
 {
-  fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
-  fstream &fileTP = onDiskWrapper.GetFileTargetInd();
-
   size_t numScores = onDiskWrapper.GetNumScores();
 
+  const char *mem = onDiskWrapper.GetMemTargetColl(filePos);
 
   uint64_t numPhrases;
-
-  uint64_t currFilePos = filePos;
-  fileTPColl.seekg(filePos);
-  fileTPColl.read((char*) &numPhrases, sizeof(uint64_t));
+  memcpy(&numPhrases, mem, sizeof(uint64_t));
+  mem += sizeof(uint64_t);
 
   // table limit
   if (tableLimit) {
     numPhrases = std::min(numPhrases, (uint64_t) tableLimit);
   }
 
-  currFilePos += sizeof(uint64_t);
-
   for (size_t ind = 0; ind < numPhrases; ++ind) {
     TargetPhrase *tp = new TargetPhrase(numScores);
 
-    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromFile(currFilePos, fileTPColl);
-    tp->ReadFromFile(fileTP);
+    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromMemory(mem);
+    tp->ReadFromMemory(onDiskWrapper.GetMemTargetInd(tp->GetFilePos()));
 
-    currFilePos += sizeOtherInfo;
+    mem += sizeOtherInfo;
 
     m_coll.push_back(tp);
   }
@@ -18,6 +18,7 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <cstring>
 #include <boost/algorithm/string/predicate.hpp>
 #include "moses/FactorCollection.h"
 #include "moses/Util.h"
@@ -72,8 +73,8 @@ size_t Word::WriteToMemory(char *mem) const
 
 size_t Word::ReadFromMemory(const char *mem)
 {
-  uint64_t *vocabMem = (uint64_t*) mem;
-  m_vocabId = vocabMem[0];
+  // mem may point anywhere inside a mapped file, so don't assume alignment
+  memcpy(&m_vocabId, mem, sizeof(uint64_t));
 
   size_t memUsed = sizeof(uint64_t);
 
@@ -86,18 +87,6 @@ size_t Word::ReadFromMemory(const char *mem)
   return memUsed;
 }
 
-size_t Word::ReadFromFile(std::fstream &file)
-{
-  const size_t memAlloc = sizeof(uint64_t) + sizeof(char);
-  char mem[sizeof(uint64_t) + sizeof(char)];
-  file.read(mem, memAlloc);
-
-  size_t memUsed = ReadFromMemory(mem);
-  assert(memAlloc == memUsed);
-
-  return memAlloc;
-}
-
 void Word::ConvertToMoses(
   const std::vector<Moses::FactorType> &outputFactorsVec,
   const Vocab &vocab,
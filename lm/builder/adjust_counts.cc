@@ -12,6 +12,58 @@ namespace lm { namespace builder {
 BadDiscountException::BadDiscountException() throw() {}
 BadDiscountException::~BadDiscountException() throw() {}
 
+AdjustedCountStats &AdjustedCountStats::operator+=(const AdjustedCountStats &other) {
+  for (unsigned i = 0; i < 5; ++i) {
+    n[i] += other.n[i];
+  }
+  count += other.count;
+  count_pruned += other.count_pruned;
+  return *this;
+}
+
+void CalculateDiscounts(const std::vector<AdjustedCountStats> &stats, const DiscountConfig &config, std::vector<uint64_t> &counts, std::vector<uint64_t> &counts_pruned, std::vector<Discount> &discounts) {
+  counts.resize(stats.size());
+  counts_pruned.resize(stats.size());
+  for (std::size_t i = 0; i < stats.size(); ++i) {
+    const AdjustedCountStats &s = stats[i];
+    counts[i] = s.count;
+    counts_pruned[i] = s.count_pruned;
+  }
+
+  discounts = config.overwrite;
+  discounts.resize(stats.size());
+  for (std::size_t i = config.overwrite.size(); i < stats.size(); ++i) {
+    const AdjustedCountStats &s = stats[i];
+    try {
+      for (unsigned j = 1; j < 4; ++j) {
+        // TODO: Specialize error message for j == 3, meaning 3+
+        UTIL_THROW_IF(s.n[j] == 0, BadDiscountException, "Could not calculate Kneser-Ney discounts for "
+            << (i+1) << "-grams with adjusted count " << (j+1) << " because we didn't observe any "
+            << (i+1) << "-grams with adjusted count " << j << "; Is this small or artificial data?\n"
+            << "Try deduplicating the input.  To override this error for e.g. a class-based model, rerun with --discount_fallback\n");
+      }
+
+      // See equation (26) in Chen and Goodman.
+      discounts[i].amount[0] = 0.0;
+      float y = static_cast<float>(s.n[1]) / static_cast<float>(s.n[1] + 2.0 * s.n[2]);
+      for (unsigned j = 1; j < 4; ++j) {
+        discounts[i].amount[j] = static_cast<float>(j) - static_cast<float>(j + 1) * y * static_cast<float>(s.n[j+1]) / static_cast<float>(s.n[j]);
+        UTIL_THROW_IF(discounts[i].amount[j] < 0.0 || discounts[i].amount[j] > j, BadDiscountException, "ERROR: " << (i+1) << "-gram discount out of range for adjusted count " << j << ": " << discounts[i].amount[j]);
+      }
+    } catch (const BadDiscountException &e) {
+      switch (config.bad_action) {
+        case THROW_UP:
+          throw;
+        case COMPLAIN:
+          std::cerr << "Substituting fallback discounts for order " << i << ": D1=" << config.fallback.amount[1] << " D2=" << config.fallback.amount[2] << " D3+=" << config.fallback.amount[3] << std::endl;
+        case SILENT:
+          break;
+      }
+      discounts[i] = config.fallback;
+    }
+  }
+}
+
 namespace {
 // Return last word in full that is different.
 const WordIndex* FindDifference(const NGram<BuildingPayload> &full, const NGram<BuildingPayload> &lower_last) {
@@ -24,58 +76,17 @@ const WordIndex* FindDifference(const NGram<BuildingPayload> &full, const NGram<
 
 class StatCollector {
   public:
-    StatCollector(std::size_t order, std::vector<uint64_t> &counts, std::vector<uint64_t> &counts_pruned, std::vector<Discount> &discounts)
-      : orders_(order), full_(orders_.back()), counts_(counts), counts_pruned_(counts_pruned), discounts_(discounts) {
-      memset(&orders_[0], 0, sizeof(OrderStat) * order);
+    explicit StatCollector(std::size_t order)
+      : orders_(order), full_(orders_.back()) {
+      memset(&orders_[0], 0, sizeof(AdjustedCountStats) * order);
     }
 
     ~StatCollector() {}
 
-    void CalculateDiscounts(const DiscountConfig &config) {
-      counts_.resize(orders_.size());
-      counts_pruned_.resize(orders_.size());
-      for (std::size_t i = 0; i < orders_.size(); ++i) {
-        const OrderStat &s = orders_[i];
-        counts_[i] = s.count;
-        counts_pruned_[i] = s.count_pruned;
-      }
-
-      discounts_ = config.overwrite;
-      discounts_.resize(orders_.size());
-      for (std::size_t i = config.overwrite.size(); i < orders_.size(); ++i) {
-        const OrderStat &s = orders_[i];
-        try {
-          for (unsigned j = 1; j < 4; ++j) {
-            // TODO: Specialize error message for j == 3, meaning 3+
-            UTIL_THROW_IF(s.n[j] == 0, BadDiscountException, "Could not calculate Kneser-Ney discounts for "
-                << (i+1) << "-grams with adjusted count " << (j+1) << " because we didn't observe any "
-                << (i+1) << "-grams with adjusted count " << j << "; Is this small or artificial data?\n"
-                << "Try deduplicating the input.  To override this error for e.g. a class-based model, rerun with --discount_fallback\n");
-          }
-
-          // See equation (26) in Chen and Goodman.
-          discounts_[i].amount[0] = 0.0;
-          float y = static_cast<float>(s.n[1]) / static_cast<float>(s.n[1] + 2.0 * s.n[2]);
-          for (unsigned j = 1; j < 4; ++j) {
-            discounts_[i].amount[j] = static_cast<float>(j) - static_cast<float>(j + 1) * y * static_cast<float>(s.n[j+1]) / static_cast<float>(s.n[j]);
-            UTIL_THROW_IF(discounts_[i].amount[j] < 0.0 || discounts_[i].amount[j] > j, BadDiscountException, "ERROR: " << (i+1) << "-gram discount out of range for adjusted count " << j << ": " << discounts_[i].amount[j]);
-          }
-        } catch (const BadDiscountException &e) {
-          switch (config.bad_action) {
-            case THROW_UP:
-              throw;
-            case COMPLAIN:
-              std::cerr << "Substituting fallback discounts for order " << i << ": D1=" << config.fallback.amount[1] << " D2=" << config.fallback.amount[2] << " D3+=" << config.fallback.amount[3] << std::endl;
-            case SILENT:
-              break;
-          }
-          discounts_[i] = config.fallback;
-        }
-      }
-    }
+    const std::vector<AdjustedCountStats> &Orders() const { return orders_; }
 
     void Add(std::size_t order_minus_1, uint64_t count, bool pruned = false) {
-      OrderStat &stat = orders_[order_minus_1];
+      AdjustedCountStats &stat = orders_[order_minus_1];
       ++stat.count;
       if (!pruned)
         ++stat.count_pruned;
@@ -90,19 +101,8 @@ class StatCollector {
     }
 
   private:
-    struct OrderStat {
-      // n_1 in equation 26 of Chen and Goodman etc
-      uint64_t n[5];
-      uint64_t count;
-      uint64_t count_pruned;
-    };
-
-    std::vector<OrderStat> orders_;
-    OrderStat &full_;
-
-    std::vector<uint64_t> &counts_;
-    std::vector<uint64_t> &counts_pruned_;
-    std::vector<Discount> &discounts_;
+    std::vector<AdjustedCountStats> orders_;
+    AdjustedCountStats &full_;
 };
 
 // Reads all entries in order like NGramStream does.
@@ -220,7 +220,7 @@ void AdjustCounts::Run(const util::stream::ChainPositions &positions) {
   UTIL_TIMER("(%w s) Adjusted counts\n");
 
   const std::size_t order = positions.size();
-  StatCollector stats(order, counts_, counts_pruned_, discounts_);
+  StatCollector stats(order);
   if (order == 1) {
 
     // Only unigrams.  Just collect stats.
@@ -238,7 +238,7 @@ void AdjustCounts::Run(const util::stream::ChainPositions &positions) {
       stats.AddFull(full->Value().UnmarkedCount(), full->Value().IsMarked());
     }
 
-    stats.CalculateDiscounts(discount_config_);
+    SetStats(stats.Orders());
     return;
   }
 
@@ -247,21 +247,36 @@ void AdjustCounts::Run(const util::stream::ChainPositions &positions) {
 
   CollapseStream full(positions[positions.size() - 1], prune_thresholds_.back(), prune_words_);
 
-  // Initialization: <unk> has count 0 and so does <s>.
   NGramStream<BuildingPayload> *lower_valid = streams.begin();
   const NGramStream<BuildingPayload> *const streams_begin = streams.begin();
-  streams[0]->Value().count = 0;
-  *streams[0]->begin() = kUNK;
-  stats.Add(0, 0);
-  (++streams[0])->Value().count = 0;
-  *streams[0]->begin() = kBOS;
-  // <s> is not in stats yet because it will get put in later.
 
   // This keeps track of actual counts for lower orders.  It is not output
   // (only adjusted counts are), but used to determine pruning.
   std::vector<uint64_t> actual_counts(positions.size(), 0);
-  // Something of a hack: don't prune <s>.
-  actual_counts[0] = std::numeric_limits<uint64_t>::max();
+
+  if (shard_.OwnsSpecials()) {
+    // Initialization: <unk> has count 0 and so does <s>.
+    streams[0]->Value().count = 0;
+    *streams[0]->begin() = kUNK;
+    stats.Add(0, 0);
+    (++streams[0])->Value().count = 0;
+    *streams[0]->begin() = kBOS;
+    // <s> is not in stats yet because it will get put in later.
+
+    // Something of a hack: don't prune <s>.
+    actual_counts[0] = std::numeric_limits<uint64_t>::max();
+  } else if (full) {
+    // Other shards start with the unigram of the first N-gram's last word.
+    // The N-gram matches it, so it is counted like any other extension.
+    streams[0]->Value().count = 0;
+    *streams[0]->begin() = *(full->end() - 1);
+  } else {
+    // A shard without any N-grams.
+    for (NGramStream<BuildingPayload> *s = streams.begin(); s != streams.end(); ++s)
+      s->Poison();
+    SetStats(stats.Orders());
+    return;
+  }
 
   // Iterate over full (the stream of the highest order ngrams)
   for (; full; ++full) {
@@ -345,9 +360,17 @@ void AdjustCounts::Run(const util::stream::ChainPositions &positions) {
   for (NGramStream<BuildingPayload> *s = streams.begin(); s != streams.end(); ++s)
     s->Poison();
 
-  stats.CalculateDiscounts(discount_config_);
+  SetStats(stats.Orders());
 
   // NOTE: See special early-return case for unigrams near the top of this function
 }
 
+void AdjustCounts::SetStats(const std::vector<AdjustedCountStats> &stats) {
+  if (shard_stats_) {
+    *shard_stats_ = stats;
+  } else {
+    CalculateDiscounts(stats, discount_config_, *counts_, *counts_pruned_, *discounts_);
+  }
+}
+
 }} // namespaces
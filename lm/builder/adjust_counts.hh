@@ -2,6 +2,7 @@
 #define LM_BUILDER_ADJUST_COUNTS_H
 
 #include "lm/builder/discount.hh"
+#include "lm/builder/shard.hh"
 #include "lm/lm_exception.hh"
 #include "util/exception.hh"
 
@@ -30,6 +31,26 @@ struct DiscountConfig {
   WarningAction bad_action;
 };
 
+// Statistics of the adjusted counts of one order, from which discounts are
+// estimated.  Sharded builds add them up over the shards.
+struct AdjustedCountStats {
+  // n_1 in equation 26 of Chen and Goodman etc
+  uint64_t n[5];
+  uint64_t count;
+  uint64_t count_pruned;
+
+  AdjustedCountStats &operator+=(const AdjustedCountStats &other);
+};
+
+// Sets counts, counts_pruned, and discounts (except for orders overwritten by
+// config) from the statistics of each order.
+void CalculateDiscounts(
+    const std::vector<AdjustedCountStats> &stats,
+    const DiscountConfig &config,
+    std::vector<uint64_t> &counts,
+    std::vector<uint64_t> &counts_pruned,
+    std::vector<Discount> &discounts);
+
 /* Compute adjusted counts.
  * Input: unique suffix sorted N-grams (and just the N-grams) with raw counts.
  * Output: [1,N]-grams with adjusted counts.
@@ -49,20 +70,40 @@ class AdjustCounts {
         const std::vector<bool> &prune_words,
         const DiscountConfig &discount_config,
         std::vector<Discount> &discounts)
-      : prune_thresholds_(prune_thresholds), counts_(counts), counts_pruned_(counts_pruned),
-        prune_words_(prune_words), discount_config_(discount_config), discounts_(discounts)
+      : prune_thresholds_(prune_thresholds), counts_(&counts), counts_pruned_(&counts_pruned),
+        prune_words_(prune_words), discount_config_(discount_config), discounts_(&discounts),
+        shard_stats_(NULL)
+    {}
+
+    // For one shard of a sharded build, whose input only has the N-grams
+    // ending with a word of the shard.  Discounts need the statistics of all
+    // shards, so this only collects them.
+    // stats: output
+    AdjustCounts(
+        const std::vector<uint64_t> &prune_thresholds,
+        const std::vector<bool> &prune_words,
+        const Shard &shard,
+        std::vector<AdjustedCountStats> &stats)
+      : prune_thresholds_(prune_thresholds), counts_(NULL), counts_pruned_(NULL),
+        prune_words_(prune_words), discounts_(NULL),
+        shard_(shard), shard_stats_(&stats)
     {}
 
     void Run(const util::stream::ChainPositions &positions);
 
   private:
+    void SetStats(const std::vector<AdjustedCountStats> &stats);
+
     const std::vector<uint64_t> &prune_thresholds_;
-    std::vector<uint64_t> &counts_;
-    std::vector<uint64_t> &counts_pruned_;
+    std::vector<uint64_t> *counts_;
+    std::vector<uint64_t> *counts_pruned_;
     const std::vector<bool> &prune_words_;
 
     DiscountConfig discount_config_;
-    std::vector<Discount> &discounts_;
+    std::vector<Discount> *discounts_;
+
+    Shard shard_;
+    std::vector<AdjustedCountStats> *shard_stats_;
 };
 
 } // namespace builder
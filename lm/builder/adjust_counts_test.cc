@@ -37,6 +37,9 @@ struct Gram4 {
 
 class WriteInput {
   public:
+    // Only writes the n-grams of shard.
+    explicit WriteInput(const Shard &shard = Shard()) : shard_(shard) {}
+
     void Run(const util::stream::ChainPosition &position) {
       NGramStream<BuildingPayload> input(position);
       Gram4 grams[] = {
@@ -46,12 +49,17 @@ class WriteInput {
         {{1,1,1,2},5},
         {{0,0,3,2},5},
       };
-      for (size_t i = 0; i < sizeof(grams) / sizeof(Gram4); ++i, ++input) {
+      for (size_t i = 0; i < sizeof(grams) / sizeof(Gram4); ++i) {
+        if (!shard_.Owns(grams[i].ids[3])) continue;
         memcpy(input->begin(), grams[i].ids, sizeof(WordIndex) * 4);
         input->Value().count = grams[i].count;
+        ++input;
       }
       input.Poison();
     }
+
+  private:
+    Shard shard_;
 };
 
 BOOST_AUTO_TEST_CASE(Simple) {
@@ -109,4 +117,45 @@ BOOST_AUTO_TEST_CASE(Simple) {
   bi.NextInMemory();
 }
 
+BOOST_AUTO_TEST_CASE(Sharded) {
+  std::vector<AdjustedCountStats> total;
+  std::size_t unigrams = 0;
+  for (unsigned int s = 0; s < 2; ++s) {
+    KeepCopy outputs[4];
+    std::vector<AdjustedCountStats> stats;
+    {
+      util::stream::ChainConfig config;
+      config.total_memory = 100;
+      config.block_count = 1;
+      util::stream::Chains chains(4);
+      for (unsigned i = 0; i < 4; ++i) {
+        config.entry_size = NGram<BuildingPayload>::TotalSize(i + 1);
+        chains.push_back(config);
+      }
+
+      chains[3] >> WriteInput(Shard(s, 2));
+      util::stream::ChainPositions for_adjust(chains);
+      for (unsigned i = 0; i < 4; ++i) {
+        chains[i] >> boost::ref(outputs[i]);
+      }
+      chains >> util::stream::kRecycle;
+      std::vector<uint64_t> prune_thresholds(4);
+      AdjustCounts(prune_thresholds, std::vector<bool>(), Shard(s, 2), stats).Run(for_adjust);
+    }
+    BOOST_REQUIRE_EQUAL(4UL, stats.size());
+    if (total.empty()) {
+      total = stats;
+    } else {
+      for (unsigned i = 0; i < 4; ++i) total[i] += stats[i];
+    }
+    unigrams += outputs[0].Size() / NGram<BuildingPayload>::TotalSize(1);
+  }
+  // Same as without sharding.
+  BOOST_CHECK_EQUAL(4UL, unigrams);
+  BOOST_CHECK_EQUAL(4UL, total[0].count);
+  BOOST_CHECK_EQUAL(4UL, total[1].count);
+  BOOST_CHECK_EQUAL(3UL, total[2].count);
+  BOOST_CHECK_EQUAL(3UL, total[3].count);
+}
+
 }}} // namespaces
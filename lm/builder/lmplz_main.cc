@@ -6,6 +6,7 @@
 #include "util/file_piece.hh"
 #include "util/usage.hh"
 
+#include <algorithm>
 #include <iostream>
 
 #include <boost/program_options.hpp>
@@ -72,7 +73,9 @@ int main(int argc, char *argv[]) {
     po::options_description options("Language model building options");
     lm::builder::PipelineConfig pipeline;
 
-    std::string text, intermediate, arpa;
+    std::string text, intermediate, arpa, binary, binary_type, shard_files;
+    unsigned int binary_quantize, binary_quantize_backoff, binary_array;
+    unsigned int shard, shards;
     std::vector<std::string> pruning;
     std::vector<std::string> discount_fallback;
     std::vector<std::string> discount_fallback_default;
@@ -100,7 +103,16 @@ int main(int argc, char *argv[]) {
       ("verbose_header", po::bool_switch(&verbose_header), "Add a verbose header to the ARPA file that includes information such as token count, smoothing type, etc.")
       ("text", po::value<std::string>(&text), "Read text from a file instead of stdin")
       ("arpa", po::value<std::string>(&arpa), "Write ARPA to a file instead of stdout")
+      ("binary", po::value<std::string>(&binary), "Build a binary model directly, like build_binary does from the ARPA file.  Turns off ARPA output (which can be reactivated by --arpa file).")
+      ("binary_type", po::value<std::string>(&binary_type)->default_value("probing"), "Data structure of --binary: probing or trie")
+      ("binary_quantize", po::value<unsigned int>(&binary_quantize), "Quantize --binary (trie only) to this many bits, like build_binary -q")
+      ("binary_quantize_backoff", po::value<unsigned int>(&binary_quantize_backoff), "Bits for backoffs.  Requires --binary_quantize and defaults to that value, like build_binary -b")
+      ("binary_array", po::value<unsigned int>(&binary_array), "Compress trie pointers of --binary, like build_binary -a")
       ("intermediate", po::value<std::string>(&intermediate), "Write ngrams to intermediate files.  Turns off ARPA output (which can be reactivated by --arpa file).  Forces --renumber on.")
+      ("shard_files", po::value<std::string>(&shard_files), "File name prefix of the shards for --shards or --merge_shards")
+      ("shards", po::value<unsigned int>(&shards), "Split counting and adjusting counts over this many runs, e.g. on different machines.  Each run reads the whole corpus and writes adjusted counts for the n-grams ending with its part of the vocabulary.  Requires --shard and --shard_files.  Combine the shards with --merge_shards.")
+      ("shard", po::value<unsigned int>(&shard), "Which shard to build, from 0 to --shards minus one")
+      ("merge_shards", po::bool_switch(), "Estimate the model from the shards in --shard_files instead of reading text.  Pruning and --renumber are taken from the shards.")
       ("renumber", po::bool_switch(&pipeline.renumber_vocabulary), "Rrenumber the vocabulary identifiers so that they are monotone with the hash of each string.  This is consistent with the ordering used by the trie data structure.")
       ("collapse_values", po::bool_switch(&pipeline.output_q), "Collapse probability and backoff into a single value, q that yields the same sentence-level probabilities.  See http://kheafield.com/professional/edinburgh/rest_paper.pdf for more details, including a proof.")
       ("prune", po::value<std::vector<std::string> >(&pruning)->multitoken(), "Prune n-grams with count less than or equal to the given threshold.  Specify one value for each order i.e. 0 0 1 to prune singleton trigrams and above.  The sequence of values must be non-decreasing and the last value applies to any remaining orders. Default is to not prune, which is equivalent to --prune 0.")
@@ -153,6 +165,56 @@ int main(int argc, char *argv[]) {
       return 1;
     }
 
+    bool merge_shards = vm["merge_shards"].as<bool>();
+    if (vm.count("shards") || vm.count("shard") || merge_shards) {
+      if (!vm.count("shard_files")) {
+        std::cerr << "Sharded builds require --shard_files" << std::endl;
+        return 1;
+      }
+      if (merge_shards && (vm.count("shards") || vm.count("shard"))) {
+        std::cerr << "--merge_shards reads the number of shards from --shard_files, so don't pass --shards or --shard" << std::endl;
+        return 1;
+      }
+      if (!merge_shards && !(vm.count("shards") && vm.count("shard") && shard < shards)) {
+        std::cerr << "Building a shard requires --shards and --shard less than --shards" << std::endl;
+        return 1;
+      }
+    }
+
+    lm::ngram::ModelType binary_model = lm::ngram::PROBING;
+    lm::ngram::Config binary_config;
+    if (vm.count("binary")) {
+      if (binary_type == "trie") {
+        binary_model = lm::ngram::TRIE;
+        binary_config.write_method = lm::ngram::Config::WRITE_MMAP;
+      } else if (binary_type == "probing") {
+        binary_config.write_method = lm::ngram::Config::WRITE_AFTER;
+      } else {
+        std::cerr << "Unknown --binary_type " << binary_type << ".  Use probing or trie." << std::endl;
+        return 1;
+      }
+      if (vm.count("binary_quantize_backoff") && !vm.count("binary_quantize")) {
+        std::cerr << "--binary_quantize_backoff requires --binary_quantize" << std::endl;
+        return 1;
+      }
+      if (vm.count("binary_quantize") || vm.count("binary_array")) {
+        if (binary_model != lm::ngram::TRIE) {
+          std::cerr << "Quantization and pointer compression are only implemented in the trie data structure." << std::endl;
+          return 1;
+        }
+        if (vm.count("binary_quantize")) {
+          binary_config.prob_bits = binary_quantize;
+          binary_config.backoff_bits = vm.count("binary_quantize_backoff") ? binary_quantize_backoff : binary_quantize;
+          UTIL_THROW_IF(binary_config.prob_bits > 25 || binary_config.backoff_bits > 25, util::Exception, "Quantization bit counts are limited to 25.");
+          binary_model = static_cast<lm::ngram::ModelType>(binary_model + lm::ngram::kQuantAdd);
+        }
+        if (vm.count("binary_array")) {
+          binary_config.pointer_bhiksha_bits = std::min(binary_array, 255U);
+          binary_model = static_cast<lm::ngram::ModelType>(binary_model + lm::ngram::kArrayAdd);
+        }
+      }
+    }
+
     if (vm["skip_symbols"].as<bool>()) {
       pipeline.disallowed_symbol_action = lm::COMPLAIN;
     } else {
@@ -198,15 +260,28 @@ int main(int argc, char *argv[]) {
     }
 
     try {
+      if (vm.count("shards")) {
+        lm::builder::PipelineShard(pipeline, in.release(), lm::builder::Shard(shard, shards), shard_files);
+        util::PrintUsage(std::cerr);
+        return 0;
+      }
       bool writing_intermediate = vm.count("intermediate");
       if (writing_intermediate) {
         pipeline.renumber_vocabulary = true;
       }
       lm::builder::Output output(writing_intermediate ? intermediate : pipeline.sort.temp_prefix, writing_intermediate, pipeline.output_q);
-      if (!writing_intermediate || vm.count("arpa")) {
+      if (vm.count("arpa") || (!writing_intermediate && !vm.count("binary"))) {
         output.Add(new lm::builder::PrintHook(out.release(), verbose_header));
       }
-      lm::builder::Pipeline(pipeline, in.release(), output);
+      if (vm.count("binary")) {
+        binary_config.temporary_directory_prefix = pipeline.sort.temp_prefix;
+        output.Add(new lm::builder::BinaryHook(binary, binary_model, binary_config));
+      }
+      if (merge_shards) {
+        lm::builder::PipelineMerge(pipeline, shard_files, output);
+      } else {
+        lm::builder::Pipeline(pipeline, in.release(), output);
+      }
     } catch (const util::MallocException &e) {
       std::cerr << e.what() << std::endl;
       std::cerr << "Try rerunning with a more conservative -S setting than " << vm["memory"].as<std::string>() << std::endl;
@@ -2,11 +2,19 @@
 
 #include "lm/common/model_buffer.hh"
 #include "lm/common/print.hh"
+#include "lm/model.hh"
 #include "util/fake_ofstream.hh"
 #include "util/stream/multi_stream.hh"
 
+#include <boost/thread/thread.hpp>
+
 #include <iostream>
 
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
 namespace lm { namespace builder {
 
 OutputHook::~OutputHook() {}
@@ -25,7 +33,7 @@ void Output::SinkProbs(util::stream::Chains &chains) {
   chains >> util::stream::kRecycle;
   chains.Wait(false);
   if (Have(PROB_SEQUENTIAL_HOOK)) {
-    std::cerr << "=== 5/5 Writing ARPA model ===" << std::endl;
+    std::cerr << "=== 5/5 Writing model ===" << std::endl;
     buffer_.Source(chains);
     Apply(PROB_SEQUENTIAL_HOOK, chains);
     chains >> util::stream::kRecycle;
@@ -49,4 +57,105 @@ void PrintHook::Sink(const HeaderInfo &info, int vocab_file, util::stream::Chain
   chains >> PrintARPA(vocab_file, file_.get(), info.counts_pruned);
 }
 
+namespace {
+
+// Same as build_binary, but reading the ARPA file from fd, which it takes.
+void LoadARPA(int fd, const char *name, ngram::ModelType type, const ngram::Config &config) {
+  switch (type) {
+    case ngram::PROBING:
+      ngram::ProbingModel(fd, name, config);
+      break;
+    case ngram::TRIE:
+      ngram::TrieModel(fd, name, config);
+      break;
+    case ngram::QUANT_TRIE:
+      ngram::QuantTrieModel(fd, name, config);
+      break;
+    case ngram::ARRAY_TRIE:
+      ngram::ArrayTrieModel(fd, name, config);
+      break;
+    case ngram::QUANT_ARRAY_TRIE:
+      ngram::QuantArrayTrieModel(fd, name, config);
+      break;
+    default:
+      util::scoped_fd closer(fd);
+      UTIL_THROW(util::Exception, "Building " << ngram::kModelNames[type] << " directly is not supported.");
+  }
+}
+
+class PrintToPipe {
+  public:
+    // Takes ownership of pipe.  What goes wrong is left in error, which must outlive the thread.
+    PrintToPipe(int vocab_file, int pipe, const std::vector<uint64_t> &counts, const util::stream::ChainPositions &positions, std::string &error)
+      : vocab_file_(vocab_file), pipe_(pipe), counts_(counts), positions_(&positions), error_(&error) {}
+
+    void operator()() {
+      // Closing the pipe tells the loader that the ARPA file ended.
+      util::scoped_fd closer(pipe_);
+      // If the loader stops reading, writes fail with EPIPE instead of killing the process.
+      sigset_t pipe_signal;
+      sigemptyset(&pipe_signal);
+      sigaddset(&pipe_signal, SIGPIPE);
+      pthread_sigmask(SIG_BLOCK, &pipe_signal, NULL);
+      try {
+        PrintARPA(vocab_file_, pipe_, counts_).Run(*positions_);
+      } catch (const util::ErrnoException &e) {
+        // The loader's own exception says why it stopped.
+        if (e.Error() != EPIPE) *error_ = e.what();
+      } catch (const std::exception &e) {
+        *error_ = e.what();
+      }
+    }
+
+  private:
+    int vocab_file_;
+    int pipe_;
+    std::vector<uint64_t> counts_;
+    const util::stream::ChainPositions *positions_;
+    std::string *error_;
+};
+
+class BuildBinary {
+  public:
+    BuildBinary(const std::string &file, ngram::ModelType type, const ngram::Config &config, int vocab_file, const std::vector<uint64_t> &counts)
+      : file_(file), type_(type), config_(config), vocab_file_(vocab_file), counts_(counts) {}
+
+    void Run(const util::stream::ChainPositions &positions) {
+      int ends[2];
+      UTIL_THROW_IF(pipe(ends), util::ErrnoException, "Could not create a pipe to build " << file_);
+      std::string printer_error;
+      boost::thread printer(PrintToPipe(vocab_file_, ends[1], counts_, positions, printer_error));
+      ngram::Config config(config_);
+      config.write_mmap = file_.c_str();
+      try {
+        LoadARPA(ends[0], ("ARPA for " + file_).c_str(), type_, config);
+      } catch (...) {
+        // The loader closed the pipe, so the printer stops too.
+        printer.join();
+        // A printer that failed first cut the ARPA file short, which is why the loader failed.
+        CheckPrinter(printer_error);
+        throw;
+      }
+      printer.join();
+      CheckPrinter(printer_error);
+    }
+
+  private:
+    void CheckPrinter(const std::string &error) const {
+      UTIL_THROW_IF(!error.empty(), util::Exception, "Writing the ARPA file for " << file_ << " failed: " << error);
+    }
+
+    std::string file_;
+    ngram::ModelType type_;
+    ngram::Config config_;
+    int vocab_file_;
+    std::vector<uint64_t> counts_;
+};
+
+} // namespace
+
+void BinaryHook::Sink(const HeaderInfo &info, int vocab_file, util::stream::Chains &chains) {
+  chains >> BuildBinary(file_, type_, config_, vocab_file, info.counts_pruned);
+}
+
 }} // namespaces
@@ -3,6 +3,8 @@
 
 #include "lm/builder/header_info.hh"
 #include "lm/common/model_buffer.hh"
+#include "lm/config.hh"
+#include "lm/model_type.hh"
 #include "util/file.hh"
 
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -80,6 +82,24 @@ class PrintHook : public OutputHook {
     bool verbose_header_;
 };
 
+/* Builds a binary model, the same as running build_binary on the ARPA file.
+ * The ARPA text goes through a pipe to the loader in this process, so it is
+ * never written to disk.
+ */
+class BinaryHook : public OutputHook {
+  public:
+    // config.write_mmap is ignored in favor of file.
+    BinaryHook(const std::string &file, ngram::ModelType type, const ngram::Config &config)
+      : OutputHook(PROB_SEQUENTIAL_HOOK), file_(file), type_(type), config_(config) {}
+
+    void Sink(const HeaderInfo &info, int vocab_file, util::stream::Chains &chains);
+
+  private:
+    std::string file_;
+    ngram::ModelType type_;
+    ngram::Config config_;
+};
+
 }} // namespaces
 
 #endif // LM_BUILDER_OUTPUT_H
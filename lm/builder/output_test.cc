@@ -0,0 +1,123 @@
+#include "lm/builder/output.hh"
+
+#include "lm/builder/pipeline.hh"
+#include "lm/model.hh"
+#include "util/file.hh"
+
+#define BOOST_TEST_MODULE OutputTest
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace lm { namespace builder { namespace {
+
+const char kCorpus[] =
+  "the cat sat on the mat\n"
+  "the dog sat on the log\n"
+  "a cat and a dog sat on a mat\n"
+  "the cat saw the dog\n"
+  "the dog saw a cat on the log\n"
+  "on the mat sat the cat\n";
+
+std::string ReadAll(const std::string &name) {
+  util::scoped_fd file(util::OpenReadOrThrow(name.c_str()));
+  std::string ret(util::SizeOrThrow(file.get()), '\0');
+  if (!ret.empty()) util::ReadOrThrow(file.get(), &ret[0], ret.size());
+  return ret;
+}
+
+class TempDir {
+  public:
+    TempDir() {
+      char name[] = "/tmp/output_test_XXXXXX";
+      BOOST_REQUIRE(mkdtemp(name));
+      name_ = name;
+    }
+
+    ~TempDir() {
+      const char *files[] = {"corpus", "arpa", "lmplz.binary", "build_binary.binary"};
+      for (std::size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        unlink((name_ + '/' + files[i]).c_str());
+      }
+      rmdir(name_.c_str());
+    }
+
+    std::string File(const char *name) const { return name_ + '/' + name; }
+
+  private:
+    std::string name_;
+};
+
+// Like lmplz -o 3 --discount_fallback --arpa arpa --binary binary.
+void RunLmplz(const TempDir &dir, ngram::ModelType type, const ngram::Config &binary_config) {
+  PipelineConfig pipeline;
+  pipeline.order = 3;
+  pipeline.sort.temp_prefix = dir.File("lm");
+  pipeline.sort.total_memory = 10 << 20;
+  pipeline.sort.buffer_size = 1 << 16;
+  pipeline.minimum_block = 8192;
+  pipeline.block_count = 2;
+  pipeline.vocab_estimate = 100;
+  pipeline.prune_thresholds.resize(pipeline.order, 0);
+  pipeline.prune_vocab = false;
+  pipeline.renumber_vocabulary = false;
+  pipeline.discount.fallback.amount[0] = 0.0;
+  pipeline.discount.fallback.amount[1] = 0.5;
+  pipeline.discount.fallback.amount[2] = 1.0;
+  pipeline.discount.fallback.amount[3] = 1.5;
+  pipeline.discount.bad_action = COMPLAIN;
+  pipeline.output_q = false;
+  pipeline.vocab_size_for_unk = 0;
+  pipeline.disallowed_symbol_action = THROW_UP;
+  pipeline.initial_probs.interpolate_unigrams = true;
+  pipeline.initial_probs.adder_in.total_memory = 32768;
+  pipeline.initial_probs.adder_in.block_count = 2;
+  pipeline.initial_probs.adder_out.total_memory = 32768;
+  pipeline.initial_probs.adder_out.block_count = 2;
+  pipeline.read_backoffs = pipeline.initial_probs.adder_out;
+
+  util::scoped_fd corpus(util::CreateOrThrow(dir.File("corpus").c_str()));
+  util::WriteOrThrow(corpus.get(), kCorpus, sizeof(kCorpus) - 1);
+  util::SeekOrThrow(corpus.get(), 0);
+
+  ngram::Config config(binary_config);
+  config.temporary_directory_prefix = pipeline.sort.temp_prefix;
+  Output output(pipeline.sort.temp_prefix, false, pipeline.output_q);
+  output.Add(new PrintHook(util::CreateOrThrow(dir.File("arpa").c_str()), false));
+  output.Add(new BinaryHook(dir.File("lmplz.binary"), type, config));
+  Pipeline(pipeline, corpus.release(), output);
+}
+
+// lmplz --binary writes the same file as build_binary on its ARPA output.
+template <class Model> void CheckSameAsBuildBinary(ngram::ModelType type, ngram::Config::WriteMethod write_method) {
+  TempDir dir;
+  ngram::Config config;
+  config.write_method = write_method;
+  config.messages = NULL;
+  RunLmplz(dir, type, config);
+
+  std::string build_binary = dir.File("build_binary.binary");
+  config.write_mmap = build_binary.c_str();
+  Model(dir.File("arpa").c_str(), config);
+
+  std::string expected = ReadAll(build_binary);
+  BOOST_CHECK(!expected.empty());
+  BOOST_CHECK(ReadAll(dir.File("lmplz.binary")) == expected);
+
+  // and it loads
+  Model model(dir.File("lmplz.binary").c_str());
+  BOOST_CHECK_EQUAL(3, model.Order());
+}
+
+BOOST_AUTO_TEST_CASE(Probing) {
+  CheckSameAsBuildBinary<ngram::ProbingModel>(ngram::PROBING, ngram::Config::WRITE_AFTER);
+}
+
+BOOST_AUTO_TEST_CASE(Trie) {
+  CheckSameAsBuildBinary<ngram::TrieModel>(ngram::TRIE, ngram::Config::WRITE_MMAP);
+}
+
+}}} // namespaces
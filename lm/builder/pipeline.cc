@@ -14,8 +14,13 @@
 #include "lm/vocab.hh"
 
 #include "util/exception.hh"
+#include "util/fake_ofstream.hh"
 #include "util/file.hh"
+#include "util/file_piece.hh"
 #include "util/stream/io.hh"
+#include "util/stream/sort.hh"
+
+#include <boost/lexical_cast.hpp>
 
 #include <algorithm>
 #include <iostream>
@@ -43,8 +48,8 @@ void PrintStatistics(const std::vector<uint64_t> &counts, const std::vector<uint
 
 class Master {
   public:
-    explicit Master(PipelineConfig &config, unsigned output_steps)
-      : config_(config), chains_(config.order), unigrams_(util::MakeTemp(config_.TempPrefix())), steps_(output_steps + 4) {
+    Master(PipelineConfig &config, unsigned int steps)
+      : config_(config), chains_(config.order), unigrams_(util::MakeTemp(config_.TempPrefix())), steps_(steps) {
       config_.minimum_block = std::max(NGram<BuildingPayload>::TotalSize(config_.order), config_.minimum_block);
     }
 
@@ -90,17 +95,24 @@ class Master {
         second.back() >> unigrams_.Source();
       }
       for (std::size_t i = unigrams_are_sorted; i < config_.order; ++i) {
-        util::scoped_fd fd(sorts[i - unigrams_are_sorted].StealCompleted());
-        chains_[i].SetProgressTarget(util::SizeOrThrow(fd.get()));
-        chains_[i] >> util::stream::PRead(util::DupOrThrow(fd.get()), true);
-        second_config.entry_size = NGram<BuildingPayload>::TotalSize(i + 1);
-        second.push_back(second_config);
-        second.back() >> util::stream::PRead(fd.release(), true);
+        ReadTwice(i, sorts[i - unigrams_are_sorted].StealCompleted(), second, second_config);
       }
     }
 
-    // There is no sort after this, so go for broke on lazy merging.
+    // Like SortAndReadTwice, but every order is already sorted in a file,
+    // e.g. by merging shards.  Takes ownership of the files.
+    void ReadTwice(const std::vector<uint64_t> &counts, const std::vector<int> &files, util::stream::Chains &second, util::stream::ChainConfig second_config) {
+      CreateChains(config_.TotalMemory(), counts);
+      chains_.back().ActivateProgress();
+      for (std::size_t i = 0; i < config_.order; ++i) {
+        ReadTwice(i, files[i], second, second_config);
+      }
+    }
+
+    // There is no sort after this, so go for broke on lazy merging.  Unigrams
+    // come from unigrams_ if SetupSorts excluded them.
     template <class Compare> void MaximumLazyInput(const std::vector<uint64_t> &counts, Sorts<Compare> &sorts) {
+      const std::size_t exclude_unigrams = config_.order - sorts.size();
       // Determine the minimum we can use for all the chains.
       std::size_t min_chains = 0;
       for (std::size_t i = 0; i < config_.order; ++i) {
@@ -109,7 +121,7 @@ class Master {
       std::size_t for_merge = min_chains > config_.TotalMemory() ? 0 : (config_.TotalMemory() - min_chains);
       std::vector<std::size_t> laziness;
       // Prioritize longer n-grams.
-      for (util::stream::Sort<SuffixOrder> *i = sorts.end() - 1; i >= sorts.begin(); --i) {
+      for (util::stream::Sort<Compare> *i = sorts.end() - 1; i >= sorts.begin(); --i) {
         laziness.push_back(i->Merge(for_merge));
         assert(for_merge >= laziness.back());
         for_merge -= laziness.back();
@@ -118,9 +130,9 @@ class Master {
 
       CreateChains(for_merge + min_chains, counts);
       chains_.back().ActivateProgress();
-      chains_[0] >> unigrams_.Source();
-      for (std::size_t i = 1; i < config_.order; ++i) {
-        sorts[i - 1].Output(chains_[i], laziness[i - 1]);
+      if (exclude_unigrams) chains_[0] >> unigrams_.Source();
+      for (std::size_t i = exclude_unigrams; i < config_.order; ++i) {
+        sorts[i - exclude_unigrams].Output(chains_[i], laziness[i - exclude_unigrams]);
       }
     }
 
@@ -137,6 +149,15 @@ class Master {
     unsigned int Steps() const { return steps_; }
 
   private:
+    void ReadTwice(std::size_t i, int file, util::stream::Chains &second, util::stream::ChainConfig second_config) {
+      util::scoped_fd fd(file);
+      chains_[i].SetProgressTarget(util::SizeOrThrow(fd.get()));
+      chains_[i] >> util::stream::PRead(util::DupOrThrow(fd.get()), true);
+      second_config.entry_size = NGram<BuildingPayload>::TotalSize(i + 1);
+      second.push_back(second_config);
+      second.back() >> util::stream::PRead(fd.release(), true);
+    }
+
     // Create chains, allocating memory to them.  Totally heuristic.  Count
     // bounds are upper bounds on the counts or not present.
     void CreateChains(std::size_t remaining_mem, const std::vector<uint64_t> &count_bounds) {
@@ -209,7 +230,7 @@ class Master {
     const unsigned int steps_;
 };
 
-util::stream::Sort<SuffixOrder, CombineCounts> *CountText(int text_file /* input */, int vocab_file /* output */, Master &master, uint64_t &token_count, WordIndex &type_count, std::string &text_file_name, std::vector<bool> &prune_words) {
+util::stream::Sort<SuffixOrder, CombineCounts> *CountText(int text_file /* input */, int vocab_file /* output */, Master &master, uint64_t &token_count, WordIndex &type_count, std::string &text_file_name, std::vector<bool> &prune_words, const Shard &shard = Shard()) {
   const PipelineConfig &config = master.Config();
   std::cerr << "=== 1/" << master.Steps() << " Counting and sorting n-grams ===" << std::endl;
 
@@ -227,7 +248,7 @@ util::stream::Sort<SuffixOrder, CombineCounts> *CountText(int text_file /* input
   type_count = config.vocab_estimate;
   util::FilePiece text(text_file, NULL, &std::cerr);
   text_file_name = text.FileName();
-  CorpusCount counter(text, vocab_file, token_count, type_count, prune_words, config.prune_vocab_file, chain.BlockSize() / chain.EntrySize(), config.disallowed_symbol_action);
+  CorpusCount counter(text, vocab_file, token_count, type_count, prune_words, config.prune_vocab_file, chain.BlockSize() / chain.EntrySize(), config.disallowed_symbol_action, shard);
   chain >> boost::ref(counter);
 
   util::scoped_ptr<util::stream::Sort<SuffixOrder, CombineCounts> > sorter(new util::stream::Sort<SuffixOrder, CombineCounts>(chain, config.sort, SuffixOrder(config.order), CombineCounts()));
@@ -235,19 +256,21 @@ util::stream::Sort<SuffixOrder, CombineCounts> *CountText(int text_file /* input
   return sorter.release();
 }
 
-void InitialProbabilities(const std::vector<uint64_t> &counts, const std::vector<uint64_t> &counts_pruned, const std::vector<Discount> &discounts, Master &master, Sorts<SuffixOrder> &primary, util::FixedArray<util::stream::FileBuffer> &gammas, const std::vector<uint64_t> &prune_thresholds, bool prune_vocab, const SpecialVocab &specials) {
+// Sorts adjusted counts in context order and reads them twice: into master's
+// chains and into second.
+void SortContextOrder(const std::vector<uint64_t> &counts, const std::vector<uint64_t> &counts_pruned, const std::vector<Discount> &discounts, Master &master, util::stream::Chains &second) {
   const PipelineConfig &config = master.Config();
-  util::stream::Chains second(config.order);
-
-  {
-    Sorts<ContextOrder> sorts;
-    master.SetupSorts(sorts, !config.renumber_vocabulary);
-    PrintStatistics(counts, counts_pruned, discounts);
-    lm::ngram::ShowSizes(counts_pruned);
-    std::cerr << "=== 3/" << master.Steps() << " Calculating and sorting initial probabilities ===" << std::endl;
-    master.SortAndReadTwice(counts_pruned, sorts, second, config.initial_probs.adder_in);
-  }
+  Sorts<ContextOrder> sorts;
+  master.SetupSorts(sorts, !config.renumber_vocabulary);
+  PrintStatistics(counts, counts_pruned, discounts);
+  lm::ngram::ShowSizes(counts_pruned);
+  std::cerr << "=== 3/" << master.Steps() << " Calculating and sorting initial probabilities ===" << std::endl;
+  master.SortAndReadTwice(counts_pruned, sorts, second, config.initial_probs.adder_in);
+}
 
+// Input: adjusted counts in context order in master's chains and in second.
+void InitialProbabilities(const std::vector<Discount> &discounts, Master &master, util::stream::Chains &second, Sorts<SuffixOrder> &primary, util::FixedArray<util::stream::FileBuffer> &gammas, const std::vector<uint64_t> &prune_thresholds, bool prune_vocab, const SpecialVocab &specials) {
+  const PipelineConfig &config = master.Config();
   util::stream::Chains gamma_chains(config.order);
   InitialProbabilities(config.initial_probs, discounts, master.MutableChains(), second, gamma_chains, prune_thresholds, prune_vocab, specials);
   // Don't care about gamma for 0.
@@ -326,10 +349,8 @@ class VocabNumbering {
     SpecialVocab specials_;
 };
 
-} // namespace
-
-void Pipeline(PipelineConfig &config, int text_file, Output &output) {
-  // Some fail-fast sanity checks.
+// Some fail-fast sanity checks.
+void CheckConfig(PipelineConfig &config) {
   if (config.sort.buffer_size * 4 > config.TotalMemory()) {
     config.sort.buffer_size = config.TotalMemory() / 4;
     std::cerr << "Warning: changing sort block size to " << config.sort.buffer_size << " bytes due to low total memory." << std::endl;
@@ -341,8 +362,14 @@ void Pipeline(PipelineConfig &config, int text_file, Output &output) {
   UTIL_THROW_IF(config.sort.buffer_size < config.minimum_block, util::Exception, "Sort block size " << config.sort.buffer_size << " is below the minimum block size " << config.minimum_block << ".");
   UTIL_THROW_IF(config.TotalMemory() < config.minimum_block * config.order * config.block_count, util::Exception,
       "Not enough memory to fit " << (config.order * config.block_count) << " blocks with minimum size " << config.minimum_block << ".  Increase memory to " << (config.minimum_block * config.order * config.block_count) << " bytes or decrease the minimum block size.");
+}
+
+} // namespace
 
-  Master master(config, output.Steps());
+void Pipeline(PipelineConfig &config, int text_file, Output &output) {
+  CheckConfig(config);
+
+  Master master(config, output.Steps() + 4);
   // master's destructor will wait for chains.  But they might be deadlocked if
   // this thread dies because e.g. it ran out of memory.
   try {
@@ -371,7 +398,11 @@ void Pipeline(PipelineConfig &config, int text_file, Output &output) {
     {
       util::FixedArray<util::stream::FileBuffer> gammas;
       Sorts<SuffixOrder> primary;
-      InitialProbabilities(counts, counts_pruned, discounts, master, primary, gammas, config.prune_thresholds, config.prune_vocab, numbering.Specials());
+      {
+        util::stream::Chains second(config.order);
+        SortContextOrder(counts, counts_pruned, discounts, master, second);
+        InitialProbabilities(discounts, master, second, primary, gammas, config.prune_thresholds, config.prune_vocab, numbering.Specials());
+      }
       output.SetHeader(HeaderInfo(text_file_name, token_count, counts_pruned));
       // Also does output.
       InterpolateProbabilities(counts_pruned, master, primary, gammas, output, numbering.Specials());
@@ -382,4 +413,266 @@ void Pipeline(PipelineConfig &config, int text_file, Output &output) {
   }
 }
 
+namespace {
+
+std::string ShardFile(const std::string &file_base, unsigned int shard) {
+  return file_base + ".shard" + boost::lexical_cast<std::string>(shard);
+}
+
+std::string ShardFile(const std::string &file_base, unsigned int shard, std::size_t order) {
+  return ShardFile(file_base, shard) + '.' + boost::lexical_cast<std::string>(order);
+}
+
+// Everything besides the n-grams that a shard leaves for the merge.
+struct ShardInfo {
+  unsigned int shard, shards;
+  std::size_t order;
+  uint64_t token_count;
+  WordIndex type_count;
+  // After renumbering.
+  WordIndex bos, eos;
+  bool renumbered;
+  std::vector<uint64_t> prune_thresholds;
+  bool prune_vocab;
+  std::vector<AdjustedCountStats> stats;
+  std::string text_file_name;
+};
+
+void WriteShardInfo(const std::string &file_base, const ShardInfo &info) {
+  util::scoped_fd file(util::CreateOrThrow(ShardFile(file_base, info.shard).c_str()));
+  util::FakeOFStream out(file.get());
+  out << "lmplz shard " << info.shard << ' ' << info.shards << '\n'
+    << "order " << info.order << '\n'
+    << "tokens " << info.token_count << '\n'
+    << "types " << info.type_count << '\n'
+    << "specials " << info.bos << ' ' << info.eos << '\n'
+    << "renumbered " << info.renumbered << '\n'
+    << "prune";
+  for (std::size_t i = 0; i < info.prune_thresholds.size(); ++i) {
+    out << ' ' << info.prune_thresholds[i];
+  }
+  out << '\n' << "limit_vocab " << info.prune_vocab << '\n';
+  for (std::size_t i = 0; i < info.stats.size(); ++i) {
+    const AdjustedCountStats &s = info.stats[i];
+    out << "stats " << (i + 1) << ' ' << s.count << ' ' << s.count_pruned;
+    for (unsigned j = 0; j < 5; ++j) {
+      out << ' ' << s.n[j];
+    }
+    out << '\n';
+  }
+  out << "input " << info.text_file_name << '\n';
+}
+
+void ExpectWord(util::FilePiece &in, StringPiece expected) {
+  StringPiece word(in.ReadDelimited());
+  UTIL_THROW_IF(word != expected, util::Exception, "Expected " << expected << " but got " << word << " in shard file " << in.FileName());
+}
+
+void ReadShardInfo(const std::string &name, ShardInfo &info) {
+  util::FilePiece in(name.c_str());
+  ExpectWord(in, "lmplz");
+  ExpectWord(in, "shard");
+  info.shard = in.ReadULong();
+  info.shards = in.ReadULong();
+  ExpectWord(in, "order");
+  info.order = in.ReadULong();
+  ExpectWord(in, "tokens");
+  info.token_count = in.ReadULong();
+  ExpectWord(in, "types");
+  info.type_count = in.ReadULong();
+  ExpectWord(in, "specials");
+  info.bos = in.ReadULong();
+  info.eos = in.ReadULong();
+  ExpectWord(in, "renumbered");
+  info.renumbered = in.ReadULong();
+  ExpectWord(in, "prune");
+  info.prune_thresholds.resize(info.order);
+  for (std::size_t i = 0; i < info.order; ++i) {
+    info.prune_thresholds[i] = in.ReadULong();
+  }
+  ExpectWord(in, "limit_vocab");
+  info.prune_vocab = in.ReadULong();
+  info.stats.resize(info.order);
+  for (std::size_t i = 0; i < info.order; ++i) {
+    ExpectWord(in, "stats");
+    UTIL_THROW_IF(in.ReadULong() != i + 1, util::Exception, "Statistics out of order in shard file " << name);
+    AdjustedCountStats &s = info.stats[i];
+    s.count = in.ReadULong();
+    s.count_pruned = in.ReadULong();
+    for (unsigned j = 0; j < 5; ++j) {
+      s.n[j] = in.ReadULong();
+    }
+  }
+  ExpectWord(in, "input");
+  // Skip the space after input.  The name might contain spaces.
+  in.get();
+  info.text_file_name = in.ReadLine().as_string();
+}
+
+// Appends the entries of one file to another.
+void AppendFile(int from, int to, std::size_t entry_size, std::size_t memory) {
+  util::stream::Chain chain(util::stream::ChainConfig(entry_size, 2, memory));
+  chain >> util::stream::Read(from) >> util::stream::WriteAndRecycle(to);
+  chain.Wait();
+}
+
+// Merges the n-grams of one order from every shard, each of which is sorted
+// in context order.  Returns the merged file.
+int MergeShards(const PipelineConfig &config, const std::string &file_base, unsigned int shards, std::size_t order) {
+  const std::size_t entry_size = NGram<BuildingPayload>::TotalSize(order);
+  // Put the shards in one file as sorted blocks, which is what the sort's
+  // merge reads.
+  util::scoped_fd data(util::MakeTemp(config.TempPrefix()));
+  util::scoped_fd offsets_file(util::MakeTemp(config.TempPrefix()));
+  util::stream::Offsets offsets(offsets_file.get());
+  for (unsigned int i = 0; i < shards; ++i) {
+    util::scoped_fd in(util::OpenReadOrThrow(ShardFile(file_base, i, order).c_str()));
+    uint64_t size = util::SizeOrThrow(in.get());
+    AppendFile(in.get(), data.get(), entry_size, config.sort.buffer_size * 2);
+    offsets.Append(size);
+  }
+  offsets.FinishedAppending();
+
+  // Every shard gets a buffer so that it's one merge.  CheckConfig left
+  // memory for four sort buffers.
+  std::size_t per_buffer = std::min(config.sort.buffer_size, (config.TotalMemory() - config.sort.buffer_size * 2) / shards);
+  per_buffer -= per_buffer % entry_size;
+  UTIL_THROW_IF(!per_buffer, util::Exception, "Not enough memory to merge " << shards << " shards of " << order << "-grams.");
+
+  util::scoped_fd merged(util::MakeTemp(config.TempPrefix()));
+  util::stream::Chain chain(util::stream::ChainConfig(entry_size, 2, config.sort.buffer_size * 2));
+  chain >> util::stream::OwningMergingReader<ContextOrder, util::stream::NeverCombine>(data.release(), offsets, per_buffer, per_buffer * shards, ContextOrder(order), util::stream::NeverCombine()) >> util::stream::WriteAndRecycle(merged.get());
+  // The reader owns the offsets now.
+  offsets_file.release();
+  chain.Wait();
+  return merged.release();
+}
+
+} // namespace
+
+void PipelineShard(PipelineConfig &config, int text_file, const Shard &shard, const std::string &file_base) {
+  CheckConfig(config);
+
+  Master master(config, 3);
+  // master's destructor will wait for chains.  But they might be deadlocked if
+  // this thread dies because e.g. it ran out of memory.
+  try {
+    // Every shard numbers the vocabulary the same way, so the first one keeps it.
+    util::scoped_fd vocab_file(shard.Index() ? util::MakeTemp(config.TempPrefix()) : util::CreateOrThrow((file_base + ".vocab").c_str()));
+    VocabNumbering numbering(vocab_file.get(), config.TempPrefix(), config.renumber_vocabulary);
+    ShardInfo info;
+    info.shard = shard.Index();
+    info.shards = shard.Count();
+    info.order = config.order;
+    std::vector<bool> prune_words;
+    util::scoped_ptr<util::stream::Sort<SuffixOrder, CombineCounts> > sorted_counts(
+        CountText(text_file, numbering.WriteOnTheFly(), master, info.token_count, info.type_count, info.text_file_name, prune_words, shard));
+    std::cerr << "Unigram tokens " << info.token_count << " types " << info.type_count << std::endl;
+
+    std::size_t subtract_for_numbering = numbering.ComputeMapping(info.type_count);
+
+    std::cerr << "=== 2/" << master.Steps() << " Calculating and sorting adjusted counts ===" << std::endl;
+    master.InitForAdjust(*sorted_counts, info.type_count, subtract_for_numbering);
+    sorted_counts.reset();
+
+    master >> AdjustCounts(config.prune_thresholds, prune_words, shard, info.stats);
+    numbering.ApplyRenumber(master.MutableChains());
+
+    Sorts<ContextOrder> sorts;
+    master.SetupSorts(sorts, !config.renumber_vocabulary);
+    std::cerr << "=== 3/" << master.Steps() << " Writing shard " << shard.Index() << " of " << shard.Count() << " ===" << std::endl;
+    // Marked n-grams are still there to be pruned later.
+    std::vector<uint64_t> counts;
+    for (std::size_t i = 0; i < info.stats.size(); ++i) {
+      counts.push_back(info.stats[i].count);
+    }
+    master.MaximumLazyInput(counts, sorts);
+    util::FixedArray<util::scoped_fd> files(config.order);
+    for (std::size_t i = 0; i < config.order; ++i) {
+      files.push_back(util::CreateOrThrow(ShardFile(file_base, shard.Index(), i + 1).c_str()));
+      master.MutableChains()[i] >> util::stream::WriteAndRecycle(files.back().get());
+    }
+    master.MutableChains().Wait(true);
+
+    info.bos = numbering.Specials().BOS();
+    info.eos = numbering.Specials().EOS();
+    info.renumbered = config.renumber_vocabulary;
+    info.prune_thresholds = config.prune_thresholds;
+    info.prune_vocab = config.prune_vocab;
+    // Written last so that a shard is only there if it finished.
+    WriteShardInfo(file_base, info);
+  } catch (const util::Exception &e) {
+    std::cerr << e.what() << std::endl;
+    abort();
+  }
+}
+
+void PipelineMerge(PipelineConfig &config, const std::string &file_base, Output &output) {
+  CheckConfig(config);
+
+  Master master(config, output.Steps() + 4);
+  // master's destructor will wait for chains.  But they might be deadlocked if
+  // this thread dies because e.g. it ran out of memory.
+  try {
+    ShardInfo info;
+    ReadShardInfo(ShardFile(file_base, 0), info);
+    UTIL_THROW_IF(info.shard != 0, util::Exception, ShardFile(file_base, 0) << " claims to be shard " << info.shard << ".");
+    UTIL_THROW_IF(info.order != config.order, util::Exception, "The shards have order " << info.order << " but the model has order " << config.order << ".");
+    UTIL_THROW_IF(config.renumber_vocabulary && !info.renumbered, util::Exception, "The vocabulary has to be renumbered, but the shards were not built with --renumber.");
+    // Pruning happened when adjusting counts, so follow the shards.
+    config.renumber_vocabulary = info.renumbered;
+    config.prune_thresholds = info.prune_thresholds;
+    config.prune_vocab = info.prune_vocab;
+
+    std::vector<AdjustedCountStats> stats(info.stats);
+    for (unsigned int i = 1; i < info.shards; ++i) {
+      ShardInfo other;
+      ReadShardInfo(ShardFile(file_base, i), other);
+      UTIL_THROW_IF(other.shard != i || other.shards != info.shards || other.order != info.order ||
+          other.token_count != info.token_count || other.type_count != info.type_count ||
+          other.bos != info.bos || other.eos != info.eos || other.renumbered != info.renumbered ||
+          other.prune_thresholds != info.prune_thresholds || other.prune_vocab != info.prune_vocab,
+          util::Exception, ShardFile(file_base, i) << " does not match " << ShardFile(file_base, 0) << ".  The shards have to be built from the same corpus with the same options.");
+      for (std::size_t j = 0; j < stats.size(); ++j) {
+        stats[j] += other.stats[j];
+      }
+    }
+    std::cerr << "Unigram tokens " << info.token_count << " types " << info.type_count << std::endl;
+    SpecialVocab specials(info.bos, info.eos);
+
+    std::cerr << "=== 2/" << master.Steps() << " Merging adjusted counts from " << info.shards << " shards ===" << std::endl;
+    std::vector<uint64_t> counts;
+    std::vector<uint64_t> counts_pruned;
+    std::vector<Discount> discounts;
+    CalculateDiscounts(stats, config.discount, counts, counts_pruned, discounts);
+    {
+      util::scoped_fd vocab(util::OpenReadOrThrow((file_base + ".vocab").c_str()));
+      AppendFile(vocab.get(), output.VocabFile(), 1, config.sort.buffer_size * 2);
+    }
+    std::vector<int> merged;
+    for (std::size_t i = 0; i < config.order; ++i) {
+      merged.push_back(MergeShards(config, file_base, info.shards, i + 1));
+    }
+
+    {
+      util::FixedArray<util::stream::FileBuffer> gammas;
+      Sorts<SuffixOrder> primary;
+      {
+        util::stream::Chains second(config.order);
+        PrintStatistics(counts, counts_pruned, discounts);
+        lm::ngram::ShowSizes(counts_pruned);
+        std::cerr << "=== 3/" << master.Steps() << " Calculating initial probabilities ===" << std::endl;
+        master.ReadTwice(counts_pruned, merged, second, config.initial_probs.adder_in);
+        InitialProbabilities(discounts, master, second, primary, gammas, config.prune_thresholds, config.prune_vocab, specials);
+      }
+      output.SetHeader(HeaderInfo(info.text_file_name, info.token_count, counts_pruned));
+      // Also does output.
+      InterpolateProbabilities(counts_pruned, master, primary, gammas, output, specials);
+    }
+  } catch (const util::Exception &e) {
+    std::cerr << e.what() << std::endl;
+    abort();
+  }
+}
+
 }} // namespaces
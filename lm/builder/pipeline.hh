@@ -4,6 +4,7 @@
 #include "lm/builder/adjust_counts.hh"
 #include "lm/builder/initial_probabilities.hh"
 #include "lm/builder/header_info.hh"
+#include "lm/builder/shard.hh"
 #include "lm/lm_exception.hh"
 #include "lm/word_index.hh"
 #include "util/stream/config.hh"
@@ -72,5 +73,18 @@ struct PipelineConfig {
 // Takes ownership of text_file and out_arpa.
 void Pipeline(PipelineConfig &config, int text_file, Output &output);
 
+/* Sharded builds split counting and adjusting counts, which need the most
+ * disk and time, over separate runs that can go on different machines.  Each
+ * shard writes its adjusted counts, sorted in context order, to
+ * file_base.shard<index>.<order> and what the merge needs to know to
+ * file_base.shard<index>.  Shard 0 also writes the vocabulary to
+ * file_base.vocab.  Takes ownership of text_file.
+ */
+void PipelineShard(PipelineConfig &config, int text_file, const Shard &shard, const std::string &file_base);
+
+// Merges the shards written by PipelineShard then estimates the model like
+// Pipeline.  Renumbering and pruning follow the shards.
+void PipelineMerge(PipelineConfig &config, const std::string &file_base, Output &output);
+
 }} // namespaces
 #endif // LM_BUILDER_PIPELINE_H
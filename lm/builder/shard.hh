@@ -0,0 +1,43 @@
+#ifndef LM_BUILDER_SHARD_H
+#define LM_BUILDER_SHARD_H
+
+#include "lm/builder/payload.hh"
+#include "lm/word_index.hh"
+#include "util/murmur_hash.hh"
+
+#include <stdint.h>
+
+namespace lm { namespace builder {
+
+/* Part of a sharded build.  Adjusted counts of an n-gram only depend on the
+ * n-grams with the same last word, so shards split n-grams by their last
+ * word.  Every shard reads the whole corpus so that they agree on vocabulary
+ * ids, then only keeps n-grams ending with one of its words.  <unk> and <s>
+ * are handled specially by AdjustCounts, so they always go to shard 0.
+ *
+ * The default is the whole vocabulary, i.e. an unsharded build.
+ */
+class Shard {
+  public:
+    Shard() : index_(0), count_(1) {}
+
+    Shard(unsigned int index, unsigned int count) : index_(index), count_(count) {}
+
+    unsigned int Index() const { return index_; }
+    unsigned int Count() const { return count_; }
+
+    bool Owns(WordIndex word) const {
+      if (count_ == 1) return true;
+      if (word <= kBOS) return OwnsSpecials();
+      return util::MurmurHashNative(&word, sizeof(WordIndex)) % count_ == index_;
+    }
+
+    bool OwnsSpecials() const { return index_ == 0; }
+
+  private:
+    unsigned int index_, count_;
+};
+
+}} // namespaces
+
+#endif // LM_BUILDER_SHARD_H
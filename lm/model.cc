@@ -75,7 +75,16 @@ template <class Search, class VocabularyT> GenericModel<Search, VocabularyT>::Ge
     ComplainAboutARPA(init_config, kModelType);
     InitializeFromARPA(fd.release(), file, init_config);
   }
+  InitializeStates();
+}
+
+template <class Search, class VocabularyT> GenericModel<Search, VocabularyT>::GenericModel(int fd, const char *name, const Config &init_config) : backing_(init_config) {
+  ComplainAboutARPA(init_config, kModelType);
+  InitializeFromARPA(fd, name, init_config);
+  InitializeStates();
+}
 
+template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::InitializeStates() {
   // g++ prints warnings unless these are fully initialized.
   State begin_sentence = State();
   begin_sentence.length = 1;
@@ -1,29 +1,56 @@
 #include "util/usage.hh"
+#include "util/file.hh"
 #include "moses/TranslationModel/ProbingPT/storing.hh"
 
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 
 
 int main(int argc, char* argv[])
 {
 
   const char * is_reordering = "false";
+  size_t num_threads = 1;
+  size_t sort_memory = 1ULL << 30;
+  std::string temp_prefix = "/tmp/";
+
+  //Options may appear anywhere, everything else is positional.
+  std::vector<char *> args;
+  for (int i = 0; i < argc; i++) {
+    if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-memory") && i + 1 < argc) {
+      sort_memory = (size_t)atoi(argv[++i]) << 20;
+    } else if (!strcmp(argv[i], "-T") && i + 1 < argc) {
+      temp_prefix = argv[++i];
+      util::NormalizeTempPrefix(temp_prefix);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
 
-  if (!(argc == 5 || argc == 4)) {
+  if (!(args.size() == 5 || args.size() == 4)) {
     // Tell the user how to run the program
-    std::cerr << "Provided " << argc << " arguments, needed 4 or 5." << std::endl;
-    std::cerr << "Usage: " << argv[0] << " path_to_phrasetable output_dir num_scores is_reordering" << std::endl;
+    std::cerr << "Provided " << args.size() << " arguments, needed 4 or 5." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " [options] path_to_phrasetable output_dir num_scores is_reordering" << std::endl;
     std::cerr << "is_reordering should be either true or false, but it is currently a stub feature." << std::endl;
+    std::cerr << "The phrase table may be unsorted and compressed. Options:" << std::endl;
+    std::cerr << "  -threads int  number of threads encoding target phrases (default 1)" << std::endl;
+    std::cerr << "  -memory int   memory in MB for sorting by source phrase (default 1024)" << std::endl;
+    std::cerr << "  -T dir        directory for temporary files (default /tmp)" << std::endl;
     //std::cerr << "Usage: " << argv[0] << " path_to_phrasetable number_of_uniq_lines output_bin_file output_hash_table output_vocab_id" << std::endl;
     return 1;
   }
 
-  if (argc == 5) {
-    is_reordering = argv[4];
+  if (args.size() == 5) {
+    is_reordering = args[4];
   }
 
-  createProbingPT(argv[1], argv[2], argv[3], is_reordering);
+  createProbingPT(args[1], args[2], args[3], is_reordering,
+                  num_threads, sort_memory, temp_prefix);
 
   util::PrintUsage(std::cout);
   return 0;
 }
-
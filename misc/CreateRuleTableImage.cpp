@@ -0,0 +1,25 @@
+#include "util/usage.hh"
+#include "util/exception.hh"
+#include "moses/TranslationModel/RuleTable/Image.h"
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " rule_table image" << std::endl;
+    std::cerr << "Writes the image of a text rule table in Moses or Hiero format, which" << std::endl;
+    std::cerr << "PhraseDictionaryMemory maps instead of loading the table." << std::endl;
+    return 1;
+  }
+
+  try {
+    Moses::RuleTableImage::Create(argv[1], argv[2]);
+  } catch (const util::Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  util::PrintUsage(std::cerr);
+  return 0;
+}
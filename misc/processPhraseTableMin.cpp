@@ -23,6 +23,8 @@ void printHelp(char **argv)
 #ifdef WITH_THREADS
             "\t-threads int|all  -- number of threads used for conversion\n"
 #endif
+            "\t-memory int       -- approximate memory budget in MB, counts beyond it are\n"
+            "\t                     kept in temporary files (default unlimited)\n"
             "\n  advanced:\n"
             "\t-encoding string  -- encoding type: PREnc REnc None (default PREnc)\n"
             "\t-rankscore int    -- score index of P(t|s) (default 2)\n"
@@ -67,6 +69,7 @@ int main(int argc, char **argv)
   bool sortScoreIndexSet = false;
   size_t sortScoreIndex = 2;
   bool warnMe = true;
+  size_t memoryBudget = 0;
   size_t threads =
 #ifdef WITH_THREADS
     boost::thread::hardware_concurrency() ? boost::thread::hardware_concurrency() :
@@ -124,6 +127,9 @@ int main(int argc, char **argv)
       quantize = atoi(argv[i]);
     } else if("-no-warnings" == arg) {
       warnMe = false;
+    } else if("-memory" == arg && i+1 < argc) {
+      ++i;
+      memoryBudget = atoi(argv[i]);
     } else if("-threads" == arg && i+1 < argc) {
 #ifdef WITH_THREADS
       ++i;
@@ -166,7 +172,7 @@ int main(int argc, char **argv)
                      numScoreComponent, sortScoreIndex,
                      coding, orderBits, fingerprintBits,
                      useAlignmentInfo, multipleScoreTrees,
-                     quantize, maxRank, warnMe
+                     quantize, maxRank, warnMe, memoryBudget
 #ifdef WITH_THREADS
                      , threads
 #endif
@@ -0,0 +1,118 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "TranslationModel/CompactPT/CanonicalHuffman.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// Fibonacci counts give codes much longer than the lookup window
+map<unsigned, size_t> SkewedCounts(size_t numSymbols)
+{
+  map<unsigned, size_t> counts;
+  size_t a = 1, b = 1;
+  for (size_t i = 0; i < numSymbols; ++i) {
+    counts[i * 7] = a;
+    size_t c = a + b;
+    a = b;
+    b = c;
+  }
+  return counts;
+}
+
+vector<unsigned> Message(size_t numSymbols)
+{
+  vector<unsigned> message;
+  for (size_t i = 0; i < 2000; ++i) {
+    message.push_back(((i * 2654435761u) % numSymbols) * 7);
+  }
+  return message;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(canonical_huffman)
+
+BOOST_AUTO_TEST_CASE(encode_decode)
+{
+  // one symbol, short codes only, and codes longer than the lookup window
+  size_t sizes[] = { 1, 5, 40 };
+  for (size_t s = 0; s < 3; ++s) {
+    map<unsigned, size_t> counts = SkewedCounts(sizes[s]);
+    CanonicalHuffman<unsigned> tree(counts.begin(), counts.end());
+
+    vector<unsigned> message = Message(sizes[s]);
+    string encoded;
+    BitWrapper<> writer(encoded);
+    for (size_t i = 0; i < message.size(); ++i) {
+      tree.Put(writer, message[i]);
+    }
+
+    BitWrapper<> reader(encoded);
+    for (size_t i = 0; i < message.size(); ++i) {
+      BOOST_REQUIRE_EQUAL(tree.Read(reader), message[i]);
+    }
+    BOOST_CHECK_EQUAL(reader.Tell(), writer.Tell());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(save_load)
+{
+  map<unsigned, size_t> counts = SkewedCounts(40);
+  CanonicalHuffman<unsigned> tree(counts.begin(), counts.end());
+
+  std::FILE *file = std::tmpfile();
+  BOOST_REQUIRE(file);
+  tree.Save(file);
+  std::rewind(file);
+  CanonicalHuffman<unsigned> loaded(file);
+  std::fclose(file);
+
+  vector<unsigned> message = Message(40);
+  string encoded;
+  BitWrapper<> writer(encoded);
+  for (size_t i = 0; i < message.size(); ++i) {
+    tree.Put(writer, message[i]);
+  }
+
+  // decode from the middle of the stream, as PhraseDecoder does for
+  // partially cached collections
+  BitWrapper<> reader(encoded);
+  for (size_t i = 0; i < message.size() / 2; ++i) {
+    loaded.Read(reader);
+  }
+  size_t fromEnd = reader.TellFromEnd();
+  BitWrapper<> resumed(encoded);
+  resumed.SeekFromEnd(fromEnd);
+  for (size_t i = message.size() / 2; i < message.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(loaded.Read(resumed), message[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <boost/functional/hash.hpp>
 #include "ChartHypothesis.h"
 #include "RuleCubeItem.h"
 #include "ChartCell.h"
@@ -37,9 +38,33 @@ using namespace std;
 namespace Moses
 {
 
+void *ChartHypothesis::operator new(size_t num_bytes, ChartManager &manager)
+{
+#ifdef USE_HYPO_POOL
+  return manager.GetHypothesisPool().getPtr();
+#else
+  return ::operator new(num_bytes);
+#endif
+}
+
+void ChartHypothesis::operator delete(void *ptr, ChartManager &manager)
+{
+#ifdef USE_HYPO_POOL
+  manager.GetHypothesisPool().freePtr(static_cast<ChartHypothesis*>(ptr));
+#else
+  ::operator delete(ptr);
+#endif
+}
+
+void ChartHypothesis::Delete(ChartHypothesis *hypo)
+{
 #ifdef USE_HYPO_POOL
-ObjectPool<ChartHypothesis> ChartHypothesis::s_objectPool("ChartHypothesis", 300000);
+  // destructor runs when the slot is reused or the manager's pool is reset
+  hypo->m_manager.GetHypothesisPool().freeObject(hypo);
+#else
+  delete hypo;
 #endif
+}
 
 /** Create a hypothesis from a rule
  * \param transOpt wrapper around the rule
@@ -56,6 +81,7 @@ ChartHypothesis::ChartHypothesis(const ChartTranslationOptions &transOpt,
   ,m_winningHypo(NULL)
   ,m_manager(manager)
   ,m_id(manager.GetNextHypoId())
+  ,m_recombinationHashComputed(false)
 {
   // underlying hypotheses for sub-spans
   const std::vector<HypothesisDimension> &childEntries = item.GetHypothesisDimensions();
@@ -76,6 +102,7 @@ ChartHypothesis::ChartHypothesis(const ChartHypothesis &pred,
   ,m_winningHypo(NULL)
   ,m_manager(pred.m_manager)
   ,m_id(pred.m_manager.GetNextHypoId())
+  ,m_recombinationHashComputed(false)
 {
   // One predecessor, which is an existing top-level ChartHypothesis.
   m_prevHypos.push_back(&pred);
@@ -207,6 +234,19 @@ int ChartHypothesis::RecombineCompare(const ChartHypothesis &compare) const
   return 0;
 }
 
+size_t ChartHypothesis::GetRecombinationHash() const
+{
+  if (!m_recombinationHashComputed) {
+    size_t seed = 0;
+    for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+      boost::hash_combine(seed, m_ffStates[i] ? m_ffStates[i]->hash() : 0);
+    }
+    m_recombinationHash = seed;
+    m_recombinationHashComputed = true;
+  }
+  return m_recombinationHash;
+}
+
 /** calculate total score */
 void ChartHypothesis::EvaluateWhenApplied()
 {
@@ -241,6 +281,18 @@ void ChartHypothesis::EvaluateWhenApplied()
   }
 }
 
+void ChartHypothesis::PrefetchWhenApplied() const
+{
+  const StaticData &staticData = StaticData::Instance();
+  const std::vector<const StatefulFeatureFunction*>& ffs =
+    StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  for (unsigned i = 0; i < ffs.size(); ++i) {
+    if (! staticData.IsFeatureFunctionIgnored( *ffs[i] )) {
+      ffs[i]->PrefetchWhenApplied(*this,i);
+    }
+  }
+}
+
 void ChartHypothesis::AddArc(ChartHypothesis *loserHypo)
 {
   if (!m_arcList) {
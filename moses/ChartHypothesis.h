@@ -49,10 +49,6 @@ class ChartHypothesis
 //  friend class ChartKBestExtractor;
 
 protected:
-#ifdef USE_HYPO_POOL
-  static ObjectPool<ChartHypothesis> s_objectPool;
-#endif
-
   boost::shared_ptr<ChartTranslationOption> m_transOpt;
 
   WordsRange					m_currSourceWordsRange;
@@ -73,6 +69,8 @@ protected:
   ChartManager& m_manager;
 
   unsigned m_id; /* pkoehn wants to log the order in which hypotheses were generated */
+  mutable size_t m_recombinationHash; /*! hash of the FF states, computed on first use */
+  mutable bool m_recombinationHashComputed;
 
   //! not implemented
   ChartHypothesis();
@@ -81,22 +79,16 @@ protected:
   ChartHypothesis(const ChartHypothesis &copy);
 
 public:
-#ifdef USE_HYPO_POOL
-  void *operator new(size_t /* num_bytes */) {
-    void *ptr = s_objectPool.getPtr();
-    return ptr;
+  //! allocate from the per-sentence pool of \param manager if USE_HYPO_POOL is set
+  void *operator new(size_t num_bytes, ChartManager &manager);
+  //! release the memory of a hypothesis whose constructor threw
+  void operator delete(void *ptr, ChartManager &manager);
+  void operator delete(void *ptr) {
+    ::operator delete(ptr);
   }
 
   //! delete \param hypo. Works with object pool too
-  static void Delete(ChartHypothesis *hypo) {
-    s_objectPool.freeObject(hypo);
-  }
-#else
-  //! delete \param hypo. Works with object pool too
-  static void Delete(ChartHypothesis *hypo) {
-    delete hypo;
-  }
-#endif
+  static void Delete(ChartHypothesis *hypo);
 
   ChartHypothesis(const ChartTranslationOptions &, const RuleCubeItem &item,
                   ChartManager &manager);
@@ -148,7 +140,13 @@ public:
 
   int RecombineCompare(const ChartHypothesis &compare) const;
 
+  /** hash of the feature function states.
+   * Hypotheses that RecombineCompare() equal have the same hash. */
+  size_t GetRecombinationHash() const;
+
   void EvaluateWhenApplied();
+  //! let stateful features prefetch what EvaluateWhenApplied() will look up
+  void PrefetchWhenApplied() const;
 
   void AddArc(ChartHypothesis *loserHypo);
   void CleanupArcList();
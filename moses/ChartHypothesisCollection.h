@@ -20,7 +20,7 @@
  ***********************************************************************/
 #pragma once
 
-#include <set>
+#include <boost/unordered_set.hpp>
 #include "ChartHypothesis.h"
 #include "RuleCube.h"
 
@@ -39,10 +39,18 @@ public:
   }
 };
 
-/** functor to compare (chart) hypotheses by feature function states.
- *  If 2 hypos are equal, according to this functor, then they can be recombined.
+/** functors to hash and compare (chart) hypotheses by feature function states.
+ *  If 2 hypos are equal, according to these functors, then they can be recombined.
  */
-class ChartHypothesisRecombinationOrderer
+class ChartHypothesisRecombinationHasher
+{
+public:
+  size_t operator()(const ChartHypothesis* hypo) const {
+    return hypo->GetRecombinationHash();
+  }
+};
+
+class ChartHypothesisRecombinationEqual
 {
 public:
   bool operator()(const ChartHypothesis* hypoA, const ChartHypothesis* hypoB) const {
@@ -52,7 +60,7 @@ public:
     // shouldn't be mixing hypos with different lhs
     assert(hypoA->GetTargetLHS() == hypoB->GetTargetLHS());
 
-    return (hypoA->RecombineCompare(*hypoB) < 0);
+    return hypoA->RecombineCompare(*hypoB) == 0;
   }
 };
 
@@ -64,7 +72,9 @@ class ChartHypothesisCollection
   friend std::ostream& operator<<(std::ostream&, const ChartHypothesisCollection&);
 
 protected:
-  typedef std::set<ChartHypothesis*, ChartHypothesisRecombinationOrderer> HCType;
+  typedef boost::unordered_set<ChartHypothesis*,
+          ChartHypothesisRecombinationHasher,
+          ChartHypothesisRecombinationEqual> HCType;
   HCType m_hypos;
   HypoList m_hyposOrdered;
 
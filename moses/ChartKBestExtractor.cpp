@@ -23,7 +23,7 @@
 #include "ScoreComponentCollection.h"
 #include "StaticData.h"
 
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <vector>
 
@@ -46,8 +46,10 @@ void ChartKBestExtractor::Extract(
   // top-level hypothesis as its predecessor and has the same score.
   std::vector<const ChartHypothesis*>::const_iterator p = topLevelHypos.begin();
   const ChartHypothesis &bestTopLevelHypo = **p;
-  boost::scoped_ptr<ChartHypothesis> supremeHypo(
-    new ChartHypothesis(bestTopLevelHypo, *this));
+  ChartManager &manager = const_cast<ChartManager&>(bestTopLevelHypo.GetManager());
+  boost::shared_ptr<ChartHypothesis> supremeHypo(
+    new (manager) ChartHypothesis(bestTopLevelHypo, *this),
+    &ChartHypothesis::Delete);
 
   // Do the same for each alternative top-level hypothesis, but add the new
   // ChartHypothesis objects as arcs from supremeHypo, as if they had been
@@ -58,7 +60,7 @@ void ChartKBestExtractor::Extract(
                    "top-level hypotheses are not correctly sorted");
     // Note: there's no need for a smart pointer here: supremeHypo will take
     // ownership of altHypo.
-    ChartHypothesis *altHypo = new ChartHypothesis(**p, *this);
+    ChartHypothesis *altHypo = new (manager) ChartHypothesis(**p, *this);
     supremeHypo->AddArc(altHypo);
   }
 
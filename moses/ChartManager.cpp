@@ -48,6 +48,9 @@ extern bool g_mosesDebug;
  */
 ChartManager::ChartManager(ttasksptr const& ttask)
   : BaseManager(ttask)
+#ifdef USE_HYPO_POOL
+  , m_hypoPool("ChartHypothesis", 10000)
+#endif
   , m_hypoStackColl(m_source, *this)
   , m_start(clock())
   , m_hypothesisId(0)
@@ -145,7 +148,7 @@ void ChartManager::AddXmlChartOptions()
     const WordsRange &range = opt->GetSourceWordsRange();
 
     RuleCubeItem* item = new RuleCubeItem( *opt, m_hypoStackColl );
-    ChartHypothesis* hypo = new ChartHypothesis(*opt, *item, *this);
+    ChartHypothesis* hypo = new (*this) ChartHypothesis(*opt, *item, *this);
     hypo->EvaluateWhenApplied();
 
 
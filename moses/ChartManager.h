@@ -44,6 +44,9 @@ class ChartSearchGraphWriter;
 class ChartManager : public BaseManager
 {
 private:
+#ifdef USE_HYPO_POOL
+  ObjectPool<ChartHypothesis> m_hypoPool; /**< owns the hypotheses of this sentence; declared before m_hypoStackColl so it is destroyed after it */
+#endif
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   clock_t m_start; /**< starting time, used for logging */
@@ -103,6 +106,11 @@ private:
 public:
   ChartManager(ttasksptr const& ttask);
   ~ChartManager();
+#ifdef USE_HYPO_POOL
+  ObjectPool<ChartHypothesis> &GetHypothesisPool() {
+    return m_hypoPool;
+  }
+#endif
   void Decode();
   void AddXmlChartOptions();
   const ChartHypothesis *GetBestHypothesis() const;
@@ -0,0 +1,114 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "TranslationModel/CompactPT/CanonicalHuffman.h"
+#include "TranslationModel/CompactPT/Counter.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+typedef Counter<unsigned> SymbolCounter;
+typedef Counter<pair<unsigned char, unsigned char> > AlignCounter;
+
+// batches of counts as the encoding threads produce them: the same
+// symbols recur in many batches, so they end up in several spill files
+template <class C, class MakeData>
+void Count(C &counter, MakeData makeData)
+{
+  for (size_t batch = 0; batch < 50; ++batch) {
+    typename C::FreqMap counts;
+    for (size_t i = 0; i < 40; ++i) {
+      counts[makeData((batch * 31 + i * i) % 97)] += i % 5 + 1;
+    }
+    counter.Merge(counts);
+  }
+  counter.Collect();
+}
+
+unsigned MakeSymbol(size_t i)
+{
+  return i * 1000003u;
+}
+
+pair<unsigned char, unsigned char> MakeAlignPoint(size_t i)
+{
+  return make_pair(i % 11, i / 11);
+}
+
+// the two trees give every symbol the same code
+template <class C, class Tree>
+void CheckSameCodes(const C &counter, Tree &a, Tree &b)
+{
+  for (typename C::iterator it = counter.Begin(); it != counter.End(); ++it) {
+    std::string codeA, codeB;
+    BitWrapper<> writerA(codeA), writerB(codeB);
+    a.Put(writerA, it->first);
+    b.Put(writerB, it->first);
+    BOOST_CHECK_EQUAL(writerA.Tell(), writerB.Tell());
+    BOOST_CHECK(codeA == codeB);
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(counter)
+
+BOOST_AUTO_TEST_CASE(spilled_counts_give_same_codes)
+{
+  SymbolCounter inMemory, spilled;
+  spilled.SetMaxEntries(8, "/tmp/");
+  Count(inMemory, MakeSymbol);
+  Count(spilled, MakeSymbol);
+
+  BOOST_CHECK_EQUAL(inMemory.Size(), 97);
+  BOOST_REQUIRE_EQUAL(spilled.Size(), inMemory.Size());
+  SymbolCounter::iterator a = inMemory.Begin(), b = spilled.Begin();
+  for (; a != inMemory.End(); ++a, ++b) {
+    BOOST_CHECK_EQUAL(a->first, b->first);
+    BOOST_CHECK_EQUAL(a->second, b->second);
+  }
+
+  CanonicalHuffman<unsigned> inMemoryTree(inMemory.Begin(), inMemory.End());
+  CanonicalHuffman<unsigned> spilledTree(spilled.Begin(), spilled.End());
+  CheckSameCodes(inMemory, inMemoryTree, spilledTree);
+}
+
+BOOST_AUTO_TEST_CASE(spilled_align_points)
+{
+  AlignCounter inMemory, spilled;
+  spilled.SetMaxEntries(3, "/tmp/");
+  Count(inMemory, MakeAlignPoint);
+  Count(spilled, MakeAlignPoint);
+
+  BOOST_REQUIRE_EQUAL(spilled.Size(), inMemory.Size());
+  CanonicalHuffman<pair<unsigned char, unsigned char> > inMemoryTree(inMemory.Begin(), inMemory.End());
+  CanonicalHuffman<pair<unsigned char, unsigned char> > spilledTree(spilled.Begin(), spilled.End());
+  CheckSameCodes(inMemory, inMemoryTree, spilledTree);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
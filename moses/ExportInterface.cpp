@@ -272,6 +272,7 @@ batch_run()
   // we are done, finishing up
 #ifdef WITH_THREADS
   pool.Stop(true); //flush remaining jobs
+  IFVERBOSE(1) pool.PrintStats(std::cerr);
 #endif
 
   FeatureFunction::Destroy();
@@ -20,6 +20,9 @@ struct DistortionState_traditional : public FFState {
     if (range.GetEndPos() > o.range.GetEndPos()) return 1;
     return 0;
   }
+  size_t hash() const {
+    return range.GetEndPos();
+  }
 };
 
 std::vector<const DistortionScoreProducer*> DistortionScoreProducer::s_staticColl;
@@ -1,6 +1,7 @@
 #ifndef moses_FFState_h
 #define moses_FFState_h
 
+#include <cstddef>
 #include <vector>
 
 
@@ -12,6 +13,13 @@ class FFState
 public:
   virtual ~FFState();
   virtual int Compare(const FFState& other) const = 0;
+
+  /** Hash used to find recombinable hypotheses. States that Compare()
+   * equal must have the same hash. The default puts all states in one
+   * bucket, so recombination falls back to Compare() for them. */
+  virtual size_t hash() const {
+    return 0;
+  }
 };
 
 class DummyState : public FFState
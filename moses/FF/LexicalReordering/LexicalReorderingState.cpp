@@ -1,6 +1,7 @@
 // -*- c++ -*-
 #include <vector>
 #include <string>
+#include <boost/functional/hash.hpp>
 
 #include "moses/FF/FFState.h"
 #include "moses/Hypothesis.h"
@@ -289,6 +290,21 @@ ComparePrevScores(const TranslationOption *other) const
   return 0;
 }
 
+size_t
+LRState::
+HashPrevScores() const
+{
+  // the initial state has no previous option
+  if (m_prevOption == NULL) return 0;
+
+  LexicalReordering* producer = m_configuration.GetScoreProducer();
+  const Scores* myScores = m_prevOption->GetLexReorderingScores(producer);
+  if (myScores == NULL) return 0;
+
+  size_t stop = m_offset + m_configuration.GetNumberOfTypes();
+  return boost::hash_range(myScores->begin() + m_offset, myScores->begin() + stop);
+}
+
 // ===========================================================================
 // PHRASE BASED REORDERING STATE
 // ===========================================================================
@@ -331,6 +347,17 @@ Compare(const FFState& o) const
   return 1;
 }
 
+size_t
+PhraseBasedReorderingState::
+hash() const
+{
+  size_t seed = hash_value(m_prevRange);
+  if (m_direction == LRModel::Forward) {
+    boost::hash_combine(seed, HashPrevScores());
+  }
+  return seed;
+}
+
 LRState*
 PhraseBasedReorderingState::
 Expand(const TranslationOption& topt, const InputType& input,
@@ -365,6 +392,15 @@ Compare(FFState const& o) const
   return (cmp < 0) ? -1 : cmp ? 1 : m_forward->Compare(*other.m_forward);
 }
 
+size_t
+BidirectionalReorderingState::
+hash() const
+{
+  size_t seed = m_backward->hash();
+  boost::hash_combine(seed, m_forward->hash());
+  return seed;
+}
+
 LRState*
 BidirectionalReorderingState::
 Expand(const TranslationOption& topt, const InputType& input,
@@ -400,6 +436,13 @@ Compare(const FFState& o) const
   return m_reoStack.Compare(other.m_reoStack);
 }
 
+size_t
+HReorderingBackwardState::
+hash() const
+{
+  return m_reoStack.hash();
+}
+
 LRState*
 HReorderingBackwardState::
 Expand(const TranslationOption& topt, const InputType& input,
@@ -451,6 +494,15 @@ Compare(const FFState& o) const
           : (m_prevRange < other.m_prevRange) ? -1 : 1);
 }
 
+size_t
+HReorderingForwardState::
+hash() const
+{
+  size_t seed = hash_value(m_prevRange);
+  boost::hash_combine(seed, HashPrevScores());
+  return seed;
+}
+
 // For compatibility with the phrase-based reordering model, scoring is one
 // step delayed.
 // The forward model takes determines orientations heuristically as follows:
@@ -147,6 +147,10 @@ public:
   int
   Compare(const FFState& o) const = 0;
 
+  virtual
+  size_t
+  hash() const = 0;
+
   virtual
   LRState*
   Expand(const TranslationOption& hypo, const InputType& input,
@@ -197,6 +201,10 @@ protected:
 
   int
   ComparePrevScores(const TranslationOption *other) const;
+
+  //! hash consistent with ComparePrevScores()
+  size_t
+  HashPrevScores() const;
 };
 
 //! @todo what is this?
@@ -226,6 +234,10 @@ public:
   int
   Compare(const FFState& o) const;
 
+  virtual
+  size_t
+  hash() const;
+
   virtual
   LRState*
   Expand(const TranslationOption& topt, const InputType& input,
@@ -253,6 +265,10 @@ public:
   int
   Compare(const FFState& o) const;
 
+  virtual
+  size_t
+  hash() const;
+
   virtual
   LRState*
   Expand(const TranslationOption& topt,const InputType& input,
@@ -278,6 +294,7 @@ public:
                            ReorderingStack reoStack);
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LRState* Expand(const TranslationOption& hypo, const InputType& input,
                           ScoreComponentCollection*  scores) const;
 
@@ -304,6 +321,7 @@ public:
                           const TranslationOption &topt);
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LRState* Expand(const TranslationOption& hypo,
                           const InputType& input,
                           ScoreComponentCollection* scores) const;
@@ -1,5 +1,6 @@
 #include "osmHyp.h"
 #include <sstream>
+#include <boost/functional/hash.hpp>
 
 using namespace std;
 using namespace lm::ngram;
@@ -39,6 +40,16 @@ int osmState::Compare(const FFState& otherBase) const
   return 0;
 }
 
+size_t osmState::hash() const
+{
+  // only the length of the LM state takes part in Compare()
+  size_t seed = j;
+  boost::hash_combine(seed, E);
+  boost::hash_combine(seed, boost::hash_range(gap.begin(), gap.end()));
+  boost::hash_combine(seed, lmState.length);
+  return seed;
+}
+
 
 std::string osmState :: getName() const
 {
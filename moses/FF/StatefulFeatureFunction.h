@@ -7,6 +7,7 @@
 namespace Moses
 {
 class FFState;
+class TranslationOptionList;
 
 /** base class for all stateful feature functions.
  * eg. LM, distortion penalty
@@ -58,6 +59,24 @@ public:
     return 0; /* FIXME */
   }
 
+  /**
+   * \brief Optional hint, called before a batch of EvaluateWhenApplied() calls.
+   * A hypothesis whose state for this feature is \param prev_state is about
+   * to be extended with each of \param options. Features that look things up
+   * in large tables can prefetch them here so that the lookups in
+   * EvaluateWhenApplied() hit the cache.
+   */
+  virtual void PrefetchWhenApplied(
+    const FFState* /* prev_state */,
+    const TranslationOptionList& /* options */) const {
+  }
+
+  //! as above, for a chart hypothesis that is about to be evaluated
+  virtual void PrefetchWhenApplied(
+    const ChartHypothesis& /* cur_hypo */,
+    int /* featureID - used to index the state in the previous hypotheses */) const {
+  }
+
   //! return the state associated with the empty hypothesis for a given sentence
   virtual const FFState* EmptyHypothesisState(const InputType &input) const = 0;
 
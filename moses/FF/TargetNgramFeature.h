@@ -24,6 +24,7 @@ public:
     return m_words;
   }
   virtual int Compare(const FFState& other) const;
+  virtual size_t hash() const;
 
 private:
   std::vector<Word> m_words;
@@ -171,6 +172,18 @@ public:
     }
     return 0;
   }
+
+  size_t hash() const {
+    // same context as Compare()
+    size_t seed = 0;
+    if (m_startPos > 0) {
+      boost::hash_combine(seed, GetPrefix());
+    }
+    if (m_endPos < m_inputSize - 1) {
+      boost::hash_combine(seed, GetSuffix());
+    }
+    return seed;
+  }
 };
 
 /** Sets the features of observed ngrams.
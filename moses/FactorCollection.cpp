@@ -23,10 +23,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifdef WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif
+#include <cstring>
+#include <new>
 #include <ostream>
 #include <string>
 #include "FactorCollection.h"
 #include "Util.h"
+#include "util/murmur_hash.hh"
 #include "util/pool.hh"
 
 using namespace std;
@@ -35,52 +38,99 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
-const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+FactorCollection::FactorSet::FactorSet()
+  : size(0)
 {
-  FactorFriend to_ins;
-  to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  // If we're threaded, hope a read-only lock is sufficient.
-#ifdef WITH_THREADS
-  {
-    // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
+  current.Store(new Table(16));
+}
+
+FactorCollection::FactorSet::~FactorSet()
+{
+  delete current.Load();
+  for (size_t i = 0; i < retired.size(); ++i) {
+    delete retired[i];
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
-      factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    } else {
-      m_factorId++;
+}
+
+const Factor *FactorCollection::Find(const FactorSet &set, const StringPiece &factorString, size_t hash)
+{
+  const Table &table = *set.current.Load();
+  for (size_t slot = hash & table.mask; ; slot = (slot + 1) & table.mask) {
+    const Factor *factor = table.slots[slot].factor.Load();
+    if (factor == NULL) {
+      return NULL;
+    }
+    if (table.slots[slot].hash == hash && factor->GetString() == factorString) {
+      return factor;
     }
   }
-  return &ret.first->in;
 }
 
-const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+void FactorCollection::Place(Table &table, const Factor *factor, size_t hash)
 {
-  FactorFriend to_find;
-  to_find.in.m_string = factorString;
-  to_find.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  {
-    // read=lock scope
+  size_t slot = hash & table.mask;
+  while (table.slots[slot].factor.Load() != NULL) {
+    slot = (slot + 1) & table.mask;
+  }
+  table.slots[slot].hash = hash;
+  table.slots[slot].factor.Store(factor);
+}
+
+const Factor *FactorCollection::Insert(FactorSet &set, const StringPiece &factorString, size_t hash, bool isNonTerminal)
+{
+  Table *table = set.current.Load();
+  if (2 * (set.size + 1) > table->mask + 1) {
+    // readers may still be probing the old table, so fill a new one
+    // completely before publishing it
+    Table *bigger = new Table(2 * (table->mask + 1));
+    for (size_t slot = 0; slot <= table->mask; ++slot) {
+      const Factor *factor = table->slots[slot].factor.Load();
+      if (factor != NULL) {
+        Place(*bigger, factor, table->slots[slot].hash);
+      }
+    }
+    set.current.Store(bigger);
+    set.retired.push_back(table);
+    table = bigger;
+  }
+
+  // all factors are the same size, so the pool keeps them aligned
+  FactorFriend *ins = new (m_factor_backing.Allocate(sizeof(FactorFriend))) FactorFriend();
+  ins->in.m_string.set(
+    memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
+    factorString.size());
+  if (isNonTerminal) {
+    ins->in.m_id = m_factorIdNonTerminal++;
+    UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+  } else {
+    ins->in.m_id = m_factorId++;
+  }
+
+  Place(*table, &ins->in, hash);
+  ++set.size;
+  return &ins->in;
+}
+
+const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  FactorSet &set = (isNonTerminal) ? m_nonTerminals : m_terminals;
+  size_t hash = util::MurmurHashNative(factorString.data(), factorString.size());
+  const Factor *factor = Find(set, factorString, hash);
+  if (factor != NULL) return factor;
+
 #ifdef WITH_THREADS
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
+  boost::mutex::scoped_lock lock(m_insertLock);
+  // another thread may have added it since we looked
+  factor = Find(set, factorString, hash);
+  if (factor != NULL) return factor;
 #endif // WITH_THREADS
-    Set::const_iterator i = set.find(to_find);
-    if (i != set.end()) return &i->in;
-  }
-  return NULL;
+  return Insert(set, factorString, hash, isNonTerminal);
+}
+
+const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  const FactorSet &set = (isNonTerminal) ? m_nonTerminals : m_terminals;
+  return Find(set, factorString, util::MurmurHashNative(factorString.data(), factorString.size()));
 }
 
 
@@ -91,15 +141,15 @@ TO_STRING_BODY(FactorCollection);
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
-#endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+  const FactorCollection::FactorSet *sets[] = { &factorCollection.m_nonTerminals, &factorCollection.m_terminals };
+  for (size_t i = 0; i < 2; ++i) {
+    const FactorCollection::Table &table = *sets[i]->current.Load();
+    for (size_t slot = 0; slot <= table.mask; ++slot) {
+      const Factor *factor = table.slots[slot].factor.Load();
+      if (factor != NULL) out << *factor;
+    }
   }
   return out;
 }
 
 }
-
-
@@ -28,14 +28,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
 
-#include "util/murmur_hash.hh"
-#include <boost/unordered_set.hpp>
+#include <boost/scoped_array.hpp>
 
-#include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "util/pool.hh"
@@ -62,31 +62,78 @@ struct FactorFriend {
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * Looking up a factor that already exists takes no lock and writes nothing
+ * shared, so AddFactor() can be called freely from decoding threads. Only
+ * adding a new factor is serialised.
  */
 class FactorCollection
 {
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const FactorFriend &factor) const {
-      return util::MurmurHashNative(factor.in.m_string.data(), factor.in.m_string.size());
+  //! pointer that is stored by one thread and loaded by many without a lock
+  template <class T> class PublishedPtr
+  {
+  public:
+    PublishedPtr() : m_ptr(NULL) {}
+#ifdef WITH_THREADS
+    T *Load() const {
+      return m_ptr.load(boost::memory_order_acquire);
     }
-  };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
+    void Store(T *ptr) {
+      m_ptr.store(ptr, boost::memory_order_release);
+    }
+  private:
+    boost::atomic<T*> m_ptr;
+#else
+    T *Load() const {
+      return m_ptr;
     }
+    void Store(T *ptr) {
+      m_ptr = ptr;
+    }
+  private:
+    T *m_ptr;
+#endif
+  };
+
+  struct Slot {
+    Slot() : hash(0) {}
+    PublishedPtr<const Factor> factor; //! NULL while the slot is empty
+    size_t hash; //! MurmurHash of the factor's string, written before factor
+  };
+
+  //! open addressing table with linear probing, at most half full
+  struct Table {
+    explicit Table(size_t size) : mask(size - 1), slots(new Slot[size]) {}
+    size_t mask;
+    boost::scoped_array<Slot> slots;
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
 
+  /** the factors of one kind (terminal or non-terminal).
+   * A slot is filled once and never changes afterwards. A full table is
+   * replaced by a bigger copy instead of being rehashed in place, so readers
+   * can probe whichever table they loaded. Replaced tables are kept until the
+   * collection is destroyed since readers may still be using them.
+   */
+  struct FactorSet {
+    FactorSet();
+    ~FactorSet();
+    PublishedPtr<Table> current;
+    size_t size;
+    std::vector<Table*> retired;
+  };
+
+  FactorSet m_terminals;
+  FactorSet m_nonTerminals;
+
+  util::Pool m_factor_backing;
   util::Pool m_string_backing;
 
   static FactorCollection s_instance;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  //! serialises insertions. Lookups don't need it
+  boost::mutex m_insertLock;
 #endif
 
   size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
@@ -98,6 +145,11 @@ class FactorCollection
     , m_factorId(moses_MaxNumNonterminals) {
   }
 
+  static const Factor *Find(const FactorSet &set, const StringPiece &factorString, size_t hash);
+  //! add a factor known not to be in set. Must hold m_insertLock
+  const Factor *Insert(FactorSet &set, const StringPiece &factorString, size_t hash, bool isNonTerminal);
+  static void Place(Table &table, const Factor *factor, size_t hash);
+
 public:
   static FactorCollection& Instance() {
     return s_instance;
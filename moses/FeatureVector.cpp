@@ -163,15 +163,99 @@ bool FName::operator!=(const FName& rhs) const
   return ! (*this == rhs);
 }
 
+void FValueArray::resize(size_t newSize)
+{
+  if (newSize == m_size) return;
+  FValueArray resized(newSize);
+  std::copy(data(), data() + min(m_size, newSize), resized.data());
+  swap(*this, resized);
+}
+
+FValue FValueArray::sum() const
+{
+  const FValue *values = data();
+  FValue sum = 0;
+  for (size_t i = 0; i < m_size; ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+void swap(FValueArray &first, FValueArray &second)
+{
+  if (first.IsInline() && second.IsInline()) {
+    FValue temp[INLINE_CORE_FEATURES];
+    std::copy(first.m_inline, first.m_inline + first.m_size, temp);
+    std::copy(second.m_inline, second.m_inline + second.m_size, first.m_inline);
+    std::copy(temp, temp + first.m_size, second.m_inline);
+  } else if (!first.IsInline() && !second.IsInline()) {
+    std::swap(first.m_heap, second.m_heap);
+  } else {
+    FValueArray &inlined = first.IsInline() ? first : second;
+    FValueArray &heaped = first.IsInline() ? second : first;
+    FValue *heap = heaped.m_heap;
+    std::copy(inlined.m_inline, inlined.m_inline + inlined.m_size, heaped.m_inline);
+    inlined.m_heap = heap;
+  }
+  std::swap(first.m_size, second.m_size);
+}
+
+// Kernels over the core features. The loops have no dependencies between
+// iterations (or, for the dot product, four independent sums), so the
+// compiler turns them into SIMD instructions.
+
+static void addCore(FValue *lhs, const FValue *rhs, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    lhs[i] += rhs[i];
+  }
+}
+
+static void subtractCore(FValue *lhs, const FValue *rhs, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    lhs[i] -= rhs[i];
+  }
+}
+
+static void scaleCore(FValue *lhs, FValue scalar, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    lhs[i] *= scalar;
+  }
+}
+
+static FValue dotCore(const FValue *lhs, const FValue *rhs, size_t size)
+{
+  FValue sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    sum0 += lhs[i] * rhs[i];
+    sum1 += lhs[i + 1] * rhs[i + 1];
+    sum2 += lhs[i + 2] * rhs[i + 2];
+    sum3 += lhs[i + 3] * rhs[i + 3];
+  }
+  for (; i < size; ++i) {
+    sum0 += lhs[i] * rhs[i];
+  }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+static bool lessName(const pair<FName, FValue> &lhs, const FName &rhs)
+{
+  return lhs.first < rhs;
+}
+
+static bool lessEntry(const pair<FName, FValue> &lhs, const pair<FName, FValue> &rhs)
+{
+  return lhs.first < rhs.first;
+}
+
 FVector::FVector(size_t coreFeatures) : m_coreFeatures(coreFeatures) {}
 
 void FVector::resize(size_t newsize)
 {
-  valarray<FValue> oldValues(m_coreFeatures);
   m_coreFeatures.resize(newsize);
-  for (size_t i = 0; i < min(m_coreFeatures.size(), oldValues.size()); ++i) {
-    m_coreFeatures[i] = oldValues[i];
-  }
 }
 
 void FVector::clear()
@@ -197,8 +281,9 @@ bool FVector::load(const std::string& filename)
     linestream >> value;
     FName fname(namestring);
     //cerr << "Setting sparse weight " << fname << " to value " << value << "." << endl;
-    set(fname,value);
+    m_features.push_back(make_pair(fname, value));
   }
+  sortSparse();
   return true;
 }
 
@@ -303,10 +388,28 @@ ostream& operator<<(ostream& out, const FVector& fv)
   return fv.print(out);
 }
 
+FVector::const_iterator FVector::find(const FName& name) const
+{
+  const_iterator fi = lower_bound(m_features.begin(), m_features.end(), name, lessName);
+  if (fi != m_features.end() && fi->first == name) {
+    return fi;
+  }
+  return m_features.end();
+}
+
+FVector::iterator FVector::lowerBound(const FName& name)
+{
+  // sparse features are mostly added in order of their ids
+  if (m_features.empty() || m_features.back().first < name) {
+    return m_features.end();
+  }
+  return lower_bound(m_features.begin(), m_features.end(), name, lessName);
+}
+
 const FValue& FVector::get(const FName& name) const
 {
   static const FValue DEFAULT = 0;
-  const_iterator fi = m_features.find(name);
+  const_iterator fi = find(name);
   if (fi == m_features.end()) {
     return DEFAULT;
   } else {
@@ -316,7 +419,7 @@ const FValue& FVector::get(const FName& name) const
 
 FValue FVector::getBackoff(const FName& name, float backoff) const
 {
-  const_iterator fi = m_features.find(name);
+  const_iterator fi = find(name);
   if (fi == m_features.end()) {
     return backoff;
   } else {
@@ -352,7 +455,80 @@ void FVector::capMin(FValue minValue)
 
 void FVector::set(const FName& name, const FValue& value)
 {
-  m_features[name] = value;
+  getRef(name) = value;
+}
+
+FValue& FVector::getRef(const FName& name)
+{
+  iterator fi = lowerBound(name);
+  if (fi == m_features.end() || fi->first != name) {
+    fi = m_features.insert(fi, make_pair(name, FValue(0)));
+  }
+  return fi->second;
+}
+
+void FVector::erase(const FName& name)
+{
+  iterator fi = lowerBound(name);
+  if (fi != m_features.end() && fi->first == name) {
+    m_features.erase(fi);
+  }
+}
+
+void FVector::sparseAdd(const FVector& rhs, FValue scale)
+{
+  if (rhs.m_features.empty()) return;
+
+  // count the names that only rhs has
+  size_t added = 0;
+  const_iterator l = m_features.begin(), r = rhs.m_features.begin();
+  while (r != rhs.m_features.end()) {
+    if (l == m_features.end() || r->first < l->first) {
+      ++added;
+      ++r;
+    } else if (l->first < r->first) {
+      ++l;
+    } else {
+      ++l;
+      ++r;
+    }
+  }
+
+  // merge in place from the back, so no new list is allocated unless the
+  // capacity runs out. Entries in front of the first name of rhs are not
+  // touched. rhs may be *this, then nothing is added.
+  size_t oldSize = m_features.size();
+  m_features.resize(oldSize + added, rhs.m_features.front());
+  FNVList::iterator out = m_features.end();
+  FNVList::iterator left = m_features.begin() + oldSize;
+  FNVList::const_iterator right = rhs.m_features.end();
+  while (right != rhs.m_features.begin()) {
+    if (left != m_features.begin() && (right - 1)->first < (left - 1)->first) {
+      *--out = *--left;
+    } else if (left != m_features.begin() && (left - 1)->first == (right - 1)->first) {
+      --left;
+      --right;
+      *--out = make_pair(left->first, left->second + scale * right->second);
+    } else {
+      --right;
+      *--out = make_pair(right->first, scale * right->second);
+    }
+  }
+}
+
+void FVector::sortSparse()
+{
+  // stable, so that of equal names the one appended last comes last
+  stable_sort(m_features.begin(), m_features.end(), lessEntry);
+  FNVList::iterator out = m_features.begin();
+  for (FNVList::iterator in = m_features.begin(); in != m_features.end(); ++in) {
+    if (out != m_features.begin() && (out - 1)->first == in->first) {
+      (out - 1)->second = in->second;
+    } else {
+      *out++ = *in;
+    }
+  }
+  m_features.erase(out, m_features.end());
 }
 
 void FVector::printCoreFeatures()
@@ -371,18 +547,15 @@ FVector& FVector::operator+= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  sparseAdd(rhs, 1);
+  addCore(m_coreFeatures.data(), rhs.m_coreFeatures.data(), rhs.m_coreFeatures.size());
   return *this;
 }
 
 // add only sparse features
 void FVector::sparsePlusEquals(const FVector& rhs)
 {
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
+  sparseAdd(rhs, 1);
 }
 
 // add only core features
@@ -390,8 +563,7 @@ void FVector::corePlusEquals(const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  addCore(m_coreFeatures.data(), rhs.m_coreFeatures.data(), rhs.m_coreFeatures.size());
 }
 
 // assign only core features
@@ -452,7 +624,7 @@ size_t FVector::pruneSparseFeatures(size_t threshold)
   }
 
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    erase(toErase[i]);
 
   return count;
 }
@@ -472,7 +644,7 @@ size_t FVector::pruneZeroWeightFeatures()
   }
 
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    erase(toErase[i]);
 
   return count;
 }
@@ -549,13 +721,8 @@ FVector& FVector::operator-= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) -(i->second));
-  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    if (i < rhs.m_coreFeatures.size()) {
-      m_coreFeatures[i] -= rhs.m_coreFeatures[i];
-    }
-  }
+  sparseAdd(rhs, -1);
+  subtractCore(m_coreFeatures.data(), rhs.m_coreFeatures.data(), rhs.m_coreFeatures.size());
   return *this;
 }
 
@@ -609,7 +776,7 @@ FVector& FVector::operator*= (const FValue& rhs)
   for (iterator i = begin(); i != end(); ++i) {
     i->second *= rhs;
   }
-  m_coreFeatures *= rhs;
+  scaleCore(m_coreFeatures.data(), rhs, m_coreFeatures.size());
   return *this;
 }
 
@@ -618,7 +785,9 @@ FVector& FVector::operator/= (const FValue& rhs)
   for (iterator i = begin(); i != end(); ++i) {
     i->second /= rhs;
   }
-  m_coreFeatures /= rhs;
+  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
+    m_coreFeatures[i] /= rhs;
+  }
   return *this;
 }
 
@@ -727,7 +896,7 @@ size_t FVector::l1regularize(float lambda)
 
   // erase features that have become zero
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    erase(toErase[i]);
   numberPruned -= size();
   return numberPruned;
 }
@@ -777,7 +946,7 @@ size_t FVector::sparseL1regularize(float lambda)
 
   // erase features that have become zero
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    erase(toErase[i]);
   numberPruned -= size();
   return numberPruned;
 }
@@ -810,9 +979,7 @@ FValue FVector::inner_product(const FVector& rhs) const
   for (const_iterator i = cbegin(); i != cend(); ++i) {
     product += ((i->second)*(rhs.get(i->first)));
   }
-  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    product += m_coreFeatures[i]*rhs.m_coreFeatures[i];
-  }
+  product += dotCore(m_coreFeatures.data(), rhs.m_coreFeatures.data(), m_coreFeatures.size());
   return product;
 }
 
@@ -830,11 +997,11 @@ void FVector::merge(const FVector &other)
   }
 
   // sparse
-  FNVmap::const_iterator iter;
+  const_iterator iter;
   for (iter = other.m_features.begin(); iter != other.m_features.end(); ++iter) {
     const FName  &otherKey = iter->first;
     const FValue otherVal = iter->second;
-    m_features[otherKey] = otherVal;
+    set(otherKey, otherVal);
   }
 }
 
@@ -22,11 +22,12 @@
 #ifndef FEATUREVECTOR_H
 #define FEATUREVECTOR_H
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
-#include <valarray>
+#include <utility>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -37,7 +38,6 @@
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
-#include <boost/serialization/valarray.hpp>
 #endif
 
 #ifdef WITH_THREADS
@@ -87,6 +87,10 @@ struct FName {
 
   bool operator==(const FName& rhs) const ;
   bool operator!=(const FName& rhs) const ;
+  //! orders by id, which is what FVector keeps its sparse features sorted by
+  bool operator<(const FName& rhs) const {
+    return m_id < rhs.m_id;
+  }
 
   static size_t getId(const std::string& name);
   static size_t getHopeIdCount(const std::string& name);
@@ -121,6 +125,88 @@ struct FNameHash
 
 class ProxyFVector;
 
+#ifndef INLINE_CORE_FEATURES
+#define INLINE_CORE_FEATURES 24
+#endif
+
+/**
+ * Values of the core features of an FVector. Up to INLINE_CORE_FEATURES
+ * values are stored inline, so copying the scores of a model with no more
+ * dense features than that doesn't allocate. Bigger arrays go on the heap.
+ **/
+class FValueArray
+{
+public:
+  explicit FValueArray(size_t size = 0) : m_size(size) {
+    FValue *values = Allocate(size);
+    std::fill(values, values + size, FValue(0));
+  }
+
+  FValueArray(const FValueArray &other) : m_size(other.m_size) {
+    FValue *values = Allocate(m_size);
+    std::copy(other.data(), other.data() + m_size, values);
+  }
+
+  ~FValueArray() {
+    if (!IsInline()) delete [] m_heap;
+  }
+
+  FValueArray &operator=(const FValueArray &other) {
+    if (this != &other) {
+      if (other.m_size != m_size) {
+        if (!IsInline()) delete [] m_heap;
+        m_size = other.m_size;
+        Allocate(m_size);
+      }
+      std::copy(other.data(), other.data() + m_size, data());
+    }
+    return *this;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  FValue *data() {
+    return IsInline() ? m_inline : m_heap;
+  }
+  const FValue *data() const {
+    return IsInline() ? m_inline : m_heap;
+  }
+
+  FValue &operator[](size_t index) {
+    return data()[index];
+  }
+  FValue operator[](size_t index) const {
+    return data()[index];
+  }
+
+  //! change the size, keeping existing values. New values are 0
+  void resize(size_t newSize);
+
+  FValue sum() const;
+
+  friend void swap(FValueArray &first, FValueArray &second);
+
+private:
+  size_t m_size;
+  union {
+    FValue m_inline[INLINE_CORE_FEATURES];
+    FValue *m_heap;
+  };
+
+  bool IsInline() const {
+    return m_size <= INLINE_CORE_FEATURES;
+  }
+
+  //! set up storage for m_size values, which must be equal to size
+  FValue *Allocate(size_t size) {
+    if (size <= INLINE_CORE_FEATURES) return m_inline;
+    m_heap = new FValue[size];
+    return m_heap;
+  }
+};
+
 /**
  * A sparse feature (or weight) vector.
  **/
@@ -141,10 +227,12 @@ public:
   **/
   void resize(size_t newsize);
 
-  typedef boost::unordered_map<FName,FValue,FNameHash, FNameEquals> FNVmap;
+  /** Sparse features, sorted by name. Only allocated once a sparse
+   * feature is set, so dense-only vectors copy without allocating. */
+  typedef std::vector<std::pair<FName,FValue> > FNVList;
   /** Iterators */
-  typedef FNVmap::iterator iterator;
-  typedef FNVmap::const_iterator const_iterator;
+  typedef FNVList::iterator iterator;
+  typedef FNVList::const_iterator const_iterator;
   iterator begin() {
     return m_features.begin();
   }
@@ -152,14 +240,14 @@ public:
     return m_features.end();
   }
   const_iterator cbegin() const {
-    return m_features.cbegin();
+    return m_features.begin();
   }
   const_iterator cend() const {
-    return m_features.cend();
+    return m_features.end();
   }
 
   bool hasNonDefaultValue(FName name) const {
-    return m_features.find(name) != m_features.end();
+    return find(name) != m_features.end();
   }
   void clear();
 
@@ -184,7 +272,7 @@ public:
     return m_coreFeatures.size();
   }
 
-  const std::valarray<FValue> &getCoreFeatures() const {
+  const FValueArray &getCoreFeatures() const {
     return m_coreFeatures;
   }
 
@@ -271,9 +359,20 @@ private:
   const FValue& get(const FName& name) const;
   FValue getBackoff(const FName& name, float backoff) const;
   void set(const FName& name, const FValue& value);
+  //! value of name, inserted as 0 if not there yet
+  FValue& getRef(const FName& name);
+  void erase(const FName& name);
+
+  const_iterator find(const FName& name) const;
+  //! first sparse feature not ordered before name
+  iterator lowerBound(const FName& name);
+  //! add scale * rhs to the sparse features, merging the two sorted lists
+  void sparseAdd(const FVector& rhs, FValue scale);
+  //! restore the order after appending unsorted; later values win
+  void sortSparse();
 
-  FNVmap m_features;
-  std::valarray<FValue> m_coreFeatures;
+  FNVList m_features;
+  FValueArray m_coreFeatures;
 
 #ifdef MPI_ENABLE
   //serialization
@@ -287,9 +386,11 @@ private:
       names.push_back(ostr.str());
       values.push_back(i->second);
     }
+    std::vector<FValue> coreFeatures(m_coreFeatures.data(),
+                                     m_coreFeatures.data() + m_coreFeatures.size());
     ar << names;
     ar << values;
-    ar << m_coreFeatures;
+    ar << coreFeatures;
   }
 
   template<class Archive>
@@ -297,9 +398,12 @@ private:
     clear();
     std::vector<std::string> names;
     std::vector<FValue> values;
+    std::vector<FValue> coreFeatures;
     ar >> names;
     ar >> values;
-    ar >> m_coreFeatures;
+    ar >> coreFeatures;
+    m_coreFeatures.resize(coreFeatures.size());
+    std::copy(coreFeatures.begin(), coreFeatures.end(), m_coreFeatures.data());
     UTIL_THROW_IF2(names.size() != values.size(), "Error");
     for (size_t i = 0; i < names.size(); ++i) {
       set(FName(names[i]), values[i]);
@@ -367,15 +471,15 @@ public:
    }*/
 
   FValue operator++() {
-    return ++m_fv->m_features[m_name];
+    return ++m_fv->getRef(m_name);
   }
 
   FValue operator +=(FValue lhs) {
-    return (m_fv->m_features[m_name] += lhs);
+    return (m_fv->getRef(m_name) += lhs);
   }
 
   FValue operator -=(FValue lhs) {
-    return (m_fv->m_features[m_name] -= lhs);
+    return (m_fv->getRef(m_name) -= lhs);
   }
 
 private:
@@ -307,5 +307,84 @@ BOOST_AUTO_TEST_CASE(ip)
 }
 
 
+BOOST_AUTO_TEST_CASE(core_resize)
+{
+  // grow from inline storage to the heap and back, keeping values
+  FVector f1(2);
+  f1[0] = 1.5;
+  f1[1] = -2;
+  f1.resize(INLINE_CORE_FEATURES + 10);
+  BOOST_CHECK_EQUAL(f1.coreSize(), INLINE_CORE_FEATURES + 10);
+  BOOST_CHECK_CLOSE((FValue)f1[0], 1.5, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[1], -2, TOL);
+  BOOST_CHECK_EQUAL(f1[INLINE_CORE_FEATURES + 9], 0);
+
+  f1[INLINE_CORE_FEATURES + 9] = 3;
+  FVector f2(f1);
+  FVector f3(1);
+  swap(f2, f3);
+  BOOST_CHECK_EQUAL(f2.coreSize(), 1);
+  BOOST_CHECK_CLOSE((FValue)f3[INLINE_CORE_FEATURES + 9], 3, TOL);
+
+  f3 += f1;
+  BOOST_CHECK_CLOSE((FValue)f3[0], 3, TOL);
+  f3.resize(2);
+  BOOST_CHECK_EQUAL(f3.coreSize(), 2);
+  BOOST_CHECK_CLOSE((FValue)f3[1], -4, TOL);
+}
+
+BOOST_AUTO_TEST_CASE(sparse_order)
+{
+  // names set in any order are looked up and summed by name
+  FName n1("order_a");
+  FName n2("order_b");
+  FName n3("order_c");
+  FVector f1, f2;
+  f1[n3] = 3;
+  f1[n1] = 1;
+  f2[n2] = 2;
+  f2[n3] = 1;
+  f1 += f2;
+  BOOST_CHECK_EQUAL(f1.size(), 3);
+  BOOST_CHECK_CLOSE((FValue)f1[n1], 1, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n2], 2, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n3], 4, TOL);
+  BOOST_CHECK(!f2.hasNonDefaultValue(n1));
+}
+
+BOOST_AUTO_TEST_CASE(sparse_merge)
+{
+  // interleaved names, names only on one side, and adding a vector to itself
+  FName n[6] = {FName("merge_a"), FName("merge_b"), FName("merge_c"),
+                FName("merge_d"), FName("merge_e"), FName("merge_f")
+               };
+  FVector f1, f2;
+  f1[n[1]] = 1;
+  f1[n[3]] = 3;
+  f1[n[4]] = 4;
+  f2[n[0]] = 10;
+  f2[n[3]] = 30;
+  f2[n[5]] = 50;
+  f1 -= f2;
+  BOOST_CHECK_EQUAL(f1.size(), 5);
+  BOOST_CHECK_CLOSE((FValue)f1[n[0]], -10, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n[1]], 1, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n[3]], -27, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n[4]], 4, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n[5]], -50, TOL);
+
+  f1 += f1;
+  BOOST_CHECK_EQUAL(f1.size(), 5);
+  BOOST_CHECK_CLOSE((FValue)f1[n[3]], -54, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[n[5]], -100, TOL);
+
+  // iteration still sees the names in order
+  FName prev = f1.cbegin()->first;
+  for (FVector::const_iterator i = ++f1.cbegin(); i != f1.cend(); ++i) {
+    BOOST_CHECK(prev < i->first);
+    prev = i->first;
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -38,16 +38,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/FF/StatelessFeatureFunction.h"
 
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 
 using namespace std;
 
 namespace Moses
 {
 
-#ifdef USE_HYPO_POOL
-ObjectPool<Hypothesis> Hypothesis::s_objectPool("Hypothesis", 300000);
-#endif
-
 Hypothesis::
 Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt)
   : m_prevHypo(NULL)
@@ -65,6 +62,7 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   , m_transOpt(initialTransOpt)
   , m_manager(manager)
   , m_id(m_manager.GetNextHypoId())
+  , m_recombinationHashComputed(false)
 {
   // used for initial seeding of trans process
   // initialize scores
@@ -73,7 +71,6 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   const vector<const StatefulFeatureFunction*>& ffs = StatefulFeatureFunction::GetStatefulFeatureFunctions();
   for (unsigned i = 0; i < ffs.size(); ++i)
     m_ffStates[i] = ffs[i]->EmptyHypothesisState(source);
-  m_manager.GetSentenceStats().AddCreated();
 }
 
 /***
@@ -96,6 +93,7 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt)
   , m_transOpt(transOpt)
   , m_manager(prevHypo.GetManager())
   , m_id(m_manager.GetNextHypoId())
+  , m_recombinationHashComputed(false)
 {
   m_currScoreBreakdown.PlusEquals(transOpt.GetScoreBreakdown());
 
@@ -106,7 +104,6 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt)
   //_hash_computed = false;
   m_sourceCompleted.SetValue(m_currSourceWordsRange.GetStartPos(), m_currSourceWordsRange.GetEndPos(), true);
   m_wordDeleted = transOpt.IsDeletionOption();
-  m_manager.GetSentenceStats().AddCreated();
 }
 
 Hypothesis::
@@ -172,8 +169,14 @@ Create(const Hypothesis &prevHypo, const TranslationOption &transOpt)
 {
 
 #ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
-  return new(ptr) Hypothesis(prevHypo, transOpt);
+  ObjectPool<Hypothesis> &pool = prevHypo.GetManager().GetHypothesisPool();
+  Hypothesis *ptr = pool.getPtr();
+  try {
+    return new(ptr) Hypothesis(prevHypo, transOpt);
+  } catch (...) {
+    pool.freePtr(ptr);
+    throw;
+  }
 #else
   return new Hypothesis(prevHypo, transOpt);
 #endif
@@ -188,13 +191,31 @@ Create(Manager& manager, InputType const& m_source,
        const TranslationOption &initialTransOpt)
 {
 #ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
-  return new(ptr) Hypothesis(manager, m_source, initialTransOpt);
+  ObjectPool<Hypothesis> &pool = manager.GetHypothesisPool();
+  Hypothesis *ptr = pool.getPtr();
+  try {
+    return new(ptr) Hypothesis(manager, m_source, initialTransOpt);
+  } catch (...) {
+    pool.freePtr(ptr);
+    throw;
+  }
 #else
   return new Hypothesis(manager, m_source, initialTransOpt);
 #endif
 }
 
+void
+Hypothesis::
+Delete(Hypothesis *hypo)
+{
+#ifdef USE_HYPO_POOL
+  // the destructor runs when the slot is reused or the manager's pool is reset
+  hypo->GetManager().GetHypothesisPool().freeObject(hypo);
+#else
+  delete hypo;
+#endif
+}
+
 /** check, if two hypothesis can be recombined.
     this is actually a sorting function that allows us to
     keep an ordered list of hypotheses. This makes recombination
@@ -224,6 +245,21 @@ RecombineCompare(const Hypothesis &compare) const
   return 0;
 }
 
+size_t
+Hypothesis::
+GetRecombinationHash() const
+{
+  if (!m_recombinationHashComputed) {
+    size_t seed = m_sourceCompleted.hash();
+    for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+      boost::hash_combine(seed, m_ffStates[i] ? m_ffStates[i]->hash() : 0);
+    }
+    m_recombinationHash = seed;
+    m_recombinationHashComputed = true;
+  }
+  return m_recombinationHash;
+}
+
 void
 Hypothesis::
 EvaluateWhenApplied(StatefulFeatureFunction const& sfff,
@@ -303,6 +339,20 @@ EvaluateWhenApplied(const SquareMatrix &futureScore)
   }
 }
 
+void
+Hypothesis::
+PrefetchWhenApplied(const TranslationOptionList &options) const
+{
+  const StaticData &staticData = StaticData::Instance();
+  const vector<const StatefulFeatureFunction*>& ffs =
+    StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  for (unsigned i = 0; i < ffs.size(); ++i) {
+    if (! staticData.IsFeatureFunctionIgnored(*ffs[i])) {
+      ffs[i]->PrefetchWhenApplied(m_ffStates[i], options);
+    }
+  }
+}
+
 const Hypothesis* Hypothesis::GetPrevHypo()const
 {
   return m_prevHypo;
@@ -49,6 +49,7 @@ namespace Moses
 class SquareMatrix;
 class StaticData;
 class TranslationOption;
+class TranslationOptionList;
 class WordsRange;
 class Hypothesis;
 class FFState;
@@ -71,8 +72,6 @@ class Hypothesis
   friend std::ostream& operator<<(std::ostream&, const Hypothesis&);
 
 protected:
-  static ObjectPool<Hypothesis> s_objectPool;
-
   const Hypothesis* m_prevHypo; /*! backpointer to previous hypothesis (from which this one was created) */
 //	const Phrase			&m_targetPhrase; /*! target phrase being created at the current decoding step */
   WordsBitmap				m_sourceCompleted; /*! keeps track of which words have been translated so far */
@@ -94,6 +93,8 @@ protected:
   Manager& m_manager;
 
   int m_id; /*! numeric ID of this hypothesis, used for logging */
+  mutable size_t m_recombinationHash; /*! hash of coverage and FF states, computed on first use */
+  mutable bool m_recombinationHashComputed;
 
   /*! used by initial seeding of the translation process */
   Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt);
@@ -101,12 +102,12 @@ protected:
   Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
 public:
-  static ObjectPool<Hypothesis> &GetObjectPool() {
-    return s_objectPool;
-  }
-
   ~Hypothesis();
 
+  /** release \param hypo. With USE_HYPO_POOL the memory is returned to the
+   * per-sentence pool of its manager, otherwise it is deleted */
+  static void Delete(Hypothesis *hypo);
+
   /** return the subclass of Hypothesis most appropriate to the given translation option */
   static Hypothesis* Create(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
@@ -148,9 +149,16 @@ public:
 
   void EvaluateWhenApplied(const SquareMatrix &futureScore);
 
+  //! let stateful features prefetch for extending this hypothesis with each of \param options
+  void PrefetchWhenApplied(const TranslationOptionList &options) const;
+
   int GetId()const {
     return m_id;
   }
+  //! renumber, used to give hypotheses built in parallel their sequential ids
+  void SetId(int id) {
+    m_id = id;
+  }
 
   const Hypothesis* GetPrevHypo() const;
 
@@ -199,6 +207,10 @@ public:
 
   int RecombineCompare(const Hypothesis &compare) const;
 
+  /** hash of the source coverage and the feature function states.
+   * Hypotheses that RecombineCompare() equal have the same hash. */
+  size_t GetRecombinationHash() const;
+
   void GetOutputPhrase(Phrase &out) const;
 
   void ToStream(std::ostream& out) const {
@@ -306,17 +318,7 @@ struct CompareHypothesisTotalScore {
   }
 };
 
-#ifdef USE_HYPO_POOL
-
-#define FREEHYPO(hypo) \
-{ \
-	ObjectPool<Hypothesis> &pool = Hypothesis::GetObjectPool(); \
-	pool.freeObject(hypo); \
-} \
-
-#else
-#define FREEHYPO(hypo) delete hypo
-#endif
+#define FREEHYPO(hypo) Hypothesis::Delete(hypo)
 
 /** defines less-than relation on hypotheses.
 * The particular order is not important for us, we need just to figure out
@@ -0,0 +1,146 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2015 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "HypothesisRecombinationTable.h"
+#include "Hypothesis.h"
+#include "TypeDef.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+HypothesisRecombinationTable::Slot::Slot()
+  : hash(0), pos(NOT_FOUND)
+{}
+
+pair<HypothesisRecombinationTable::iterator, bool>
+HypothesisRecombinationTable::insert(Hypothesis *hypo)
+{
+  if (2 * (m_hypos.size() + 1) > m_slots.size()) {
+    Grow();
+  }
+
+  size_t hash = hypo->GetRecombinationHash();
+  size_t slot = FindSlot(*hypo, hash);
+  if (m_slots[slot].pos != NOT_FOUND) {
+    return make_pair(m_hypos.begin() + m_slots[slot].pos, false);
+  }
+
+  m_slots[slot].hash = hash;
+  m_slots[slot].pos = m_hypos.size();
+  m_hypos.push_back(hypo);
+  return make_pair(m_hypos.end() - 1, true);
+}
+
+HypothesisRecombinationTable::iterator
+HypothesisRecombinationTable::find(const Hypothesis *hypo)
+{
+  size_t slot = FindSlot(*hypo, hypo->GetRecombinationHash());
+  if (m_slots[slot].pos == NOT_FOUND) {
+    return m_hypos.end();
+  }
+  return m_hypos.begin() + m_slots[slot].pos;
+}
+
+void HypothesisRecombinationTable::erase(iterator iter)
+{
+  size_t pos = iter - m_hypos.begin();
+  size_t last = m_hypos.size() - 1;
+
+  ClearSlot(FindSlotOf(pos));
+  if (pos != last) {
+    m_slots[FindSlotOf(last)].pos = pos;
+    m_hypos[pos] = m_hypos[last];
+  }
+  m_hypos.pop_back();
+}
+
+void HypothesisRecombinationTable::clear()
+{
+  m_hypos.clear();
+  m_slots.assign(m_slots.size(), Slot());
+}
+
+size_t HypothesisRecombinationTable::FindSlot(const Hypothesis &hypo, size_t hash) const
+{
+  size_t mask = m_slots.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    const Slot &current = m_slots[slot];
+    if (current.pos == NOT_FOUND) {
+      return slot;
+    }
+    if (current.hash == hash && m_hypos[current.pos]->RecombineCompare(hypo) == 0) {
+      return slot;
+    }
+  }
+}
+
+size_t HypothesisRecombinationTable::FindSlotOf(size_t pos) const
+{
+  size_t mask = m_slots.size() - 1;
+  size_t slot = m_hypos[pos]->GetRecombinationHash() & mask;
+  while (m_slots[slot].pos != pos) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/** empty a slot and shift later members of its probe sequence back, so
+ * that lookups never need tombstones */
+void HypothesisRecombinationTable::ClearSlot(size_t slot)
+{
+  size_t mask = m_slots.size() - 1;
+  size_t next = slot;
+  for (;;) {
+    m_slots[slot] = Slot();
+    for (;;) {
+      next = (next + 1) & mask;
+      if (m_slots[next].pos == NOT_FOUND) {
+        return;
+      }
+      // leave the entry where it is if its home slot lies cyclically in (slot, next]
+      size_t home = m_slots[next].hash & mask;
+      bool inRange = (slot <= next) ? (slot < home && home <= next)
+                     : (slot < home || home <= next);
+      if (!inRange) {
+        break;
+      }
+    }
+    m_slots[slot] = m_slots[next];
+    slot = next;
+  }
+}
+
+void HypothesisRecombinationTable::Grow()
+{
+  m_slots.assign(m_slots.size() * 2, Slot());
+  size_t mask = m_slots.size() - 1;
+  for (size_t pos = 0; pos < m_hypos.size(); ++pos) {
+    size_t hash = m_hypos[pos]->GetRecombinationHash();
+    size_t slot = hash & mask;
+    while (m_slots[slot].pos != NOT_FOUND) {
+      slot = (slot + 1) & mask;
+    }
+    m_slots[slot].hash = hash;
+    m_slots[slot].pos = pos;
+  }
+}
+
+}
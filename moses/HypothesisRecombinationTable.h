@@ -0,0 +1,104 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2015 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#ifndef moses_HypothesisRecombinationTable_h
+#define moses_HypothesisRecombinationTable_h
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Moses
+{
+
+class Hypothesis;
+
+/** The hypotheses of a phrase-based stack, indexed for recombination.
+ *
+ * Hypotheses are kept in a dense vector. An open-addressing table with
+ * linear probing maps Hypothesis::GetRecombinationHash() to positions in
+ * that vector. Two hypotheses are equivalent if their hashes are equal and
+ * RecombineCompare() returns 0, so Compare() of the FF states is only
+ * called on hash matches.
+ *
+ * The interface follows the subset of std::set that the stacks use, with
+ * one difference: erase() moves the last hypothesis into the erased
+ * position, so erasing invalidates iterators to the last element.
+ */
+class HypothesisRecombinationTable
+{
+public:
+  typedef std::vector<Hypothesis*>::iterator iterator;
+  typedef std::vector<Hypothesis*>::const_iterator const_iterator;
+
+  HypothesisRecombinationTable() : m_slots(16) {}
+
+  iterator begin() {
+    return m_hypos.begin();
+  }
+  iterator end() {
+    return m_hypos.end();
+  }
+  const_iterator begin() const {
+    return m_hypos.begin();
+  }
+  const_iterator end() const {
+    return m_hypos.end();
+  }
+  size_t size() const {
+    return m_hypos.size();
+  }
+  bool empty() const {
+    return m_hypos.empty();
+  }
+
+  /** add hypo, unless an equivalent hypothesis is already in the table.
+   * \return position of hypo or of the equivalent hypothesis, and whether
+   *         hypo was added */
+  std::pair<iterator, bool> insert(Hypothesis *hypo);
+
+  //! position of the hypothesis equivalent to hypo, or end()
+  iterator find(const Hypothesis *hypo);
+
+  //! remove the hypothesis at iter without deleting it
+  void erase(iterator iter);
+
+  void clear();
+
+private:
+  struct Slot {
+    Slot();
+    size_t hash;
+    size_t pos; //! index into m_hypos, NOT_FOUND for an empty slot
+  };
+
+  std::vector<Hypothesis*> m_hypos;
+  std::vector<Slot> m_slots; //! size is a power of 2, at most half full
+
+  //! slot holding a hypothesis equivalent to hypo, or the empty slot where it belongs
+  size_t FindSlot(const Hypothesis &hypo, size_t hash) const;
+  //! slot pointing to position pos of m_hypos
+  size_t FindSlotOf(size_t pos) const;
+  void ClearSlot(size_t slot);
+  void Grow();
+};
+
+}
+
+#endif
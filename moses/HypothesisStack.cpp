@@ -6,8 +6,8 @@ namespace Moses
 HypothesisStack::~HypothesisStack()
 {
   // delete all hypos
-  while (m_hypos.begin() != m_hypos.end()) {
-    Remove(m_hypos.begin());
+  while (!m_hypos.empty()) {
+    Remove(m_hypos.end() - 1);
   }
 }
 
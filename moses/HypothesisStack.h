@@ -2,8 +2,8 @@
 #define moses_HypothesisStack_h
 
 #include <vector>
-#include <set>
 #include "Hypothesis.h"
+#include "HypothesisRecombinationTable.h"
 #include "WordsBitmap.h"
 
 namespace Moses
@@ -18,7 +18,7 @@ class HypothesisStack
 {
 
 protected:
-  typedef std::set< Hypothesis*, HypothesisRecombinationOrderer > _HCType;
+  typedef HypothesisRecombinationTable _HCType;
   _HCType m_hypos; /**< contains hypotheses */
   Manager& m_manager;
 
@@ -51,7 +51,8 @@ public:
   virtual const Hypothesis *GetBestHypothesis() const = 0;
   virtual std::vector<const Hypothesis*> GetSortedList() const = 0;
 
-  //! remove hypothesis pointed to by iterator but don't delete the object
+  /** remove hypothesis pointed to by iterator but don't delete the object.
+   * The last hypothesis of the stack takes its place, so iterators to it become invalid */
   virtual void Detach(const HypothesisStack::iterator &iter);
   /** destroy Hypothesis pointed to by iterator (object pool version) */
   virtual void Remove(const HypothesisStack::iterator &iter);
@@ -20,8 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <algorithm>
-#include <set>
-#include <queue>
+#include <functional>
 #include "HypothesisStackCubePruning.h"
 #include "TypeDef.h"
 #include "Util.h"
@@ -156,41 +155,39 @@ void HypothesisStackCubePruning::PruneToSize(size_t newSize)
   if ( newSize == 0) return; // no limit
 
   if (m_hypos.size() > newSize) { // ok, if not over the limit
-    priority_queue<float> bestScores;
-
-    // push all scores to a heap
-    // (but never push scores below m_bestScore+m_beamWidth)
-    iterator iter = m_hypos.begin();
-    float score = 0;
-    while (iter != m_hypos.end()) {
-      Hypothesis *hypo = *iter;
-      score = hypo->GetTotalScore();
+    vector<float> bestScores;
+    bestScores.reserve(m_hypos.size());
+
+    // collect all scores
+    // (but never collect scores below m_bestScore+m_beamWidth)
+    iterator iter;
+    for (iter = m_hypos.begin(); iter != m_hypos.end(); ++iter) {
+      float score = (*iter)->GetTotalScore();
       if (score > m_bestScore+m_beamWidth) {
-        bestScores.push(score);
+        bestScores.push_back(score);
       }
-      ++iter;
     }
 
-    // pop the top newSize scores (and ignore them, these are the scores of hyps that will remain)
-    //  ensure to never pop beyond heap size
-    size_t minNewSizeHeapSize = newSize > bestScores.size() ? bestScores.size() : newSize;
-    for (size_t i = 1 ; i < minNewSizeHeapSize ; i++)
-      bestScores.pop();
-
-    // and remember the threshold
-    float scoreThreshold = bestScores.top();
+    // the threshold is the newSize-th best score
+    //  ensure to never go beyond the number of scores
+    float scoreThreshold = m_bestScore;
+    if (!bestScores.empty()) {
+      size_t minNewSize = newSize > bestScores.size() ? bestScores.size() : newSize;
+      vector<float>::iterator nth = bestScores.begin() + (minNewSize - 1);
+      nth_element(bestScores.begin(), nth, bestScores.end(), greater<float>());
+      scoreThreshold = *nth;
+    }
 
-    // delete all hypos under score threshold
-    iter = m_hypos.begin();
-    while (iter != m_hypos.end()) {
-      Hypothesis *hypo = *iter;
-      float score = hypo->GetTotalScore();
-      if (score < scoreThreshold) {
-        iterator iterRemove = iter++;
-        Remove(iterRemove);
+    // delete all hypos under score threshold.
+    // Remove() moves the last hypo into the freed position, so look at it again
+    size_t pos = 0;
+    while (pos < m_hypos.size()) {
+      iterator iterHypo = m_hypos.begin() + pos;
+      if ((*iterHypo)->GetTotalScore() < scoreThreshold) {
+        Remove(iterHypo);
         m_manager.GetSentenceStats().AddPruning();
       } else {
-        ++iter;
+        ++pos;
       }
     }
     VERBOSE(3,", pruned to size " << size() << endl);
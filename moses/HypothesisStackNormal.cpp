@@ -20,8 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <algorithm>
-#include <set>
-#include <queue>
+#include <boost/unordered_map.hpp>
 #include "HypothesisStackNormal.h"
 #include "TypeDef.h"
 #include "Util.h"
@@ -44,8 +43,8 @@ HypothesisStackNormal::HypothesisStackNormal(Manager& manager) :
 /** remove all hypotheses from the collection */
 void HypothesisStackNormal::RemoveAll()
 {
-  while (m_hypos.begin() != m_hypos.end()) {
-    Remove(m_hypos.begin());
+  while (!m_hypos.empty()) {
+    Remove(m_hypos.end() - 1);
   }
 }
 
@@ -156,33 +155,68 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
   if ( newSize == 0) return; // no limit
   if ( size() <= newSize ) return; // ok, if not over the limit
 
+  if ( m_minHypoStackDiversity == 0 ) {
+    PruneToSizeByScore(newSize);
+  } else {
+    PruneToSizeWithDiversity(newSize);
+  }
+
+  // some reporting....
+  VERBOSE(3,", pruned to size " << size() << endl);
+  IFVERBOSE(3) {
+    TRACE_ERR("stack now contains: ");
+    for(iterator iter = m_hypos.begin(); iter != m_hypos.end(); iter++) {
+      Hypothesis *hypo = *iter;
+      TRACE_ERR( hypo->GetId() << " (" << hypo->GetTotalScore() << ") ");
+    }
+    TRACE_ERR( endl);
+  }
+}
+
+/** without diversity constraints only the newSize best hypotheses matter,
+ * so partition around the newSize-th score instead of sorting the stack */
+void HypothesisStackNormal::PruneToSizeByScore(size_t newSize)
+{
+  vector< Hypothesis* > hypos(m_hypos.begin(), m_hypos.end());
+  m_hypos.clear();
+
+  nth_element(hypos.begin(), hypos.begin() + (newSize - 1), hypos.end(),
+              CompareHypothesisTotalScore());
+
+  size_t kept = 0;
+  for(size_t i=0; i<hypos.size(); i++) {
+    Hypothesis *hypo = hypos[i];
+    if (i < newSize && hypo->GetTotalScore() > m_bestScore+m_beamWidth) {
+      m_hypos.insert( hypo );
+      ++kept;
+    } else {
+      FREEHYPO( hypo );
+      m_manager.GetSentenceStats().AddPruning();
+    }
+  }
+  if (kept == newSize)
+    m_worstScore = hypos[newSize - 1]->GetTotalScore();
+}
+
+void HypothesisStackNormal::PruneToSizeWithDiversity(size_t newSize)
+{
   // we need to store a temporary list of hypotheses
   vector< Hypothesis* > hypos = GetSortedListNOTCONST();
-  bool* included = (bool*) malloc(sizeof(bool) * hypos.size());
-  for(size_t i=0; i<hypos.size(); i++) included[i] = false;
+  vector< bool > included(hypos.size(), false);
 
   // clear out original set
-  for( iterator iter = m_hypos.begin(); iter != m_hypos.end(); ) {
-    iterator removeHyp = iter++;
-    Detach(removeHyp);
-  }
+  m_hypos.clear();
 
   // add best hyps for each coverage according to minStackDiversity
-  if ( m_minHypoStackDiversity > 0 ) {
-    map< WordsBitmapID, size_t > diversityCount;
-    for(size_t i=0; i<hypos.size(); i++) {
-      Hypothesis *hyp = hypos[i];
-      WordsBitmapID coverage = hyp->GetWordsBitmap().GetID();;
-      if (diversityCount.find( coverage ) == diversityCount.end())
-        diversityCount[ coverage ] = 0;
-
-      if (diversityCount[ coverage ] < m_minHypoStackDiversity) {
-        m_hypos.insert( hyp );
-        included[i] = true;
-        diversityCount[ coverage ]++;
-        if (diversityCount[ coverage ] == m_minHypoStackDiversity)
-          SetWorstScoreForBitmap( coverage, hyp->GetTotalScore());
-      }
+  boost::unordered_map< WordsBitmapID, size_t > diversityCount;
+  for(size_t i=0; i<hypos.size(); i++) {
+    Hypothesis *hyp = hypos[i];
+    size_t &count = diversityCount[ hyp->GetWordsBitmap().GetID() ];
+    if (count < m_minHypoStackDiversity) {
+      m_hypos.insert( hyp );
+      included[i] = true;
+      if (++count == m_minHypoStackDiversity)
+        SetWorstScoreForBitmap( hyp->GetWordsBitmap().GetID(), hyp->GetTotalScore());
     }
   }
 
@@ -209,18 +243,6 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
       m_manager.GetSentenceStats().AddPruning();
     }
   }
-  free(included);
-
-  // some reporting....
-  VERBOSE(3,", pruned to size " << size() << endl);
-  IFVERBOSE(3) {
-    TRACE_ERR("stack now contains: ");
-    for(iterator iter = m_hypos.begin(); iter != m_hypos.end(); iter++) {
-      Hypothesis *hypo = *iter;
-      TRACE_ERR( hypo->GetId() << " (" << hypo->GetTotalScore() << ") ");
-    }
-    TRACE_ERR( endl);
-  }
 }
 
 const Hypothesis *HypothesisStackNormal::GetBestHypothesis() const
@@ -23,7 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_HypothesisStackNormal_h
 
 #include <limits>
-#include <set>
+#include <boost/unordered_map.hpp>
 #include "Hypothesis.h"
 #include "HypothesisStack.h"
 #include "WordsBitmap.h"
@@ -42,7 +42,7 @@ public:
 protected:
   float m_bestScore; /**< score of the best hypothesis in collection */
   float m_worstScore; /**< score of the worse hypothesis in collection */
-  std::map< WordsBitmapID, float > m_diversityWorstScore; /**< score of worst hypothesis for particular source word coverage */
+  boost::unordered_map< WordsBitmapID, float > m_diversityWorstScore; /**< score of worst hypothesis for particular source word coverage */
   float m_beamWidth; /**< minimum score due to threashold pruning */
   size_t m_maxHypoStackSize; /**< maximum number of hypothesis allowed in this stack */
   size_t m_minHypoStackDiversity; /**< minimum number of hypothesis with different source word coverage */
@@ -56,15 +56,19 @@ protected:
   /** destroy all instances of Hypothesis in this collection */
   void RemoveAll();
 
+  void PruneToSizeByScore(size_t newSize);
+  void PruneToSizeWithDiversity(size_t newSize);
+
   void SetWorstScoreForBitmap( WordsBitmapID id, float worstScore ) {
     m_diversityWorstScore[ id ] = worstScore;
   }
 
 public:
   float GetWorstScoreForBitmap( WordsBitmapID id ) {
-    if (m_diversityWorstScore.find( id ) == m_diversityWorstScore.end())
+    boost::unordered_map< WordsBitmapID, float >::const_iterator iter = m_diversityWorstScore.find( id );
+    if (iter == m_diversityWorstScore.end())
       return -std::numeric_limits<float>::infinity();
-    return m_diversityWorstScore[ id ];
+    return iter->second;
   }
   virtual float GetWorstScoreForBitmap( const WordsBitmap &coverage ) {
     return GetWorstScoreForBitmap( coverage.GetID() );
@@ -55,6 +55,9 @@ public:
 
   FFState *Evaluate(const Phrase &phrase, const FFState *ps, float &returnedScore) const;
 
+  //! the forward prefetch would misread the backward state
+  virtual void PrefetchWhenApplied(const FFState * /*ps*/, const TranslationOptionList &/*options*/) const {}
+
 private:
 
   // These lines are required to make the parent class's protected members visible to this class
@@ -38,6 +38,9 @@ public:
   }
 
   int Compare(const FFState& other) const;
+  size_t hash() const {
+    return m_hash;
+  }
 };
 
 class BilingualLM : public StatefulFeatureFunction
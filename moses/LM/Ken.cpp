@@ -43,6 +43,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/InputFileStream.h"
 #include "moses/StaticData.h"
 #include "moses/ChartHypothesis.h"
+#include "moses/TranslationOption.h"
+#include "moses/TranslationOptionList.h"
 #include "moses/Incremental.h"
 #include "moses/Syntax/SVertex.h"
 
@@ -61,6 +63,9 @@ struct KenLMState : public FFState {
     if (state.length > other.state.length) return 1;
     return std::memcmp(state.words, other.state.words, sizeof(lm::WordIndex) * state.length);
   }
+  size_t hash() const {
+    return lm::ngram::hash_value(state, state.length);
+  }
 };
 
 ///*
@@ -289,6 +294,33 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
   return ret.release();
 }
 
+template <class Model> void LanguageModelKen<Model>::PrefetchWhenApplied(const FFState *ps, const TranslationOptionList &options) const
+{
+  const lm::ngram::State &in_state = static_cast<const KenLMState&>(*ps).state;
+  const std::size_t maxWords = m_ngram->Order() - 1;
+
+  // Holds the target words of an option in reverse order, followed by the
+  // words of in_state, so that the context of each word is a suffix of it.
+  lm::WordIndex context[2 * KENLM_MAX_ORDER];
+  for (TranslationOptionList::const_iterator iter = options.begin(); iter != options.end(); ++iter) {
+    const TargetPhrase &target = (*iter)->GetTargetPhrase();
+    // only these words are scored one by one in EvaluateWhenApplied()
+    const std::size_t size = std::min(target.GetSize(), maxWords);
+    if (!size) continue;
+
+    lm::WordIndex *const inStateBegin = context + size - 1;
+    std::copy(in_state.words, in_state.words + in_state.length, inStateBegin);
+    lm::WordIndex *const contextEnd = inStateBegin + in_state.length;
+    for (std::size_t i = 0; i < size; ++i) {
+      const lm::WordIndex id = TranslateID(target.GetWord(i));
+      m_ngram->Prefetch(inStateBegin - i, contextEnd, id);
+      if (i + 1 < size) {
+        *(inStateBegin - i - 1) = id;
+      }
+    }
+  }
+}
+
 class LanguageModelChartStateKenLM : public FFState
 {
 public:
@@ -307,10 +339,50 @@ public:
     return ret;
   }
 
+  size_t hash() const {
+    return lm::ngram::hash_value(m_state);
+  }
+
 private:
   lm::ngram::ChartState m_state;
 };
 
+template <class Model> void LanguageModelKen<Model>::PrefetchWhenApplied(const ChartHypothesis& hypo, int featureID) const
+{
+  const TargetPhrase &target = hypo.GetCurrTargetPhrase();
+  const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
+    target.GetAlignNonTerm().GetNonTermIndexMap();
+  const std::size_t maxContext = m_ngram->Order() - 1;
+
+  // Only the terminals are prefetched. Their context is the preceding
+  // terminals, most recent first, followed by the right state of the
+  // non-terminal before them. Lookups that extend a non-terminal's left
+  // state are left to EvaluateWhenApplied().
+  lm::WordIndex context[KENLM_MAX_ORDER];
+  std::size_t length = 0;
+  for (size_t phrasePos = 0; phrasePos < target.GetSize(); ++phrasePos) {
+    const Word &word = target.GetWord(phrasePos);
+    if (word.IsNonTerminal()) {
+      const ChartHypothesis *prevHypo = hypo.GetPrevHypo(nonTermIndexMap[phrasePos]);
+      const lm::ngram::State &right = static_cast<const LanguageModelChartStateKenLM*>(prevHypo->GetFFState(featureID))->GetChartState().right;
+      length = right.length;
+      std::copy(right.words, right.words + length, context);
+      continue;
+    }
+
+    lm::WordIndex id;
+    if (phrasePos == 0 && word.GetFactor(m_factorType) == m_beginSentenceFactor) {
+      id = m_ngram->GetVocabulary().BeginSentence();
+    } else {
+      id = TranslateID(word);
+      m_ngram->Prefetch(context, context + length, id);
+    }
+    length = std::min(length + 1, maxContext);
+    std::copy_backward(context, context + length - 1, context + length);
+    context[0] = id;
+  }
+}
+
 template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const
 {
   LanguageModelChartStateKenLM *newState = new LanguageModelChartStateKenLM();
@@ -61,6 +61,10 @@ public:
 
   virtual FFState *EvaluateWhenApplied(const Syntax::SHyperedge& hyperedge, int featureID, ScoreComponentCollection *accumulator) const;
 
+  virtual void PrefetchWhenApplied(const FFState *ps, const TranslationOptionList &options) const;
+
+  virtual void PrefetchWhenApplied(const ChartHypothesis& cur_hypo, int featureID) const;
+
   virtual void IncrementalCallback(Incremental::Manager &manager) const;
   virtual void ReportHistoryOrder(std::ostream &out,const Phrase &phrase) const;
 
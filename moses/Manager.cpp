@@ -64,9 +64,15 @@ namespace Moses
 
 Manager::Manager(ttasksptr const& ttask)
   : BaseManager(ttask)
+#ifdef USE_HYPO_POOL
+  , m_hypoPool("Hypothesis", 10000)
+#endif
   , interrupted_flag(0)
   , m_hypoId(0)
 {
+#ifdef WITH_THREADS
+  m_threadedExpansion = options().search.expansion_threads > 1;
+#endif
   boost::shared_ptr<InputType> source = ttask->GetSource();
   m_transOptColl = source->CreateTranslationOptionCollection(ttask);
 
@@ -80,8 +86,13 @@ Manager::Manager(ttasksptr const& ttask)
 
 Manager::~Manager()
 {
-  delete m_transOptColl;
   delete m_search;
+#ifdef USE_HYPO_POOL
+  // release all hypotheses of this sentence in one step, before the
+  // translation options they point to go away
+  m_hypoPool.reset();
+#endif
+  delete m_transOptColl;
   StaticData::Instance().CleanUpAfterSentenceProcessing(m_ttask.lock());
 }
 
@@ -1460,8 +1471,17 @@ const Hypothesis *Manager::GetBestHypothesis() const
   return m_search->GetBestHypothesis();
 }
 
+/** called once for every hypothesis that is created */
 int Manager::GetNextHypoId()
 {
+#ifdef WITH_THREADS
+  if (m_threadedExpansion) {
+    boost::mutex::scoped_lock lock(m_hypoIdMutex);
+    GetSentenceStats().AddCreated();
+    return m_hypoId++;
+  }
+#endif
+  GetSentenceStats().AddCreated();
   return m_hypoId++;
 }
 
@@ -112,6 +112,9 @@ private:
 
 protected:
   // data
+#ifdef USE_HYPO_POOL
+  ObjectPool<Hypothesis> m_hypoPool; /**< owns the hypotheses of this sentence; reset in ~Manager() after m_search is deleted */
+#endif
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
@@ -119,6 +122,10 @@ protected:
   size_t interrupted_flag;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   int m_hypoId; //used to number the hypos as they are created.
+#ifdef WITH_THREADS
+  bool m_threadedExpansion; //! hypotheses may be created by several threads
+  boost::mutex m_hypoIdMutex;
+#endif
 
   void GetConnectedGraph(
     std::map< int, bool >* pConnected,
@@ -168,6 +175,11 @@ public:
   void GetOutputLanguageModelOrder( std::ostream &out, const Hypothesis *hypo ) const;
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+#ifdef USE_HYPO_POOL
+  ObjectPool<Hypothesis> &GetHypothesisPool() {
+    return m_hypoPool;
+  }
+#endif
 
   void OutputLatticeMBRNBest(std::ostream& out, const std::vector<LatticeMBRSolution>& solutions,long translationId) const;
   void OutputBestHypo(const std::vector<Moses::Word>&  mbrBestHypo, long /*translationId*/,
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <deque>
+#include <set>
 #include <string>
 #include <iostream>
 #include <iterator>
@@ -32,6 +33,7 @@ private:
   std::vector<Object*> data;
   std::vector<size_t> dataSize;
   std::deque<Object*> freeObj;
+  std::vector<Object*> rawObj;
   int mode;
 public:
   static const int cleanUpOnDestruction=1;
@@ -63,6 +65,11 @@ public:
   // WARNING: use only if you know what you are doing !
   // useful for non-default constructors, you have to use placement new
   Object* getPtr() {
+    if(rawObj.size()) {
+      Object* rv=rawObj.back();
+      rawObj.pop_back();
+      return rv;
+    }
     if(freeObj.size()) {
       Object* rv=freeObj.back();
       freeObj.pop_back();
@@ -83,6 +90,11 @@ public:
   void freeObject(Object* x) {
     freeObj.push_back(x);
   }
+  // return memory from 'getPtr' that holds no object, e.g. because the
+  // constructor threw; it is neither destroyed nor passed to 'destroyObjects'
+  void freePtr(Object* x) {
+    rawObj.push_back(x);
+  }
   template<class fwiter> void freeObjects(fwiter b,fwiter e) {
     for(; b!=e; ++b) this->free(*b);
   }
@@ -93,6 +105,7 @@ public:
     idx=0;
     dIdx=0;
     freeObj.clear();
+    rawObj.clear();
   }
   // destroy all objects and free memory
   void cleanUp() {
@@ -118,9 +131,11 @@ public:
 private:
   void destroyObjects() {
     if(mode & hasTrivialDestructor) return;
+    std::set<Object*> raw(rawObj.begin(),rawObj.end());
     for(size_t i=0; i<=dIdx; ++i) {
       size_t lastJ= (i<dIdx ? dataSize[i] : idx);
-      for(size_t j=0; j<lastJ; ++j) (data[i]+j)->~Object();
+      for(size_t j=0; j<lastJ; ++j)
+        if(raw.empty() || !raw.count(data[i]+j)) (data[i]+j)->~Object();
     }
   }
   // allocate memory for a N objects, for follow-up allocations,
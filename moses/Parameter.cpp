@@ -81,6 +81,7 @@ Parameter::Parameter()
   AddParam(search_opts,"early-discarding-threshold", "edt", "threshold for constructing hypotheses based on estimate cost");
   AddParam(search_opts,"stack", "s", "maximum stack size for histogram pruning. 0 = unlimited stack size");
   AddParam(search_opts,"stack-diversity", "sd", "minimum number of hypothesis of each coverage in stack (default 0)");
+  AddParam(search_opts,"stack-expansion-threads", "number of threads expanding the hypotheses of one stack in parallel (normal search without early discarding; default 1)");
 
   // feature weight-related options
   AddParam(search_opts,"weight-file", "wf", "feature weights file. Do *not* put weights for 'core' features in here - they go in moses.ini");
@@ -219,6 +220,20 @@ Parameter::Parameter()
   AddParam(server_opts,"session-cache-size", string("Max. number of sessions cached.")
            +"Least recently used session is dumped first.");
   AddParam(server_opts,"serial", "Run server in serial mode, processing only one request at a time.");
+  AddParam(server_opts,"server-max-connections",
+           "Max. number of open connections, including idle ones (default 4 * threads)");
+  AddParam(server_opts,"server-queue-size",
+           "Max. number of requests waiting for a decoder thread; further requests are rejected (default 4 * threads, 0 = unbounded)");
+  AddParam(server_opts,"server-request-timeout",
+           "Default deadline for translation requests, e.g. '30s'; requests may set their own 'timeout' in seconds (default 0 = none)");
+  AddParam(server_opts,"server-keepalive-timeout",
+           "Time an idle keep-alive connection is kept open (default 15s)");
+  AddParam(server_opts,"server-io-timeout",
+           "Time to wait for a client to send its request (default 15s)");
+  AddParam(server_opts,"server-batch-window",
+           "Collect requests arriving within this many milliseconds and look up their shared n-grams in the phrase tables once (default 0 = no batching)");
+  AddParam(server_opts,"server-batch-size",
+           "Max. number of requests in a batch (default 4 * threads)");
 
   po::options_description irstlm_opts("IRSTLM Options");
   AddParam(irstlm_opts,"clean-lm-cache",
@@ -68,36 +68,54 @@ RuleCubeItem *RuleCube::Pop(ChartManager &manager)
 // create new RuleCube for neighboring principle rules
 void RuleCube::CreateNeighbors(const RuleCubeItem &item, ChartManager &manager)
 {
+  std::vector<RuleCubeItem*> newItems;
+  newItems.reserve(item.GetHypothesisDimensions().size() + 1);
+
   // create neighbor along translation dimension
   const TranslationDimension &translationDimension =
     item.GetTranslationDimension();
   if (translationDimension.HasMoreTranslations()) {
-    CreateNeighbor(item, -1, manager);
+    CreateNeighbor(item, -1, newItems);
   }
 
   // create neighbors along all hypothesis dimensions
   for (size_t i = 0; i < item.GetHypothesisDimensions().size(); ++i) {
     const HypothesisDimension &dimension = item.GetHypothesisDimensions()[i];
     if (dimension.HasMoreHypo()) {
-      CreateNeighbor(item, i, manager);
+      CreateNeighbor(item, i, newItems);
+    }
+  }
+
+  // score the new neighbors as a batch: all hypotheses are created (and
+  // their LM lookups prefetched) before the first one is evaluated
+  std::vector<RuleCubeItem*>::const_iterator p;
+  if (StaticData::Instance().options().cube.lazy_scoring) {
+    for (p = newItems.begin(); p != newItems.end(); ++p) {
+      (*p)->EstimateScore();
+    }
+  } else {
+    for (p = newItems.begin(); p != newItems.end(); ++p) {
+      (*p)->PrepareHypothesis(m_transOpt, manager);
+    }
+    for (p = newItems.begin(); p != newItems.end(); ++p) {
+      (*p)->ScoreHypothesis();
     }
   }
+  for (p = newItems.begin(); p != newItems.end(); ++p) {
+    m_queue.push(*p);
+  }
 }
 
+// adds the neighbor to newItems unless it has been created before
 void RuleCube::CreateNeighbor(const RuleCubeItem &item, int dimensionIndex,
-                              ChartManager &manager)
+                              std::vector<RuleCubeItem*> &newItems)
 {
   RuleCubeItem *newItem = new RuleCubeItem(item, dimensionIndex);
   std::pair<ItemSet::iterator, bool> result = m_covered.insert(newItem);
   if (!result.second) {
     delete newItem;  // already seen it
   } else {
-    if (StaticData::Instance().options().cube.lazy_scoring) {
-      newItem->EstimateScore();
-    } else {
-      newItem->CreateHypothesis(m_transOpt, manager);
-    }
-    m_queue.push(newItem);
+    newItems.push_back(newItem);
   }
 }
 
@@ -126,7 +126,7 @@ private:
   RuleCube &operator=(const RuleCube &);  // Not implemented
 
   void CreateNeighbors(const RuleCubeItem &, ChartManager &);
-  void CreateNeighbor(const RuleCubeItem &, int, ChartManager &);
+  void CreateNeighbor(const RuleCubeItem &, int, std::vector<RuleCubeItem*> &);
 
   const ChartTranslationOptions &m_transOpt;
   ItemSet m_covered;
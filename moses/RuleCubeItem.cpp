@@ -62,7 +62,9 @@ RuleCubeItem::RuleCubeItem(const RuleCubeItem &copy, int hypoDimensionIncr)
 
 RuleCubeItem::~RuleCubeItem()
 {
-  delete m_hypothesis;
+  if (m_hypothesis) {
+    ChartHypothesis::Delete(m_hypothesis);
+  }
 }
 
 void RuleCubeItem::EstimateScore()
@@ -78,7 +80,19 @@ void RuleCubeItem::EstimateScore()
 void RuleCubeItem::CreateHypothesis(const ChartTranslationOptions &transOpt,
                                     ChartManager &manager)
 {
-  m_hypothesis = new ChartHypothesis(transOpt, *this, manager);
+  PrepareHypothesis(transOpt, manager);
+  ScoreHypothesis();
+}
+
+void RuleCubeItem::PrepareHypothesis(const ChartTranslationOptions &transOpt,
+                                     ChartManager &manager)
+{
+  m_hypothesis = new (manager) ChartHypothesis(transOpt, *this, manager);
+  m_hypothesis->PrefetchWhenApplied();
+}
+
+void RuleCubeItem::ScoreHypothesis()
+{
   m_hypothesis->EvaluateWhenApplied();
   m_score = m_hypothesis->GetTotalScore();
 }
@@ -133,6 +133,11 @@ public:
 
   void CreateHypothesis(const ChartTranslationOptions &, ChartManager &);
 
+  //! first half of CreateHypothesis(): create it and let features prefetch
+  void PrepareHypothesis(const ChartTranslationOptions &, ChartManager &);
+  //! second half of CreateHypothesis(): evaluate the prepared hypothesis
+  void ScoreHypothesis();
+
   ChartHypothesis *ReleaseHypothesis();
 
   bool operator<(const RuleCubeItem &) const;
@@ -0,0 +1,169 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include "ScoreComponentCollection.h"
+#include "StaticData.h"
+#include "TargetPhrase.h"
+#include "TargetPhraseCollection.h"
+#include "TranslationModel/PhraseDictionaryMemory.h"
+#include "TranslationModel/PhraseDictionaryNodeMemory.h"
+#include "TranslationModel/RuleTable/Image.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+const char *kGrammar =
+  "das [X] ||| that [X] ||| 0.5 0.25 ||| 0-0 ||| 1 1 1\n"
+  "das haus [X] ||| the house [X] ||| 0.5 0.5 ||| 0-0 1-1 ||| 1 1 1\n"
+  "[X][X] haus [X] ||| [X][X] house [X] ||| 0.25 0.5 ||| 0-0 1-1 ||| 1 1 1\n"
+  "das [X][NP] [S] ||| the [X][NP] [S] ||| 0.5 0.125 ||| 0-0 1-1 ||| 1 1 1\n"
+  "das haus [X] ||| the home [X] ||| 0.75 0.5 ||| 0-0 1-1 ||| 1 1 1\n"
+  "[X][X] [X][X] [X] ||| [X][X] [X][X] [X] ||| 1 1 ||| 0-0 1-1 ||| 1 1 1\n"
+  "haus [X] ||| house [X] ||| 0.5 0.5 ||| 0-0 ||| 1 1 1\n"
+  "das haus [X] ||| this house [X] ||| 0.125 0.5 ||| 0-0 1-1 ||| 1 1 1\n"
+  "[X][X] haus [X] ||| house of [X][X] [X] ||| 0.5 0.5 ||| 0-2 1-0 ||| 1 1 1\n";
+
+string ToString(const Phrase &phrase)
+{
+  ostringstream out;
+  out << phrase;
+  return out.str();
+}
+
+void CompareCollections(const PhraseDictionary &textTable, const TargetPhraseCollection &text,
+                        const PhraseDictionary &imageTable, const TargetPhraseCollection &image)
+{
+  BOOST_REQUIRE_EQUAL(text.GetSize(), image.GetSize());
+  for (size_t i = 0; i < text.GetSize(); ++i) {
+    const TargetPhrase &a = *text.GetTargetPhrase(i);
+    const TargetPhrase &b = *image.GetTargetPhrase(i);
+    BOOST_CHECK_EQUAL(ToString(a), ToString(b));
+    BOOST_CHECK(a.GetTargetLHS() == b.GetTargetLHS());
+    BOOST_CHECK(a.GetAlignTerm() == b.GetAlignTerm());
+    BOOST_CHECK(a.GetAlignNonTerm() == b.GetAlignNonTerm());
+    vector<float> scoresA = a.GetScoreBreakdown().GetScoresForProducer(&textTable);
+    vector<float> scoresB = b.GetScoreBreakdown().GetScoresForProducer(&imageTable);
+    BOOST_CHECK_EQUAL_COLLECTIONS(scoresA.begin(), scoresA.end(), scoresB.begin(), scoresB.end());
+  }
+}
+
+//! every rule of the text table is found at the same place in the image, and nothing else
+void CompareNodes(const PhraseDictionary &textTable, const PhraseDictionaryNodeMemory &text,
+                  const PhraseDictionary &imageTable, const PhraseDictionaryNodeMemory &image)
+{
+  CompareCollections(textTable, text.GetTargetPhraseCollection(),
+                     imageTable, image.GetTargetPhraseCollection());
+
+  BOOST_REQUIRE_EQUAL(text.GetTerminalMap().size(), image.GetTerminalMap().size());
+  PhraseDictionaryNodeMemory::TerminalMap::const_iterator t;
+  for (t = text.GetTerminalMap().begin(); t != text.GetTerminalMap().end(); ++t) {
+    const PhraseDictionaryNodeMemory *child = image.GetChild(t->first);
+    BOOST_REQUIRE(child);
+    CompareNodes(textTable, t->second, imageTable, *child);
+  }
+
+  BOOST_REQUIRE_EQUAL(text.GetNonTerminalMap().size(), image.GetNonTerminalMap().size());
+  PhraseDictionaryNodeMemory::NonTerminalMap::const_iterator n;
+  for (n = text.GetNonTerminalMap().begin(); n != text.GetNonTerminalMap().end(); ++n) {
+#if defined(UNLABELLED_SOURCE)
+    const PhraseDictionaryNodeMemory *child = image.GetNonTerminalChild(n->first);
+#else
+    const PhraseDictionaryNodeMemory *child = image.GetChild(n->first.first, n->first.second);
+#endif
+    BOOST_REQUIRE(child);
+    CompareNodes(textTable, n->second, imageTable, *child);
+  }
+}
+
+//! fill in all nodes, as decoding threads do
+void LoadAll(const PhraseDictionaryNodeMemory &node)
+{
+  node.GetTargetPhraseCollection();
+  PhraseDictionaryNodeMemory::TerminalMap::const_iterator t;
+  for (t = node.GetTerminalMap().begin(); t != node.GetTerminalMap().end(); ++t) {
+    LoadAll(t->second);
+  }
+  PhraseDictionaryNodeMemory::NonTerminalMap::const_iterator n;
+  for (n = node.GetNonTerminalMap().begin(); n != node.GetNonTerminalMap().end(); ++n) {
+    LoadAll(n->second);
+  }
+}
+
+struct TempDir {
+  TempDir() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directory(path);
+  }
+  ~TempDir() {
+    boost::filesystem::remove_all(path);
+  }
+  boost::filesystem::path path;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(rule_table_image)
+
+BOOST_AUTO_TEST_CASE(image_matches_text_table)
+{
+  TempDir dir;
+  string textPath = (dir.path / "rule-table").string();
+  string imagePath = (dir.path / "rule-table.image").string();
+  {
+    ofstream out(textPath.c_str());
+    out << kGrammar;
+  }
+  RuleTableImage::Create(textPath, imagePath);
+  BOOST_CHECK(!RuleTableImage::IsImage(textPath));
+  BOOST_CHECK(RuleTableImage::IsImage(imagePath));
+
+  PhraseDictionaryMemory textTable("PhraseDictionaryMemory name=RuleTableImageTestText num-features=2 "
+                                   "input-factor=0 output-factor=0 table-limit=2 path=" + textPath);
+  PhraseDictionaryMemory imageTable("PhraseDictionaryMemory name=RuleTableImageTestImage num-features=2 "
+                                    "input-factor=0 output-factor=0 table-limit=2 path=" + imagePath);
+
+  // rules are scored while loading, with weights for all features so far
+  StaticData::InstanceNonConst().SetAllWeights(ScoreComponentCollection());
+  StaticData::InstanceNonConst().SetWeights(&textTable, vector<float>(2, 1.0f));
+  StaticData::InstanceNonConst().SetWeights(&imageTable, vector<float>(2, 1.0f));
+  textTable.Load();
+  imageTable.Load();
+
+  // several threads fill in the same nodes of the image at once
+  boost::thread_group threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.create_thread(boost::bind(&LoadAll, boost::cref(imageTable.GetRootNode())));
+  }
+  threads.join_all();
+
+  CompareNodes(textTable, textTable.GetRootNode(), imageTable, imageTable.GetRootNode());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
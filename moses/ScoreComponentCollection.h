@@ -147,7 +147,7 @@ public:
     return m_scores;
   }
 
-  const std::valarray<FValue> &getCoreFeatures() const {
+  const FValueArray &getCoreFeatures() const {
     return m_scores.getCoreFeatures();
   }
 
@@ -3,12 +3,43 @@
 #include "SearchNormal.h"
 #include "SentenceStats.h"
 
+#include <limits>
 #include <boost/foreach.hpp>
 
 using namespace std;
 
 namespace Moses
 {
+
+#ifdef WITH_THREADS
+/** Expands one hypothesis of a stack in a worker thread, collecting the
+ * new hypotheses in a buffer owned by that hypothesis
+ */
+class SearchNormal::ExpansionTask : public Task
+{
+public:
+  ExpansionTask(SearchNormal &search, const Hypothesis &hypothesis,
+                std::vector<Hypothesis*> &candidates, size_t &remaining,
+                boost::mutex &mutex, boost::condition_variable &done)
+    : m_search(search), m_hypothesis(hypothesis), m_candidates(candidates)
+    , m_remaining(remaining), m_mutex(mutex), m_done(done) {}
+
+  virtual void Run() {
+    m_search.ProcessOneHypothesis(m_hypothesis, &m_candidates);
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (--m_remaining == 0) m_done.notify_all();
+  }
+
+private:
+  SearchNormal &m_search;
+  const Hypothesis &m_hypothesis;
+  std::vector<Hypothesis*> &m_candidates;
+  size_t &m_remaining;
+  boost::mutex &m_mutex;
+  boost::condition_variable &m_done;
+};
+#endif
+
 /**
  * Organizing main function
  *
@@ -22,6 +53,9 @@ SearchNormal(Manager& manager, const InputType &source,
   , m_source(source)
   , m_hypoStackColl(source.GetSize() + 1)
   , m_transOptColl(transOptColl)
+#ifdef WITH_THREADS
+  , m_expansionPool(NULL)
+#endif
 {
   VERBOSE(1, "Translating: " << m_source << endl);
 
@@ -43,6 +77,25 @@ SearchNormal(Manager& manager, const InputType &source,
     sourceHypoColl->SetBeamWidth(this->m_options.search.beam_width);
     m_hypoStackColl[ind] = sourceHypoColl;
   }
+
+#ifdef WITH_THREADS
+  size_t expansionThreads = this->m_options.search.expansion_threads;
+  if (expansionThreads > 1) {
+#ifdef USE_HYPO_POOL
+    VERBOSE(1, "Hypothesis pool is not thread-safe, expanding stacks sequentially" << endl);
+#else
+    if (this->m_options.search.UseEarlyDiscarding()) {
+      // early discarding depends on the order in which hypotheses are added
+      VERBOSE(1, "Early discarding is on, expanding stacks sequentially" << endl);
+    } else if (StaticData::Instance().GetVerboseLevel() >= 2) {
+      // the per-hypothesis timing statistics are not thread-safe
+      VERBOSE(2, "Collecting timing statistics, expanding stacks sequentially" << endl);
+    } else {
+      m_expansionPool = &StaticData::Instance().GetExpansionPool();
+    }
+#endif
+  }
+#endif
 }
 
 SearchNormal::~SearchNormal()
@@ -68,6 +121,13 @@ ProcessOneStack(HypothesisStack* hstack)
   sourceHypoColl.CleanupArcList();
   IFVERBOSE(2)  stats.StopTimeStack();
 
+#ifdef WITH_THREADS
+  if (m_expansionPool && sourceHypoColl.size() > 1) {
+    ExpandStackInParallel(sourceHypoColl);
+    return true;
+  }
+#endif
+
   // go through each hypothesis on the stack and try to expand it
   // BOOST_FOREACH(Hypothesis* h, sourceHypoColl)
   HypothesisStackNormal::const_iterator h;
@@ -76,6 +136,55 @@ ProcessOneStack(HypothesisStack* hstack)
   return true;
 }
 
+#ifdef WITH_THREADS
+/**
+ * Expand all hypotheses of a stack in the expansion threads, then add the
+ * new hypotheses to their stacks in exactly the order (and with the ids)
+ * that sequential expansion would have produced.
+ * The stack is expanded in chunks of a few hypotheses per thread, so only
+ * the expansions of one chunk are buffered at a time.
+ */
+void
+SearchNormal::
+ExpandStackInParallel(const HypothesisStackNormal &sourceHypoColl)
+{
+  const size_t chunkSize = 4 * m_expansionPool->GetNumThreads();
+  std::vector<const Hypothesis*> hypos(sourceHypoColl.begin(), sourceHypoColl.end());
+  std::vector<std::vector<Hypothesis*> > candidates(std::min(chunkSize, hypos.size()));
+  boost::mutex mutex;
+  boost::condition_variable done;
+
+  for (size_t begin = 0; begin < hypos.size(); begin += chunkSize) {
+    size_t end = std::min(begin + chunkSize, hypos.size());
+    size_t remaining = end - begin;
+    for (size_t i = begin; i < end; ++i) {
+      candidates[i - begin].clear();
+      boost::shared_ptr<Task> task(new ExpansionTask(*this, *hypos[i],
+                                   candidates[i - begin], remaining, mutex, done));
+      m_expansionPool->Submit(task);
+    }
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      while (remaining > 0) done.wait(lock);
+    }
+
+    // the ids handed out during expansion of a chunk are a contiguous block
+    int nextId = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < end - begin; ++i) {
+      BOOST_FOREACH(const Hypothesis *newHypo, candidates[i]) {
+        nextId = std::min(nextId, newHypo->GetId());
+      }
+    }
+
+    for (size_t i = 0; i < end - begin; ++i) {
+      BOOST_FOREACH(Hypothesis *newHypo, candidates[i]) {
+        newHypo->SetId(nextId++);
+        AddToStack(newHypo);
+      }
+    }
+  }
+}
+#endif
 
 /**
  * Main decoder loop that translates a sentence by expanding
@@ -105,7 +214,8 @@ void SearchNormal::Decode()
  */
 void
 SearchNormal::
-ProcessOneHypothesis(const Hypothesis &hypothesis)
+ProcessOneHypothesis(const Hypothesis &hypothesis,
+                     std::vector<Hypothesis*> *candidates)
 {
   // since we check for reordering limits, its good to have that limit handy
   // int maxDistortion  = StaticData::Instance().GetMaxDistortion();
@@ -134,7 +244,7 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
         }
 
         //TODO: does this method include incompatible WordLattice hypotheses?
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, candidates);
       }
     }
     return; // done with special case (no reordering limit)
@@ -211,7 +321,7 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
 
       if (isLeftMostEdge) {
         // any length extension is okay if starting at left-most edge
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, candidates);
       } else { // starting somewhere other than left-most edge, use caution
         // the basic idea is this: we would like to translate a phrase
         // starting from a position further right than the left-most
@@ -227,7 +337,7 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
             > m_options.reordering.max_distortion) continue;
 
         // everything is fine, we're good to go
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, candidates);
       }
     }
   }
@@ -243,7 +353,8 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
 
 void
 SearchNormal::
-ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos)
+ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos,
+                    std::vector<Hypothesis*> *candidates)
 {
   // early discarding: check if hypothesis is too bad to build
   // this idea is explained in (Moore&Quirk, MT Summit 2007)
@@ -262,9 +373,13 @@ ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos
   const TranslationOptionList* tol
   = m_transOptColl.GetTranslationOptionList(startPos, endPos);
   if (!tol) return;
+
+  // let stateful features fetch what they need for all expansions at once
+  hypothesis.PrefetchWhenApplied(*tol);
+
   TranslationOptionList::const_iterator iter;
   for (iter = tol->begin() ; iter != tol->end() ; ++iter) {
-    ExpandHypothesis(hypothesis, **iter, expectedScore);
+    ExpandHypothesis(hypothesis, **iter, expectedScore, candidates);
   }
 }
 
@@ -277,13 +392,21 @@ ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos
  * \param expectedScore base score for early discarding
  *        (base hypothesis score plus future score estimation)
  */
-void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore)
+void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore,
+                                    std::vector<Hypothesis*> *candidates)
 {
   const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
 
   Hypothesis *newHypo;
-  if (! m_options.search.UseEarlyDiscarding()) {
+  if (candidates) {
+    // parallel expansion: build and score only, the caller adds to the stack
+    newHypo = hypothesis.CreateNext(transOpt);
+    if (newHypo==NULL) return;
+    newHypo->EvaluateWhenApplied(m_transOptColl.GetFutureScore());
+    candidates->push_back(newHypo);
+    return;
+  } else if (! m_options.search.UseEarlyDiscarding()) {
     // simple build, no questions asked
     IFVERBOSE(2) {
       stats.StartTimeBuildHyp();
@@ -339,6 +462,16 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const Translat
 
   }
 
+  AddToStack(newHypo);
+}
+
+/**
+ * Add a newly built hypothesis to the stack for its number of covered words.
+ */
+void SearchNormal::AddToStack(Hypothesis *newHypo)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+
   // logging for the curious
   IFVERBOSE(3) {
     newHypo->PrintHypothesis();
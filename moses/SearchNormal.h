@@ -6,6 +6,7 @@
 #include "HypothesisStackNormal.h"
 #include "TranslationOptionCollection.h"
 #include "Timer.h"
+#include "ThreadPool.h"
 
 namespace Moses
 {
@@ -32,20 +33,38 @@ protected:
   /** pre-computed list of translation options for the phrases in this sentence */
   const TranslationOptionCollection &m_transOptColl;
 
+#ifdef WITH_THREADS
+  class ExpansionTask;
+
+  /** threads expanding the hypotheses of one stack, shared by all
+   * sentences; NULL when the stack is expanded sequentially */
+  ThreadPool *m_expansionPool;
+
+  void
+  ExpandStackInParallel(const HypothesisStackNormal &sourceHypoColl);
+#endif
+
   // functions for creating hypotheses
+  // If candidates is not NULL, new hypotheses are built and scored but
+  // collected there instead of being added to their stack.
 
   virtual bool
   ProcessOneStack(HypothesisStack* hstack);
 
   virtual void
-  ProcessOneHypothesis(const Hypothesis &hypothesis);
+  ProcessOneHypothesis(const Hypothesis &hypothesis,
+                       std::vector<Hypothesis*> *candidates = NULL);
 
   virtual void
-  ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos);
+  ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos,
+                      std::vector<Hypothesis*> *candidates);
 
   virtual void
   ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt,
-                   float expectedScore);
+                   float expectedScore, std::vector<Hypothesis*> *candidates);
+
+  void
+  AddToStack(Hypothesis *newHypo);
 
 public:
   SearchNormal(Manager& manager, const InputType &source, const TranslationOptionCollection &transOptColl);
@@ -0,0 +1,235 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_ShardedCache_h
+#define moses_ShardedCache_h
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <ostream>
+
+#include <stdint.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Moses
+{
+
+//! counters of a ShardedCache, summed over all shards
+struct ShardedCacheStats {
+  ShardedCacheStats()
+    : hits(0), misses(0), evictions(0), entries(0), bytes(0) {}
+
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  size_t entries;
+  size_t bytes;
+};
+
+inline std::ostream& operator<<(std::ostream &out, const ShardedCacheStats &stats)
+{
+  out << "hits=" << stats.hits << " misses=" << stats.misses
+      << " evictions=" << stats.evictions << " entries=" << stats.entries
+      << " bytes=" << stats.bytes;
+  return out;
+}
+
+/** Cache shared by all decoding threads with a memory budget in bytes.
+ *
+ * Keys are spread over a fixed number of shards by their hash. Each shard
+ * has its own lock, hash map and LRU list, and gets an equal part of the
+ * budget, so threads only contend when they hit the same shard. The caller
+ * estimates the size of each entry when adding it.
+ *
+ * Values are copied out of the cache, so they should be cheap to copy, eg.
+ * shared pointers. An evicted value stays alive as long as a copy does.
+ */
+template <class Key, class Value,
+         class Hash = boost::hash<Key>, class Pred = std::equal_to<Key> >
+class ShardedCache
+{
+public:
+  ShardedCache(size_t maxBytes, size_t numShards = 16)
+    : m_shards(new Shard[RoundUpToPowerOf2(numShards)])
+    , m_mask(RoundUpToPowerOf2(numShards) - 1)
+    , m_maxBytesPerShard(maxBytes / (m_mask + 1)) {
+  }
+
+  //! copy the value cached for key to value and mark it as recently used
+  bool Find(const Key &key, Value &value) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    typename Index::iterator iter = shard.index.find(key);
+    if (iter == shard.index.end()) {
+      ++shard.misses;
+      return false;
+    }
+    ++shard.hits;
+    shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+    value = iter->second->value;
+    return true;
+  }
+
+  /** mark key as recently used, without counting a hit or miss.
+   * \return false if key is not cached */
+  bool Touch(const Key &key) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    typename Index::iterator iter = shard.index.find(key);
+    if (iter == shard.index.end()) {
+      return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+    return true;
+  }
+
+  /** add value for key unless key is already cached, evicting the least
+   * recently used entries of its shard if over budget.
+   * \return false if key was already cached or value is too big to cache */
+  bool Add(const Key &key, const Value &value, size_t bytes) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    typename Index::iterator iter = shard.index.find(key);
+    if (iter != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+      return false;
+    }
+    if (bytes > m_maxBytesPerShard) {
+      return false;
+    }
+
+    while (shard.bytes + bytes > m_maxBytesPerShard) {
+      Entry &oldest = shard.lru.back();
+      shard.bytes -= oldest.bytes;
+      shard.index.erase(oldest.key);
+      shard.lru.pop_back();
+      ++shard.evictions;
+    }
+
+    shard.lru.push_front(Entry(key, value, bytes));
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += bytes;
+    return true;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i <= m_mask; ++i) {
+      Shard &shard = m_shards[i];
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+      shard.index.clear();
+      shard.lru.clear();
+      shard.bytes = 0;
+    }
+  }
+
+  ShardedCacheStats GetStats() const {
+    ShardedCacheStats stats;
+    for (size_t i = 0; i <= m_mask; ++i) {
+      Shard &shard = m_shards[i];
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+      stats.hits += shard.hits;
+      stats.misses += shard.misses;
+      stats.evictions += shard.evictions;
+      stats.entries += shard.lru.size();
+      stats.bytes += shard.bytes;
+    }
+    return stats;
+  }
+
+  size_t GetMaxBytes() const {
+    return m_maxBytesPerShard * (m_mask + 1);
+  }
+
+  size_t GetNumShards() const {
+    return m_mask + 1;
+  }
+
+private:
+  struct Entry {
+    Entry(const Key &key, const Value &value, size_t bytes)
+      : key(key), value(value), bytes(bytes) {}
+    Key key;
+    Value value;
+    size_t bytes;
+  };
+
+  typedef std::list<Entry> LRUList; //! most recently used first
+  typedef boost::unordered_map<Key, typename LRUList::iterator, Hash, Pred> Index;
+
+  struct Shard {
+    Shard() : bytes(0), hits(0), misses(0), evictions(0) {}
+#ifdef WITH_THREADS
+    boost::mutex mutex;
+#endif
+    LRUList lru;
+    Index index;
+    size_t bytes;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+  };
+
+  boost::scoped_array<Shard> m_shards;
+  size_t m_mask;
+  size_t m_maxBytesPerShard;
+  Hash m_hash;
+
+  // no copying
+  ShardedCache(const ShardedCache&);
+  ShardedCache& operator=(const ShardedCache&);
+
+  static size_t RoundUpToPowerOf2(size_t n) {
+    size_t ret = 1;
+    while (ret < n) ret <<= 1;
+    return ret;
+  }
+
+  Shard &GetShard(const Key &key) const {
+    // the maps inside the shards use the low bits of the same hash,
+    // so pick the shard from the high bits. Mix in 64 bits, size_t may be
+    // only 32 bits wide.
+    uint64_t hash = m_hash(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return m_shards[static_cast<size_t>(hash >> 16) & m_mask];
+  }
+};
+
+}
+
+#endif
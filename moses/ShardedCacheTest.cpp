@@ -0,0 +1,97 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "ShardedCache.h"
+
+using namespace Moses;
+
+BOOST_AUTO_TEST_SUITE(sharded_cache)
+
+BOOST_AUTO_TEST_CASE(find_and_add)
+{
+  ShardedCache<int, int> cache(1000, 4);
+  BOOST_CHECK_EQUAL(cache.GetNumShards(), 4);
+
+  int value = 0;
+  BOOST_CHECK(!cache.Find(1, value));
+  BOOST_CHECK(cache.Add(1, 10, 10));
+  BOOST_CHECK(!cache.Add(1, 20, 10));
+  BOOST_CHECK(cache.Find(1, value));
+  BOOST_CHECK_EQUAL(value, 10);
+
+  ShardedCacheStats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(stats.hits, 1);
+  BOOST_CHECK_EQUAL(stats.misses, 1);
+  BOOST_CHECK_EQUAL(stats.entries, 1);
+  BOOST_CHECK_EQUAL(stats.bytes, 10);
+
+  cache.Clear();
+  BOOST_CHECK(!cache.Find(1, value));
+  BOOST_CHECK_EQUAL(cache.GetStats().entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(touch)
+{
+  // a single shard, room for two entries
+  ShardedCache<int, int> cache(20, 1);
+  BOOST_CHECK(!cache.Touch(1));
+  cache.Add(1, 1, 10);
+  cache.Add(2, 2, 10);
+  BOOST_CHECK(cache.Touch(1));
+  cache.Add(3, 3, 10);
+
+  int value;
+  BOOST_CHECK(cache.Find(1, value));
+  BOOST_CHECK(!cache.Find(2, value));
+
+  // touching counts neither hits nor misses
+  ShardedCacheStats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(stats.hits, 1);
+  BOOST_CHECK_EQUAL(stats.misses, 1);
+}
+
+BOOST_AUTO_TEST_CASE(evict_least_recently_used)
+{
+  // a single shard, room for three entries
+  ShardedCache<int, int> cache(30, 1);
+  cache.Add(1, 1, 10);
+  cache.Add(2, 2, 10);
+  cache.Add(3, 3, 10);
+
+  int value;
+  BOOST_CHECK(cache.Find(1, value));
+  cache.Add(4, 4, 10);
+
+  BOOST_CHECK(cache.Find(1, value));
+  BOOST_CHECK(!cache.Find(2, value));
+  BOOST_CHECK(cache.Find(3, value));
+  BOOST_CHECK(cache.Find(4, value));
+
+  ShardedCacheStats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(stats.evictions, 1);
+  BOOST_CHECK_EQUAL(stats.bytes, 30);
+
+  // too big for the budget
+  BOOST_CHECK(!cache.Add(5, 5, 31));
+  BOOST_CHECK_EQUAL(cache.GetStats().entries, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
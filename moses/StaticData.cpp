@@ -49,6 +49,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #ifdef WITH_THREADS
 #include <boost/thread.hpp>
+#include "ThreadPool.h"
 #endif
 
 using namespace std;
@@ -82,6 +83,17 @@ StaticData::~StaticData()
   Phrase::FinalizeMemPool();
 }
 
+#ifdef WITH_THREADS
+ThreadPool &StaticData::GetExpansionPool() const
+{
+  boost::mutex::scoped_lock lock(m_expansionPoolMutex);
+  if (!m_expansionPool) {
+    m_expansionPool.reset(new ThreadPool(m_options.search.expansion_threads));
+  }
+  return *m_expansionPool;
+}
+#endif
+
 bool StaticData::LoadDataStatic(Parameter *parameter, const std::string &execPath)
 {
   s_instance.SetExecPath(execPath);
@@ -875,6 +887,9 @@ void StaticData::LoadFeatureFunctions()
     VERBOSE(1, "Loading " << pt->GetScoreProducerDescription() << endl);
     pt->Load();
   }
+  for (size_t i = 0; i < pts.size(); ++i) {
+    pts[i]->InitializeCache();
+  }
 
   CheckLEGACYPT();
 }
@@ -1066,7 +1081,7 @@ void StaticData::NoCache()
     const std::vector<PhraseDictionary*> &pts = PhraseDictionary::GetColl();
     for (size_t i = 0; i < pts.size(); ++i) {
       PhraseDictionary &pt = *pts[i];
-      pt.SetParameter("cache-size", "0");
+      pt.SetParameter("cache-size-mb", "0");
     }
   }
 }
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 
 #ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #endif
@@ -56,6 +57,9 @@ class DecodeStep;
 
 class DynamicCacheBasedLanguageModel;
 class PhraseDictionaryDynamicCacheBased;
+#ifdef WITH_THREADS
+class ThreadPool;
+#endif
 
 typedef std::pair<std::string, float> UnknownLHSEntry;
 typedef std::vector<UnknownLHSEntry>  UnknownLHSList;
@@ -195,6 +199,12 @@ protected:
   int m_threadCount;
   long m_startTranslationId;
 
+#ifdef WITH_THREADS
+  // threads expanding stacks in parallel, shared by all decoding threads
+  mutable boost::scoped_ptr<ThreadPool> m_expansionPool;
+  mutable boost::mutex m_expansionPoolMutex;
+#endif
+
   // alternate weight settings
   mutable std::string m_currentWeightSetting;
   std::map< std::string, ScoreComponentCollection* > m_weightSetting; // core weights
@@ -664,6 +674,11 @@ public:
     return m_threadCount;
   }
 
+#ifdef WITH_THREADS
+  //! pool of stack-expansion-threads workers, created on first use
+  ThreadPool &GetExpansionPool() const;
+#endif
+
   long GetStartTranslationId() const {
     return m_startTranslationId;
   }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cassert>
+
+#include "moses/FF/FFState.h"
+
+#include "SVertex.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+class SVertexRecombinationEqualityPred
+{
+public:
+  bool operator()(const SVertex *v1, const SVertex *v2) const {
+    assert(v1->state.size() == v2->state.size());
+    for (std::size_t i = 0; i < v1->state.size(); ++i) {
+      if (v1->state[i] == NULL || v2->state[i] == NULL) {
+        if (v1->state[i] != v2->state[i]) {
+          return false;
+        }
+      } else if (v1->state[i]->Compare(*v2->state[i]) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // Syntax
+}  // Moses
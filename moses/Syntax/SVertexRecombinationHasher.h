@@ -0,0 +1,30 @@
+#pragma once
+
+#include <boost/functional/hash.hpp>
+
+#include "moses/FF/FFState.h"
+
+#include "SVertex.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Hashes the FFState values of a SVertex.  Vertices that are equal according
+// to SVertexRecombinationEqualityPred have the same hash value.
+class SVertexRecombinationHasher
+{
+public:
+  std::size_t operator()(const SVertex *v) const {
+    std::size_t seed = 0;
+    for (std::vector<FFState*>::const_iterator p = v->state.begin();
+         p != v->state.end(); ++p) {
+      boost::hash_combine(seed, *p ? (*p)->hash() : 0);
+    }
+    return seed;
+  }
+};
+
+}  // Syntax
+}  // Moses
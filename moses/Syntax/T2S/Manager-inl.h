@@ -1,5 +1,7 @@
 #pragma once
 
+#include <boost/unordered_set.hpp>
+
 #include "moses/DecodeGraph.h"
 #include "moses/StaticData.h"
 #include "moses/Syntax/BoundedPriorityContainer.h"
@@ -11,7 +13,8 @@
 #include "moses/Syntax/RuleTableFF.h"
 #include "moses/Syntax/SHyperedgeBundle.h"
 #include "moses/Syntax/SVertex.h"
-#include "moses/Syntax/SVertexRecombinationOrderer.h"
+#include "moses/Syntax/SVertexRecombinationEqualityPred.h"
+#include "moses/Syntax/SVertexRecombinationHasher.h"
 #include "moses/Syntax/SymbolEqualityPred.h"
 #include "moses/Syntax/SymbolHasher.h"
 
@@ -240,27 +243,27 @@ template<typename RuleMatcher>
 void Manager<RuleMatcher>::RecombineAndSort(
   const std::vector<SHyperedge*> &buffer, SVertexStack &stack)
 {
-  // Step 1: Create a map containing a single instance of each distinct vertex
+  // Step 1: Create a set containing a single instance of each distinct vertex
   // (where distinctness is defined by the state value).  The hyperedges'
-  // head pointers are updated to point to the vertex instances in the map and
+  // head pointers are updated to point to the vertex instances in the set and
   // any 'duplicate' vertices are deleted.
-// TODO Set?
-  typedef std::map<SVertex *, SVertex *, SVertexRecombinationOrderer> Map;
-  Map map;
+  typedef boost::unordered_set<SVertex *, SVertexRecombinationHasher,
+          SVertexRecombinationEqualityPred> Set;
+  Set set;
   for (std::vector<SHyperedge*>::const_iterator p = buffer.begin();
        p != buffer.end(); ++p) {
     SHyperedge *h = *p;
     SVertex *v = h->head;
     assert(v->best == h);
     assert(v->recombined.empty());
-    std::pair<Map::iterator, bool> result = map.insert(Map::value_type(v, v));
+    std::pair<Set::iterator, bool> result = set.insert(v);
     if (result.second) {
       continue;  // v's recombination value hasn't been seen before.
     }
     // v is a duplicate (according to the recombination rules).
     // Compare the score of h against the score of the best incoming hyperedge
     // for the stored vertex.
-    SVertex *storedVertex = result.first->second;
+    SVertex *storedVertex = *result.first;
     if (h->label.score > storedVertex->best->label.score) {
       // h's score is better.
       storedVertex->recombined.push_back(storedVertex->best);
@@ -273,11 +276,11 @@ void Manager<RuleMatcher>::RecombineAndSort(
     h->head = storedVertex;
   }
 
-  // Step 2: Copy the vertices from the map to the stack.
+  // Step 2: Copy the vertices from the set to the stack.
   stack.clear();
-  stack.reserve(map.size());
-  for (Map::const_iterator p = map.begin(); p != map.end(); ++p) {
-    stack.push_back(boost::shared_ptr<SVertex>(p->first));
+  stack.reserve(set.size());
+  for (Set::const_iterator p = set.begin(); p != set.end(); ++p) {
+    stack.push_back(boost::shared_ptr<SVertex>(*p));
   }
 
   // Step 3: Sort the vertices in the stack.
@@ -31,34 +31,101 @@ namespace Moses
 {
 
 ThreadPool::ThreadPool( size_t numThreads )
-  : m_stopped(false), m_stopping(false), m_queueLimit(0)
+  : m_pending(0), m_nextQueue(0), m_stopped(false), m_stopping(false), m_queueLimit(0)
 {
+  if (numThreads == 0) numThreads = 1;
   for (size_t i = 0; i < numThreads; ++i) {
-    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
+    m_queues.push_back(new WorkerQueue);
   }
+  for (size_t i = 0; i < numThreads; ++i) {
+    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this,i));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  Stop();
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    delete m_queues[i];
+  }
+}
+
+boost::shared_ptr<Task> ThreadPool::Pop(size_t worker)
+{
+  boost::shared_ptr<Task> task;
+  WorkerQueue &queue = *m_queues[worker];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  if (!queue.tasks.empty()) {
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+  }
+  return task;
 }
 
-void ThreadPool::Execute()
+boost::shared_ptr<Task> ThreadPool::Steal(size_t thief)
+{
+  // take the most expensive job waiting at the head of any other queue, so
+  // that idle workers keep to the longest-first schedule
+  boost::shared_ptr<Task> task;
+  size_t victimIdx = thief;
+  size_t victimCost = 0;
+  for (size_t i = 1; i < m_queues.size(); ++i) {
+    size_t idx = (thief + i) % m_queues.size();
+    WorkerQueue &victim = *m_queues[idx];
+    boost::mutex::scoped_lock lock(victim.mutex);
+    if (!victim.tasks.empty()
+        && (victimIdx == thief || victim.tasks.front()->GetCost() > victimCost)) {
+      victimIdx = idx;
+      victimCost = victim.tasks.front()->GetCost();
+    }
+  }
+  if (victimIdx != thief) {
+    // the head may have been taken in the meantime; the queue is still
+    // sorted, so whatever is at the front now is its most expensive job
+    WorkerQueue &victim = *m_queues[victimIdx];
+    boost::mutex::scoped_lock lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+    }
+  }
+  if (task) {
+    WorkerQueue &queue = *m_queues[thief];
+    boost::mutex::scoped_lock lock(queue.mutex);
+    ++queue.steals;
+  }
+  return task;
+}
+
+void ThreadPool::Execute(size_t worker)
 {
   do {
     boost::shared_ptr<Task> task;
     {
-      // Find a job to perform
+      // Wait until there is a job to perform
       boost::mutex::scoped_lock lock(m_mutex);
-      if (m_tasks.empty() && !m_stopped) {
+      if (m_pending == 0 && !m_stopped) {
         m_threadNeeded.wait(lock);
       }
-      if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
-        m_tasks.pop();
-      }
+      if (m_stopped) break;
     }
+    // Find a job: our own queue first, then the other workers' queues
+    task = Pop(worker);
+    if (!task) task = Steal(worker);
     //Execute job
     if (task) {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        --m_pending;
+      }
+      m_threadAvailable.notify_all();
       // must read from task before run. otherwise task may be deleted by main thread
       // race condition
       task->DeleteAfterExecution();
       task->Run();
+      WorkerQueue &queue = *m_queues[worker];
+      boost::mutex::scoped_lock lock(queue.mutex);
+      ++queue.executed;
     }
     m_threadAvailable.notify_all();
   } while (!m_stopped);
@@ -66,14 +133,30 @@ void ThreadPool::Execute()
 
 void ThreadPool::Submit(boost::shared_ptr<Task> task)
 {
-  boost::mutex::scoped_lock lock(m_mutex);
-  if (m_stopping) {
-    throw runtime_error("ThreadPool stopping - unable to accept new jobs");
-  }
-  while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
-    m_threadAvailable.wait(lock);
+  size_t worker;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_stopping) {
+      throw runtime_error("ThreadPool stopping - unable to accept new jobs");
+    }
+    while (m_queueLimit > 0 && m_pending >= m_queueLimit) {
+      m_threadAvailable.wait(lock);
+    }
+    worker = m_nextQueue;
+    m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+
+    // insert behind all jobs that cost at least as much, so that expensive
+    // jobs start first and equal jobs keep their submission order
+    WorkerQueue &queue = *m_queues[worker];
+    boost::mutex::scoped_lock queueLock(queue.mutex);
+    size_t cost = task->GetCost();
+    std::deque<boost::shared_ptr<Task> >::iterator iter = queue.tasks.end();
+    while (iter != queue.tasks.begin() && (*(iter - 1))->GetCost() < cost) {
+      --iter;
+    }
+    queue.tasks.insert(iter, task);
+    ++m_pending;
   }
-  m_tasks.push(task);
   m_threadNeeded.notify_all();
 }
 
@@ -88,7 +171,7 @@ void ThreadPool::Stop(bool processRemainingJobs)
   if (processRemainingJobs) {
     boost::mutex::scoped_lock lock(m_mutex);
     //wait for queue to drain.
-    while (!m_tasks.empty() && !m_stopped) {
+    while (m_pending > 0 && !m_stopped) {
       m_threadAvailable.wait(lock);
     }
   }
@@ -102,6 +185,37 @@ void ThreadPool::Stop(bool processRemainingJobs)
   m_threads.join_all();
 }
 
+size_t ThreadPool::GetQueueDepth(size_t worker) const
+{
+  const WorkerQueue &queue = *m_queues[worker];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  return queue.tasks.size();
+}
+
+size_t ThreadPool::GetStealCount(size_t worker) const
+{
+  const WorkerQueue &queue = *m_queues[worker];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  return queue.steals;
+}
+
+size_t ThreadPool::GetExecutedCount(size_t worker) const
+{
+  const WorkerQueue &queue = *m_queues[worker];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  return queue.executed;
+}
+
+void ThreadPool::PrintStats(std::ostream &out) const
+{
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    out << "ThreadPool worker " << i
+        << ": queued=" << GetQueueDepth(i)
+        << " executed=" << GetExecutedCount(i)
+        << " stolen=" << GetStealCount(i) << endl;
+  }
+}
+
 }
 #endif //WITH_THREADS
 
@@ -23,7 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_ThreadPool_h
 
 #include <iostream>
-#include <queue>
+#include <deque>
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
@@ -56,6 +56,12 @@ public:
   virtual bool DeleteAfterExecution() {
     return true;
   }
+  /** Estimated cost of running this task. Queued tasks with a higher
+   * cost are started first; tasks of equal cost run in submission order.
+   */
+  virtual size_t GetCost() const {
+    return 0;
+  }
   virtual ~Task() {}
 };
 
@@ -69,9 +75,7 @@ public:
    **/
   explicit ThreadPool(size_t numThreads);
 
-  ~ThreadPool() {
-    Stop();
-  }
+  ~ThreadPool();
 
   /**
    * Add a job to the threadpool.
@@ -91,17 +95,50 @@ public:
     m_queueLimit = limit;
   }
 
+  size_t GetNumThreads() const {
+    return m_queues.size();
+  }
+
+  //! number of jobs waiting in the queue of worker \param worker
+  size_t GetQueueDepth(size_t worker) const;
+
+  //! number of jobs worker \param worker took from the queues of other workers
+  size_t GetStealCount(size_t worker) const;
+
+  //! number of jobs worker \param worker has run
+  size_t GetExecutedCount(size_t worker) const;
+
+  void PrintStats(std::ostream &out) const;
+
 private:
+  /** Jobs assigned to one worker, ordered by decreasing cost. The owner
+   * takes jobs from the front; an idle worker steals the most expensive
+   * job at the front of any other queue.
+   */
+  struct WorkerQueue {
+    WorkerQueue() : steals(0), executed(0) {}
+
+    mutable boost::mutex mutex;
+    std::deque<boost::shared_ptr<Task> > tasks;
+    size_t steals;
+    size_t executed;
+  };
+
   /**
    * The main loop executed by each thread.
    **/
-  void Execute();
+  void Execute(size_t worker);
+
+  boost::shared_ptr<Task> Pop(size_t worker);
+  boost::shared_ptr<Task> Steal(size_t thief);
 
-  std::queue<boost::shared_ptr<Task> > m_tasks;
+  std::vector<WorkerQueue*> m_queues;
   boost::thread_group m_threads;
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
   boost::condition_variable m_threadAvailable;
+  size_t m_pending; //! number of queued jobs not yet taken by a worker
+  size_t m_nextQueue; //! round-robin position for Submit
   bool m_stopped;
   bool m_stopping;
   size_t m_queueLimit;
@@ -0,0 +1,179 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "ThreadPool.h"
+
+using namespace Moses;
+using namespace std;
+
+#ifdef WITH_THREADS
+
+namespace
+{
+
+//! records the order in which tasks are run
+class RecordingTask : public Task
+{
+public:
+  RecordingTask(int id, size_t cost, vector<int> &order, boost::mutex &mutex)
+    : m_id(id), m_cost(cost), m_order(order), m_mutex(mutex) {}
+
+  virtual void Run() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_order.push_back(m_id);
+  }
+
+  virtual size_t GetCost() const {
+    return m_cost;
+  }
+
+private:
+  int m_id;
+  size_t m_cost;
+  vector<int> &m_order;
+  boost::mutex &m_mutex;
+};
+
+//! keeps its worker busy until Release() is called
+class BlockingTask : public Task
+{
+public:
+  BlockingTask() : m_started(false), m_released(false) {}
+
+  virtual void Run() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_started = true;
+    m_cond.notify_all();
+    while (!m_released) m_cond.wait(lock);
+  }
+
+  void WaitStarted() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_started) m_cond.wait(lock);
+  }
+
+  void Release() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_released = true;
+    m_cond.notify_all();
+  }
+
+private:
+  bool m_started;
+  bool m_released;
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(thread_pool)
+
+BOOST_AUTO_TEST_CASE(expensive_tasks_first)
+{
+  vector<int> order;
+  boost::mutex mutex;
+  ThreadPool pool(1);
+
+  boost::shared_ptr<BlockingTask> blocker(new BlockingTask);
+  pool.Submit(blocker);
+  // wait until the only worker has taken the blocking task
+  while (pool.GetQueueDepth(0) > 0) boost::this_thread::yield();
+
+  size_t costs[] = {1, 5, 3, 5};
+  for (int i = 0; i < 4; ++i) {
+    pool.Submit(boost::shared_ptr<Task>(new RecordingTask(i, costs[i], order, mutex)));
+  }
+  BOOST_CHECK_EQUAL(pool.GetQueueDepth(0), 4);
+  blocker->Release();
+  pool.Stop(true);
+
+  int expected[] = {1, 3, 2, 0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected, expected + 4);
+}
+
+BOOST_AUTO_TEST_CASE(idle_worker_steals_most_expensive)
+{
+  vector<int> order;
+  boost::mutex mutex;
+  ThreadPool pool(2);
+
+  // occupy both workers
+  boost::shared_ptr<BlockingTask> first(new BlockingTask), second(new BlockingTask);
+  pool.Submit(first);
+  pool.Submit(second);
+  first->WaitStarted();
+  second->WaitStarted();
+
+  // queues are filled round-robin: queue 0 holds {2 (cost 9), 0 (cost 1)},
+  // queue 1 holds {3 (cost 7), 1 (cost 2)}
+  size_t costs[] = {1, 2, 9, 7};
+  for (int i = 0; i < 4; ++i) {
+    pool.Submit(boost::shared_ptr<Task>(new RecordingTask(i, costs[i], order, mutex)));
+  }
+
+  // the released worker drains its own queue, then steals from the other
+  // one, most expensive job first
+  second->Release();
+  for (;;) {
+    boost::mutex::scoped_lock lock(mutex);
+    if (order.size() == 4) break;
+    lock.unlock();
+    boost::this_thread::yield();
+  }
+  first->Release();
+  pool.Stop(true);
+
+  // which worker took which blocking task is up to the scheduler
+  int ownFirst[] = {2, 0, 3, 1};
+  int ownSecond[] = {3, 1, 2, 0};
+  BOOST_CHECK(std::equal(order.begin(), order.end(), ownFirst)
+              || std::equal(order.begin(), order.end(), ownSecond));
+  BOOST_CHECK(pool.GetStealCount(0) + pool.GetStealCount(1) >= 2);
+}
+
+BOOST_AUTO_TEST_CASE(all_tasks_run)
+{
+  vector<int> order;
+  boost::mutex mutex;
+  ThreadPool pool(4);
+  BOOST_CHECK_EQUAL(pool.GetNumThreads(), 4);
+
+  for (int i = 0; i < 100; ++i) {
+    pool.Submit(boost::shared_ptr<Task>(new RecordingTask(i, i % 7, order, mutex)));
+  }
+  pool.Stop(true);
+
+  BOOST_CHECK_EQUAL(order.size(), 100);
+  size_t executed = 0;
+  for (size_t i = 0; i < pool.GetNumThreads(); ++i) {
+    BOOST_CHECK_EQUAL(pool.GetQueueDepth(i), 0);
+    executed += pool.GetExecutedCount(i);
+  }
+  BOOST_CHECK_EQUAL(executed, 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 #include <algorithm>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
 #include <boost/unordered_map.hpp>
 
 #include "ThrowingFwrite.h"
@@ -43,6 +44,18 @@ private:
   typedef boost::unordered_map<Data, boost::dynamic_bitset<> > EncodeMap;
   EncodeMap m_encodeMap;
 
+  // Decoding table indexed by the next m_lookupBits bits of the stream in
+  // the order they are stored, ie. the first bit is the lowest. Codes that
+  // fit into the window are decoded with one lookup, longer codes have
+  // length 0 and are read bit by bit.
+  struct LookupEntry {
+    unsigned index; // into m_symbols
+    unsigned char length;
+  };
+  static const size_t MAX_LOOKUP_BITS = 10;
+  size_t m_lookupBits;
+  std::vector<LookupEntry> m_lookup;
+
   struct MinHeapSorter {
     std::vector<size_t>& m_vec;
 
@@ -142,6 +155,27 @@ private:
     m_symbols.swap(t_symbols);
   }
 
+  void CreateLookupTable() {
+    size_t maxLength = m_firstCodes.size() ? m_firstCodes.size() - 1 : 0;
+    m_lookupBits = std::min(maxLength, MAX_LOOKUP_BITS);
+    m_lookup.resize(size_t(1) << m_lookupBits);
+
+    for(size_t window = 0; window < m_lookup.size(); window++) {
+      LookupEntry entry = { 0, 0 };
+
+      size_t intCode = 0;
+      for(size_t len = 1; len <= m_lookupBits; len++) {
+        intCode = 2 * intCode + ((window >> (len - 1)) & 1);
+        if(intCode >= m_firstCodes[len]) {
+          entry.index = m_lengthIndex[len] + (intCode - m_firstCodes[len]);
+          entry.length = len;
+          break;
+        }
+      }
+      m_lookup[window] = entry;
+    }
+  }
+
   void CreateCodeMap() {
     for(size_t l = 1; l < m_lengthIndex.size(); l++) {
       size_t intCode = m_firstCodes[l];
@@ -176,6 +210,7 @@ public:
     std::vector<size_t> lengths;
     CalcLengths(begin, end, lengths);
     CalcCodes(lengths);
+    CreateLookupTable();
 
     if(forEncoding)
       CreateCodeMap();
@@ -195,7 +230,14 @@ public:
 
   template <class BitWrapper>
   Data Read(BitWrapper& bitWrapper) {
-    if(bitWrapper.TellFromEnd()) {
+    size_t bitsLeft = bitWrapper.TellFromEnd();
+    if(bitsLeft) {
+      const LookupEntry& entry = m_lookup[bitWrapper.Peek(m_lookupBits)];
+      if(entry.length && entry.length <= bitsLeft) {
+        bitWrapper.Skip(entry.length);
+        return m_symbols[entry.index];
+      }
+
       size_t intCode = bitWrapper.Read();
       size_t len = 1;
       while(intCode < m_firstCodes[len]) {
@@ -224,6 +266,8 @@ public:
     m_lengthIndex.resize(size);
     read += std::fread(&m_lengthIndex[0], sizeof(size_t), size, pFile);
 
+    CreateLookupTable();
+
     return std::ftell(pFile) - start;
   }
 
@@ -246,6 +290,9 @@ public:
   }
 };
 
+template <typename Data>
+const size_t CanonicalHuffman<Data>::MAX_LOOKUP_BITS;
+
 template <class Container = std::string>
 class BitWrapper
 {
@@ -277,6 +324,31 @@ public:
     return (m_currentValue & m_mask);
   }
 
+  //! the next bits bits without consuming them, the first one lowest. Zero past the end
+  size_t Peek(size_t bits) const {
+    typedef typename boost::make_unsigned<typename Container::value_type>::type UnsignedValue;
+
+    size_t value = 0;
+    size_t got = 0;
+    size_t bitPos = m_bitPos;
+    while(got < bits) {
+      size_t pos = bitPos / m_valueBits;
+      if(pos >= m_data.size())
+        break;
+      size_t offset = bitPos % m_valueBits;
+      value |= (size_t(UnsignedValue(m_data[pos])) >> offset) << got;
+      got += m_valueBits - offset;
+      bitPos += m_valueBits - offset;
+    }
+    return value & ((size_t(1) << bits) - 1);
+  }
+
+  //! same as calling Read() bits times, as long as bits <= TellFromEnd()
+  void Skip(size_t bits) {
+    if(bits)
+      Seek(m_bitPos + bits);
+  }
+
   void Put(bool bit) {
     if(m_bitPos % m_valueBits == 0)
       m_data.push_back(0);
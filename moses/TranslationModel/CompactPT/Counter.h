@@ -0,0 +1,278 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_Counter_h
+#define moses_Counter_h
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include "util/file.hh"
+
+namespace Moses
+{
+
+/** Frequencies of symbols, for building Huffman codes.
+ *
+ * Counts are added to a hash map. With a limit on its number of entries,
+ * a full map is written to a temporary file sorted by symbol and cleared.
+ * Collect() merges these sorted runs in one streaming pass, so each symbol
+ * is held in memory once, in a compact sorted list. The counts are read
+ * from that list, in order of the symbols, whether anything was spilled or
+ * not.
+ */
+template <typename DataType>
+class Counter
+{
+public:
+  typedef boost::unordered_map<DataType, size_t> FreqMap;
+  typedef typename FreqMap::mapped_type mapped_type;
+  typedef std::pair<DataType, mapped_type> value_type;
+  typedef std::vector<value_type> CountVec;
+  typedef typename CountVec::const_iterator iterator;
+
+private:
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+  FreqMap m_freqMap;
+  CountVec m_counts; //! filled by Collect(), sorted by symbol
+  size_t m_maxSize;
+  std::vector<DataType> m_bestVec;
+
+  // with a limit on the number of entries, counts are spilled to
+  // temporary files and merged again by Collect()
+  size_t m_maxEntries;
+  std::string m_spillPath;
+  std::vector<std::FILE*> m_spills;
+
+  struct FreqSorter {
+    bool operator()(const value_type& a, const value_type& b) const {
+      if(a.second > b.second)
+        return true;
+      // Check impact on translation quality!
+      if(a.second == b.second && a.first > b.first)
+        return true;
+      return false;
+    }
+  };
+
+  static bool LessData(const value_type& a, const value_type& b) {
+    return a.first < b.first;
+  }
+
+  //! head of one sorted spill file during the merge
+  struct Head {
+    value_type count;
+    size_t spill;
+    bool operator<(const Head& other) const {
+      // std::priority_queue puts the largest first
+      return other.count.first < count.first;
+    }
+  };
+
+  static bool Read(std::FILE* spill, value_type& count) {
+    return std::fread(&count.first, sizeof(DataType), 1, spill) == 1
+           && std::fread(&count.second, sizeof(mapped_type), 1, spill) == 1;
+  }
+
+  // call with the lock held
+  void Spill() {
+    CountVec sorted(m_freqMap.begin(), m_freqMap.end());
+    FreqMap().swap(m_freqMap);
+    std::sort(sorted.begin(), sorted.end(), LessData);
+
+    std::FILE* spill = util::FMakeTemp(m_spillPath);
+    for(typename CountVec::const_iterator it = sorted.begin(); it != sorted.end(); it++) {
+      util::WriteOrThrow(spill, &it->first, sizeof(DataType));
+      util::WriteOrThrow(spill, &it->second, sizeof(mapped_type));
+    }
+    m_spills.push_back(spill);
+  }
+
+  // call with the lock held
+  void SpillIfFull() {
+    if(m_maxEntries && m_freqMap.size() > m_maxEntries)
+      Spill();
+  }
+
+  // call with the lock held
+  void MergeSpills() {
+    std::priority_queue<Head> heads;
+    for(size_t i = 0; i < m_spills.size(); i++) {
+      std::rewind(m_spills[i]);
+      Head head;
+      head.spill = i;
+      if(Read(m_spills[i], head.count))
+        heads.push(head);
+    }
+
+    while(!heads.empty()) {
+      Head head = heads.top();
+      heads.pop();
+      if(!m_counts.empty() && !(m_counts.back().first < head.count.first))
+        m_counts.back().second += head.count.second;
+      else
+        m_counts.push_back(head.count);
+      if(Read(m_spills[head.spill], head.count))
+        heads.push(head);
+    }
+
+    for(size_t i = 0; i < m_spills.size(); i++)
+      std::fclose(m_spills[i]);
+    m_spills.clear();
+  }
+
+public:
+  Counter() : m_maxSize(0), m_maxEntries(0) {}
+
+  ~Counter() {
+    for(size_t i = 0; i < m_spills.size(); i++)
+      std::fclose(m_spills[i]);
+  }
+
+  //! keep at most maxEntries counts in memory, spill the rest to temporary files at spillPath
+  void SetMaxEntries(size_t maxEntries, const std::string& spillPath) {
+    m_maxEntries = maxEntries;
+    m_spillPath = spillPath;
+  }
+
+  //! counts in order of the symbols, after Collect()
+  iterator Begin() const {
+    return m_counts.begin();
+  }
+
+  iterator End() const {
+    return m_counts.end();
+  }
+
+  void Increase(DataType data) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_freqMap[data]++;
+  }
+
+  void IncreaseBy(DataType data, size_t num) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_freqMap[data] += num;
+  }
+
+  //! add counts collected elsewhere, eg. by one thread, and clear them
+  void Merge(FreqMap& counts) {
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(m_mutex);
+#endif
+      for(typename FreqMap::iterator it = counts.begin(); it != counts.end(); it++)
+        m_freqMap[it->first] += it->second;
+      SpillIfFull();
+    }
+    counts.clear();
+  }
+
+  //! gather all counts into the sorted list, once no more counts are added
+  void Collect() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    if(m_spills.empty()) {
+      m_counts.insert(m_counts.end(), m_freqMap.begin(), m_freqMap.end());
+      FreqMap().swap(m_freqMap);
+      std::sort(m_counts.begin(), m_counts.end(), LessData);
+    } else {
+      if(!m_freqMap.empty())
+        Spill();
+      MergeSpills();
+    }
+    m_maxEntries = 0;
+  }
+
+  //! number of symbols, after Collect()
+  size_t Size() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    return m_counts.size();
+  }
+
+  //! map the collected counts to the maxSize most frequent symbols
+  void Quantize(size_t maxSize) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_maxSize = maxSize;
+    CountVec freqVec(m_counts);
+    std::sort(freqVec.begin(), freqVec.end(), FreqSorter());
+
+    for(size_t i = 0; i < freqVec.size() && i < m_maxSize; i++)
+      m_bestVec.push_back(freqVec[i].first);
+
+    std::sort(m_bestVec.begin(), m_bestVec.end());
+
+    FreqMap t_freqMap;
+    for(typename CountVec::iterator it = freqVec.begin(); it != freqVec.end(); it++) {
+      DataType closest = LowerBound(it->first);
+      t_freqMap[closest] += it->second;
+    }
+
+    m_counts.assign(t_freqMap.begin(), t_freqMap.end());
+    std::sort(m_counts.begin(), m_counts.end(), LessData);
+  }
+
+  void Clear() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_freqMap.clear();
+    m_counts.clear();
+  }
+
+  DataType LowerBound(DataType data) {
+    if(m_maxSize == 0 || m_bestVec.size() == 0)
+      return data;
+    else {
+      typename std::vector<DataType>::iterator it
+      = std::lower_bound(m_bestVec.begin(), m_bestVec.end(), data);
+      if(it != m_bestVec.end())
+        return *it;
+      else
+        return m_bestVec.back();
+    }
+  }
+};
+
+}
+
+#endif
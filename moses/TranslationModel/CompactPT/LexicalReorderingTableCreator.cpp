@@ -138,6 +138,7 @@ void LexicalReorderingTableCreator::CalcHuffmanCodes()
   std::vector<ScoreTree*>::iterator treeIt = m_scoreTrees.begin();
   for(std::vector<ScoreCounter*>::iterator it = m_scoreCounters.begin();
       it != m_scoreCounters.end(); it++) {
+    (*it)->Collect();
     if(m_quantize)
       (*it)->Quantize(m_quantize);
 
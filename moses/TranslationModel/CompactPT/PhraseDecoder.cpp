@@ -34,12 +34,14 @@ PhraseDecoder::PhraseDecoder(
   const std::vector<FactorType>* input,
   const std::vector<FactorType>* output,
   size_t numScoreComponent,
-  const std::vector<float>* weight
+  const std::vector<float>* weight,
+  size_t decodingCacheBytes
 )
   : m_coding(None), m_numScoreComponent(numScoreComponent),
     m_containsAlignmentInfo(true), m_maxRank(0),
     m_symbolTree(0), m_multipleScoreTrees(false),
     m_scoreTrees(1), m_alignTree(0),
+    m_decodingCache(decodingCacheBytes),
     m_phraseDictionary(phraseDictionary), m_input(input), m_output(output),
     m_weight(weight),
     m_separator(" ||| ")
@@ -450,9 +452,9 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
   return tpv;
 }
 
-void PhraseDecoder::PruneCache()
+ShardedCacheStats PhraseDecoder::GetCacheStats() const
 {
-  m_decodingCache.Prune();
+  return m_decodingCache.GetStats();
 }
 
 }
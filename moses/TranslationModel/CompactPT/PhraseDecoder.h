@@ -122,7 +122,8 @@ public:
     const std::vector<FactorType>* input,
     const std::vector<FactorType>* output,
     size_t numScoreComponent,
-    const std::vector<float>* weight
+    const std::vector<float>* weight,
+    size_t decodingCacheBytes
   );
 
   ~PhraseDecoder();
@@ -138,7 +139,7 @@ public:
                                          bool topLevel,
                                          bool eval);
 
-  void PruneCache();
+  ShardedCacheStats GetCacheStats() const;
 };
 
 }
@@ -47,6 +47,7 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line, true)
   ,m_inMemory(true)
   ,m_useAlignmentInfo(true)
+  ,m_decodingCacheSize(128)
   ,m_hash(10, 16)
   ,m_phraseDecoder(0)
   ,m_weight(0)
@@ -70,7 +71,8 @@ void PhraseDictionaryCompact::Load()
     throw runtime_error("Error: File " + tFilePath + " does not exist.");
 
   m_phraseDecoder = new PhraseDecoder(*this, &m_input, &m_output,
-                                      m_numScoreComponents, &m_weight);
+                                      m_numScoreComponents, &m_weight,
+                                      m_decodingCacheSize << 20);
 
   std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
 
@@ -96,6 +98,15 @@ void PhraseDictionaryCompact::Load()
                  "Not successfully loaded");
 }
 
+void PhraseDictionaryCompact::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "decoding-cache-size") {
+    m_decodingCacheSize = Scan<size_t>(value);
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 // now properly declared in TargetPhraseCollection.h
 // and defined in TargetPhraseCollection.cpp
 // struct CompareTargetPhrase {
@@ -171,6 +182,31 @@ void PhraseDictionaryCompact::CacheForCleanup(TargetPhraseCollection* tpc)
   ref.push_back(tpc);
 }
 
+void PhraseDictionaryCompact::CacheTargetPhrases(const Phrase &source) const
+{
+  PhraseDictionaryCompact &self = const_cast<PhraseDictionaryCompact&>(*this);
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(self.m_sentenceMutex);
+  PhraseCache &ref = self.m_sentenceCache[boost::this_thread::get_id()];
+  size_t before = ref.size();
+  lock.unlock();
+#else
+  PhraseCache &ref = self.m_sentenceCache;
+  size_t before = ref.size();
+#endif
+
+  GetTargetPhraseCollectionLEGACY(source);
+
+  // the shared cache holds a copy, and warm-up or prefetching threads never
+  // finish a sentence, so drop the original right away
+#ifdef WITH_THREADS
+  lock.lock();
+#endif
+  for(size_t i = before; i < ref.size(); ++i)
+    delete ref[i];
+  ref.resize(before);
+}
+
 void PhraseDictionaryCompact::AddEquivPhrase(const Phrase &source,
     const TargetPhrase &targetPhrase) { }
 
@@ -179,7 +215,8 @@ void PhraseDictionaryCompact::CleanUpAfterSentenceProcessing(const InputType &so
   if(!m_inMemory)
     m_hash.KeepNLastRanges(0.01, 0.2);
 
-  m_phraseDecoder->PruneCache();
+  VERBOSE(2, "Compact phrase table decoding cache: "
+          << m_phraseDecoder->GetCacheStats() << std::endl);
 
 #ifdef WITH_THREADS
   boost::mutex::scoped_lock lock(m_sentenceMutex);
@@ -50,6 +50,7 @@ protected:
 
   bool m_inMemory;
   bool m_useAlignmentInfo;
+  size_t m_decodingCacheSize; // in MB, shared by all threads
 
   typedef std::vector<TargetPhraseCollection*> PhraseCache;
 #ifdef WITH_THREADS
@@ -74,6 +75,8 @@ public:
 
   void Load();
 
+  void SetParameter(const std::string& key, const std::string& value);
+
   const TargetPhraseCollection* GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
 
@@ -82,6 +85,11 @@ public:
   void CacheForCleanup(TargetPhraseCollection* tpc);
   void CleanUpAfterSentenceProcessing(const InputType &source);
 
+  bool SupportsPrefetch() const {
+    return true;
+  }
+  void CacheTargetPhrases(const Phrase &source) const;
+
   virtual ChartRuleLookupManager *CreateRuleLookupManager(
     const ChartParser &,
     const ChartCellCollectionBase &,
@@ -52,7 +52,8 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
                                        bool multipleScoreTrees,
                                        size_t quantize,
                                        size_t maxRank,
-                                       bool warnMe
+                                       bool warnMe,
+                                       size_t memoryBudget
 #ifdef WITH_THREADS
                                        , size_t threads
 #endif
@@ -91,6 +92,19 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     *it = new ScoreCounter();
   m_scoreTrees.resize(m_multipleScoreTrees ? m_numScoreComponent : 1);
 
+  if(memoryBudget) {
+    // give half of the budget (in MB) to the counters, the largest
+    // structures of the encoding pass, at roughly 48 bytes per count
+    size_t numCounters = m_scoreCounters.size() + 2;
+    size_t maxEntries = std::max<size_t>((memoryBudget << 20) / 2 / 48 / numCounters, 1024);
+    std::string spillPath = tempfilePath.size() ? tempfilePath : "/tmp/";
+
+    m_symbolCounter.SetMaxEntries(maxEntries, spillPath);
+    m_alignCounter.SetMaxEntries(maxEntries, spillPath);
+    for(size_t i = 0; i < m_scoreCounters.size(); i++)
+      m_scoreCounters[i]->SetMaxEntries(maxEntries, spillPath);
+  }
+
   // 0th pass
   if(m_coding == REnc) {
     size_t found = inPath.find_last_of("/\\");
@@ -379,6 +393,11 @@ void PhraseTableCreator::CompressTargetPhrases()
 
 void PhraseTableCreator::CalcHuffmanCodes()
 {
+  m_symbolCounter.Collect();
+  m_alignCounter.Collect();
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    m_scoreCounters[i]->Collect();
+
   std::cerr << "\tCreating Huffman codes for " << m_symbolCounter.Size()
             << " target phrase symbols" << std::endl;
 
@@ -473,6 +492,23 @@ unsigned PhraseTableCreator::GetOrAddTargetSymbolId(std::string& symbol)
   }
 }
 
+unsigned PhraseTableCreator::GetOrAddTargetSymbolId(std::string& symbol,
+    EncodingContext& context)
+{
+  boost::unordered_map<std::string, unsigned>::iterator it
+  = context.targetSymbolIds.find(symbol);
+  if(it != context.targetSymbolIds.end())
+    return it->second;
+
+  // bound the size of the thread-local copy
+  if(context.targetSymbolIds.size() >= (1ul << 20))
+    context.targetSymbolIds.clear();
+
+  unsigned value = GetOrAddTargetSymbolId(symbol);
+  context.targetSymbolIds[symbol] = value;
+  return value;
+}
+
 unsigned PhraseTableCreator::GetRank(unsigned srcIdx, unsigned trgIdx)
 {
   size_t srcTrgIdx = m_lexicalTableIndex[srcIdx];
@@ -535,26 +571,28 @@ unsigned PhraseTableCreator::EncodePREncSymbol2(int left, int right, unsigned ra
 }
 
 void PhraseTableCreator::EncodeTargetPhraseNone(std::vector<std::string>& t,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::stringstream encodedTargetPhrase;
   size_t j = 0;
   while(j < t.size()) {
-    unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
+    unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j], context);
 
-    m_symbolCounter.Increase(targetSymbolId);
+    context.symbolCounts[targetSymbolId]++;
     os.write((char*)&targetSymbolId, sizeof(targetSymbolId));
     j++;
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   os.write((char*)&stopSymbolId, sizeof(stopSymbolId));
-  m_symbolCounter.Increase(stopSymbolId);
+  context.symbolCounts[stopSymbolId]++;
 }
 
 void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     std::vector<std::string>& t,
     std::set<AlignPoint>& a,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::stringstream encodedTargetPhrase;
@@ -564,7 +602,7 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     a2[it->second].push_back(it->first);
 
   for(size_t i = 0; i < t.size(); i++) {
-    unsigned idxTarget = GetOrAddTargetSymbolId(t[i]);
+    unsigned idxTarget = GetOrAddTargetSymbolId(t[i], context);
     unsigned encodedSymbol = -1;
 
     unsigned bestSrcPos = s.size();
@@ -598,19 +636,20 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     }
 
     os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-    m_symbolCounter.Increase(encodedSymbol);
+    context.symbolCounts[encodedSymbol]++;
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   unsigned encodedSymbol = EncodeREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
+  context.symbolCounts[encodedSymbol]++;
 }
 
 void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
     std::vector<std::string>& t,
     std::set<AlignPoint>& a,
     size_t ownRank,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::vector<unsigned> encodedSymbols(t.size());
@@ -660,25 +699,26 @@ void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
   while(j < t.size()) {
     if(encodedSymbolsLengths[j] > 0) {
       unsigned encodedSymbol = encodedSymbols[j];
-      m_symbolCounter.Increase(encodedSymbol);
+      context.symbolCounts[encodedSymbol]++;
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j += encodedSymbolsLengths[j];
     } else {
-      unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
+      unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j], context);
       unsigned encodedSymbol = EncodePREncSymbol1(targetSymbolId);
-      m_symbolCounter.Increase(encodedSymbol);
+      context.symbolCounts[encodedSymbol]++;
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j++;
     }
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   unsigned encodedSymbol = EncodePREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
+  context.symbolCounts[encodedSymbol]++;
 }
 
-void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream& os)
+void PhraseTableCreator::EncodeScores(std::vector<float>& scores,
+                                      EncodingContext& context, std::ostream& os)
 {
   size_t c = 0;
   float score;
@@ -687,25 +727,27 @@ void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream&
     score = scores[c];
     score = FloorScore(TransformScore(score));
     os.write((char*)&score, sizeof(score));
-    m_scoreCounters[m_multipleScoreTrees ? c : 0]->Increase(score);
+    context.scoreCounts[m_multipleScoreTrees ? c : 0][score]++;
     c++;
   }
 }
 
 void PhraseTableCreator::EncodeAlignment(std::set<AlignPoint>& alignment,
+    EncodingContext& context,
     std::ostream& os)
 {
   for(std::set<AlignPoint>::iterator it = alignment.begin();
       it != alignment.end(); it++) {
     os.write((char*)&(*it), sizeof(AlignPoint));
-    m_alignCounter.Increase(*it);
+    context.alignCounts[*it]++;
   }
   AlignPoint stop(-1, -1);
   os.write((char*) &stop, sizeof(AlignPoint));
-  m_alignCounter.Increase(stop);
+  context.alignCounts[stop]++;
 }
 
-std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, size_t ownRank)
+std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, size_t ownRank,
+    EncodingContext& context)
 {
   std::string sourcePhraseStr = tokens[0];
   std::string targetPhraseStr = tokens[1];
@@ -718,8 +760,8 @@ std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, siz
   std::vector<std::string> s = Tokenize(sourcePhraseStr);
 
   size_t phraseLength = s.size();
-  if(m_maxPhraseLength < phraseLength)
-    m_maxPhraseLength = phraseLength;
+  if(context.maxPhraseLength < phraseLength)
+    context.maxPhraseLength = phraseLength;
 
   std::vector<std::string> t = Tokenize(targetPhraseStr);
   std::vector<float> scores = Tokenize<float>(scoresStr);
@@ -743,21 +785,41 @@ std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, siz
   std::stringstream encodedTargetPhrase;
 
   if(m_coding == PREnc) {
-    EncodeTargetPhrasePREnc(s, t, a, ownRank, encodedTargetPhrase);
+    EncodeTargetPhrasePREnc(s, t, a, ownRank, context, encodedTargetPhrase);
   } else if(m_coding == REnc) {
-    EncodeTargetPhraseREnc(s, t, a, encodedTargetPhrase);
+    EncodeTargetPhraseREnc(s, t, a, context, encodedTargetPhrase);
   } else {
-    EncodeTargetPhraseNone(t, encodedTargetPhrase);
+    EncodeTargetPhraseNone(t, context, encodedTargetPhrase);
   }
 
-  EncodeScores(scores, encodedTargetPhrase);
+  EncodeScores(scores, context, encodedTargetPhrase);
 
   if(m_useAlignmentInfo)
-    EncodeAlignment(a, encodedTargetPhrase);
+    EncodeAlignment(a, context, encodedTargetPhrase);
 
   return encodedTargetPhrase.str();
 }
 
+void PhraseTableCreator::InitEncodingContext(EncodingContext& context)
+{
+  context.scoreCounts.resize(m_scoreCounters.size());
+  context.maxPhraseLength = 0;
+}
+
+void PhraseTableCreator::MergeEncodingContext(EncodingContext& context)
+{
+  m_symbolCounter.Merge(context.symbolCounts);
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    m_scoreCounters[i]->Merge(context.scoreCounts[i]);
+  m_alignCounter.Merge(context.alignCounts);
+
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  if(m_maxPhraseLength < context.maxPhraseLength)
+    m_maxPhraseLength = context.maxPhraseLength;
+}
+
 std::string PhraseTableCreator::CompressEncodedCollection(std::string encodedCollection)
 {
   enum EncodeState {
@@ -1128,6 +1190,9 @@ void EncodingTask::operator()()
 {
   size_t lineNum = 0;
 
+  PhraseTableCreator::EncodingContext context;
+  m_creator.InitEncodingContext(context);
+
   std::vector<std::string> lines;
   size_t max_lines = 1000;
   lines.reserve(max_lines);
@@ -1176,13 +1241,15 @@ void EncodingTask::operator()()
       if(m_creator.m_coding == PhraseTableCreator::PREnc)
         ownRank = m_creator.m_ranks[lineNum + i];
 
-      std::string encodedLine = m_creator.EncodeLine(tokens, ownRank);
+      std::string encodedLine = m_creator.EncodeLine(tokens, ownRank, context);
 
       PackedItem packedItem(lineNum + i, tokens[0], encodedLine, ownRank);
       result.push_back(packedItem);
     }
     lines.clear();
 
+    m_creator.MergeEncodingContext(context);
+
     {
 #ifdef WITH_THREADS
       boost::mutex::scoped_lock lock(m_mutex);
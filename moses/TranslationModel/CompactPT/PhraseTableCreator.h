@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_PhraseTableCreator_h
 #define moses_PhraseTableCreator_h
 
+#include <cstdio>
 #include <sstream>
 #include <iostream>
 #include <queue>
@@ -32,126 +33,20 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/InputFileStream.h"
 #include "moses/ThreadPool.h"
 #include "moses/Util.h"
+#include "util/file.hh"
 
 #include "BlockHashIndex.h"
 #include "StringVector.h"
 #include "StringVectorTemp.h"
 #include "CanonicalHuffman.h"
+#include "Counter.h"
+#include "ThrowingFwrite.h"
 
 namespace Moses
 {
 
 typedef std::pair<unsigned char, unsigned char> AlignPoint;
 
-template <typename DataType>
-class Counter
-{
-public:
-  typedef boost::unordered_map<DataType, size_t> FreqMap;
-  typedef typename FreqMap::iterator iterator;
-  typedef typename FreqMap::mapped_type mapped_type;
-  typedef typename FreqMap::value_type value_type;
-
-private:
-#ifdef WITH_THREADS
-  boost::mutex m_mutex;
-#endif
-  FreqMap m_freqMap;
-  size_t m_maxSize;
-  std::vector<DataType> m_bestVec;
-
-  struct FreqSorter {
-    bool operator()(const value_type& a, const value_type& b) const {
-      if(a.second > b.second)
-        return true;
-      // Check impact on translation quality!
-      if(a.second == b.second && a.first > b.first)
-        return true;
-      return false;
-    }
-  };
-
-public:
-  Counter() : m_maxSize(0) {}
-
-  iterator Begin() {
-    return m_freqMap.begin();
-  }
-
-  iterator End() {
-    return m_freqMap.end();
-  }
-
-  void Increase(DataType data) {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    m_freqMap[data]++;
-  }
-
-  void IncreaseBy(DataType data, size_t num) {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    m_freqMap[data] += num;
-  }
-
-  mapped_type& operator[](DataType data) {
-    return m_freqMap[data];
-  }
-
-  size_t Size() {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    return m_freqMap.size();
-  }
-
-  void Quantize(size_t maxSize) {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    m_maxSize = maxSize;
-    std::vector<std::pair<DataType, mapped_type> > freqVec;
-    freqVec.insert(freqVec.begin(), m_freqMap.begin(), m_freqMap.end());
-    std::sort(freqVec.begin(), freqVec.end(), FreqSorter());
-
-    for(size_t i = 0; i < freqVec.size() && i < m_maxSize; i++)
-      m_bestVec.push_back(freqVec[i].first);
-
-    std::sort(m_bestVec.begin(), m_bestVec.end());
-
-    FreqMap t_freqMap;
-    for(typename std::vector<std::pair<DataType, mapped_type> >::iterator it
-        = freqVec.begin(); it != freqVec.end(); it++) {
-      DataType closest = LowerBound(it->first);
-      t_freqMap[closest] += it->second;
-    }
-
-    m_freqMap.swap(t_freqMap);
-  }
-
-  void Clear() {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    m_freqMap.clear();
-  }
-
-  DataType LowerBound(DataType data) {
-    if(m_maxSize == 0 || m_bestVec.size() == 0)
-      return data;
-    else {
-      typename std::vector<DataType>::iterator it
-      = std::lower_bound(m_bestVec.begin(), m_bestVec.end(), data);
-      if(it != m_bestVec.end())
-        return *it;
-      else
-        return m_bestVec.back();
-    }
-  }
-};
-
 class PackedItem
 {
 private:
@@ -264,6 +159,17 @@ private:
   std::vector<ScoreCounter*> m_scoreCounters;
   std::vector<ScoreTree*> m_scoreTrees;
 
+  // State of one thread in the encoding pass. Counts, the maximum phrase
+  // length and target symbol ids are kept here and merged into the shared
+  // state once per batch of lines, so threads rarely wait for each other.
+  struct EncodingContext {
+    SymbolCounter::FreqMap symbolCounts;
+    std::vector<ScoreCounter::FreqMap> scoreCounts;
+    AlignCounter::FreqMap alignCounts;
+    size_t maxPhraseLength;
+    boost::unordered_map<std::string, unsigned> targetSymbolIds;
+  };
+
   std::priority_queue<PackedItem> m_queue;
   long m_lastFlushedLine;
   long m_lastFlushedSourceNum;
@@ -281,6 +187,7 @@ private:
   void AddTargetSymbolId(std::string& symbol);
   unsigned GetTargetSymbolId(std::string& symbol);
   unsigned GetOrAddTargetSymbolId(std::string& symbol);
+  unsigned GetOrAddTargetSymbolId(std::string& symbol, EncodingContext& context);
 
   unsigned GetRank(unsigned srcIdx, unsigned trgIdx);
 
@@ -292,20 +199,25 @@ private:
   unsigned EncodePREncSymbol2(int lOff, int rOff, unsigned rank);
 
   void EncodeTargetPhraseNone(std::vector<std::string>& t,
+                              EncodingContext& context,
                               std::ostream& os);
 
   void EncodeTargetPhraseREnc(std::vector<std::string>& s,
                               std::vector<std::string>& t,
                               std::set<AlignPoint>& a,
+                              EncodingContext& context,
                               std::ostream& os);
 
   void EncodeTargetPhrasePREnc(std::vector<std::string>& s,
                                std::vector<std::string>& t,
                                std::set<AlignPoint>& a, size_t ownRank,
+                               EncodingContext& context,
                                std::ostream& os);
 
-  void EncodeScores(std::vector<float>& scores, std::ostream& os);
-  void EncodeAlignment(std::set<AlignPoint>& alignment, std::ostream& os);
+  void EncodeScores(std::vector<float>& scores, EncodingContext& context,
+                    std::ostream& os);
+  void EncodeAlignment(std::set<AlignPoint>& alignment, EncodingContext& context,
+                       std::ostream& os);
 
   std::string MakeSourceKey(std::string&);
   std::string MakeSourceTargetKey(std::string&, std::string&);
@@ -320,7 +232,10 @@ private:
   void AddRankedLine(PackedItem& pi);
   void FlushRankedQueue(bool force = false);
 
-  std::string EncodeLine(std::vector<std::string>& tokens, size_t ownRank);
+  std::string EncodeLine(std::vector<std::string>& tokens, size_t ownRank,
+                         EncodingContext& context);
+  void InitEncodingContext(EncodingContext& context);
+  void MergeEncodingContext(EncodingContext& context);
   void AddEncodedLine(PackedItem& pi);
   void FlushEncodedQueue(bool force = false);
 
@@ -342,7 +257,8 @@ public:
                      bool multipleScoreTrees = true,
                      size_t quantize = 0,
                      size_t maxRank = 100,
-                     bool warnMe = true
+                     bool warnMe = true,
+                     size_t memoryBudget = 0
 #ifdef WITH_THREADS
                                    , size_t threads = 2
 #endif
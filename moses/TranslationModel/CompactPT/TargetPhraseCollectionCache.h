@@ -22,19 +22,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
+#include <algorithm>
+#include <utility>
 #include <vector>
 
-#ifdef WITH_THREADS
-#ifdef BOOST_HAS_PTHREADS
-#include <boost/thread/mutex.hpp>
-#endif
-#endif
-
 #include <boost/shared_ptr.hpp>
 
 #include "moses/Phrase.h"
+#include "moses/ShardedCache.h"
 #include "moses/TargetPhraseCollection.h"
 
 namespace Moses
@@ -44,125 +39,61 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Implementation of Persistent Cache, shared by all threads **/
 class TargetPhraseCollectionCache
 {
 private:
-  size_t m_max;
-  float m_tolerance;
-
-  struct LastUsed {
-    clock_t m_clock;
-    TargetPhraseVectorPtr m_tpv;
-    size_t m_bitsLeft;
-
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
-
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
-  };
-
-  typedef std::map<Phrase, LastUsed> CacheMap;
-
-  CacheMap m_phraseCache;
-
-#ifdef WITH_THREADS
-  boost::mutex m_mutex;
-#endif
-
-public:
-
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
-
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
-  }
+  // translations and number of bits left to decode
+  typedef std::pair<TargetPhraseVectorPtr, size_t> Entry;
 
-  iterator Begin() {
-    return m_phraseCache.begin();
-  }
+  ShardedCache<Phrase, Entry> m_phraseCache;
 
-  const_iterator Begin() const {
-    return m_phraseCache.begin();
+  static size_t EstimateBytes(const Phrase &sourcePhrase, const TargetPhraseVector &tpv) {
+    size_t bytes = sizeof(Phrase) + sourcePhrase.GetSize() * sizeof(Word)
+                   + sizeof(TargetPhraseVector);
+    for(TargetPhraseVector::const_iterator it = tpv.begin(); it != tpv.end(); it++)
+      bytes += sizeof(TargetPhrase) + it->GetSize() * sizeof(Word);
+    return bytes;
   }
 
-  iterator End() {
-    return m_phraseCache.end();
-  }
+public:
 
-  const_iterator End() const {
-    return m_phraseCache.end();
+  TargetPhraseCollectionCache(size_t maxBytes = 128 << 20)
+    : m_phraseCache(maxBytes) {
   }
 
-  /** retrieve translations for source phrase from persistent cache **/
+  /** store translations for source phrase in persistent cache **/
   void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
              size_t bitsLeft = 0, size_t maxRank = 0) {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-
-    // check if source phrase is already in cache
-    iterator it = m_phraseCache.find(sourcePhrase);
-    if(it != m_phraseCache.end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        m_phraseCache[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        m_phraseCache[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
+    // if already in cache, just mark it as used
+    if(m_phraseCache.Touch(sourcePhrase))
+      return;
+    if(maxRank && tpv->size() > maxRank) {
+      TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
+      tpv_temp->resize(maxRank);
+      std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
+      tpv = tpv_temp;
     }
+    // another thread may have added it in the meantime, then Add is a no-op
+    m_phraseCache.Add(sourcePhrase, Entry(tpv, bitsLeft),
+                      EstimateBytes(sourcePhrase, *tpv));
   }
 
+  /** retrieve translations for source phrase from persistent cache **/
   std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-
-    iterator it = m_phraseCache.find(sourcePhrase);
-    if(it != m_phraseCache.end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
-      return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
+    Entry entry;
+    if(m_phraseCache.Find(sourcePhrase, entry))
+      return entry;
+    else
       return std::make_pair(TargetPhraseVectorPtr(), 0);
   }
 
-  // if cache full, reduce
-  void Prune() {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-
-    if(m_phraseCache.size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache.begin();
-          it != m_phraseCache.end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache.erase(p);
-
-        if(m_phraseCache.size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
-    }
+  ShardedCacheStats GetStats() const {
+    return m_phraseCache.GetStats();
   }
 
   void CleanUp() {
-#ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
-#endif
-    m_phraseCache.clear();
+    m_phraseCache.Clear();
   }
 
 };
@@ -19,7 +19,6 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
-#include <queue>
 #include "moses/TranslationModel/PhraseDictionary.h"
 #include "moses/StaticData.h"
 #include "moses/InputType.h"
@@ -27,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/DecodeStep.h"
 #include "moses/DecodeGraph.h"
 #include "moses/InputPath.h"
+#include "moses/InputFileStream.h"
 #include "util/exception.hh"
 
 using namespace std;
@@ -35,13 +35,59 @@ namespace Moses
 {
 std::vector<PhraseDictionary*> PhraseDictionary::s_staticColl;
 
-CacheColl::~CacheColl()
+namespace
 {
-  for (iterator iter = begin(); iter != end(); ++iter) {
-    std::pair<const TargetPhraseCollection*, clock_t> &key = iter->second;
-    const TargetPhraseCollection *tps = key.first;
-    delete tps;
+// rough memory use of a cached collection
+size_t EstimateBytes(const TargetPhraseCollection *tpc)
+{
+  size_t bytes = sizeof(TargetPhraseCollection);
+  if (tpc) {
+    TargetPhraseCollection::const_iterator iter;
+    for (iter = tpc->begin(); iter != tpc->end(); ++iter) {
+      bytes += sizeof(const TargetPhrase*) + sizeof(TargetPhrase)
+               + (*iter)->GetSize() * sizeof(Word);
+    }
+  }
+  return bytes;
+}
+}
+
+CacheColl::CacheColl(size_t maxBytes)
+  : m_cache(maxBytes)
+{
+}
+
+bool CacheColl::Find(size_t key, const TargetPhraseCollection *&tpc)
+{
+  TargetPhraseCollectionPtr found;
+  if (!m_cache.Find(key, found)) {
+    return false;
+  }
+  GetPinned().push_back(found);
+  tpc = found.get();
+  return true;
+}
+
+void CacheColl::Add(size_t key, const TargetPhraseCollection *tpc)
+{
+  TargetPhraseCollectionPtr added(tpc);
+  GetPinned().push_back(added);
+  m_cache.Add(key, added, EstimateBytes(tpc));
+}
+
+void CacheColl::ReleasePinned()
+{
+  GetPinned().clear();
+}
+
+CacheColl::PinnedColl &CacheColl::GetPinned()
+{
+  PinnedColl *pinned = m_pinned.get();
+  if (pinned == NULL) {
+    pinned = new PinnedColl;
+    m_pinned.reset(pinned);
   }
+  return *pinned;
 }
 
 PhraseDictionary::PhraseDictionary(const std::string &line, bool registerNow)
@@ -68,24 +114,14 @@ const TargetPhraseCollection *PhraseDictionary::GetTargetPhraseCollectionLEGACY(
 
     size_t hash = hash_value(src);
 
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter == cache.end()) {
+    if (!cache.Find(hash, ret)) {
       // not in cache, need to look up from phrase table
       ret = GetTargetPhraseCollectionNonCacheLEGACY(src);
       if (ret) {
         ret = new TargetPhraseCollection(*ret);
       }
 
-      std::pair<const TargetPhraseCollection*, clock_t> value(ret, clock());
-      cache[hash] = value;
-    } else {
-      // in cache. just use it
-      std::pair<const TargetPhraseCollection*, clock_t> &value = iter->second;
-      value.second = clock();
-
-      ret = value.first;
+      cache.Add(hash, ret);
     }
   } else {
     // don't use cache. look up from phrase table
@@ -114,8 +150,15 @@ void
 PhraseDictionary::
 SetParameter(const std::string& key, const std::string& value)
 {
-  if (key == "cache-size") {
+  if (key == "cache-size-mb") {
     m_maxCacheSize = Scan<size_t>(value);
+  } else if (key == "cache-size") {
+    // used to be a number of entries; only "off" still means the same
+    UTIL_THROW_IF2(Scan<size_t>(value) != 0, GetScoreProducerDescription()
+                   << ": cache-size is no longer supported, give the size of the cache in MB with cache-size-mb");
+    m_maxCacheSize = 0;
+  } else if (key == "cache-warmup") {
+    m_cacheWarmUpPath = value;
   } else if (key == "path") {
     m_filePath = value;
   } else if (key == "table-limit") {
@@ -200,48 +243,58 @@ GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 //  }
 //}
 
-// reduce presistent cache by half of maximum size
+// the shared cache bounds its own size, so between sentences a thread only
+// lets go of the collections it used
 void PhraseDictionary::ReduceCache() const
 {
-  Timer reduceCacheTime;
-  reduceCacheTime.start();
   CacheColl &cache = GetCache();
-  if (cache.size() <= m_maxCacheSize) return; // not full
-
-  // find cutoff for last used time
-  priority_queue< clock_t > lastUsedTimes;
-  CacheColl::iterator iter;
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    lastUsedTimes.push( iter->second.second );
-    iter++;
+  cache.ReleasePinned();
+  VERBOSE(3,"Persistent translation option cache: " << cache.GetStats() << std::endl);
+}
+
+void PhraseDictionary::InitializeCache()
+{
+  m_cache.reset(new CacheColl(m_maxCacheSize << 20));
+  if (m_cacheWarmUpPath.empty()) return;
+  if (!m_maxCacheSize || !SupportsPrefetch()) {
+    TRACE_ERR("WARNING: " << GetScoreProducerDescription()
+              << " cannot warm up its cache, ignoring cache-warmup" << std::endl);
+    return;
   }
-  for( size_t i=0; i < lastUsedTimes.size()-m_maxCacheSize/2; i++ )
-    lastUsedTimes.pop();
-  clock_t cutoffLastUsedTime = lastUsedTimes.top();
-
-  // remove all old entries
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    if (iter->second.second < cutoffLastUsedTime) {
-      CacheColl::iterator iterRemove = iter++;
-      delete iterRemove->second.first;
-      cache.erase(iterRemove);
-    } else iter++;
+
+  Timer warmUpTime;
+  warmUpTime.start();
+  InputFileStream in(m_cacheWarmUpPath);
+  std::string line;
+  size_t count = 0;
+  while (getline(in, line)) {
+    Phrase phrase;
+    phrase.CreateFromString(Input, m_input, line, NULL);
+    if (phrase.GetSize()) CacheTargetPhrases(phrase);
+    ++count;
   }
-  VERBOSE(2,"Reduced persistent translation option cache in " << reduceCacheTime << " seconds." << std::endl);
+  // the cache holds on to what it needs
+  m_cache->ReleasePinned();
+  VERBOSE(1,"Warmed up cache of " << GetScoreProducerDescription() << " with "
+          << count << " phrases in " << warmUpTime << " seconds: "
+          << m_cache->GetStats() << std::endl);
 }
 
-CacheColl &PhraseDictionary::GetCache() const
+void PhraseDictionary::Prefetch(const std::vector<Phrase> &phrases) const
 {
-  CacheColl *cache;
-  cache = m_cache.get();
-  if (cache == NULL) {
-    cache = new CacheColl;
-    m_cache.reset(cache);
+  if (!m_maxCacheSize || !SupportsPrefetch()) return;
+  CacheColl &cache = GetCache();
+  cache.ReleasePinned();
+  for (size_t i = 0; i < phrases.size(); ++i) {
+    CacheTargetPhrases(phrases[i]);
   }
-  assert(cache);
-  return *cache;
+}
+
+CacheColl &PhraseDictionary::GetCache() const
+{
+  UTIL_THROW_IF2(!m_cache, "Cache of " << GetScoreProducerDescription()
+                 << " used before InitializeCache()");
+  return *m_cache;
 }
 
 bool PhraseDictionary::SatisfyBackoff(const InputPath &inputPath) const
@@ -31,15 +31,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <vector>
 #include <string>
 #include <boost/unordered_map.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #ifdef WITH_THREADS
 #include <boost/thread/tss.hpp>
-#else
-#include <boost/scoped_ptr.hpp>
-#include <ctime>
 #endif
 
 #include "moses/Phrase.h"
+#include "moses/ShardedCache.h"
 #include "moses/TargetPhrase.h"
 #include "moses/TargetPhraseCollection.h"
 #include "moses/InputPath.h"
@@ -55,14 +55,45 @@ class ChartCellCollectionBase;
 class ChartRuleLookupManager;
 class ChartParser;
 
-class CacheColl : public boost::unordered_map<size_t, std::pair<const TargetPhraseCollection*, clock_t> >
+/** Translations of source phrases, shared by all threads and bounded in
+ * bytes. The key is the hash of the source phrase or the address of the
+ * phrase-table node.
+ *
+ * A collection can be evicted by one thread while another one still uses
+ * it, so each thread keeps a reference to every collection it looked up or
+ * added until it calls ReleasePinned(), normally between sentences.
+ */
+class CacheColl
 {
-// 1st = hash of source phrase/ address of phrase-table node
-// 2nd = all translations
-// 3rd = time of last access
-
 public:
-  ~CacheColl();
+  CacheColl(size_t maxBytes);
+
+  //! true if key is cached. tpc may be NULL if the phrase has no translations
+  bool Find(size_t key, const TargetPhraseCollection *&tpc);
+
+  //! take ownership of tpc and cache it, unless key is already cached
+  void Add(size_t key, const TargetPhraseCollection *tpc);
+
+  //! drop this thread's references to collections it used
+  void ReleasePinned();
+
+  ShardedCacheStats GetStats() const {
+    return m_cache.GetStats();
+  }
+
+private:
+  typedef boost::shared_ptr<const TargetPhraseCollection> TargetPhraseCollectionPtr;
+  typedef std::vector<TargetPhraseCollectionPtr> PinnedColl;
+
+  ShardedCache<size_t, TargetPhraseCollectionPtr> m_cache;
+
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<PinnedColl> m_pinned;
+#else
+  boost::scoped_ptr<PinnedColl> m_pinned;
+#endif
+
+  PinnedColl &GetPinned();
 };
 
 /**
@@ -155,6 +186,21 @@ public:
 
   void SetParameter(const std::string& key, const std::string& value);
 
+  //! create the cache and look up the phrases in the cache-warmup file, if any. Called after Load()
+  void InitializeCache();
+
+  //! true if CacheTargetPhrases() can fill the cache, for warm-up and prefetching
+  virtual bool SupportsPrefetch() const {
+    return false;
+  }
+
+  /** look up phrases in the shared cache ahead of decoding, so that
+   * sentences sharing them find them there. The calling thread keeps
+   * them until its next call, or until ReduceCache(). No-op without cache
+   * or unless SupportsPrefetch()
+   */
+  void Prefetch(const std::vector<Phrase> &phrases) const;
+
   // LEGACY
   //! find list of translations that can translates a portion of src. Used by confusion network decoding
   virtual const TargetPhraseCollectionWithSourcePhrase* GetTargetPhraseCollectionLEGACY(InputType const& src,WordsRange const& range) const;
@@ -175,18 +221,20 @@ protected:
   bool SatisfyBackoff(const InputPath &inputPath) const;
 
   // cache
-  size_t m_maxCacheSize; // 0 = no caching
+  size_t m_maxCacheSize; // in MB, 0 = no caching
+  std::string m_cacheWarmUpPath; // frequent source phrases, one per line
 
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::thread_specific_ptr<CacheColl> m_cache;
-#else
-  mutable boost::scoped_ptr<CacheColl> m_cache;
-#endif
+  boost::scoped_ptr<CacheColl> m_cache;
 
   virtual const TargetPhraseCollection *GetTargetPhraseCollectionNonCacheLEGACY(const Phrase& src) const;
   void ReduceCache() const;
 
+  /** look up src so that its translations end up in the cache, under the
+   * key the table's own lookups use. Only called if SupportsPrefetch() */
+  virtual void CacheTargetPhrases(const Phrase& src) const {
+    GetTargetPhraseCollectionLEGACY(src);
+  }
+
 protected:
   CacheColl &GetCache() const;
   size_t m_id;
@@ -49,6 +49,19 @@ PhraseDictionaryMemory::PhraseDictionaryMemory(const std::string &line)
 
 }
 
+void PhraseDictionaryMemory::Load()
+{
+  if (!RuleTableImage::IsImage(m_filePath)) {
+    RuleTableTrie::Load();
+    return;
+  }
+
+  // nodes are filled in from the image when they are first used
+  SetFeaturesToApply();
+  m_image.reset(new RuleTableImage(m_filePath, *this, m_input, m_output));
+  m_collection.AddImageNode(*m_image, m_image->GetRootNode());
+}
+
 TargetPhraseCollection &PhraseDictionaryMemory::GetOrCreateTargetPhraseCollection(
   const Phrase &source
   , const TargetPhrase &target
@@ -24,6 +24,9 @@
 #include "moses/InputType.h"
 #include "moses/NonTerminal.h"
 #include "moses/TranslationModel/RuleTable/Trie.h"
+#include "moses/TranslationModel/RuleTable/Image.h"
+
+#include <boost/scoped_ptr.hpp>
 
 namespace Moses
 {
@@ -45,6 +48,9 @@ protected:
 public:
   PhraseDictionaryMemory(const std::string &line);
 
+  //! maps a rule table image, or loads the text rule table
+  void Load();
+
   const PhraseDictionaryNodeMemory &GetRootNode() const {
     return m_collection;
   }
@@ -72,6 +78,7 @@ protected:
   void SortAndPrune();
 
   PhraseDictionaryNodeMemory m_collection;
+  boost::scoped_ptr<RuleTableImage> m_image;
 };
 
 }  // namespace Moses
@@ -22,12 +22,62 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "PhraseDictionaryNodeMemory.h"
 #include "moses/TargetPhrase.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
+#include "moses/TranslationModel/RuleTable/Image.h"
 
 using namespace std;
 
 namespace Moses
 {
 
+PhraseDictionaryNodeMemory::PhraseDictionaryNodeMemory(const PhraseDictionaryNodeMemory &copy)
+  : m_sourceTermMap(copy.m_sourceTermMap)
+  , m_nonTermMap(copy.m_nonTermMap)
+  , m_targetPhraseCollection(copy.m_targetPhraseCollection)
+  , m_imageNodes(copy.m_imageNodes)
+  , m_loaded(copy.m_loaded.load())
+{
+}
+
+PhraseDictionaryNodeMemory &PhraseDictionaryNodeMemory::operator=(const PhraseDictionaryNodeMemory &copy)
+{
+  m_sourceTermMap = copy.m_sourceTermMap;
+  m_nonTermMap = copy.m_nonTermMap;
+  m_targetPhraseCollection = copy.m_targetPhraseCollection;
+  m_imageNodes = copy.m_imageNodes;
+  m_loaded.store(copy.m_loaded.load());
+  return *this;
+}
+
+void PhraseDictionaryNodeMemory::AddImageNode(const RuleTableImage &image, uint64_t imageNode)
+{
+  if (!m_imageNodes) {
+    m_imageNodes.reset(new ImageNodes);
+    m_imageNodes->image = &image;
+  }
+  m_imageNodes->nodes.push_back(imageNode);
+  m_loaded.store(0);
+}
+
+void PhraseDictionaryNodeMemory::LoadFromImage(unsigned char part) const
+{
+  const RuleTableImage &image = *m_imageNodes->image;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(image.GetMutex(this));
+#endif
+  if (m_loaded.load(boost::memory_order_relaxed) & part) {
+    return;
+  }
+
+  // only this thread can see the part of the node being filled in
+  PhraseDictionaryNodeMemory &node = const_cast<PhraseDictionaryNodeMemory&>(*this);
+  if (part == ChildrenLoaded) {
+    image.LoadChildren(node, m_imageNodes->nodes);
+  } else {
+    image.LoadTargetPhrases(node.m_targetPhraseCollection, m_imageNodes->nodes);
+  }
+  m_loaded.fetch_or(part, boost::memory_order_release);
+}
+
 void PhraseDictionaryNodeMemory::Prune(size_t tableLimit)
 {
   // recusively prune
@@ -87,6 +137,7 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetChild(const Wor
   UTIL_THROW_IF2(sourceTerm.IsNonTerminal(),
                  "Not a terminal: " << sourceTerm);
 
+  EnsureChildren();
   TerminalMap::const_iterator p = m_sourceTermMap.find(sourceTerm);
   return (p == m_sourceTermMap.end()) ? NULL : &p->second;
 }
@@ -97,6 +148,7 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetNonTerminalChil
   UTIL_THROW_IF2(!targetNonTerm.IsNonTerminal(),
                  "Not a non-terminal: " << targetNonTerm);
 
+  EnsureChildren();
   NonTerminalMap::const_iterator p = m_nonTermMap.find(targetNonTerm);
   return (p == m_nonTermMap.end()) ? NULL : &p->second;
 }
@@ -108,6 +160,7 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetChild(const Wor
   UTIL_THROW_IF2(!targetNonTerm.IsNonTerminal(),
                  "Not a non-terminal: " << targetNonTerm);
 
+  EnsureChildren();
   NonTerminalMapKey key(sourceNonTerm, targetNonTerm);
   NonTerminalMap::const_iterator p = m_nonTermMap.find(key);
   return (p == m_nonTermMap.end()) ? NULL : &p->second;
@@ -119,6 +172,8 @@ void PhraseDictionaryNodeMemory::Remove()
   m_sourceTermMap.clear();
   m_nonTermMap.clear();
   m_targetPhraseCollection.Remove();
+  m_imageNodes.reset();
+  m_loaded.store(AllLoaded);
 }
 
 std::ostream& operator<<(std::ostream &out, const PhraseDictionaryNodeMemory &node)
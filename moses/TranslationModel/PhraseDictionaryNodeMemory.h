@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <map>
 #include <vector>
+#include <stdint.h>
 #include <iterator>
 #include <utility>
 #include <ostream>
@@ -31,7 +32,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/Terminal.h"
 #include "moses/NonTerminal.h"
 
+#include <boost/atomic.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/version.hpp>
 
@@ -40,6 +43,7 @@ namespace Moses
 
 class PhraseDictionaryMemory;
 class PhraseDictionaryScope3;
+class RuleTableImage;
 class PhraseDictionaryFuzzyMatch;
 
 //! @todo why?
@@ -132,11 +136,43 @@ private:
   NonTerminalMap m_nonTermMap;
   TargetPhraseCollection m_targetPhraseCollection;
 
+  // Nodes of a binary rule table image read their children and target
+  // phrases from it when first used, from one or more nodes of the image
+  // which map to the same words here.
+  enum {
+    ChildrenLoaded = 1,
+    TargetPhrasesLoaded = 2,
+    AllLoaded = 3
+  };
+  struct ImageNodes {
+    const RuleTableImage *image;
+    std::vector<uint64_t> nodes;
+  };
+  boost::shared_ptr<ImageNodes> m_imageNodes;
+  mutable boost::atomic<unsigned char> m_loaded;
+
+  void EnsureChildren() const {
+    if (!(m_loaded.load(boost::memory_order_acquire) & ChildrenLoaded)) {
+      LoadFromImage(ChildrenLoaded);
+    }
+  }
+  void EnsureTargetPhrases() const {
+    if (!(m_loaded.load(boost::memory_order_acquire) & TargetPhrasesLoaded)) {
+      LoadFromImage(TargetPhrasesLoaded);
+    }
+  }
+  void LoadFromImage(unsigned char part) const;
 
 public:
-  PhraseDictionaryNodeMemory() {}
+  PhraseDictionaryNodeMemory() : m_loaded(AllLoaded) {}
+  PhraseDictionaryNodeMemory(const PhraseDictionaryNodeMemory &copy);
+  PhraseDictionaryNodeMemory &operator=(const PhraseDictionaryNodeMemory &copy);
+
+  //! read children and target phrases of this node from node imageNode of image when they are first needed
+  void AddImageNode(const RuleTableImage &image, uint64_t imageNode);
 
   bool IsLeaf() const {
+    EnsureChildren();
     return m_sourceTermMap.empty() && m_nonTermMap.empty();
   }
 
@@ -153,17 +189,21 @@ public:
 #endif
 
   const TargetPhraseCollection &GetTargetPhraseCollection() const {
+    EnsureTargetPhrases();
     return m_targetPhraseCollection;
   }
   TargetPhraseCollection &GetTargetPhraseCollection() {
+    EnsureTargetPhrases();
     return m_targetPhraseCollection;
   }
 
   const TerminalMap & GetTerminalMap() const {
+    EnsureChildren();
     return m_sourceTermMap;
   }
 
   const NonTerminalMap & GetNonTerminalMap() const {
+    EnsureChildren();
     return m_nonTermMap;
   }
 
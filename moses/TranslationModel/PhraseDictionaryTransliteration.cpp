@@ -61,12 +61,9 @@ void PhraseDictionaryTransliteration::GetTargetPhraseCollection(InputPath &input
 
   CacheColl &cache = GetCache();
 
-  CacheColl::iterator iter;
-  iter = cache.find(hash);
-
-  if (iter != cache.end()) {
+  const TargetPhraseCollection *tpColl;
+  if (cache.Find(hash, tpColl)) {
     // already in cache
-    const TargetPhraseCollection *tpColl = iter->second.first;
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   } else {
     // TRANSLITERATE
@@ -89,16 +86,16 @@ void PhraseDictionaryTransliteration::GetTargetPhraseCollection(InputPath &input
     int ret = system(cmd.c_str());
     UTIL_THROW_IF2(ret != 0, "Transliteration script error");
 
-    TargetPhraseCollection *tpColl = new TargetPhraseCollection();
+    TargetPhraseCollection *newColl = new TargetPhraseCollection();
     vector<TargetPhrase*> targetPhrases = CreateTargetPhrases(sourcePhrase, outDir.path());
     vector<TargetPhrase*>::const_iterator iter;
     for (iter = targetPhrases.begin(); iter != targetPhrases.end(); ++iter) {
       TargetPhrase *tp = *iter;
-      tpColl->Add(tp);
+      newColl->Add(tp);
     }
 
-    std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-    cache[hash] = value;
+    tpColl = newColl;
+    cache.Add(hash, tpColl);
 
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   }
@@ -39,25 +39,22 @@ void ProbingPT::Load()
     const string &wordStr = iterSource->second;
     const Factor *factor = FactorCollection::Instance().AddFactor(wordStr);
 
-    uint64_t probingId = iterSource->first;
-
-    SourceVocabMap::value_type entry(factor, probingId);
-    m_sourceVocabMap.insert(entry);
-
+    size_t factorId = factor->GetId();
+    if (factorId >= m_sourceIds.size()) {
+      m_sourceIds.resize(factorId + 1, m_unkId);
+    }
+    m_sourceIds[factorId] = iterSource->first;
   }
 
   // target vocab
   const std::map<unsigned int, std::string> &probingVocab = m_engine->getVocab();
+  if (!probingVocab.empty()) {
+    m_targetFactors.resize(probingVocab.rbegin()->first + 1, NULL);
+  }
   std::map<unsigned int, std::string>::const_iterator iter;
   for (iter = probingVocab.begin(); iter != probingVocab.end(); ++iter) {
     const string &wordStr = iter->second;
-    const Factor *factor = FactorCollection::Instance().AddFactor(wordStr);
-
-    unsigned int probingId = iter->first;
-
-    TargetVocabMap::value_type entry(factor, probingId);
-    m_vocabMap.insert(entry);
-
+    m_targetFactors[iter->first] = FactorCollection::Instance().AddFactor(wordStr);
   }
 }
 
@@ -68,8 +65,6 @@ void ProbingPT::InitializeForInput(ttasksptr const& ttask)
 
 void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
-  CacheColl &cache = GetCache();
-
   InputPathList::const_iterator iter;
   for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
     InputPath &inputPath = **iter;
@@ -79,15 +74,25 @@ void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQue
       continue;
     }
 
-    TargetPhraseCollection *tpColl = CreateTargetPhrase(sourcePhrase);
+    const TargetPhraseCollection *tpColl = GetTargetPhraseCollectionLEGACY(sourcePhrase);
+    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+  }
+}
 
-    // add target phrase to phrase-table cache
-    size_t hash = hash_value(sourcePhrase);
-    std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-    cache[hash] = value;
+const TargetPhraseCollection *ProbingPT::GetTargetPhraseCollectionLEGACY(const Phrase& src) const
+{
+  CacheColl &cache = GetCache();
 
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+  // look in phrase-table cache first
+  size_t hash = hash_value(src);
+  const TargetPhraseCollection *tpColl;
+  if (!cache.Find(hash, tpColl)) {
+    tpColl = CreateTargetPhrase(src);
+
+    // add target phrase to phrase-table cache
+    cache.Add(hash, tpColl);
   }
+  return tpColl;
 }
 
 std::vector<uint64_t> ProbingPT::ConvertToProbingSourcePhrase(const Phrase &sourcePhrase, bool &ok) const
@@ -122,34 +127,32 @@ TargetPhraseCollection *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase
     return NULL;
   }
 
-  std::pair<bool, std::vector<target_text> > query_result;
-
-  TargetPhraseCollection *tpColl = NULL;
-
-  //Actual lookup
-  query_result = m_engine->query(probingSource);
-
-  if (query_result.first) {
-    //m_engine->printTargetInfo(query_result.second);
-    tpColl = new TargetPhraseCollection();
+  //Actual lookup. The target phrases are decoded straight out of the mmapped table
+  const unsigned char *begin, *end;
+  if (!m_engine->query_raw(probingSource, begin, end)) {
+    return NULL;
+  }
 
-    const std::vector<target_text> &probingTargetPhrases = query_result.second;
-    for (size_t i = 0; i < probingTargetPhrases.size(); ++i) {
-      const target_text &probingTargetPhrase = probingTargetPhrases[i];
-      TargetPhrase *tp = CreateTargetPhrase(sourcePhrase, probingTargetPhrase);
+  TargetPhraseCollection *tpColl = new TargetPhraseCollection();
 
-      tpColl->Add(tp);
-    }
-
-    tpColl->Prune(true, m_tableLimit);
+  target_phrase_reader reader(begin, end, m_engine->get_num_scores());
+  std::vector<unsigned int> probingPhrase;
+  std::vector<float> scores;
+  unsigned int alignId;
+  while (reader.next(probingPhrase, scores, alignId)) {
+    TargetPhrase *tp = CreateTargetPhrase(sourcePhrase, probingPhrase, scores);
+    tpColl->Add(tp);
   }
 
+  tpColl->Prune(true, m_tableLimit);
+
   return tpColl;
 }
 
-TargetPhrase *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase, const target_text &probingTargetPhrase) const
+TargetPhrase *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase,
+    const std::vector<unsigned int> &probingPhrase,
+    std::vector<float> &scores) const
 {
-  const std::vector<unsigned int> &probingPhrase = probingTargetPhrase.target_phrase;
   size_t size = probingPhrase.size();
 
   TargetPhrase *tp = new TargetPhrase(this);
@@ -165,7 +168,6 @@ TargetPhrase *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase, const ta
   }
 
   // score for this phrase table
-  vector<float> scores = probingTargetPhrase.prob;
   std::transform(scores.begin(), scores.end(), scores.begin(),TransformScore);
   tp->GetScoreBreakdown().PlusEquals(this, scores);
 
@@ -186,10 +188,8 @@ TargetPhrase *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase, const ta
 
 const Factor *ProbingPT::GetTargetFactor(uint64_t probingId) const
 {
-  TargetVocabMap::right_map::const_iterator iter;
-  iter = m_vocabMap.right.find(probingId);
-  if (iter != m_vocabMap.right.end()) {
-    return iter->second;
+  if (probingId < m_targetFactors.size()) {
+    return m_targetFactors[probingId];
   } else {
     // not in mapping. Must be UNK
     return NULL;
@@ -198,12 +198,11 @@ const Factor *ProbingPT::GetTargetFactor(uint64_t probingId) const
 
 uint64_t ProbingPT::GetSourceProbingId(const Factor *factor) const
 {
-  SourceVocabMap::left_map::const_iterator iter;
-  iter = m_sourceVocabMap.left.find(factor);
-  if (iter != m_sourceVocabMap.left.end()) {
-    return iter->second;
+  size_t factorId = factor->GetId();
+  if (factorId < m_sourceIds.size()) {
+    return m_sourceIds[factorId];
   } else {
-    // not in mapping. Must be UNK
+    // not in mapping, eg. an input word added after loading. Must be UNK
     return m_unkId;
   }
 }
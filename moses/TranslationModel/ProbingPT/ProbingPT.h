@@ -1,11 +1,10 @@
 
 #pragma once
 
-#include <boost/bimap.hpp>
+#include <vector>
 #include "../PhraseDictionary.h"
 
 class QueryEngine;
-class target_text;
 
 namespace Moses
 {
@@ -28,6 +27,14 @@ public:
   // for phrase-based model
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
 
+  // cached lookup, also used to warm up the cache
+  using PhraseDictionary::GetTargetPhraseCollectionLEGACY;
+  const TargetPhraseCollection *GetTargetPhraseCollectionLEGACY(const Phrase& src) const;
+
+  bool SupportsPrefetch() const {
+    return true;
+  }
+
   // for syntax/hiero model (CKY+ decoding)
   virtual ChartRuleLookupManager *CreateRuleLookupManager(
     const ChartParser &,
@@ -40,14 +47,14 @@ public:
 protected:
   QueryEngine *m_engine;
 
-  typedef boost::bimap<const Factor *, uint64_t> SourceVocabMap;
-  mutable SourceVocabMap m_sourceVocabMap;
-
-  typedef boost::bimap<const Factor *, unsigned int> TargetVocabMap;
-  mutable TargetVocabMap m_vocabMap;
+  // dense vocab mappings built in Load(), so that lookups are plain array accesses
+  std::vector<uint64_t> m_sourceIds; //! probing source id, indexed by Factor::GetId()
+  std::vector<const Factor*> m_targetFactors; //! indexed by probing target id
 
   TargetPhraseCollection *CreateTargetPhrase(const Phrase &sourcePhrase) const;
-  TargetPhrase *CreateTargetPhrase(const Phrase &sourcePhrase, const target_text &probingTargetPhrase) const;
+  TargetPhrase *CreateTargetPhrase(const Phrase &sourcePhrase,
+                                   const std::vector<unsigned int> &probingPhrase,
+                                   std::vector<float> &scores) const;
   const Factor *GetTargetFactor(uint64_t probingId) const;
   uint64_t GetSourceProbingId(const Factor *factor) const;
 
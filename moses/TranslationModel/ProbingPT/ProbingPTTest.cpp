@@ -0,0 +1,68 @@
+#include "storing.hh"
+#include "quering.hh"
+
+#define BOOST_TEST_MODULE ProbingPTTest
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "util/file.hh"
+
+namespace
+{
+
+std::string MakeTempDir()
+{
+  char name[] = "/tmp/probingpt_test_XXXXXX";
+  BOOST_REQUIRE(mkdtemp(name));
+  return name;
+}
+
+std::string Decode(QueryEngine &engine, StringPiece source)
+{
+  std::pair<bool, std::vector<target_text> > found = engine.query(source);
+  if (!found.first) {
+    return "";
+  }
+  std::map<unsigned int, std::string> vocab = engine.getVocab();
+  std::string out;
+  for (size_t i = 0; i < found.second.size(); i++) {
+    out += getTargetWordsFromIDs(found.second[i].target_phrase, &vocab) + "|";
+  }
+  return out;
+}
+
+// Lines of one source phrase are scattered through the table. After building,
+// every source finds exactly its own targets, in the order of the table.
+BOOST_AUTO_TEST_CASE(round_trip_unsorted)
+{
+  std::string dir = MakeTempDir();
+  std::string table = dir + "/phrase-table";
+  {
+    std::ofstream out(table.c_str());
+    out << "das haus ||| the house ||| 0.5 0.5 0.5 0.5 ||| 0-0 1-1 ||| 1 1 1\n";
+    out << "haus ||| house ||| 0.5 0.5 0.5 0.5 ||| 0-0 ||| 1 1 1\n";
+    out << "das ||| the ||| 0.5 0.5 0.5 0.5 ||| 0-0 ||| 1 1 1\n";
+    out << "das haus ||| the home ||| 0.5 0.5 0.5 0.5 ||| 0-0 1-1 ||| 1 1 1\n";
+    out << "haus das ||| house the ||| 0.5 0.5 0.5 0.5 ||| 0-0 1-1 ||| 1 1 1\n";
+    out << "das ||| that ||| 0.5 0.5 0.5 0.5 ||| 0-0 ||| 1 1 1\n";
+    out << "das haus ||| the building ||| 0.5 0.5 0.5 0.5 ||| 0-0 1-1 ||| 1 1 1\n";
+  }
+
+  createProbingPT(table.c_str(), (dir + "/pt").c_str(), "4", "false", 2, 1 << 20, dir + "/");
+
+  QueryEngine engine((dir + "/pt").c_str());
+  BOOST_CHECK_EQUAL("the house |the home |the building |", Decode(engine, "das haus"));
+  BOOST_CHECK_EQUAL("house the |", Decode(engine, "haus das"));
+  BOOST_CHECK_EQUAL("the |that |", Decode(engine, "das"));
+  BOOST_CHECK_EQUAL("house |", Decode(engine, "haus"));
+  BOOST_CHECK_EQUAL("", Decode(engine, "haus haus"));
+
+  std::string rm = "rm -rf " + dir;
+  BOOST_CHECK_EQUAL(0, std::system(rm.c_str()));
+}
+
+}
@@ -1,5 +1,7 @@
 #include "huffmanish.hh"
 
+Huffman::Huffman () : uniq_lines(0) {}
+
 Huffman::Huffman (const char * filepath)
 {
   //Read the file
@@ -37,38 +39,31 @@ Huffman::Huffman (const char * filepath)
   std::cerr << uniq_lines << std::endl;
 }
 
-void Huffman::count_elements(line_text linein)
+void Huffman::count_elements(const line_text &linein)
 {
   //For target phrase:
   util::TokenIter<util::SingleCharacter> it(linein.target_phrase, util::SingleCharacter(' '));
   while (it) {
-    //Check if we have that entry
-    std::map<std::string, unsigned int>::iterator mapiter;
-    mapiter = target_phrase_words.find(it->as_string());
-
-    if (mapiter != target_phrase_words.end()) {
-      //If the element is found, increment the count.
-      mapiter->second++;
-    } else {
-      //Else create a new entry;
-      target_phrase_words.insert(std::pair<std::string, unsigned int>(it->as_string(), 1));
-    }
+    //Creates the entry with a zero count if it is new
+    target_phrase_words[it->as_string()]++;
     it++;
   }
 
   //For word allignment 1
-  std::map<std::vector<unsigned char>, unsigned int>::iterator mapiter3;
-  std::vector<unsigned char> numbers = splitWordAll1(linein.word_all1);
-  mapiter3 = word_all1.find(numbers);
-
-  if (mapiter3 != word_all1.end()) {
-    //If the element is found, increment the count.
-    mapiter3->second++;
-  } else {
-    //Else create a new entry;
-    word_all1.insert(std::pair<std::vector<unsigned char>, unsigned int>(numbers, 1));
-  }
+  word_all1[splitWordAll1(linein.word_all1)]++;
+}
 
+void Huffman::merge_counts(const Huffman &other)
+{
+  for (boost::unordered_map<std::string, unsigned int>::const_iterator it = other.target_phrase_words.begin();
+       it != other.target_phrase_words.end(); it++) {
+    target_phrase_words[it->first] += it->second;
+  }
+  for (boost::unordered_map<std::vector<unsigned char>, unsigned int>::const_iterator it = other.word_all1.begin();
+       it != other.word_all1.end(); it++) {
+    word_all1[it->first] += it->second;
+  }
+  uniq_lines += other.uniq_lines;
 }
 
 //Assigns huffman values for each unique element
@@ -77,14 +72,14 @@ void Huffman::assign_values()
   //First create vectors for all maps so that we could sort them later.
 
   //Create a vector for target phrases
-  for(std::map<std::string, unsigned int>::iterator it = target_phrase_words.begin(); it != target_phrase_words.end(); it++ ) {
+  for(boost::unordered_map<std::string, unsigned int>::iterator it = target_phrase_words.begin(); it != target_phrase_words.end(); it++ ) {
     target_phrase_words_counts.push_back(*it);
   }
   //Sort it
   std::sort(target_phrase_words_counts.begin(), target_phrase_words_counts.end(), sort_pair());
 
   //Create a vector for word allignments 1
-  for(std::map<std::vector<unsigned char>, unsigned int>::iterator it = word_all1.begin(); it != word_all1.end(); it++ ) {
+  for(boost::unordered_map<std::vector<unsigned char>, unsigned int>::iterator it = word_all1.begin(); it != word_all1.end(); it++ ) {
     word_all1_counts.push_back(*it);
   }
   //Sort it
@@ -138,12 +133,12 @@ void Huffman::serialize_maps(const char * dirname)
   os2.close();
 }
 
-std::vector<unsigned char> Huffman::full_encode_line(line_text line)
+std::vector<unsigned char> Huffman::full_encode_line(const line_text &line) const
 {
   return vbyte_encode_line((encode_line(line)));
 }
 
-std::vector<unsigned int> Huffman::encode_line(line_text line)
+std::vector<unsigned int> Huffman::encode_line(const line_text &line) const
 {
   std::vector<unsigned int> retvector;
 
@@ -179,11 +174,11 @@ std::vector<unsigned int> Huffman::encode_line(line_text line)
 void Huffman::produce_lookups()
 {
   //basically invert every map that we have
-  for(std::map<std::string, unsigned int>::iterator it = target_phrase_huffman.begin(); it != target_phrase_huffman.end(); it++ ) {
+  for(boost::unordered_map<std::string, unsigned int>::iterator it = target_phrase_huffman.begin(); it != target_phrase_huffman.end(); it++ ) {
     lookup_target_phrase.insert(std::pair<unsigned int, std::string>(it->second, it->first));
   }
 
-  for(std::map<std::vector<unsigned char>, unsigned int>::iterator it = word_all1_huffman.begin(); it != word_all1_huffman.end(); it++ ) {
+  for(boost::unordered_map<std::vector<unsigned char>, unsigned int>::iterator it = word_all1_huffman.begin(); it != word_all1_huffman.end(); it++ ) {
     lookup_word_all1.insert(std::pair<unsigned int, std::vector<unsigned char> >(it->second, it->first));
   }
 
@@ -4,25 +4,34 @@
 #include "hash.hh"
 #include "line_splitter.hh"
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <boost/unordered_map.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 
-//Sorting for the second
+//Sorting for the second. Ties are broken on the first, so that the ids
+//do not depend on the order in which the counts were collected.
 struct sort_pair {
   bool operator()(const std::pair<std::string, unsigned int> &left, const std::pair<std::string, unsigned int> &right) {
-    return left.second > right.second; //This puts biggest numbers first.
+    if (left.second != right.second) {
+      return left.second > right.second; //This puts biggest numbers first.
+    }
+    return left.first < right.first;
   }
 };
 
 struct sort_pair_vec {
   bool operator()(const std::pair<std::vector<unsigned char>, unsigned int> &left, const std::pair<std::vector<unsigned char>, unsigned int> &right) {
-    return left.second > right.second; //This puts biggest numbers first.
+    if (left.second != right.second) {
+      return left.second > right.second; //This puts biggest numbers first.
+    }
+    return left.first < right.first;
   }
 };
 
@@ -31,32 +40,36 @@ class Huffman
   unsigned long uniq_lines; //Unique lines in the file.
 
   //Containers used when counting the occurence of a given phrase
-  std::map<std::string, unsigned int> target_phrase_words;
-  std::map<std::vector<unsigned char>, unsigned int> word_all1;
+  boost::unordered_map<std::string, unsigned int> target_phrase_words;
+  boost::unordered_map<std::vector<unsigned char>, unsigned int> word_all1;
 
   //Same containers as vectors, for sorting
   std::vector<std::pair<std::string, unsigned int> > target_phrase_words_counts;
   std::vector<std::pair<std::vector<unsigned char>, unsigned int> > word_all1_counts;
 
   //Huffman maps
-  std::map<std::string, unsigned int> target_phrase_huffman;
-  std::map<std::vector<unsigned char>, unsigned int> word_all1_huffman;
+  boost::unordered_map<std::string, unsigned int> target_phrase_huffman;
+  boost::unordered_map<std::vector<unsigned char>, unsigned int> word_all1_huffman;
 
   //inverted maps
   std::map<unsigned int, std::string> lookup_target_phrase;
   std::map<unsigned int, std::vector<unsigned char> > lookup_word_all1;
 
 public:
+  Huffman ();
   Huffman (const char *);
-  void count_elements (line_text line);
+  void count_elements (const line_text &line);
+  //Adds the counts collected by another instance, eg. in another thread
+  void merge_counts (const Huffman &other);
   void assign_values();
   void serialize_maps(const char * dirname);
   void produce_lookups();
 
-  std::vector<unsigned int> encode_line(line_text line);
+  //Encoding only reads the huffman maps, so several threads may encode at once
+  std::vector<unsigned int> encode_line(const line_text &line) const;
 
   //encode line + variable byte ontop
-  std::vector<unsigned char> full_encode_line(line_text line);
+  std::vector<unsigned char> full_encode_line(const line_text &line) const;
 
   //Getters
   const std::map<unsigned int, std::string> get_target_lookup_map() const {
@@ -98,6 +111,59 @@ public:
   std::vector<target_text> full_decode_line (std::vector<unsigned char> lines, int num_scores);
 };
 
+//Walks the variable byte encoded target phrases of one source phrase in place,
+//without copying the record or decoding it all up front. Every target phrase is
+//stored as: words 0 scores 0 word_all1 0, with exactly num_scores scores.
+class target_phrase_reader
+{
+  const unsigned char * current;
+  const unsigned char * end;
+  int num_scores;
+
+  inline unsigned int next_number() {
+    unsigned int num = 0;
+    unsigned char shift = 0;
+    while (current != end) {
+      unsigned char byte = *current++;
+      num |= (unsigned int)(byte & 0x7f) << shift;
+      if ((byte >> 7) != 1) {
+        break;
+      }
+      shift += 7;
+    }
+    return num;
+  }
+
+public:
+  target_phrase_reader(const unsigned char * begin_, const unsigned char * end_, int num_scores_)
+    : current(begin_), end(end_), num_scores(num_scores_) {}
+
+  //Reads the next target phrase into the given buffers, which are reused between calls.
+  //word_all1_id is the huffman id of the word alignment.
+  bool next(std::vector<unsigned int> &words, std::vector<float> &scores, unsigned int &word_all1_id) {
+    words.clear();
+    scores.clear();
+    if (current == end) {
+      return false;
+    }
+
+    for (unsigned int word = next_number(); word != 0 && current != end; word = next_number()) {
+      words.push_back(word);
+    }
+    for (int i = 0; i < num_scores && current != end; i++) {
+      unsigned int bits = next_number();
+      float score;
+      std::memcpy(&score, &bits, sizeof(score));
+      scores.push_back(score);
+    }
+    next_number(); //zero after the scores
+    word_all1_id = next_number();
+    next_number(); //zero closing the target phrase
+
+    return scores.size() == (size_t)num_scores;
+  }
+};
+
 std::string getTargetWordsFromIDs(std::vector<unsigned int> ids, std::map<unsigned int, std::string> * lookup_target_phrase);
 
 inline std::string getTargetWordFromID(unsigned int id, std::map<unsigned int, std::string> * lookup_target_phrase);
@@ -86,88 +86,48 @@ QueryEngine::~QueryEngine()
 
 }
 
-std::pair<bool, std::vector<target_text> > QueryEngine::query(std::vector<uint64_t> source_phrase)
+uint64_t QueryEngine::getKey(const std::vector<uint64_t> &source_phrase) const
 {
-  bool found;
-  std::vector<target_text> translation_entries;
-  const Entry * entry;
   //TOO SLOW
   //uint64_t key = util::MurmurHashNative(&source_phrase[0], source_phrase.size());
   uint64_t key = 0;
-  for (int i = 0; i < source_phrase.size(); i++) {
+  for (size_t i = 0; i < source_phrase.size(); i++) {
     key += (source_phrase[i] << i);
   }
-
-
-  found = table.Find(key, entry);
-
-  if (found) {
-    //The phrase that was searched for was found! We need to get the translation entries.
-    //We will read the largest entry in bytes and then filter the unnecesarry with functions
-    //from line_splitter
-    uint64_t initial_index = entry -> GetValue();
-    unsigned int bytes_toread = entry -> bytes_toread;
-
-    //ASK HIEU FOR MORE EFFICIENT WAY TO DO THIS!
-    std::vector<unsigned char> encoded_text; //Assign to the vector the relevant portion of the array.
-    encoded_text.reserve(bytes_toread);
-    for (int i = 0; i < bytes_toread; i++) {
-      encoded_text.push_back(binary_mmaped[i+initial_index]);
-    }
-
-    //Get only the translation entries necessary
-    translation_entries = decoder.full_decode_line(encoded_text, num_scores);
-
-  }
-
-  std::pair<bool, std::vector<target_text> > output (found, translation_entries);
-
-  return output;
-
+  return key;
 }
 
-std::pair<bool, std::vector<target_text> > QueryEngine::query(StringPiece source_phrase)
+bool QueryEngine::query_raw(const std::vector<uint64_t> &source_phrase, const unsigned char *&begin, const unsigned char *&end) const
 {
-  bool found;
-  std::vector<target_text> translation_entries;
   const Entry * entry;
-  //Convert source frase to VID
-  std::vector<uint64_t> source_phrase_vid = getVocabIDs(source_phrase);
-  //TOO SLOW
-  //uint64_t key = util::MurmurHashNative(&source_phrase_vid[0], source_phrase_vid.size());
-  uint64_t key = 0;
-  for (int i = 0; i < source_phrase_vid.size(); i++) {
-    key += (source_phrase_vid[i] << i);
+  if (!table.Find(getKey(source_phrase), entry)) {
+    return false;
   }
 
-  found = table.Find(key, entry);
+  begin = binary_mmaped + entry -> GetValue();
+  end = begin + entry -> bytes_toread;
+  return true;
+}
 
+std::pair<bool, std::vector<target_text> > QueryEngine::query(std::vector<uint64_t> source_phrase)
+{
+  std::vector<target_text> translation_entries;
+  const unsigned char *begin, *end;
 
+  bool found = query_raw(source_phrase, begin, end);
   if (found) {
-    //The phrase that was searched for was found! We need to get the translation entries.
-    //We will read the largest entry in bytes and then filter the unnecesarry with functions
-    //from line_splitter
-    uint64_t initial_index = entry -> GetValue();
-    unsigned int bytes_toread = entry -> bytes_toread;
-    //At the end of the file we can't readd + largest_entry cause we get a segfault.
-    std::cerr << "Entry size is bytes is: " << bytes_toread << std::endl;
-
-    //ASK HIEU FOR MORE EFFICIENT WAY TO DO THIS!
-    std::vector<unsigned char> encoded_text; //Assign to the vector the relevant portion of the array.
-    encoded_text.reserve(bytes_toread);
-    for (int i = 0; i < bytes_toread; i++) {
-      encoded_text.push_back(binary_mmaped[i+initial_index]);
-    }
-
     //Get only the translation entries necessary
+    std::vector<unsigned char> encoded_text(begin, end);
     translation_entries = decoder.full_decode_line(encoded_text, num_scores);
-
   }
 
-  std::pair<bool, std::vector<target_text> > output (found, translation_entries);
-
-  return output;
+  return std::pair<bool, std::vector<target_text> >(found, translation_entries);
+}
 
+std::pair<bool, std::vector<target_text> > QueryEngine::query(StringPiece source_phrase)
+{
+  //Convert source frase to VID
+  return query(getVocabIDs(source_phrase));
 }
 
 void QueryEngine::printTargetInfo(std::vector<target_text> target_phrases)
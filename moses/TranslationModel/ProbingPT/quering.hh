@@ -26,12 +26,20 @@ class QueryEngine
   size_t table_filesize;
   int num_scores;
   bool is_reordering;
+
+  uint64_t getKey(const std::vector<uint64_t> &source_phrase) const;
 public:
   QueryEngine (const char *);
   ~QueryEngine();
   std::pair<bool, std::vector<target_text> > query(StringPiece source_phrase);
   std::pair<bool, std::vector<target_text> > query(std::vector<uint64_t> source_phrase);
+  //Points begin and end at the encoded target phrases of source_phrase inside the
+  //mmapped binary file, without copying or decoding them. See target_phrase_reader.
+  bool query_raw(const std::vector<uint64_t> &source_phrase, const unsigned char *&begin, const unsigned char *&end) const;
   void printTargetInfo(std::vector<target_text> target_phrases);
+  int get_num_scores() const {
+    return num_scores;
+  }
   const std::map<unsigned int, std::string> getVocab() const {
     return decoder.get_target_lookup_map();
   }
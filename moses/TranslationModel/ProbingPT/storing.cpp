@@ -1,5 +1,12 @@
 #include "storing.hh"
 
+#include <boost/thread/thread.hpp>
+
+#include "util/mmap.hh"
+#include "util/stream/chain.hh"
+#include "util/stream/sort.hh"
+#include "util/stream/stream.hh"
+
 BinaryFileWriter::BinaryFileWriter (std::string basepath) : os ((basepath + "/binfile.dat").c_str(), std::ios::binary)
 {
   binfile.reserve(10000); //Reserve part of the vector to avoid realocation
@@ -20,6 +27,16 @@ void BinaryFileWriter::write (std::vector<unsigned char> * bytes)
   }
 }
 
+void BinaryFileWriter::write (const unsigned char * bytes, size_t size)
+{
+  binfile.insert(it, bytes, bytes + size);
+  it += size;
+  dist_from_start = distance(binfile.begin(),it);
+  if (dist_from_start > 9000) {
+    flush();
+  }
+}
+
 void BinaryFileWriter::flush ()
 {
   //Cast unsigned char to char before writing...
@@ -38,110 +55,300 @@ BinaryFileWriter::~BinaryFileWriter ()
   binfile.clear();
 }
 
-void createProbingPT(const char * phrasetable_path, const char * target_path,
-                     const char * num_scores, const char * is_reordering)
+namespace
 {
-  //Get basepath and create directory if missing
-  std::string basepath(target_path);
-  mkdir(basepath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
-  //Set up huffman and serialize decoder maps.
-  Huffman huffmanEncoder(phrasetable_path); //initialize
-  huffmanEncoder.assign_values();
-  huffmanEncoder.produce_lookups();
-  huffmanEncoder.serialize_maps(target_path);
+const size_t kBatchLines = 100000;
 
-  //Get uniq lines:
-  unsigned long uniq_entries = huffmanEncoder.getUniqLines();
+//One line of the phrase table after encoding: where its target side is in the
+//payload file, and the key of its source phrase to group by. The source phrase
+//itself follows the target side in the payload file.
+struct ProbingRecord {
+  uint64_t key;
+  uint64_t seq; //Line number, keeps the target phrases in their original order
+  uint64_t offset;
+  uint64_t length;
+  uint64_t source_length;
+};
 
-  //Source phrase vocabids
-  std::map<uint64_t, std::string> source_vocabids;
+struct ProbingRecordOrder : public std::binary_function<const void *, const void *, bool> {
+  bool operator()(const void *first, const void *second) const {
+    const ProbingRecord &a = *static_cast<const ProbingRecord*>(first);
+    const ProbingRecord &b = *static_cast<const ProbingRecord*>(second);
+    if (a.key != b.key) {
+      return a.key < b.key;
+    }
+    return a.seq < b.seq;
+  }
+};
 
-  //Read the file
-  util::FilePiece filein(phrasetable_path);
+//The key is the sum of hashes of individual words bitshifted by their position in the phrase.
+//Probably not entirerly correct, but fast and seems to work fine in practise.
+uint64_t getSourceKey(StringPiece source_phrase)
+{
+  uint64_t key = 0;
+  size_t i = 0;
+  for (util::TokenIter<util::SingleCharacter> it(source_phrase, util::SingleCharacter(' ')); it; it++, i++) {
+    key += (getHash(*it) << i);
+  }
+  return key;
+}
 
-  //Init the probing hash table
-  size_t size = Table::Size(uniq_entries, 1.2);
-  char * mem = new char[size];
-  memset(mem, 0, size);
-  Table table(mem, size);
+//Reads up to kBatchLines lines into batch, reusing its strings. Returns the number of lines read.
+size_t readBatch(util::FilePiece &filein, std::vector<std::string> &batch)
+{
+  size_t lines = 0;
+  try {
+    for (; lines < kBatchLines; lines++) {
+      StringPiece line = filein.ReadLine();
+      if (lines == batch.size()) {
+        batch.push_back(std::string());
+      }
+      batch[lines].assign(line.data(), line.size());
+    }
+  } catch (const util::EndOfFileException &e) {
+  }
+  return lines;
+}
 
-  BinaryFileWriter binfile(basepath); //Init the binary file writer.
+//Runs every slice in its own thread. Slices only hold pointers, so they are cheap to copy.
+template <class Slice> void runSlices(const std::vector<Slice> &slices)
+{
+  if (slices.size() == 1) {
+    Slice slice(slices[0]);
+    slice();
+    return;
+  }
+  boost::thread_group threads;
+  for (size_t i = 0; i < slices.size(); i++) {
+    threads.create_thread(slices[i]);
+  }
+  threads.join_all();
+}
 
-  line_text prev_line; //Check if the source phrase of the previous line is the same
+//Counts target words, alignments and source words of the lines [begin, end) of a batch
+struct CountSlice {
+  const std::vector<std::string> *batch;
+  size_t begin, end;
+  Huffman *counts;
+  boost::unordered_map<uint64_t, std::string> *source_vocab;
 
-  //Keep track of the size of each group of target phrases
-  uint64_t entrystartidx = 0;
-  //uint64_t line_num = 0;
+  void operator()() {
+    for (size_t i = begin; i < end; i++) {
+      line_text line = splitLine((*batch)[i]);
+      counts->count_elements(line);
+      for (util::TokenIter<util::SingleCharacter> it(line.source_phrase, util::SingleCharacter(' ')); it; it++) {
+        uint64_t id = getHash(*it);
+        if (source_vocab->find(id) == source_vocab->end()) {
+          (*source_vocab)[id] = it->as_string();
+        }
+      }
+    }
+  }
+};
 
+//Encodes the lines [begin, end) of a batch, offsets are relative to bytes
+struct EncodeSlice {
+  const std::vector<std::string> *batch;
+  size_t begin, end;
+  uint64_t first_seq;
+  const Huffman *encoder;
+  std::vector<unsigned char> *bytes;
+  std::vector<ProbingRecord> *records;
 
-  //Read everything and processs
-  while(true) {
-    try {
-      //Process line read
-      line_text line;
-      line = splitLine(filein.ReadLine());
-      //Add source phrases to vocabularyIDs
-      add_to_map(&source_vocabids, line.source_phrase);
+  void operator()() {
+    bytes->clear();
+    records->clear();
+    for (size_t i = begin; i < end; i++) {
+      line_text line = splitLine((*batch)[i]);
+      std::vector<unsigned char> encoded_line = encoder->full_encode_line(line);
 
-      if ((binfile.dist_from_start + binfile.extra_counter) == 0) {
-        prev_line = line; //For the first iteration assume the previous line is
-      } //The same as this one.
+      ProbingRecord record;
+      record.key = getSourceKey(line.source_phrase);
+      record.seq = first_seq + i;
+      record.offset = bytes->size();
+      record.length = encoded_line.size();
+      record.source_length = line.source_phrase.size();
+      records->push_back(record);
 
-      if (line.source_phrase != prev_line.source_phrase) {
+      bytes->insert(bytes->end(), encoded_line.begin(), encoded_line.end());
+      bytes->insert(bytes->end(), line.source_phrase.data(), line.source_phrase.data() + line.source_phrase.size());
+    }
+  }
+};
 
-        //Create a new entry even
+void countElements(const char * phrasetable_path, size_t num_threads,
+                   Huffman &huffmanEncoder, std::map<uint64_t, std::string> &source_vocabids)
+{
+  std::vector<Huffman> counts(num_threads);
+  std::vector<boost::unordered_map<uint64_t, std::string> > source_vocabs(num_threads);
 
-        //Create an entry for the previous source phrase:
-        Entry pesho;
-        pesho.value = entrystartidx;
-        //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
-        //Probably not entirerly correct, but fast and seems to work fine in practise.
-        pesho.key = 0;
-        std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-        for (int i = 0; i < vocabid_source.size(); i++) {
-          pesho.key += (vocabid_source[i] << i);
-        }
-        pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
+  util::FilePiece filein(phrasetable_path);
+  std::vector<std::string> batch;
+  for (size_t lines; (lines = readBatch(filein, batch)); ) {
+    std::vector<CountSlice> slices(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      slices[t].batch = &batch;
+      slices[t].begin = lines * t / num_threads;
+      slices[t].end = lines * (t + 1) / num_threads;
+      slices[t].counts = &counts[t];
+      slices[t].source_vocab = &source_vocabs[t];
+    }
+    runSlices(slices);
+  }
 
-        //Put into table
-        table.Insert(pesho);
+  for (size_t t = 0; t < num_threads; t++) {
+    huffmanEncoder.merge_counts(counts[t]);
+    source_vocabids.insert(source_vocabs[t].begin(), source_vocabs[t].end());
+  }
+}
 
-        entrystartidx = binfile.dist_from_start + binfile.extra_counter; //Designate start idx for new entry
+//First step of the sorting chain: reads the phrase table again, encodes the target
+//sides in parallel, appends them to the payload file and passes a record per line on.
+class EncodeLines
+{
+public:
+  EncodeLines(const char * phrasetable_path, const Huffman &encoder, size_t num_threads, int payload)
+    : phrasetable_path_(phrasetable_path), encoder_(&encoder), num_threads_(num_threads), payload_(payload) {}
 
-        //Encode a line and write it to disk.
-        std::vector<unsigned char> encoded_line = huffmanEncoder.full_encode_line(line);
-        binfile.write(&encoded_line);
+  void Run(const util::stream::ChainPosition &position) {
+    util::stream::Stream out(position);
+    util::FilePiece filein(phrasetable_path_);
 
-        //Set prevLine
-        prev_line = line;
+    std::vector<std::string> batch;
+    std::vector<std::vector<unsigned char> > bytes(num_threads_);
+    std::vector<std::vector<ProbingRecord> > records(num_threads_);
+    uint64_t offset = 0;
 
-      } else {
-        //If we still have the same line, just append to it:
-        std::vector<unsigned char> encoded_line = huffmanEncoder.full_encode_line(line);
-        binfile.write(&encoded_line);
+    for (uint64_t seq = 0, lines; (lines = readBatch(filein, batch)); seq += lines) {
+      std::vector<EncodeSlice> slices(num_threads_);
+      for (size_t t = 0; t < num_threads_; t++) {
+        slices[t].batch = &batch;
+        slices[t].begin = lines * t / num_threads_;
+        slices[t].end = lines * (t + 1) / num_threads_;
+        slices[t].first_seq = seq;
+        slices[t].encoder = encoder_;
+        slices[t].bytes = &bytes[t];
+        slices[t].records = &records[t];
       }
+      runSlices(slices);
 
-    } catch (util::EndOfFileException e) {
-      std::cerr << "Reading phrase table finished, writing remaining files to disk." << std::endl;
-      binfile.flush();
-
-      //After the final entry is constructed we need to add it to the phrase_table
-      //Create an entry for the previous source phrase:
-      Entry pesho;
-      pesho.value = entrystartidx;
-      //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
-      pesho.key = 0;
-      std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-      for (int i = 0; i < vocabid_source.size(); i++) {
-        pesho.key += (vocabid_source[i] << i);
+      for (size_t t = 0; t < num_threads_; t++) {
+        if (!bytes[t].empty()) {
+          util::WriteOrThrow(payload_, &bytes[t][0], bytes[t].size());
+        }
+        for (size_t i = 0; i < records[t].size(); i++, ++out) {
+          ProbingRecord *record = static_cast<ProbingRecord*>(out.Get());
+          *record = records[t][i];
+          record->offset += offset;
+        }
+        offset += bytes[t].size();
       }
-      pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
-      //Put into table
-      table.Insert(pesho);
+    }
+    out.Poison();
+  }
+
+private:
+  const char * phrasetable_path_;
+  const Huffman *encoder_;
+  size_t num_threads_;
+  int payload_;
+};
+
+}
+
+void createProbingPT(const char * phrasetable_path, const char * target_path,
+                     const char * num_scores, const char * is_reordering,
+                     size_t num_threads, size_t sort_memory,
+                     const std::string &temp_prefix)
+{
+  //Get basepath and create directory if missing
+  std::string basepath(target_path);
+  mkdir(basepath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
 
-      break;
+  //Count, set up huffman and serialize decoder maps.
+  Huffman huffmanEncoder;
+  std::map<uint64_t, std::string> source_vocabids;
+  countElements(phrasetable_path, num_threads, huffmanEncoder, source_vocabids);
+  huffmanEncoder.assign_values();
+  huffmanEncoder.produce_lookups();
+  huffmanEncoder.serialize_maps(target_path);
+
+  //Encode all lines and sort them by source phrase. Only the fixed size records are
+  //sorted, the encoded target phrases stay in the payload file until they are copied.
+  util::scoped_fd payload(util::MakeTemp(temp_prefix));
+
+  util::stream::SortConfig sort_config;
+  sort_config.temp_prefix = temp_prefix;
+  sort_config.total_memory = std::max<size_t>(sort_memory, 1 << 20);
+  sort_config.buffer_size = std::min<size_t>(64 << 20, sort_config.total_memory / 4);
+
+  util::stream::ChainConfig chain_config(sizeof(ProbingRecord), 2, sort_config.total_memory);
+  util::stream::Chain chain(chain_config);
+  chain >> EncodeLines(phrasetable_path, huffmanEncoder, num_threads, payload.get());
+  util::stream::BlockingSort(chain, sort_config, ProbingRecordOrder(), util::stream::NeverCombine());
+  std::cerr << "Encoding and sorting finished, writing the binary file." << std::endl;
+
+  util::scoped_memory payload_mem;
+  uint64_t payload_size = util::SizeOrThrow(payload.get());
+  if (payload_size) {
+    util::MapRead(util::LAZY, payload.get(), 0, payload_size, payload_mem);
+  }
+  const unsigned char * encoded = static_cast<const unsigned char*>(payload_mem.get());
+
+  //Copy the target phrases grouped by source phrase and remember a table entry for
+  //each group. The table can only be sized once the groups are counted.
+  BinaryFileWriter binfile(basepath);
+  util::scoped_FILE entries(util::FMakeTemp(temp_prefix));
+  unsigned long uniq_entries = 0;
+  Entry pesho;
+
+  //The table is looked up by key alone, so all records with one key must come from
+  //the same source phrase. Compare the phrases instead of merging colliding ones.
+  //The stream is read to the end before failing, so that the chain can shut down.
+  util::stream::Stream sorted;
+  chain >> sorted >> util::stream::kRecycle;
+  StringPiece group_source;
+  std::string collision;
+  for (; sorted; ++sorted) {
+    const ProbingRecord &record = *static_cast<const ProbingRecord*>(sorted.Get());
+    StringPiece source(reinterpret_cast<const char*>(encoded + record.offset + record.length), record.source_length);
+    if (!uniq_entries || record.key != pesho.key) {
+      if (uniq_entries) {
+        pesho.bytes_toread = binfile.position() - pesho.value;
+        util::WriteOrThrow(entries.get(), &pesho, sizeof(Entry));
+      }
+      pesho.key = record.key;
+      pesho.value = binfile.position();
+      group_source = source;
+      uniq_entries++;
+    } else if (source != group_source && collision.empty()) {
+      collision = "'" + group_source.as_string() + "' and '" + source.as_string() + "'";
     }
+    binfile.write(encoded + record.offset, record.length);
+  }
+  if (uniq_entries) {
+    pesho.bytes_toread = binfile.position() - pesho.value;
+    util::WriteOrThrow(entries.get(), &pesho, sizeof(Entry));
+  }
+  binfile.flush();
+  chain.Wait();
+  UTIL_THROW_IF(!collision.empty(), util::Exception, "Source phrases " << collision
+                << " have the same key, cannot tell them apart");
+  std::cerr << "Unique entries counted: " << uniq_entries << std::endl;
+
+  //Init the probing hash table
+  size_t size = Table::Size(uniq_entries, 1.2);
+  char * mem = new char[size];
+  memset(mem, 0, size);
+  Table table(mem, size);
+
+  std::rewind(entries.get());
+  while (std::fread(&pesho, sizeof(Entry), 1, entries.get()) == 1) {
+    table.Insert(pesho);
   }
 
   serialize_table(mem, size, (basepath + "/probing_hash.dat").c_str());
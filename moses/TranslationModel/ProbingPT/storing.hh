@@ -14,8 +14,14 @@
 #include "vocabid.hh"
 #define API_VERSION 3
 
+//Builds the probing table from a phrase table, which may be unsorted and compressed.
+//Target sides are encoded by num_threads threads and the lines are grouped by
+//source phrase with an external sort that uses about sort_memory bytes of RAM
+//and temporary files starting with temp_prefix.
 void createProbingPT(const char * phrasetable_path, const char * target_path,
-                     const char * num_scores, const char * is_reordering);
+                     const char * num_scores, const char * is_reordering,
+                     size_t num_threads = 1, size_t sort_memory = 1ULL << 30,
+                     const std::string &temp_prefix = "/tmp/");
 
 class BinaryFileWriter
 {
@@ -31,6 +37,10 @@ public:
   BinaryFileWriter (std::string);
   ~BinaryFileWriter ();
   void write (std::vector<unsigned char> * bytes);
+  void write (const unsigned char * bytes, size_t size);
+  uint64_t position () const {
+    return extra_counter + dist_from_start;
+  }
   void flush (); //Flush to disk
 
 };
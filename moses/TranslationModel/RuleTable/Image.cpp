@@ -0,0 +1,387 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2015 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "Image.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+
+#include "LoaderStandard.h"
+#include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
+#include "moses/TargetPhraseCollection.h"
+#include "moses/Util.h"
+#include "moses/Word.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
+#include "moses/TranslationModel/PhraseDictionaryNodeMemory.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/file_piece.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+
+const char kMagic[8] = { 'm', 'o', 's', 'e', 's', 'R', 'T', 'I' };
+const uint64_t kVersion = 1;
+
+struct BuildNode {
+  BuildNode() : numRules(0) {}
+  std::map<std::string, uint64_t> terminals;
+  std::map<std::pair<std::string, std::string>, uint64_t> nonTerminals;
+  uint64_t numRules;
+};
+
+bool IsNonTerminal(const StringPiece &word)
+{
+  return word.size() >= 2 && word.data()[0] == '[' && word.data()[word.size() - 1] == ']';
+}
+
+//! split a phrase as Phrase::CreateFromString does, without the LHS
+void SplitPhrase(const StringPiece &phrase, std::vector<StringPiece> &words)
+{
+  words.clear();
+  for (util::TokenIter<util::AnyCharacter, true> it(phrase, "\t "); it; ++it) {
+    words.push_back(*it);
+  }
+  if (!words.empty() && IsNonTerminal(words.back())) {
+    words.pop_back();
+  }
+}
+
+//! source or target label of a non-terminal like [X][NP]
+StringPiece Label(const StringPiece &word, bool source)
+{
+  size_t nextPos = word.find('[', 1);
+  UTIL_THROW_IF2(nextPos == StringPiece::npos,
+                 "Incorrect formatting of non-terminal. Should have 2 non-terms, eg. [X][X]. "
+                 << "Current string: " << word);
+  if (source) {
+    return word.substr(1, nextPos - 2);
+  }
+  return word.substr(nextPos + 1, word.size() - nextPos - 2);
+}
+
+/** find or create the node of a rule, following the path
+ * PhraseDictionaryMemory::GetOrCreateNode takes in the loaded table */
+uint64_t GetOrCreateNode(std::vector<BuildNode> &nodes, const StringPiece &line,
+                         std::vector<StringPiece> &source, std::vector<StringPiece> &target)
+{
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  SplitPhrase(*pipes, source);
+  UTIL_THROW_IF2(!++pipes, "Not a rule in Moses or Hiero format: " << line);
+  SplitPhrase(*pipes, target);
+  ++pipes; // scores
+  StringPiece alignString;
+  if (++pipes) {
+    alignString = *pipes;
+  }
+
+  // alignments of non-terminals, as in TargetPhrase::SetAlignmentInfo
+  std::set<std::pair<size_t, size_t> > alignNonTerm;
+  for (util::TokenIter<util::AnyCharacter, true> token(alignString, " \t"); token; ++token) {
+    util::TokenIter<util::SingleCharacter, false> dash(*token, '-');
+    size_t sourcePos = Scan<size_t>(dash->as_string());
+    size_t targetPos = Scan<size_t>((++dash)->as_string());
+    UTIL_THROW_IF2(targetPos >= target.size(),
+                   "Alignment point " << *token << " outside of the target phrase");
+    if (IsNonTerminal(target[targetPos])) {
+      alignNonTerm.insert(std::make_pair(sourcePos, targetPos));
+    }
+  }
+
+  std::set<std::pair<size_t, size_t> >::const_iterator iterAlign = alignNonTerm.begin();
+  uint64_t node = 0;
+  for (size_t pos = 0; pos < source.size(); ++pos) {
+    uint64_t child = nodes.size();
+    if (IsNonTerminal(source[pos])) {
+      UTIL_THROW_IF2(iterAlign == alignNonTerm.end(),
+                     "No alignment for non-term at position " << pos);
+      UTIL_THROW_IF2(iterAlign->first != pos,
+                     "Alignment info incorrect at position " << pos);
+      std::pair<std::string, std::string> key(Label(source[pos], true).as_string(),
+                                              Label(target[iterAlign->second], false).as_string());
+      ++iterAlign;
+      child = nodes[node].nonTerminals.insert(std::make_pair(key, child)).first->second;
+    } else {
+      child = nodes[node].terminals.insert(std::make_pair(source[pos].as_string(), child)).first->second;
+    }
+    if (child == nodes.size()) {
+      nodes.push_back(BuildNode());
+    }
+    node = child;
+  }
+  return node;
+}
+
+//! next rule of the text table in Moses format, false at the end
+bool ReadRule(util::FilePiece &in, bool hiero, std::string &hieroRule, StringPiece &line)
+{
+  try {
+    line = in.ReadLine();
+  } catch (const util::EndOfFileException &e) {
+    return false;
+  }
+  if (hiero) {
+    ReformatHieroRule(line.as_string(), hieroRule);
+    line = hieroRule;
+  }
+  return true;
+}
+
+bool IsHiero(const std::string &textPath)
+{
+  util::FilePiece in(textPath.c_str());
+  try {
+    util::TokenIter<util::AnyCharacter, true> it(in.ReadLine(), " \t");
+    return it && *it == "[X]" && ++it && *it == "|||";
+  } catch (const util::EndOfFileException &e) {
+    return false;
+  }
+}
+
+//! keep sections aligned for the structs read from the mapped file
+void Pad(std::FILE *file, uint64_t &offset)
+{
+  static const char zeros[8] = { 0 };
+  size_t padding = (8 - offset % 8) % 8;
+  util::WriteOrThrow(file, zeros, padding);
+  offset += padding;
+}
+
+uint64_t GetKey(std::map<std::string, uint64_t> &keys, std::string &pool, const std::string &key)
+{
+  std::map<std::string, uint64_t>::iterator it = keys.find(key);
+  if (it != keys.end()) {
+    return it->second;
+  }
+  uint64_t offset = pool.size();
+  pool.append(key.c_str(), key.size() + 1);
+  keys[key] = offset;
+  return offset;
+}
+
+}
+
+bool RuleTableImage::IsImage(const std::string &path)
+{
+  char magic[sizeof(kMagic)];
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  bool ret = std::fread(magic, sizeof(magic), 1, file) == 1
+             && !memcmp(magic, kMagic, sizeof(kMagic));
+  std::fclose(file);
+  return ret;
+}
+
+void RuleTableImage::Create(const std::string &textPath, const std::string &imagePath)
+{
+  bool hiero = IsHiero(textPath);
+  std::string hieroRule;
+  StringPiece line;
+  std::vector<StringPiece> source, target;
+
+  // build the trie and remember the node of each rule
+  std::vector<BuildNode> nodes(1);
+  std::vector<uint64_t> ruleNodes;
+  {
+    util::FilePiece in(textPath.c_str(), &std::cerr);
+    while (ReadRule(in, hiero, hieroRule, line)) {
+      uint64_t node = GetOrCreateNode(nodes, line, source, target);
+      ++nodes[node].numRules;
+      ruleNodes.push_back(node);
+    }
+  }
+
+  // nodes and children, with the words and labels in a pool of keys
+  std::vector<Node> imageNodes(nodes.size());
+  std::vector<Child> children;
+  std::vector<uint64_t> nextRule(nodes.size());
+  std::map<std::string, uint64_t> keys;
+  std::string pool;
+  uint64_t numRules = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    BuildNode &node = nodes[i];
+    Node &imageNode = imageNodes[i];
+    imageNode.firstChild = children.size();
+    imageNode.numTerminals = node.terminals.size();
+    imageNode.numNonTerminals = node.nonTerminals.size();
+    imageNode.firstRule = nextRule[i] = numRules;
+    imageNode.numRules = node.numRules;
+    numRules += node.numRules;
+
+    for (std::map<std::string, uint64_t>::const_iterator it = node.terminals.begin(); it != node.terminals.end(); ++it) {
+      Child child;
+      child.sourceKey = GetKey(keys, pool, it->first);
+      child.targetKey = 0;
+      child.node = it->second;
+      children.push_back(child);
+    }
+    for (std::map<std::pair<std::string, std::string>, uint64_t>::const_iterator it = node.nonTerminals.begin(); it != node.nonTerminals.end(); ++it) {
+      Child child;
+      child.sourceKey = GetKey(keys, pool, it->first.first);
+      child.targetKey = GetKey(keys, pool, it->first.second);
+      child.node = it->second;
+      children.push_back(child);
+    }
+    BuildNode().terminals.swap(node.terminals);
+    BuildNode().nonTerminals.swap(node.nonTerminals);
+  }
+  std::map<std::string, uint64_t>().swap(keys);
+
+  util::scoped_FILE file(std::fopen(imagePath.c_str(), "wb"));
+  UTIL_THROW_IF2(!file.get(), "Could not open " << imagePath << " for writing");
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.numNodes = imageNodes.size();
+  header.numRules = numRules;
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+  uint64_t offset = sizeof(header);
+
+  header.nodesOffset = offset;
+  util::WriteOrThrow(file.get(), &imageNodes[0], imageNodes.size() * sizeof(Node));
+  offset += imageNodes.size() * sizeof(Node);
+
+  header.childrenOffset = offset;
+  if (!children.empty()) {
+    util::WriteOrThrow(file.get(), &children[0], children.size() * sizeof(Child));
+    offset += children.size() * sizeof(Child);
+  }
+
+  header.keysOffset = offset;
+  util::WriteOrThrow(file.get(), pool.data(), pool.size());
+  offset += pool.size();
+  Pad(file.get(), offset);
+
+  // the rules in their original order, indexed by node
+  header.rulesOffset = offset;
+  std::vector<Rule> ruleIndex(numRules);
+  {
+    util::FilePiece in(textPath.c_str());
+    for (size_t i = 0; ReadRule(in, hiero, hieroRule, line); ++i) {
+      Rule &rule = ruleIndex[nextRule[ruleNodes[i]]++];
+      rule.offset = offset - header.rulesOffset;
+      rule.length = line.size();
+      util::WriteOrThrow(file.get(), line.data(), line.size());
+      offset += line.size();
+    }
+  }
+  Pad(file.get(), offset);
+
+  header.ruleIndexOffset = offset;
+  if (numRules) {
+    util::WriteOrThrow(file.get(), &ruleIndex[0], numRules * sizeof(Rule));
+  }
+
+  std::rewind(file.get());
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+}
+
+RuleTableImage::RuleTableImage(const std::string &path,
+                               const PhraseDictionary &ruleTable,
+                               const std::vector<FactorType> &input,
+                               const std::vector<FactorType> &output)
+  : m_ruleTable(ruleTable)
+  , m_input(input)
+  , m_output(output)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(Header), "Rule table image " << path << " is truncated");
+  util::MapRead(util::LAZY, file.get(), 0, size, m_mem);
+
+  const char *base = static_cast<const char*>(m_mem.get());
+  m_header = reinterpret_cast<const Header*>(base);
+  UTIL_THROW_IF2(memcmp(m_header->magic, kMagic, sizeof(kMagic)) || m_header->version != kVersion,
+                 "Rule table image " << path << " has an unknown format");
+  UTIL_THROW_IF2(m_header->ruleIndexOffset + m_header->numRules * sizeof(Rule) > size,
+                 "Rule table image " << path << " is truncated");
+
+  m_nodes = reinterpret_cast<const Node*>(base + m_header->nodesOffset);
+  m_children = reinterpret_cast<const Child*>(base + m_header->childrenOffset);
+  m_keys = base + m_header->keysOffset;
+  m_rules = base + m_header->rulesOffset;
+  m_ruleIndex = reinterpret_cast<const Rule*>(base + m_header->ruleIndexOffset);
+}
+
+void RuleTableImage::LoadChildren(PhraseDictionaryNodeMemory &node, const std::vector<uint64_t> &imageNodes) const
+{
+  for (size_t i = 0; i < imageNodes.size(); ++i) {
+    const Node &imageNode = m_nodes[imageNodes[i]];
+    const Child *child = m_children + imageNode.firstChild;
+
+    for (size_t j = 0; j < imageNode.numTerminals; ++j, ++child) {
+      Word word;
+      word.CreateFromString(Input, m_input, m_keys + child->sourceKey, false);
+      node.GetOrCreateChild(word)->AddImageNode(*this, child->node);
+    }
+
+    for (size_t j = 0; j < imageNode.numNonTerminals; ++j, ++child) {
+      Word targetNonTerm(true);
+      targetNonTerm.CreateFromString(Output, m_output, m_keys + child->targetKey, true);
+#if defined(UNLABELLED_SOURCE)
+      node.GetOrCreateNonTerminalChild(targetNonTerm)->AddImageNode(*this, child->node);
+#else
+      Word sourceNonTerm(true);
+      sourceNonTerm.CreateFromString(Input, m_input, m_keys + child->sourceKey, true);
+      node.GetOrCreateChild(sourceNonTerm, targetNonTerm)->AddImageNode(*this, child->node);
+#endif
+    }
+  }
+}
+
+void RuleTableImage::LoadTargetPhrases(TargetPhraseCollection &coll, const std::vector<uint64_t> &imageNodes) const
+{
+  std::vector<float> scoreVector;
+  for (size_t i = 0; i < imageNodes.size(); ++i) {
+    const Node &imageNode = m_nodes[imageNodes[i]];
+    for (uint64_t r = imageNode.firstRule; r < imageNode.firstRule + imageNode.numRules; ++r) {
+      const Rule &rule = m_ruleIndex[r];
+      Phrase sourcePhrase;
+      Word *sourceLHS = NULL;
+      TargetPhrase *targetPhrase = RuleTableLoaderStandard::ParseRule(
+                                     StringPiece(m_rules + rule.offset, rule.length), r,
+                                     m_input, m_output, m_ruleTable,
+                                     scoreVector, sourcePhrase, sourceLHS);
+      if (targetPhrase) {
+        coll.Add(targetPhrase);
+      }
+      delete sourceLHS;
+    }
+  }
+
+  // as RuleTableLoader::SortAndPrune for the text table
+  if (m_ruleTable.GetTableLimit()) {
+    coll.Sort(true, m_ruleTable.GetTableLimit());
+  }
+}
+
+}  // namespace Moses
@@ -0,0 +1,134 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2015 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "moses/TypeDef.h"
+#include "util/mmap.hh"
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Moses
+{
+
+class PhraseDictionary;
+class PhraseDictionaryNodeMemory;
+class TargetPhraseCollection;
+
+/** Binary image of a text rule table for PhraseDictionaryMemory.
+ *
+ * The image holds the trie of source sides, keyed by the strings of the
+ * words, with the children of each node sorted by key, and the rules of
+ * each node in a pool of records. Only offsets are stored, so the file is
+ * mapped read-only and its pages are shared by all processes using it.
+ * Nothing is read when the table is loaded: each PhraseDictionaryNodeMemory
+ * reads its children and parses its rules the first time it is used, in
+ * exactly the same way as RuleTableLoaderStandard.
+ *
+ * Byte order and word size are those of the machine that created it.
+ */
+class RuleTableImage
+{
+public:
+  //! does the file at path start like an image?
+  static bool IsImage(const std::string &path);
+
+  //! write the image of the text rule table at textPath, in Moses or Hiero format, to imagePath
+  static void Create(const std::string &textPath, const std::string &imagePath);
+
+  RuleTableImage(const std::string &path,
+                 const PhraseDictionary &ruleTable,
+                 const std::vector<FactorType> &input,
+                 const std::vector<FactorType> &output);
+
+  uint64_t GetRootNode() const {
+    return 0;
+  }
+
+  //! add the children of the given image nodes to node
+  void LoadChildren(PhraseDictionaryNodeMemory &node, const std::vector<uint64_t> &imageNodes) const;
+
+  //! parse the rules of the given image nodes into coll, then sort and prune it
+  void LoadTargetPhrases(TargetPhraseCollection &coll, const std::vector<uint64_t> &imageNodes) const;
+
+#ifdef WITH_THREADS
+  //! held while the given node is filled in; nodes share a few locks, not one
+  boost::mutex &GetMutex(const void *node) const {
+    size_t hash = reinterpret_cast<size_t>(node);
+    return m_mutexes[(hash ^ (hash >> 12)) % NumMutexes];
+  }
+#endif
+
+  struct Header {
+    char magic[8];
+    uint64_t version;
+    uint64_t numNodes;
+    uint64_t nodesOffset;
+    uint64_t childrenOffset;
+    uint64_t keysOffset;
+    uint64_t rulesOffset;
+    uint64_t ruleIndexOffset;
+    uint64_t numRules;
+  };
+
+  struct Node {
+    uint64_t firstChild;
+    uint32_t numTerminals; //! children for terminals come first
+    uint32_t numNonTerminals;
+    uint64_t firstRule;
+    uint64_t numRules;
+  };
+
+  struct Child {
+    uint64_t sourceKey; //! offset of the word or source label in the keys
+    uint64_t targetKey; //! offset of the target label for non-terminals
+    uint64_t node;
+  };
+
+  struct Rule {
+    uint64_t offset; //! of the line in Moses format in the rules
+    uint64_t length;
+  };
+
+private:
+  util::scoped_memory m_mem;
+  const Header *m_header;
+  const Node *m_nodes;
+  const Child *m_children;
+  const char *m_keys;
+  const char *m_rules;
+  const Rule *m_ruleIndex;
+
+  const PhraseDictionary &m_ruleTable;
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+
+#ifdef WITH_THREADS
+  enum { NumMutexes = 64 };
+  mutable boost::mutex m_mutexes[NumMutexes];
+#endif
+};
+
+}  // namespace Moses
@@ -21,6 +21,7 @@
 
 #include "moses/Util.h"
 #include "moses/InputFileStream.h"
+#include "Image.h"
 #include "LoaderCompact.h"
 #include "LoaderHiero.h"
 #include "LoaderStandard.h"
@@ -38,6 +39,11 @@ namespace Moses
 std::auto_ptr<RuleTableLoader> RuleTableLoaderFactory::Create(
   const std::string &path)
 {
+  if (RuleTableImage::IsImage(path)) {
+    std::cerr << "Rule table images can only be used with PhraseDictionaryMemory: " << path << std::endl;
+    return std::auto_ptr<RuleTableLoader>();
+  }
+
   InputFileStream input(path);
   std::string line;
 
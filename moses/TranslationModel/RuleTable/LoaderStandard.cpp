@@ -142,6 +142,80 @@ void ReformatHieroRule(const string &lineOrig, string &out)
   out = ret.str();
 }
 
+TargetPhrase *RuleTableLoaderStandard::ParseRule(const StringPiece &line
+    , size_t lineNum
+    , const std::vector<FactorType> &input
+    , const std::vector<FactorType> &output
+    , const PhraseDictionary &ruleTable
+    , std::vector<float> &scoreVector
+    , Phrase &sourcePhrase
+    , Word *&sourceLHS)
+{
+  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
+
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourcePhraseString(*pipes);
+  StringPiece targetPhraseString(*++pipes);
+  StringPiece scoreString(*++pipes);
+
+  StringPiece alignString;
+  if (++pipes) {
+    StringPiece temp(*pipes);
+    alignString = temp;
+  }
+
+  bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
+  if (isLHSEmpty && !StaticData::Instance().IsWordDeletionEnabled()) {
+    TRACE_ERR( ruleTable.GetFilePath() << ":" << lineNum << ": pt entry contains empty target, skipping\n");
+    return NULL;
+  }
+
+  scoreVector.clear();
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
+    int processed;
+    float score = converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << lineNum);
+    scoreVector.push_back(FloorScore(TransformScore(score)));
+  }
+  const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
+  if (scoreVector.size() != numScoreComponents) {
+    UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
+                << numScoreComponents << ") of score components on line " << lineNum);
+  }
+
+  // parse source & find pt node
+
+  // constituent labels
+  Word *targetLHS;
+
+  // create target phrase obj
+  TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
+  targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
+  // source
+  sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
+
+  // rest of target phrase
+  targetPhrase->SetAlignmentInfo(alignString);
+  targetPhrase->SetTargetLHS(targetLHS);
+
+  ++pipes;  // skip over counts field
+
+  if (++pipes) {
+    StringPiece sparseString(*pipes);
+    targetPhrase->SetSparseScore(&ruleTable, sparseString);
+  }
+
+  if (++pipes) {
+    StringPiece propertiesString(*pipes);
+    targetPhrase->SetProperties(propertiesString);
+  }
+
+  targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
+  targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
+
+  return targetPhrase;
+}
+
 bool RuleTableLoaderStandard::Load(FormatType format
                                    , const std::vector<FactorType> &input
                                    , const std::vector<FactorType> &output
@@ -151,8 +225,6 @@ bool RuleTableLoaderStandard::Load(FormatType format
 {
   PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
 
-  const StaticData &staticData = StaticData::Instance();
-
   string lineOrig;
   size_t count = 0;
 
@@ -165,8 +237,6 @@ bool RuleTableLoaderStandard::Load(FormatType format
   StringPiece line;
   std::string hiero_before, hiero_after;
 
-  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
-
   while(true) {
     try {
       line = in.ReadLine();
@@ -180,68 +250,14 @@ bool RuleTableLoaderStandard::Load(FormatType format
       line = hiero_after;
     }
 
-    util::TokenIter<util::MultiCharacter> pipes(line, "|||");
-    StringPiece sourcePhraseString(*pipes);
-    StringPiece targetPhraseString(*++pipes);
-    StringPiece scoreString(*++pipes);
-
-    StringPiece alignString;
-    if (++pipes) {
-      StringPiece temp(*pipes);
-      alignString = temp;
-    }
-
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !staticData.IsWordDeletionEnabled()) {
-      TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
-    }
-
-    scoreVector.clear();
-    for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
-      int processed;
-      float score = converter.StringToFloat(s->data(), s->length(), &processed);
-      UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
-      scoreVector.push_back(FloorScore(TransformScore(score)));
-    }
-    const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
-    }
-
-    // parse source & find pt node
-
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
-
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
     Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
-
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
-
-    ++pipes;  // skip over counts field
-
-    if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ruleTable, sparseString);
-    }
-
-    if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
+    Word *sourceLHS = NULL;
+    TargetPhrase *targetPhrase = ParseRule(line, count, input, output, ruleTable,
+                                           scoreVector, sourcePhrase, sourceLHS);
+    if (targetPhrase == NULL) {
+      continue;
     }
 
-    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
-
     TargetPhraseCollection &phraseColl = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase, *targetPhrase, sourceLHS);
     phraseColl.Add(targetPhrase);
 
@@ -20,10 +20,21 @@
 #pragma once
 
 #include "Loader.h"
+#include "util/string_piece.hh"
+
+#include <string>
 
 namespace Moses
 {
 
+class Phrase;
+class PhraseDictionary;
+class TargetPhrase;
+class Word;
+
+//! convert a rule in Hiero format to Moses format
+void ReformatHieroRule(const std::string &lineOrig, std::string &out);
+
 //! Loader to load Moses-formatted SCFG rules from a text file
 class RuleTableLoaderStandard : public RuleTableLoader
 {
@@ -41,6 +52,19 @@ public:
             const std::string &inFile,
             size_t tableLimit,
             RuleTableTrie &);
+
+  /** Parse one rule in Moses format into a new target phrase, which is
+   * evaluated in isolation, and its source phrase. The caller owns the
+   * target phrase and sourceLHS.
+   * \return NULL if the rule is skipped */
+  static TargetPhrase *ParseRule(const StringPiece &line,
+                                 size_t lineNum,
+                                 const std::vector<FactorType> &input,
+                                 const std::vector<FactorType> &output,
+                                 const PhraseDictionary &ruleTable,
+                                 std::vector<float> &scoreVector,
+                                 Phrase &sourcePhrase,
+                                 Word *&sourceLHS);
 };
 
 }  // namespace Moses
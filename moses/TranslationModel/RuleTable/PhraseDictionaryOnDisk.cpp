@@ -39,6 +39,7 @@ PhraseDictionaryOnDisk::PhraseDictionaryOnDisk(const std::string &line)
   : MyBase(line, true)
   , m_maxSpanDefault(NOT_FOUND)
   , m_maxSpanLabelled(NOT_FOUND)
+  , m_populate(false)
 {
   ReadParameters();
 }
@@ -50,6 +51,27 @@ PhraseDictionaryOnDisk::~PhraseDictionaryOnDisk()
 void PhraseDictionaryOnDisk::Load()
 {
   SetFeaturesToApply();
+
+  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
+  obj->BeginLoad(m_filePath, m_populate ? util::POPULATE_OR_READ : util::LAZY);
+
+  UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
+                 "On-disk phrase table is version " <<  obj->GetMisc("Version")
+                 << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
+
+  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
+                 "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
+                 << ". The ini file specified " << m_input.size() << " source factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
+                 "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
+                 << ". The ini file specified " << m_output.size() << " target factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
+                 "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
+                 << ". The ini file specified " << m_numScoreComponents << " scores");
+
+  m_implementation.reset(obj);
 }
 
 ChartRuleLookupManager *PhraseDictionaryOnDisk::CreateRuleLookupManager(
@@ -67,7 +89,7 @@ OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation()
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
@@ -75,35 +97,13 @@ const OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation() const
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
 void PhraseDictionaryOnDisk::InitializeForInput(ttasksptr const& ttask)
 {
-  InputType const& source = *ttask->GetSource();
   ReduceCache();
-
-  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
-  obj->BeginLoad(m_filePath);
-
-  UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
-                 "On-disk phrase table is version " <<  obj->GetMisc("Version")
-                 << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
-
-  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
-                 "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
-                 << ". The ini file specified " << m_input.size() << " source factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
-                 "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
-                 << ". The ini file specified " << m_output.size() << " target factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
-                 "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
-                 << ". The ini file specified " << m_numScoreComponents << " scores");
-
-  m_implementation.reset(obj);
 }
 
 void PhraseDictionaryOnDisk::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
@@ -173,22 +173,11 @@ const TargetPhraseCollection *PhraseDictionaryOnDisk::GetTargetPhraseCollection(
   CacheColl &cache = GetCache();
   size_t hash = (size_t) ptNode->GetFilePos();
 
-  CacheColl::iterator iter;
-
-  iter = cache.find(hash);
-
-  if (iter == cache.end()) {
+  if (!cache.Find(hash, ret)) {
     // not in cache, need to look up from phrase table
     ret = GetTargetPhraseCollectionNonCache(ptNode);
 
-    std::pair<const TargetPhraseCollection*, clock_t> value(ret, clock());
-    cache[hash] = value;
-  } else {
-    // in cache. just use it
-    std::pair<const TargetPhraseCollection*, clock_t> &value = iter->second;
-    value.second = clock();
-
-    ret = value.first;
+    cache.Add(hash, ret);
   }
 
   return ret;
@@ -210,12 +199,42 @@ const TargetPhraseCollection *PhraseDictionaryOnDisk::GetTargetPhraseCollectionN
   return targetPhrases;
 }
 
+// walk down the source trie as GetTargetPhraseCollectionBatch() does, so
+// the collection is cached under its node's file position
+void PhraseDictionaryOnDisk::CacheTargetPhrases(const Phrase &src) const
+{
+  OnDiskPt::OnDiskWrapper &wrapper = const_cast<OnDiskPt::OnDiskWrapper&>(GetImplementation());
+  const OnDiskPt::PhraseNode *root = &wrapper.GetRootSourceNode();
+  const OnDiskPt::PhraseNode *ptNode = root;
+
+  for (size_t pos = 0; ptNode && pos < src.GetSize(); ++pos) {
+    Word word = src.GetWord(pos);
+    word.OnlyTheseFactors(m_inputFactors);
+    OnDiskPt::Word *wordOnDisk = wrapper.ConvertFromMoses(m_input, word);
+
+    const OnDiskPt::PhraseNode *child = NULL;
+    if (wordOnDisk) {
+      child = ptNode->GetChild(*wordOnDisk, wrapper);
+      delete wordOnDisk;
+    }
+    if (ptNode != root) delete ptNode;
+    ptNode = child;
+  }
+
+  if (ptNode && ptNode != root) {
+    GetTargetPhraseCollection(ptNode);
+    delete ptNode;
+  }
+}
+
 void PhraseDictionaryOnDisk::SetParameter(const std::string& key, const std::string& value)
 {
   if (key == "max-span-default") {
     m_maxSpanDefault = Scan<size_t>(value);
   } else if (key == "max-span-labelled") {
     m_maxSpanLabelled = Scan<size_t>(value);
+  } else if (key == "populate") {
+    m_populate = Scan<bool>(value);
   } else {
     PhraseDictionary::SetParameter(key, value);
   }
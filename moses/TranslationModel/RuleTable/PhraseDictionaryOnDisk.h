@@ -29,11 +29,7 @@
 #include "OnDiskPt/Word.h"
 #include "OnDiskPt/PhraseNode.h"
 
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
 #include <boost/scoped_ptr.hpp>
-#endif
 
 namespace Moses
 {
@@ -51,13 +47,11 @@ class PhraseDictionaryOnDisk : public PhraseDictionary
   friend class ChartRuleLookupManagerOnDisk;
 
 protected:
-#ifdef WITH_THREADS
-  boost::thread_specific_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#else
+  // lookups only read the mapped table, so all threads share it
   boost::scoped_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#endif
 
   size_t m_maxSpanDefault, m_maxSpanLabelled;
+  bool m_populate; //! read the whole table into memory when loading
 
   OnDiskPt::OnDiskWrapper &GetImplementation();
   const OnDiskPt::OnDiskWrapper &GetImplementation() const;
@@ -83,6 +77,13 @@ public:
 
   void SetParameter(const std::string& key, const std::string& value);
 
+  bool SupportsPrefetch() const {
+    return true;
+  }
+
+protected:
+  void CacheTargetPhrases(const Phrase &src) const;
+
 };
 
 }  // namespace Moses
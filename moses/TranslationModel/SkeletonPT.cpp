@@ -31,14 +31,18 @@ void SkeletonPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQu
     InputPath &inputPath = **iter;
     const Phrase &sourcePhrase = inputPath.GetPhrase();
 
-    TargetPhrase *tp = CreateTargetPhrase(sourcePhrase);
-    TargetPhraseCollection *tpColl = new TargetPhraseCollection();
-    tpColl->Add(tp);
-
-    // add target phrase to phrase-table cache
+    // look in phrase-table cache first
     size_t hash = hash_value(sourcePhrase);
-    std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-    cache[hash] = value;
+    const TargetPhraseCollection *tpColl;
+    if (!cache.Find(hash, tpColl)) {
+      TargetPhrase *tp = CreateTargetPhrase(sourcePhrase);
+      TargetPhraseCollection *newColl = new TargetPhraseCollection();
+      newColl->Add(tp);
+
+      // add target phrase to phrase-table cache
+      tpColl = newColl;
+      cache.Add(hash, tpColl);
+    }
 
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   }
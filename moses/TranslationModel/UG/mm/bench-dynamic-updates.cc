@@ -0,0 +1,200 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+// Benchmark: latency of lookups in a dynamic bitext while sentence pairs
+// are being added to it, as with online updates of Mmsapt.
+// (c) 2015 University of Edinburgh
+
+#include <boost/program_options.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/foreach.hpp>
+#include <boost/atomic.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ug_bitext.h"
+#include "ug_im_bitext.h"
+#include "moses/TranslationModel/UG/generic/file_io/ug_stream.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace ugdiss;
+using namespace sapt;
+namespace po=boost::program_options;
+
+typedef L2R_Token<SimpleWordId> Token;
+typedef imBitext<Token> bitext_t;
+
+string L1file, L2file, alnfile;
+size_t num_readers, num_initial, interval;
+double duration;
+bool locked;
+
+// the dynamic bitext and its lock, as in Mmsapt
+SPTR<bitext_t> btdyn;
+boost::shared_mutex btlock;
+boost::mutex update_lock;
+boost::atomic<bool> done(false);
+
+void
+interpret_args(int ac, char* av[])
+{
+  po::variables_map vm;
+  po::options_description o("Options");
+  o.add_options()
+    ("help,h", "print this message")
+    ("readers,r", po::value<size_t>(&num_readers)->default_value(4),
+     "number of threads doing lookups")
+    ("initial,n", po::value<size_t>(&num_initial)->default_value(10000),
+     "number of sentence pairs in the bitext before updates start")
+    ("interval,i", po::value<size_t>(&interval)->default_value(100),
+     "milliseconds between updates")
+    ("seconds,s", po::value<double>(&duration)->default_value(10),
+     "duration of the benchmark")
+    ("locked", po::bool_switch(&locked),
+     "hold the exclusive lock while the update is built (the old Mmsapt behaviour)")
+    ;
+  po::options_description h("Hidden Options");
+  h.add_options()
+    ("L1", po::value<string>(&L1file), "L1 text")
+    ("L2", po::value<string>(&L2file), "L2 text")
+    ("aln", po::value<string>(&alnfile), "word alignment, one sentence pair per line")
+    ;
+  h.add(o);
+  po::positional_options_description a;
+  a.add("L1",1);
+  a.add("L2",1);
+  a.add("aln",1);
+
+  po::store(po::command_line_parser(ac,av)
+            .options(h)
+            .positional(a)
+            .run(),vm);
+  po::notify(vm);
+  if (vm.count("help") || alnfile.empty())
+    {
+      cout << "\nusage:\n\t" << av[0]
+           << " [options] <L1 text> <L2 text> <alignment>" << endl;
+      cout << o << endl;
+      exit(0);
+    }
+}
+
+void
+read_lines(string const& fname, vector<string>& lines)
+{
+  boost::iostreams::filtering_istream in;
+  open_input_stream(fname,in);
+  string line;
+  while (getline(in,line)) lines.push_back(line);
+}
+
+SPTR<bitext_t>
+snapshot()
+{
+  if (locked)
+    {
+      boost::unique_lock<boost::shared_mutex> guard(btlock);
+      return btdyn;
+    }
+  boost::shared_lock<boost::shared_mutex> guard(btlock);
+  return btdyn;
+}
+
+void
+update(string const& s1, string const& s2, string const& a)
+{
+  vector<string> S1(1,s1), S2(1,s2), A(1,a);
+  if (locked)
+    {
+      boost::unique_lock<boost::shared_mutex> guard(btlock);
+      btdyn = btdyn->add(S1,S2,A);
+      return;
+    }
+  boost::lock_guard<boost::mutex> guard(update_lock);
+  SPTR<bitext_t> dyn = snapshot()->add(S1,S2,A);
+  boost::unique_lock<boost::shared_mutex> publish(btlock);
+  btdyn = dyn;
+}
+
+// look up random n-grams of the initial sentences, record latencies (ms)
+void
+reader(unsigned seed, vector<double>* latencies)
+{
+  while (!done)
+    {
+      double start = util::WallTime();
+      SPTR<bitext_t> dyn = snapshot();
+      size_t sid = rand_r(&seed) % num_initial;
+      Token const* a = dyn->T1->sntStart(sid);
+      Token const* z = dyn->T1->sntEnd(sid);
+      if (a == z) continue;
+      a += rand_r(&seed) % (z - a);
+      TSA<Token>::tree_iterator m(dyn->I1.get());
+      for (size_t k = 0; a < z && k < 3 && m.extend(*a); ++a, ++k)
+        m.approxOccurrenceCount();
+      latencies->push_back((util::WallTime() - start) * 1000);
+    }
+}
+
+double
+percentile(vector<double> const& sorted, double p)
+{
+  if (sorted.empty()) return 0;
+  return sorted[min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+int
+main(int argc, char* argv[])
+{
+  interpret_args(argc,argv);
+  vector<string> S1, S2, A;
+  read_lines(L1file,S1);
+  read_lines(L2file,S2);
+  read_lines(alnfile,A);
+  UTIL_THROW_IF2(S1.size() != S2.size() || S1.size() != A.size(),
+                 "Input files differ in length");
+  num_initial = min(num_initial, S1.size());
+  UTIL_THROW_IF2(num_initial == 0 || num_initial == S1.size(),
+                 "Need sentence pairs both for the initial bitext and for updates");
+
+  btdyn.reset(new bitext_t());
+  btdyn = btdyn->add(vector<string>(S1.begin(), S1.begin() + num_initial),
+                     vector<string>(S2.begin(), S2.begin() + num_initial),
+                     vector<string>(A.begin(), A.begin() + num_initial));
+
+  vector<vector<double> > latencies(num_readers);
+  boost::thread_group readers;
+  for (size_t i = 0; i < num_readers; ++i)
+    readers.create_thread(boost::bind(reader, unsigned(i + 1), &latencies[i]));
+
+  double start = util::WallTime();
+  double slowest = 0;
+  size_t next = num_initial, updates = 0;
+  while (util::WallTime() - start < duration)
+    {
+      double t = util::WallTime();
+      update(S1[next],S2[next],A[next]);
+      slowest = max(slowest, util::WallTime() - t);
+      ++updates;
+      if (++next == S1.size()) next = num_initial;
+      boost::this_thread::sleep(boost::posix_time::milliseconds(interval));
+    }
+  done = true;
+  readers.join_all();
+
+  vector<double> all;
+  BOOST_FOREACH(vector<double> const& v, latencies)
+    all.insert(all.end(), v.begin(), v.end());
+  sort(all.begin(), all.end());
+  cout << (locked ? "locked" : "snapshot") << " updates: " << updates
+       << " (slowest " << slowest * 1000 << " ms), "
+       << "lookups: " << all.size() << endl
+       << "lookup latency (ms): p50 " << percentile(all,.5)
+       << " p99 " << percentile(all,.99)
+       << " p99.9 " << percentile(all,.999)
+       << " max " << (all.size() ? all.back() : 0) << endl;
+}
@@ -1,5 +1,6 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
 #include "ug_bitext_jstats.h"
+#include "tpt_pickler.h"
 namespace sapt
 {
 
@@ -88,4 +89,72 @@ namespace sapt
   aln() const
   { return my_aln; }
 
+  void
+  jstats::
+  save(std::ostream& out) const
+  {
+    using tpt::binwrite;
+    binwrite(out, my_rcnt);
+    binwrite(out, my_cnt2);
+    binwrite(out, my_wcnt);
+    binwrite(out, my_bcnt);
+    binwrite(out, my_aln.size());
+    for (size_t i = 0; i < my_aln.size(); ++i)
+      {
+        binwrite(out, my_aln[i].first);
+        binwrite(out, my_aln[i].second.size());
+        if (my_aln[i].second.size())
+          out.write(reinterpret_cast<char const*>(&my_aln[i].second[0]),
+                    my_aln[i].second.size());
+      }
+    for (int i = 0; i <= Moses::LRModel::NONE; ++i)
+      {
+        binwrite(out, ofwd[i]);
+        binwrite(out, obwd[i]);
+      }
+    binwrite(out, indoc.size());
+    typedef std::map<uint32_t,uint32_t>::const_iterator iter;
+    for (iter m = indoc.begin(); m != indoc.end(); ++m)
+      {
+        binwrite(out, m->first);
+        binwrite(out, m->second);
+      }
+  }
+
+  void
+  jstats::
+  load(std::istream& in)
+  {
+    using tpt::binread;
+    binread(in, my_rcnt);
+    binread(in, my_cnt2);
+    binread(in, my_wcnt);
+    binread(in, my_bcnt);
+    size_t n;
+    binread(in, n);
+    my_aln.resize(n);
+    for (size_t i = 0; i < n; ++i)
+      {
+        size_t len;
+        binread(in, my_aln[i].first);
+        binread(in, len);
+        my_aln[i].second.resize(len);
+        if (len) in.read(reinterpret_cast<char*>(&my_aln[i].second[0]), len);
+      }
+    for (int i = 0; i <= Moses::LRModel::NONE; ++i)
+      {
+        binread(in, ofwd[i]);
+        binread(in, obwd[i]);
+      }
+    binread(in, n);
+    indoc.clear();
+    for (size_t i = 0; i < n; ++i)
+      {
+        uint32_t docid, cnt;
+        binread(in, docid);
+        binread(in, cnt);
+        indoc[docid] = cnt;
+      }
+  }
+
 } // namespace sapt
@@ -1,6 +1,7 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
 #pragma once
 #include <string>
+#include <iostream>
 #include <stdint.h>
 #include "ug_typedefs.h"
 #include "ug_lexical_reordering.h"
@@ -51,6 +52,10 @@ namespace sapt
     void fill_lr_vec(Moses::LRModel::Direction const& dir,
                      Moses::LRModel::ModelType const& mdl,
                      std::vector<float>& v);
+
+    // (de)serialization for the persistent statistics cache
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
   };
 }
 
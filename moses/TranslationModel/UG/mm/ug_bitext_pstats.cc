@@ -1,6 +1,7 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
 #include <boost/thread/locks.hpp>
 #include "ug_bitext_pstats.h"
+#include "tpt_pickler.h"
 
 namespace sapt
 {
@@ -91,5 +92,69 @@ namespace sapt
       this->ready.wait(lock);
   }
 
+  void
+  pstats::
+  save(std::ostream& out) const
+  {
+    using tpt::binwrite;
+    boost::lock_guard<boost::mutex> guard(this->lock);
+    binwrite(out, raw_cnt);
+    binwrite(out, sample_cnt);
+    binwrite(out, good);
+    binwrite(out, sum_pairs);
+    for (int i = 0; i <= Moses::LRModel::NONE; ++i)
+      {
+        binwrite(out, ofwd[i]);
+        binwrite(out, obwd[i]);
+      }
+    binwrite(out, indoc.size());
+    for (indoc_map_t::const_iterator m = indoc.begin(); m != indoc.end(); ++m)
+      {
+        binwrite(out, m->first);
+        binwrite(out, m->second);
+      }
+    binwrite(out, trg.size());
+    for (trg_map_t::const_iterator m = trg.begin(); m != trg.end(); ++m)
+      {
+        binwrite(out, m->first);
+        m->second.save(out);
+      }
+  }
+
+  void
+  pstats::
+  load(std::istream& in)
+  {
+    using tpt::binread;
+    boost::lock_guard<boost::mutex> guard(this->lock);
+    binread(in, raw_cnt);
+    binread(in, sample_cnt);
+    binread(in, good);
+    binread(in, sum_pairs);
+    for (int i = 0; i <= Moses::LRModel::NONE; ++i)
+      {
+        binread(in, ofwd[i]);
+        binread(in, obwd[i]);
+      }
+    size_t n;
+    binread(in, n);
+    indoc.clear();
+    for (size_t i = 0; i < n; ++i)
+      {
+        uint32_t docid, cnt;
+        binread(in, docid);
+        binread(in, cnt);
+        indoc[docid] = cnt;
+      }
+    binread(in, n);
+    trg.clear();
+    for (size_t i = 0; i < n; ++i)
+      {
+        uint64_t pid;
+        binread(in, pid);
+        trg[pid].load(in);
+      }
+  }
+
 } // end of namespace sapt
 
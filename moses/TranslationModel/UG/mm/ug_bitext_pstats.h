@@ -57,6 +57,10 @@ namespace sapt
 		 int const po_fwd,       // fwd phrase orientation
 		 int const po_bwd);      // bwd phrase orientation
     void wait() const;
+
+    // (de)serialization of finished statistics for the persistent cache
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
   };
 
 }
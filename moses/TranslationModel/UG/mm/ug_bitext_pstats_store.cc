@@ -0,0 +1,293 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+// (c) 2015 University of Edinburgh
+#include "ug_bitext_pstats_store.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <boost/functional/hash.hpp>
+#include "util/exception.hh"
+
+namespace sapt
+{
+  namespace
+  {
+    char const magic[8] = { 'U','G','P','S','T','A','T','1' };
+
+    // record layout: payload length, pid, bias, samples, method, payload
+    size_t const record_header_size = 4 + 8 + 8 + 4 + 4;
+
+    // records larger than this are taken for garbage
+    uint32_t const max_payload = 1U << 30;
+
+    // holds an flock() on the file for its lifetime
+    class
+    file_lock
+    {
+      int m_fd;
+    public:
+      file_lock(int const fd, int const op) : m_fd(fd)
+      {
+        while (flock(m_fd, op) < 0)
+          UTIL_THROW_IF2(errno != EINTR, "flock() failed on persistent pstats cache: "
+                         << strerror(errno));
+      }
+      ~file_lock() { flock(m_fd, LOCK_UN); }
+    };
+
+    bool
+    read_fully(int const fd, char* buf, size_t const n, uint64_t const offset)
+    {
+      size_t done = 0;
+      while (done < n)
+        {
+          ssize_t r = pread(fd, buf + done, n - done, offset + done);
+          if (r < 0 && errno == EINTR) continue;
+          if (r <= 0) return false;
+          done += r;
+        }
+      return true;
+    }
+
+    void
+    write_fully(int const fd, char const* buf, size_t const n, uint64_t const offset)
+    {
+      size_t done = 0;
+      while (done < n)
+        {
+          ssize_t r = pwrite(fd, buf + done, n - done, offset + done);
+          if (r < 0 && errno == EINTR) continue;
+          UTIL_THROW_IF2(r < 0, "Failed to write to persistent pstats cache: "
+                         << strerror(errno));
+          done += r;
+        }
+    }
+  }
+
+  bool
+  pstats_store::
+  key::
+  operator==(key const& other) const
+  {
+    return (pid == other.pid && bias == other.bias
+            && samples == other.samples && method == other.method);
+  }
+
+  size_t
+  hash_value(pstats_store::key const& k)
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, k.pid);
+    boost::hash_combine(seed, k.bias);
+    boost::hash_combine(seed, k.samples);
+    boost::hash_combine(seed, k.method);
+    return seed;
+  }
+
+  std::string
+  pstats_store::
+  fingerprint(std::vector<std::string> const& files)
+  {
+    std::ostringstream buf;
+    for (size_t i = 0; i < files.size(); ++i)
+      {
+        struct stat st;
+        if (stat(files[i].c_str(), &st) < 0) continue; // optional file
+        buf << files[i] << " " << st.st_size << " " << st.st_mtime << "\n";
+      }
+    return buf.str();
+  }
+
+  pstats_store::
+  pstats_store(std::string const& fname, std::string const& fingerprint)
+    : m_fname(fname), m_fingerprint(fingerprint), m_fd(-1)
+    , m_start(sizeof(magic) + 4 + fingerprint.size()), m_scanned(0)
+  {
+    m_fd = open(fname.c_str(), O_RDWR | O_CREAT, 0666);
+    UTIL_THROW_IF2(m_fd < 0, "Cannot open persistent pstats cache " << fname
+                   << ": " << strerror(errno));
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    file_lock flk(m_fd, LOCK_EX);
+    m_scanned = m_start;
+    if (!check_header()) reset();
+    uint64_t const end = file_size();
+    scan(end);
+    // cut off a record torn by a process that died while writing it
+    if (m_scanned < end && ftruncate(m_fd, m_scanned) < 0)
+      UTIL_THROW2("Cannot truncate persistent pstats cache " << fname
+                  << ": " << strerror(errno));
+  }
+
+  pstats_store::
+  ~pstats_store()
+  {
+    if (m_fd >= 0) close(m_fd);
+  }
+
+  uint64_t
+  pstats_store::
+  file_size() const
+  {
+    struct stat st;
+    UTIL_THROW_IF2(fstat(m_fd, &st) < 0, "fstat() failed on persistent pstats cache "
+                   << m_fname << ": " << strerror(errno));
+    return st.st_size;
+  }
+
+  bool
+  pstats_store::
+  check_header()
+  {
+    std::vector<char> buf(m_start);
+    if (!read_fully(m_fd, &buf[0], m_start, 0)) return false;
+    if (memcmp(&buf[0], magic, sizeof(magic))) return false;
+    uint32_t len;
+    memcpy(&len, &buf[sizeof(magic)], 4);
+    return (len == m_fingerprint.size() &&
+            !m_fingerprint.compare(0, len, &buf[sizeof(magic) + 4], len));
+  }
+
+  // Empty the file and write our header. Caller holds the exclusive flock.
+  void
+  pstats_store::
+  reset()
+  {
+    UTIL_THROW_IF2(ftruncate(m_fd, 0) < 0, "Cannot truncate persistent pstats cache "
+                   << m_fname << ": " << strerror(errno));
+    std::string header(magic, sizeof(magic));
+    uint32_t len = m_fingerprint.size();
+    header.append(reinterpret_cast<char const*>(&len), 4);
+    header += m_fingerprint;
+    write_fully(m_fd, header.data(), header.size(), 0);
+    m_index.clear();
+    m_scanned = m_start;
+  }
+
+  // Index the complete records between m_scanned and end. Caller holds
+  // m_lock and an flock, so that no record is in the middle of being written
+  // (except one torn by a process that died).
+  void
+  pstats_store::
+  scan(uint64_t const end)
+  {
+    if (m_scanned > end)
+      {
+        // another process has emptied the file; if it did so for a
+        // different bitext, the records are no longer ours
+        m_index.clear();
+        m_scanned = m_start;
+        UTIL_THROW_IF2(!check_header(), "Persistent pstats cache " << m_fname
+                       << " has been taken over for a different bitext");
+      }
+    std::vector<char> buf(1 << 20);
+    while (m_scanned + record_header_size <= end)
+      {
+        size_t n = std::min(uint64_t(buf.size()), end - m_scanned);
+        if (!read_fully(m_fd, &buf[0], n, m_scanned)) return;
+        size_t p = 0;
+        uint32_t len = 0;
+        while (p + record_header_size <= n)
+          {
+            key k;
+            char const* r = &buf[p];
+            memcpy(&len,       r,      4);
+            memcpy(&k.pid,     r + 4,  8);
+            memcpy(&k.bias,    r + 12, 8);
+            memcpy(&k.samples, r + 20, 4);
+            memcpy(&k.method,  r + 24, 4);
+            if (len > max_payload || p + record_header_size + len > n) break;
+            location& loc = m_index[k];
+            loc.first  = m_scanned + p + record_header_size;
+            loc.second = len;
+            p += record_header_size + len;
+          }
+        if (p == 0)
+          {
+            // garbage, a torn record, or a record larger than the buffer
+            if (len > max_payload || m_scanned + record_header_size + len > end)
+              return;
+            buf.resize(record_header_size + len);
+            continue;
+          }
+        m_scanned += p;
+      }
+  }
+
+  SPTR<pstats>
+  pstats_store::
+  get(key const& k)
+  {
+    location loc;
+    {
+      boost::lock_guard<boost::mutex> guard(m_lock);
+      index_t::const_iterator m = m_index.find(k);
+      if (m == m_index.end())
+        {
+          // look for records added by other processes in the meantime
+          uint64_t const end = file_size();
+          if (end == m_scanned) return SPTR<pstats>();
+          file_lock flk(m_fd, LOCK_SH);
+          scan(file_size());
+          m = m_index.find(k);
+          if (m == m_index.end()) return SPTR<pstats>();
+        }
+      loc = m->second;
+    }
+    std::string payload(loc.second, 0);
+    if (loc.second && !read_fully(m_fd, &payload[0], loc.second, loc.first))
+      return SPTR<pstats>();
+    std::istringstream in(payload);
+    SPTR<pstats> ret(new pstats);
+    ret->load(in);
+    return ret;
+  }
+
+  void
+  pstats_store::
+  put(key const& k, pstats const& stats)
+  {
+    {
+      boost::lock_guard<boost::mutex> guard(m_lock);
+      if (m_index.find(k) != m_index.end()) return;
+    }
+
+    std::ostringstream out;
+    stats.save(out);
+    std::string const payload = out.str();
+    if (payload.size() > max_payload) return;
+    std::string record(record_header_size, 0);
+    uint32_t len = payload.size();
+    memcpy(&record[0],  &len,       4);
+    memcpy(&record[4],  &k.pid,     8);
+    memcpy(&record[12], &k.bias,    8);
+    memcpy(&record[20], &k.samples, 4);
+    memcpy(&record[24], &k.method,  4);
+    record += payload;
+
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    file_lock flk(m_fd, LOCK_EX);
+    uint64_t const end = file_size();
+    scan(end);
+    if (m_index.find(k) != m_index.end()) return; // another process was faster
+    if (m_scanned < end && ftruncate(m_fd, m_scanned) < 0) return; // torn record
+    write_fully(m_fd, record.data(), record.size(), m_scanned);
+    location& loc = m_index[k];
+    loc.first  = m_scanned + record_header_size;
+    loc.second = len;
+    m_scanned += record.size();
+  }
+
+  size_t
+  pstats_store::
+  size() const
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    return m_index.size();
+  }
+}
@@ -0,0 +1,82 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+// Persistent cache of phrase statistics (pstats) for a memory-mapped bitext.
+// (c) 2015 University of Edinburgh
+//
+// Sampling the same frequent phrases over and over again is expensive,
+// and each decoder process has to do it again after every restart. The
+// pstats_store keeps finished pstats in a file, so that they can be
+// shared by all processes on a machine (reads go through the page cache,
+// which they all share) and survive restarts.
+//
+// The file is append-only: a header with the fingerprint of the bitext,
+// followed by records [length][key][serialized pstats]. Appends are
+// serialized across processes with flock(); records appended by other
+// processes are picked up when a lookup misses. A torn record at the end
+// of the file (from a process that died while writing it) is cut off.
+// If the fingerprint doesn't match (the bitext has been rebuilt), the
+// file is emptied.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include "ug_typedefs.h"
+#include "ug_bitext_pstats.h"
+
+namespace sapt
+{
+  class
+  pstats_store
+  {
+  public:
+    struct
+    key
+    {
+      uint64_t pid;     // phrase id in the suffix array
+      uint64_t bias;    // SamplingBias::GetId(), 0 for no bias
+      uint32_t samples; // sample size
+      uint32_t method;  // sampling method
+      key() : pid(0), bias(0), samples(0), method(0) { }
+      key(uint64_t const p, uint64_t const b, uint32_t const s, uint32_t const m)
+        : pid(p), bias(b), samples(s), method(m) { }
+      bool operator==(key const& other) const;
+    };
+
+    // size and modification time of the files, to detect changes of the
+    // bitext they belong to
+    static std::string
+    fingerprint(std::vector<std::string> const& files);
+
+    pstats_store(std::string const& fname, std::string const& fingerprint);
+    ~pstats_store();
+
+    // statistics stored under k, NULL if there are none
+    SPTR<pstats> get(key const& k);
+
+    // store finished statistics under k, unless something is stored there
+    void put(key const& k, pstats const& stats);
+
+    size_t size() const; // number of records known to this process
+
+  private:
+    typedef std::pair<uint64_t, uint32_t> location; // offset and length of payload
+    typedef boost::unordered_map<key, location> index_t;
+
+    std::string m_fname;
+    std::string m_fingerprint;
+    int m_fd;
+    uint64_t m_start;   // end of header
+    uint64_t m_scanned; // end of the records in m_index
+    index_t m_index;
+    mutable boost::mutex m_lock; // held while the file is flock()ed
+
+    bool check_header();
+    void reset();
+    void scan(uint64_t const end);
+    uint64_t file_size() const;
+  };
+
+  size_t hash_value(pstats_store::key const& k);
+}
@@ -11,6 +11,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "tpt_typedefs.h"
 #include "tpt_tokenindex.h"
@@ -42,8 +43,11 @@ namespace sapt
 
   private:
     size_t numToks;
+    // Sentence buffer, shared by all tracks appended from this one. Each
+    // track only sees its first numSnts sentences, so appending to the
+    // buffer in place leaves the tracks that readers hold unchanged.
     boost::shared_ptr<typename std::vector<std::vector<Token> > > myData;  
-    // pointer to corpus data
+    size_t numSnts;
     friend class imTSA<Token>;
 
     friend
@@ -78,12 +82,12 @@ namespace sapt
   m_check_token_count()
   { // sanity check
     size_t check = 0;
-    BOOST_FOREACH(std::vector<Token> const& s, *myData)
-      check += s.size();
+    for (size_t i = 0; i < numSnts; ++i)
+      check += (*myData)[i].size();
     UTIL_THROW_IF2(check != this->numToks, "[" << HERE << "]"
 		   << " Wrong token count after appending sentence!"
 		   << " Counted " << check << " but expected "
-		   << this->numToks << " in a total of " << myData->size()
+		   << this->numToks << " in a total of " << numSnts
 		   << " sentences.");
 
   }
@@ -116,7 +120,7 @@ namespace sapt
     // we assume that myIndex has pointers to both the beginning of the
     // first sentence and the end point of the last, so there's one more
     // offset in the myIndex than there are sentences
-    return myData->size();
+    return numSnts;
   }
 
   template<typename Token>
@@ -130,7 +134,7 @@ namespace sapt
   template<typename Token>
   imTtrack<Token>::
   imTtrack(std::istream& in, TokenIndex& V, std::ostream* log)
-    : numToks(0)
+    : numToks(0), numSnts(0)
   {
     myData.reset(new std::vector<std::vector<Token> >());
     std::string line,w;
@@ -155,12 +159,13 @@ namespace sapt
 	// myData->back().resize(myData->back().size(), Token(0));
 	numToks += myData->back().size();
       }
+    numSnts = myData->size();
   }
 
   template<typename Token>
   imTtrack<Token>::
   imTtrack(size_t reserve)
-    : numToks(0)
+    : numToks(0), numSnts(0)
   {
     myData.reset(new std::vector<std::vector<Token> >());
     if (reserve) myData->reserve(reserve);
@@ -172,6 +177,7 @@ namespace sapt
     : numToks(0)
   {
     myData  = d;
+    numSnts = d->size();
     BOOST_FOREACH(std::vector<Token> const& v, *d)
       numToks += v.size();
   }
@@ -182,7 +188,7 @@ namespace sapt
   findSid(Token const* t) const
   {
     id_type i;
-    for (i = 0; i < myData->size(); ++i)
+    for (i = 0; i < numSnts; ++i)
       {
 	std::vector<Token> const& v = (*myData)[i];
 	if (v.size() == 0) continue;
@@ -192,7 +198,14 @@ namespace sapt
     return i;
   }
 
-  /// add a sentence to the database
+  // serializes appends to shared sentence buffers
+  inline boost::mutex& imTtrack_append_lock()
+  {
+    static boost::mutex lock;
+    return lock;
+  }
+
+  /// add a sentence to the database; crp itself is not modified
   template<typename TOKEN>
   boost::shared_ptr<imTtrack<TOKEN> >
   append(boost::shared_ptr<imTtrack<TOKEN> > const& crp, std::vector<TOKEN> const & snt)
@@ -200,20 +213,32 @@ namespace sapt
 #if 1
     if (crp) crp->m_check_token_count();
 #endif
-    boost::shared_ptr<imTtrack<TOKEN> > ret;
-    if (crp == NULL)
+    boost::shared_ptr<imTtrack<TOKEN> > ret(new imTtrack<TOKEN>());
+    if (crp)
       {
-  	ret.reset(new imTtrack<TOKEN>());
-	ret->myData->reserve(IMTTRACK_INCREMENT_SIZE);
+        boost::lock_guard<boost::mutex> guard(imTtrack_append_lock());
+        ret->numToks = crp->numToks;
+        ret->numSnts = crp->numSnts;
+        // Share the buffer as long as crp is its last track and the buffer
+        // need not grow, otherwise copy crp's sentences to a new buffer.
+        // Growing a shared buffer would move the sentences under readers.
+        if (crp->myData->size() == crp->numSnts 
+            && crp->myData->capacity() > crp->numSnts)
+          ret->myData = crp->myData;
+        else
+          {
+            ret->myData->reserve(crp->numSnts + IMTTRACK_INCREMENT_SIZE);
+            ret->myData->assign(crp->myData->begin(),
+                                crp->myData->begin() + crp->numSnts);
+          }
+        ret->myData->push_back(snt);
       }
-    else if (crp->myData->capacity() == crp->size())
+    else
       {
-  	ret.reset(new imTtrack<TOKEN>());
-	ret->myData->reserve(crp->size() + IMTTRACK_INCREMENT_SIZE);
-	copy(crp->myData->begin(),crp->myData->end(),ret->myData->begin());
+        ret->myData->reserve(IMTTRACK_INCREMENT_SIZE);
+        ret->myData->push_back(snt);
       }
-    else ret = crp;
-    ret->myData->push_back(snt);
+    ++ret->numSnts;
     ret->numToks += snt.size();
 
 #if 1
@@ -2,6 +2,8 @@
 #include "ug_sampling_bias.h"
 #include <iostream>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <cstring>
 #include "moses/Util.h"
 #ifndef NO_MOSES
 #include "moses/Timer.h"
@@ -51,6 +53,11 @@ namespace sapt
     return m_sid2docid ? m_sid2docid->at(idx) : -1;
   }
 
+  uint64_t
+  SamplingBias::
+  GetId() const
+  { return 0; }
+
   DocumentBias::
   DocumentBias(std::vector<id_type> const& sid2doc,
                std::map<std::string,id_type> const& docname2docid,
@@ -194,6 +201,24 @@ namespace sapt
   size() const
   { return m_sid2docid->size(); }
 
+  uint64_t
+  DocumentBias::
+  GetId() const
+  {
+    // hash the bit patterns rather than the floats, so that the id
+    // doesn't depend on how boost hashes floating point numbers
+    size_t seed = m_bias.size();
+    typedef std::map<id_type, float>::value_type item;
+    BOOST_FOREACH(item const& i, m_bias)
+      {
+        uint32_t bits;
+        memcpy(&bits, &i.second, sizeof(bits));
+        boost::hash_combine(seed, i.first);
+        boost::hash_combine(seed, bits);
+      }
+    return uint64_t(seed) | 1; // never 0
+  }
+
 
 
   SentenceBias::
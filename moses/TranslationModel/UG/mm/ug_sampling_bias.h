@@ -37,6 +37,12 @@ namespace sapt
     virtual int
     GetClass(id_type const ID) const;
     // returns class/document/domain id of item ID
+
+    virtual uint64_t
+    GetId() const;
+    // returns a non-zero id that is the same for equal biases in any
+    // process (used as part of the key in the persistent statistics
+    // cache), or 0 if the bias has no such id
   };
 
   class
@@ -73,6 +79,9 @@ namespace sapt
 
     size_t
     size() const;
+
+    uint64_t
+    GetId() const;
   };
 
   class
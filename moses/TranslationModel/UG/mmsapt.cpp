@@ -243,6 +243,11 @@ namespace Moses
     if ((m = param.find("extra")) != param.end())
       m_extra_data = m->second;
 
+    // statistics sampled from the static bitext are stored in this file
+    // and shared with other processes using the same file
+    if ((m = param.find("pstats-cache")) != param.end())
+      m_pstats_cache_file = m->second;
+
     if ((m = param.find("method")) != param.end())
       {
         if (m->second == "random")
@@ -295,6 +300,7 @@ namespace Moses
     known_parameters.push_back("pbwd");
     known_parameters.push_back("pfwd");
     known_parameters.push_back("prov");
+    known_parameters.push_back("pstats-cache");
     known_parameters.push_back("rare");
     known_parameters.push_back("sample");
     known_parameters.push_back("smooth");
@@ -341,11 +347,19 @@ namespace Moses
     while(getline(in2,line)) text2.push_back(line);
     while(getline(ina,line)) symal.push_back(line);
 
-    scoped_ptr<boost::unique_lock<shared_mutex> > guard;
-    if (locking) guard.reset(new boost::unique_lock<shared_mutex>(m_lock));
-    btdyn = btdyn->add(text1,text2,symal);
-    assert(btdyn);
-    cerr << "Loaded " << btdyn->T1->size() << " sentence pairs" << endl;
+    if (!locking) 
+      {
+        btdyn = btdyn->add(text1,text2,symal);
+        assert(btdyn);
+        cerr << "Loaded " << btdyn->T1->size() << " sentence pairs" << endl;
+        return;
+      }
+    boost::lock_guard<boost::mutex> update(m_update_lock);
+    SPTR<imbitext> dyn = dynamic_snapshot()->add(text1,text2,symal);
+    assert(dyn);
+    cerr << "Loaded " << dyn->T1->size() << " sentence pairs" << endl;
+    boost::unique_lock<boost::shared_mutex> guard(m_lock);
+    btdyn = dyn;
   }
 
   template<typename fftype>
@@ -487,6 +501,20 @@ namespace Moses
     btfix->open(m_bname, L1, L2);
     btfix->setDefaultSampleSize(m_default_sample_size);
 
+    if (m_pstats_cache_file.size())
+      {
+        vector<string> files;
+        files.push_back(m_bname + L1 + ".mct");
+        files.push_back(m_bname + L2 + ".mct");
+        files.push_back(m_bname + L1 + "-" + L2 + ".mam");
+        files.push_back(m_bname + L1 + ".sfa");
+        files.push_back(m_bname + L1 + ".tdx");
+        files.push_back(m_bname + L2 + ".tdx");
+        files.push_back(m_bname + "dmp");
+        m_pstats_store.reset(new sapt::pstats_store
+                             (m_pstats_cache_file, sapt::pstats_store::fingerprint(files)));
+      }
+
     btdyn.reset(new imbitext(btfix->V1, btfix->V2, m_default_sample_size, m_workers));
     if (m_bias_file.size())
       load_bias(m_bias_file);
@@ -515,8 +543,36 @@ namespace Moses
     vector<string> S1(1,s1);
     vector<string> S2(1,s2);
     vector<string> ALN(1,a);
+    // lookups keep using the current snapshot while the new one is built
+    boost::lock_guard<boost::mutex> update(m_update_lock);
+    SPTR<imbitext> dyn = dynamic_snapshot()->add(S1,S2,ALN);
     boost::unique_lock<boost::shared_mutex> guard(m_lock);
-    btdyn = btdyn->add(S1,S2,ALN);
+    btdyn = dyn;
+  }
+
+  SPTR<Mmsapt::imbitext>
+  Mmsapt::
+  dynamic_snapshot() const
+  {
+    boost::shared_lock<boost::shared_mutex> guard(m_lock);
+    assert(btdyn);
+    return btdyn;
+  }
+
+  // Key of the statistics of btfix phrase pid in the persistent cache.
+  // Only statistics of btfix are kept there: the dynamic bitext changes
+  // with every update, and its statistics are merged with those of btfix
+  // only after the lookup. Biases without a stable id can't be cached.
+  bool
+  Mmsapt::
+  pstats_key(SPTR<ContextForQuery> const& context, uint64_t const pid,
+             sapt::pstats_store::key& k) const
+  {
+    if (!m_pstats_store) return false;
+    uint64_t bias = context->bias ? context->bias->GetId() : 0;
+    if (context->bias && !bias) return false;
+    k = sapt::pstats_store::key(pid, bias, m_default_sample_size, m_sampling_method);
+    return true;
   }
 
 
@@ -644,12 +700,7 @@ namespace Moses
     // Reserve a local copy of the dynamic bitext in its current form. /btdyn/
     // is set to a new copy of the dynamic bitext every time a sentence pair
     // is added. /dyn/ keeps the old bitext around as long as we need it.
-    SPTR<imBitext<Token> > dyn;
-    { // braces are needed for scoping mutex lock guard!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
-      assert(btdyn);
-      dyn = btdyn;
-    }
+    SPTR<imBitext<Token> > dyn = dynamic_snapshot();
     assert(dyn);
 
     // lookup phrases in both bitexts
@@ -693,14 +744,18 @@ namespace Moses
       {
         SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
         SPTR<pstats> const* foo = context->cache1->get(mfix.getPid());
+        sapt::pstats_store::key k;
+        bool persistent = pstats_key(context, mfix.getPid(), k);
         if (foo) { sfix = *foo; sfix->wait(); }
-        else 
+        else if (persistent) sfix = m_pstats_store->get(k);
+        if (!sfix)
           {
             BitextSampler<Token> s(btfix.get(), mfix, context->bias, 
                                    m_default_sample_size, m_sampling_method);
             s();
             sfix = s.stats();
           }
+        if (persistent) m_pstats_store->put(k, *sfix);
       }
     if (mdyn.size() == sphrase.size()) sdyn = dyn->lookup(ttask, mdyn);
 
@@ -891,21 +946,24 @@ namespace Moses
         uint64_t pid = mfix.getPid();
         if (!context->cache1->get(pid))
           {
-            BitextSampler<Token> s(btfix.get(), mfix, context->bias, 
-                                   m_default_sample_size, m_sampling_method);
-            if (*context->cache1->get(pid, s.stats()) == s.stats())
-              m_thread_pool->add(s);
+            sapt::pstats_store::key k;
+            SPTR<pstats> stored;
+            if (pstats_key(context, pid, k) && (stored = m_pstats_store->get(k)))
+              context->cache1->get(pid, stored);
+            else
+              {
+                BitextSampler<Token> s(btfix.get(), mfix, context->bias, 
+                                       m_default_sample_size, m_sampling_method);
+                if (*context->cache1->get(pid, s.stats()) == s.stats())
+                  m_thread_pool->add(s);
+              }
           }
         // btfix->prep(ttask, mfix);
         // cerr << phrase << " " << mfix.approxOccurrenceCount() << endl;
         return true;
       }
 
-    SPTR<imBitext<Token> > dyn;
-    { // braces are needed for scoping lock!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
-      dyn = btdyn;
-    }
+    SPTR<imBitext<Token> > dyn = dynamic_snapshot();
     assert(dyn);
     TSA<Token>::tree_iterator mdyn(dyn->I1.get());
     if (dyn->I1.get())
@@ -22,6 +22,7 @@
 #include "moses/TranslationModel/UG/mm/tpt_pickler.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext_sampler.h"
+#include "moses/TranslationModel/UG/mm/ug_bitext_pstats_store.h"
 #include "moses/TranslationModel/UG/mm/ug_lexical_phrase_scorer2.h"
 
 #include "moses/TranslationModel/UG/TargetPhraseCollectionCache.h"
@@ -93,6 +94,8 @@ namespace Moses
     boost::shared_ptr<sapt::SamplingBias> m_bias; // for global default bias
     boost::shared_ptr<TPCollCache> m_cache; // for global default bias
     size_t m_cache_size;  //
+    std::string m_pstats_cache_file; // persistent cache of btfix statistics
+    boost::scoped_ptr<sapt::pstats_store> m_pstats_store;
     // size_t input_factor;  //
     // size_t output_factor; // we can actually return entire Tokens!
 
@@ -140,6 +143,9 @@ namespace Moses
     // PScoreLogCounts<Token>   add_logcounts_dyn;
     void init(std::string const& line);
     mutable boost::shared_mutex m_lock;
+    // Updates build a new snapshot of the dynamic bitext without holding
+    // m_lock, then swap it in; m_update_lock keeps them from racing.
+    boost::mutex m_update_lock;
     // mutable boost::shared_mutex m_cache_lock;
     // for more complex operations on the cache
     bool withPbwd;
@@ -147,6 +153,9 @@ namespace Moses
     std::vector<FactorType> m_ifactor, m_ofactor;
 
     void setup_local_feature_functions();
+    SPTR<imbitext> dynamic_snapshot() const; // the current btdyn
+    bool pstats_key(SPTR<sapt::ContextForQuery> const& context, uint64_t const pid,
+                    sapt::pstats_store::key& k) const;
     void set_bias_via_server(ttasksptr const& ttask);
 
 #if PROVIDES_RANKED_SAMPLING
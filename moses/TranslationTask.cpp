@@ -107,6 +107,14 @@ TranslationTask
 TranslationTask::~TranslationTask()
 { }
 
+size_t
+TranslationTask
+::GetCost() const
+{
+  // decoding time grows with input length; start long sentences first
+  return m_source ? m_source->GetSize() : 0;
+}
+
 
 boost::shared_ptr<BaseManager>
 TranslationTask
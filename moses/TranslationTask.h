@@ -104,6 +104,9 @@ public:
    * gets called by main function implemented at end of this source file */
   virtual void Run();
 
+  /** estimated cost used by the ThreadPool to schedule long inputs first */
+  virtual size_t GetCost() const;
+
   boost::shared_ptr<Moses::InputType>
   GetSource() const {
     return m_source;
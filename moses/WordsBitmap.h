@@ -31,6 +31,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <cstdlib>
 #include "TypeDef.h"
 #include "WordsRange.h"
+#include "util/murmur_hash.hh"
 
 namespace Moses
 {
@@ -203,6 +204,11 @@ public:
     return Compare(compare) < 0;
   }
 
+  //! hash consistent with Compare()
+  size_t hash() const {
+    return util::MurmurHashNative(&m_bitmap[0], m_bitmap.size());
+  }
+
   inline size_t GetEdgeToTheLeftOf(size_t l) const {
     if (l == 0) return l;
     while (l && !m_bitmap[l-1]) {
@@ -6,6 +6,7 @@ namespace Moses
   SearchOptions::
   SearchOptions(Parameter const& param)
     : stack_diversity(0)
+    , expansion_threads(1)
   {
     init(param);
   }
@@ -17,6 +18,7 @@ namespace Moses
     param.SetParameter(algo, "search-algorithm", Normal);
     param.SetParameter(stack_size, "stack", DEFAULT_MAX_HYPOSTACK_SIZE);
     param.SetParameter(stack_diversity, "stack-diversity", size_t(0));
+    param.SetParameter(expansion_threads, "stack-expansion-threads", size_t(1));
     param.SetParameter(beam_width, "beam-threshold", DEFAULT_BEAM_WIDTH);
     param.SetParameter(early_discarding_threshold, "early-discarding-threshold", 
                        DEFAULT_EARLY_DISCARDING_THRESHOLD);
@@ -16,6 +16,7 @@ namespace Moses
     // stack decoding
     size_t stack_size;      // maxHypoStackSize;
     size_t stack_diversity; // minHypoStackDiversity;
+    size_t expansion_threads; // threads expanding one stack (normal search)
 
     size_t max_phrase_length;
     size_t max_trans_opt_per_cov; 
@@ -31,7 +31,7 @@ parse_timespec(std::string const& spec)
 	  t = 0;
 	}
     }
-  return timeout;
+  return timeout + t;
 }
 
 ServerOptions::
@@ -48,6 +48,20 @@ init(Parameter const& P)
   P.SetParameter(this->is_serial, "serial", false);
   P.SetParameter(this->logfile, "server-log", std::string("/dev/null"));
   P.SetParameter(this->num_threads, "threads", uint32_t(10));
+  P.SetParameter(this->max_conn, "server-max-connections", 
+                 size_t(4 * this->num_threads));
+  P.SetParameter(this->queue_size, "server-queue-size", 
+                 size_t(4 * this->num_threads));
+  std::string request_timeout, keepalive_timeout, io_timeout;
+  P.SetParameter(request_timeout, "server-request-timeout", std::string("0"));
+  P.SetParameter(keepalive_timeout, "server-keepalive-timeout", std::string("15s"));
+  P.SetParameter(io_timeout, "server-io-timeout", std::string("15s"));
+  this->request_timeout = parse_timespec(request_timeout);
+  this->keepalive_timeout = parse_timespec(keepalive_timeout);
+  this->io_timeout = parse_timespec(io_timeout);
+  P.SetParameter(this->batch_window, "server-batch-window", size_t(0));
+  P.SetParameter(this->batch_size, "server-batch-size", 
+                 size_t(4 * this->num_threads));
   P.SetParameter(this->session_cache_size, "session-cache_size", size_t(25));
   std::string timeout_spec;
   P.SetParameter(timeout_spec, "session-timeout",std::string("30m"));
@@ -12,6 +12,13 @@ namespace Moses
     bool is_serial;
     std::string logfile;
     uint32_t num_threads;
+    size_t max_conn;          // open connections, idle ones included
+    size_t queue_size;        // requests waiting for a decoder, 0: unbounded
+    size_t request_timeout;   // default deadline in seconds, 0: none
+    size_t keepalive_timeout; // seconds an idle connection is kept open
+    size_t io_timeout;        // seconds to wait for a client's request
+    size_t batch_window;      // milliseconds to collect a batch, 0: off
+    size_t batch_size;        // max. requests per batch
     size_t session_timeout;
     size_t session_cache_size;
     bool init(Parameter const& param);
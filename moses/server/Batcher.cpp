@@ -0,0 +1,129 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "Batcher.h"
+#include "TranslationRequest.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
+#include "moses/WordsRange.h"
+#include <boost/foreach.hpp>
+#include <iostream>
+#include <set>
+
+namespace MosesServer
+{
+  using namespace std;
+  using Moses::Phrase;
+  using Moses::PhraseDictionary;
+  using Moses::StaticData;
+
+  Batcher::
+  Batcher(Moses::ThreadPool& pool, size_t window, size_t max_size)
+    : m_pool(pool), m_window(window), m_max_size(max(max_size, size_t(1)))
+    , m_stopped(false)
+  {
+    m_thread = boost::thread(&Batcher::run, this);
+  }
+
+  Batcher::
+  ~Batcher()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      m_stopped = true;
+    }
+    m_ready.notify_one();
+    m_thread.join();
+  }
+
+  void
+  Batcher::
+  submit(boost::shared_ptr<TranslationRequest> const& task)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      m_pending.push_back(task);
+    }
+    m_ready.notify_one();
+  }
+
+  void
+  Batcher::
+  run()
+  {
+    vector<boost::shared_ptr<TranslationRequest> > batch;
+    while (true)
+      {
+        {
+          boost::unique_lock<boost::mutex> lock(m_lock);
+          while (m_pending.empty() && !m_stopped) m_ready.wait(lock);
+          if (m_stopped) break;
+
+          // the window opens with the first request of the batch
+          boost::system_time const deadline = boost::get_system_time()
+            + boost::posix_time::milliseconds(m_window);
+          while (m_pending.size() < m_max_size && !m_stopped 
+                 && m_ready.timed_wait(lock, deadline));
+
+          size_t n = min(m_pending.size(), m_max_size);
+          batch.assign(m_pending.begin(), m_pending.begin() + n);
+          m_pending.erase(m_pending.begin(), m_pending.begin() + n);
+        }
+        prefetch(batch);
+        BOOST_FOREACH(boost::shared_ptr<TranslationRequest> const& task, batch)
+          m_pool.Submit(task);
+        batch.clear();
+      }
+
+    // don't leave anyone waiting
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    BOOST_FOREACH(boost::shared_ptr<TranslationRequest> const& task, m_pending)
+      m_pool.Submit(task);
+    m_pending.clear();
+  }
+
+  void
+  Batcher::
+  prefetch(vector<boost::shared_ptr<TranslationRequest> > const& batch)
+  {
+    if (StaticData::Instance().IsSyntax()) return;
+
+    // the sentences as the requests will parse them
+    vector<boost::shared_ptr<Moses::InputType> > sources;
+    BOOST_FOREACH(boost::shared_ptr<TranslationRequest> const& task, batch)
+      {
+        try { sources.push_back(task->ParseSource()); }
+        catch (std::exception const&) { } // reported when the request runs
+      }
+    prefetch_ngrams(sources);
+    XVERBOSE(2, "Batch of " << batch.size() << " requests" << endl);
+  }
+
+  void
+  Batcher::
+  prefetch_ngrams(vector<boost::shared_ptr<Moses::InputType> > const& sources)
+  {
+    // every n-gram once, however many sentences share it
+    size_t const max_len = StaticData::Instance().GetMaxPhraseLength();
+    set<Phrase> ngrams;
+    BOOST_FOREACH(boost::shared_ptr<Moses::InputType> const& source, sources)
+      {
+        size_t const size = source->GetSize();
+        for (size_t start = 0; start < size; ++start)
+          for (size_t end = start; end < size && end - start < max_len; ++end)
+            ngrams.insert(source->GetSubString(Moses::WordsRange(start, end)));
+      }
+    vector<Phrase> phrases(ngrams.begin(), ngrams.end());
+
+    // prefetching only saves time, so a table failing at it must not take
+    // the batcher thread, and with it the server, down
+    BOOST_FOREACH(PhraseDictionary const* pt, PhraseDictionary::GetColl())
+      {
+        try { pt->Prefetch(phrases); }
+        catch (std::exception const& e)
+          {
+            cerr << "WARNING: prefetching for " 
+                 << pt->GetScoreProducerDescription() << " failed: " 
+                 << e.what() << endl;
+          }
+      }
+    XVERBOSE(2, "Prefetched " << phrases.size() << " n-grams" << endl);
+  }
+}
@@ -0,0 +1,45 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include "moses/ThreadPool.h"
+
+namespace Moses
+{
+  class InputType;
+}
+
+namespace MosesServer
+{
+  class TranslationRequest;
+
+  // Collects the requests that arrive within a short window, looks up
+  // the union of their source n-grams in the phrase tables once, and
+  // then hands them to the decoder threads, which find those n-grams in
+  // the shared phrase-table caches.
+  class Batcher
+  {
+    Moses::ThreadPool& m_pool;
+    size_t m_window;   // milliseconds to wait for more requests
+    size_t m_max_size; // requests per batch
+
+    boost::mutex m_lock;
+    boost::condition_variable m_ready;
+    std::vector<boost::shared_ptr<TranslationRequest> > m_pending;
+    bool m_stopped;
+    boost::thread m_thread;
+
+    void run();
+    void prefetch(std::vector<boost::shared_ptr<TranslationRequest> > const& batch);
+  public:
+    Batcher(Moses::ThreadPool& pool, size_t window, size_t max_size);
+    ~Batcher();
+
+    void submit(boost::shared_ptr<TranslationRequest> const& task);
+
+    // look up the n-grams of the sentences in every phrase table that
+    // supports prefetching; a table that fails is skipped with a warning
+    static void prefetch_ngrams(std::vector<boost::shared_ptr<Moses::InputType> > const& sources);
+  };
+}
@@ -0,0 +1,84 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#define BOOST_TEST_MODULE BatcherTest
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "Batcher.h"
+#include "moses/Sentence.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+  // a table with only the batch lookup, like most of the newer ones:
+  // its legacy lookup throws
+  class NoLegacyTable : public PhraseDictionary
+  {
+  public:
+    NoLegacyTable(string const& line) : PhraseDictionary(line, true)
+    {
+      ReadParameters();
+    }
+
+    void Load() { SetFeaturesToApply(); }
+
+    ChartRuleLookupManager*
+    CreateRuleLookupManager(ChartParser const&, ChartCellCollectionBase const&,
+                            size_t)
+    {
+      return NULL;
+    }
+  };
+
+  // a table that remembers what it was asked to cache, or fails at it
+  class PrefetchingTable : public NoLegacyTable
+  {
+    bool m_fail;
+  public:
+    mutable set<string> cached;
+
+    PrefetchingTable(string const& line, bool fail)
+      : NoLegacyTable(line), m_fail(fail) { }
+
+    bool SupportsPrefetch() const { return true; }
+
+  protected:
+    void CacheTargetPhrases(Phrase const& src) const
+    {
+      UTIL_THROW_IF2(m_fail, "No lookup in " << GetScoreProducerDescription());
+      cached.insert(src.GetStringRep(vector<FactorType>(1, 0)));
+    }
+  };
+
+  string const options = " num-features=1 input-factor=0 output-factor=0";
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_skips_tables_without_lookup)
+{
+  NoLegacyTable noLegacy("NoLegacyTable name=BatcherTestNoLegacy" + options);
+  PrefetchingTable failing("PrefetchingTable name=BatcherTestFailing" + options, true);
+  PrefetchingTable prefetching("PrefetchingTable name=BatcherTestPrefetching" + options, false);
+  noLegacy.InitializeCache();
+  failing.InitializeCache();
+  prefetching.InitializeCache();
+
+  vector<boost::shared_ptr<InputType> > sources;
+  sources.push_back(boost::shared_ptr<InputType>(new Sentence(0, "a b c")));
+  sources.push_back(boost::shared_ptr<InputType>(new Sentence(1, "b c d")));
+  MosesServer::Batcher::prefetch_ngrams(sources);
+
+  // every n-gram of both sentences, once
+  char const* expected[] = {
+    "a", "a b", "a b c", "b", "b c", "b c d", "c", "c d", "d"
+  };
+  BOOST_CHECK_EQUAL_COLLECTIONS(prefetching.cached.begin(), prefetching.cached.end(),
+                                expected, expected + 9);
+  BOOST_CHECK(failing.cached.empty());
+}
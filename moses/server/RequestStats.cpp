@@ -0,0 +1,120 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "RequestStats.h"
+#include <algorithm>
+
+namespace MosesServer
+{
+  using xmlrpc_c::value_int;
+  using xmlrpc_c::value_double;
+
+  namespace 
+  {
+    size_t const num_latencies = 1024;
+
+    // p-th percentile of sorted values, in milliseconds
+    double 
+    percentile(std::vector<double> const& sorted, double p)
+    {
+      if (sorted.empty()) return 0;
+      size_t i = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+      return sorted[i] * 1000;
+    }
+  }
+
+  RequestStats::
+  RequestStats(size_t queue_limit)
+    : m_queue_limit(queue_limit), m_queued(0), m_running(0)
+    , m_admitted(0), m_rejected(0), m_timed_out(0), m_dropped(0)
+    , m_completed(0), m_next_latency(0)
+  { }
+
+  bool
+  RequestStats::
+  admit()
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_lock);
+#endif
+    if (m_queue_limit && m_queued >= m_queue_limit)
+      {
+        ++m_rejected;
+        return false;
+      }
+    ++m_queued;
+    ++m_admitted;
+    return true;
+  }
+
+  void
+  RequestStats::
+  start()
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_lock);
+#endif
+    --m_queued;
+    ++m_running;
+  }
+
+  void
+  RequestStats::
+  drop()
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_lock);
+#endif
+    --m_queued;
+    ++m_dropped;
+  }
+
+  void
+  RequestStats::
+  finish(double latency)
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_lock);
+#endif
+    --m_running;
+    ++m_completed;
+    if (m_latencies.size() < num_latencies)
+      m_latencies.push_back(latency);
+    else
+      m_latencies[m_next_latency] = latency;
+    m_next_latency = (m_next_latency + 1) % num_latencies;
+  }
+
+  void
+  RequestStats::
+  time_out()
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_lock);
+#endif
+    ++m_timed_out;
+  }
+
+  void
+  RequestStats::
+  report(std::map<std::string, xmlrpc_c::value>& dest) const
+  {
+    std::vector<double> latencies;
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(m_lock);
+#endif
+      dest["queue-limit"] = value_int(m_queue_limit);
+      dest["queued"]      = value_int(m_queued);
+      dest["running"]     = value_int(m_running);
+      dest["admitted"]    = value_int(m_admitted);
+      dest["rejected"]    = value_int(m_rejected);
+      dest["timed-out"]   = value_int(m_timed_out);
+      dest["dropped"]     = value_int(m_dropped);
+      dest["completed"]   = value_int(m_completed);
+      latencies = m_latencies;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    dest["latency-p50"] = value_double(percentile(latencies, 0.50));
+    dest["latency-p90"] = value_double(percentile(latencies, 0.90));
+    dest["latency-p99"] = value_double(percentile(latencies, 0.99));
+  }
+}
@@ -0,0 +1,43 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <xmlrpc-c/base.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace MosesServer
+{
+  // Admission control and counters for translation requests. A request
+  // is admitted into a bounded queue, started by a decoder thread, and
+  // finished; requests whose client times out while they wait leave the
+  // queue at once.
+  class RequestStats
+  {
+#ifdef WITH_THREADS
+    mutable boost::mutex m_lock;
+#endif
+    size_t m_queue_limit; // 0 means unbounded
+    size_t m_queued, m_running;
+    size_t m_admitted, m_rejected, m_timed_out, m_dropped, m_completed;
+    std::vector<double> m_latencies; // most recent latencies in seconds
+    size_t m_next_latency;
+  public:
+    RequestStats(size_t queue_limit);
+
+    // false if the queue is full
+    bool admit();
+    // a decoder thread took a request from the queue
+    void start();
+    // a queued request was dropped because its client stopped waiting
+    void drop();
+    // a started request is done; latency includes the time it was queued
+    void finish(double latency);
+    // a client stopped waiting for its request
+    void time_out();
+
+    void report(std::map<std::string, xmlrpc_c::value>& dest) const;
+  };
+}
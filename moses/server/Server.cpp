@@ -7,15 +7,18 @@ namespace MosesServer
   Server(Moses::Parameter& params)
 #ifdef HAVE_XMLRPC_C
     : m_server_options(params),
+      m_request_stats(m_server_options.queue_size),
       m_updater(new Updater),
       m_optimizer(new Optimizer),
       m_translator(new Translator(*this)),
-      m_close_session(new CloseSession(*this))
+      m_close_session(new CloseSession(*this)),
+      m_stats(new Stats(*this))
   {
     m_registry.addMethod("translate", m_translator);
     m_registry.addMethod("updater",   m_updater);
     m_registry.addMethod("optimize",  m_optimizer);
     m_registry.addMethod("close_session", m_close_session);
+    m_registry.addMethod("stats", m_stats);
   }
 #else
   { }
@@ -32,7 +35,11 @@ namespace MosesServer
        .portNumber(m_server_options.port) // TCP port on which to listen
        .logFileName(m_server_options.logfile)
        .allowOrigin("*")
-       .maxConn(m_server_options.num_threads));
+       // connections only wait for the decoder threads, which are
+       // limited separately by the queue in the Translator
+       .maxConn(m_server_options.max_conn)
+       .keepaliveTimeout(m_server_options.keepalive_timeout)
+       .timeout(m_server_options.io_timeout));
     
     XVERBOSE(1,"Listening on port " << m_server_options.port << std::endl);
     if (m_server_options.is_serial) 
@@ -65,6 +72,15 @@ namespace MosesServer
     return m_session_cache[session_id];
   }
 
+#ifdef HAVE_XMLRPC_C
+  RequestStats&
+  Server::
+  request_stats()
+  {
+    return m_request_stats;
+  }
+#endif
+
   void
   Server::
   delete_session(uint64_t const session_id)
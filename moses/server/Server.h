@@ -13,6 +13,8 @@
 #include "Optimizer.h"
 #include "Updater.h"
 #include "CloseSession.h"
+#include "Stats.h"
+#include "RequestStats.h"
 #include "Session.h"
 #endif
 #include "moses/parameters/ServerOptions.h"
@@ -24,11 +26,13 @@ namespace MosesServer
     Moses::ServerOptions m_server_options;
     SessionCache   m_session_cache;
 #ifdef HAVE_XMLRPC_C
+    RequestStats m_request_stats;
     xmlrpc_c::registry m_registry;
     xmlrpc_c::methodPtr const m_updater;
     xmlrpc_c::methodPtr const m_optimizer;
     xmlrpc_c::methodPtr const m_translator;
     xmlrpc_c::methodPtr const m_close_session;
+    xmlrpc_c::methodPtr const m_stats;
 #endif    
   public:
     Server(Moses::Parameter& params);
@@ -42,5 +46,10 @@ namespace MosesServer
     Session const& 
     get_session(uint64_t session_id);
 
+#ifdef HAVE_XMLRPC_C
+    RequestStats& 
+    request_stats();
+#endif
+
   };
 }
@@ -0,0 +1,26 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "Stats.h"
+#include "Server.h"
+
+namespace MosesServer
+{
+  Stats::
+  Stats(Server& server)
+    : m_server(server)
+  {
+    this->_signature = "S:";
+    this->_help = "Reports queue depth, request counts and latency percentiles (ms)";
+  }
+
+  void
+  Stats::
+  execute(xmlrpc_c::paramList const& paramList,
+          xmlrpc_c::value *   const  retvalP)
+  {
+    std::map<std::string, xmlrpc_c::value> ret;
+    m_server.request_stats().report(ret);
+    ret["threads"] = xmlrpc_c::value_int(m_server.options().num_threads);
+    ret["max-connections"] = xmlrpc_c::value_int(m_server.options().max_conn);
+    *retvalP = xmlrpc_c::value_struct(ret);
+  }
+}
@@ -0,0 +1,20 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace MosesServer
+{
+  class Server;
+  class
+  Stats : public xmlrpc_c::method
+  {
+    Server& m_server;
+  public:
+    Stats(Server& server);
+
+    void execute(xmlrpc_c::paramList const& paramList,
+                 xmlrpc_c::value *   const  retvalP);
+  };
+}
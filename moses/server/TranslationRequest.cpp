@@ -18,18 +18,17 @@ using Moses::TranslationOptionList;
 using Moses::TranslationOption;
 using Moses::TargetPhrase;
 using Moses::FValue;
+using Moses::FValueArray;
 using Moses::PhraseDictionaryMultiModel;
 using Moses::FindPhraseDictionary;
 using Moses::Sentence;
 
 boost::shared_ptr<TranslationRequest>
 TranslationRequest::
-create(Translator* translator, xmlrpc_c::paramList const& paramList,
-       boost::condition_variable& cond,
-       boost::mutex& mut)
+create(Translator* translator, xmlrpc_c::paramList const& paramList)
 {
   boost::shared_ptr<TranslationRequest> ret;
-  ret.reset(new TranslationRequest(paramList, cond, mut));
+  ret.reset(new TranslationRequest(paramList));
   ret->m_self = ret;
   ret->m_translator = translator;
   return ret;
@@ -38,6 +37,48 @@ create(Translator* translator, xmlrpc_c::paramList const& paramList,
 void
 TranslationRequest::
 Run()
+{
+  RequestStats& stats = m_translator->request_stats();
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    if (m_abandoned) {
+      // nobody is waiting for it any more, and its place in the queue
+      // was given up when its client timed out
+      m_done = true;
+      return;
+    }
+    m_started = true;
+  }
+  stats.start();
+
+  // the request is finished however decoding ends, so that neither the
+  // stats nor the client wait for it forever
+  struct Finisher {
+    TranslationRequest& request;
+    RequestStats& stats;
+    ~Finisher() {
+      stats.finish(request.m_timer.get_elapsed_time());
+      {
+        boost::lock_guard<boost::mutex> lock(request.m_mutex);
+        request.m_done = true;
+      }
+      request.m_cond.notify_one();
+    }
+  } finisher = { *this, stats };
+
+  try {
+    translate();
+  } catch (std::exception const& e) {
+    // an exception escaping a worker thread would end the server
+    m_error = e.what();
+  } catch (xmlrpc_c::fault const& e) {
+    m_error = e.getDescription();
+  }
+}
+
+void
+TranslationRequest::
+translate()
 {
   std::map<std::string,xmlrpc_c::value>const& params = m_paramList.getStruct(0);
   parse_request(params);
@@ -66,12 +107,6 @@ Run()
     run_phrase_decoder();
 
   // XVERBOSE(1,"Output: " << out.str() << endl);
-  {
-    boost::lock_guard<boost::mutex> lock(m_mutex);
-    m_done = true;
-  }
-  m_cond.notify_one();
-
 }
 
 /// add phrase alignment information from a Hypothesis
@@ -209,7 +244,7 @@ insertTranslationOptions(Moses::Manager& manager,
         toptXml["start"]  = xmlrpc_c::value_int(s);
         toptXml["end"]    = xmlrpc_c::value_int(e);
         vector<xmlrpc_c::value> scoresXml;
-        const std::valarray<FValue> &scores
+        const FValueArray &scores
         = topt->GetScoreBreakdown().getCoreFeatures();
         for (size_t j = 0; j < scores.size(); ++j)
           scoresXml.push_back(xmlrpc_c::value_double(scores[j]));
@@ -230,13 +265,53 @@ check(std::map<std::string, xmlrpc_c::value> const& params, std::string const ke
 }
 
 TranslationRequest::
-TranslationRequest(xmlrpc_c::paramList const& paramList,
-                   boost::condition_variable& cond, boost::mutex& mut)
-  : m_cond(cond), m_mutex(mut), m_done(false), m_paramList(paramList)
+TranslationRequest(xmlrpc_c::paramList const& paramList)
+  : m_done(false), m_started(false), m_abandoned(false), m_paramList(paramList)
   , m_nbestSize(0)
   , m_session_id(0)
 { 
   m_options = StaticData::Instance().options();
+  m_timer.start();
+}
+
+bool
+TranslationRequest::
+Wait(double timeout)
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  if (timeout <= 0) {
+    while (!m_done) m_cond.wait(lock);
+    return true;
+  }
+  boost::system_time const deadline = boost::get_system_time()
+    + boost::posix_time::milliseconds(long(timeout * 1000));
+  while (!m_done && m_cond.timed_wait(lock, deadline));
+  if (m_done) return true;
+
+  // a request that is still queued gives its place up now, not when
+  // a decoder thread gets to it
+  m_abandoned = true;
+  if (!m_started) m_translator->request_stats().drop();
+  return false;
+}
+
+boost::shared_ptr<Moses::InputType>
+TranslationRequest::
+ParseSource()
+{
+  if (!m_source) m_source.reset(new Sentence(0,GetSourceText()));
+  return m_source;
+}
+
+std::string
+TranslationRequest::
+GetSourceText() const
+{
+  typedef std::map<std::string, xmlrpc_c::value> params_t;
+  params_t const params = m_paramList.getStruct(0);
+  params_t::const_iterator si = params.find("text");
+  if (si == params.end()) return std::string();
+  return xmlrpc_c::value_string(si->second);
 }
 
 void
@@ -270,7 +345,8 @@ parse_request(std::map<std::string, xmlrpc_c::value> const& params)
   m_reportAllFactors    = check(params, "report-all-factors");
   m_nbestDistinct       = check(params, "nbest-distinct");
   m_withScoreBreakdown  = check(params, "add-score-breakdown");
-  m_source.reset(new Sentence(0,m_source_string));
+  // the batcher may have parsed it already
+  if (!m_source) m_source.reset(new Sentence(0,m_source_string));
   si = params.find("lambda");
   if (si != params.end()) 
     {
@@ -18,6 +18,7 @@
 #include "moses/TranslationModel/PhraseDictionaryMultiModel.h"
 #include "moses/TreeInput.h"
 #include "moses/TranslationTask.h"
+#include "moses/Timer.h"
 #include <boost/shared_ptr.hpp>
 #include <xmlrpc-c/base.hpp>
 
@@ -28,11 +29,16 @@ namespace MosesServer
 class
 TranslationRequest : public virtual Moses::TranslationTask
 {
-  boost::condition_variable& m_cond;
-  boost::mutex& m_mutex;
+  boost::condition_variable m_cond;
+  boost::mutex m_mutex;
   bool m_done;
+  bool m_started; // a decoder thread took it from the queue
+  bool m_abandoned; // the client stopped waiting
+  std::string m_error; // why decoding failed, empty on success
+  Moses::Timer m_timer;
 
-  xmlrpc_c::paramList const& m_paramList;
+  // a copy, the request may outlive the call that submitted it
+  xmlrpc_c::paramList const m_paramList;
   std::map<std::string, xmlrpc_c::value> m_retData;
   std::map<uint32_t,float> m_bias; // for biased sampling
 
@@ -52,6 +58,10 @@ TranslationRequest : public virtual Moses::TranslationTask
   void
   parse_request();
 
+  // parse the request and decode it, called by Run()
+  void
+  translate();
+
   void
   parse_request(std::map<std::string, xmlrpc_c::value> const& req);
 
@@ -96,18 +106,14 @@ TranslationRequest : public virtual Moses::TranslationTask
   insertTranslationOptions(Moses::Manager& manager,
                            std::map<std::string, xmlrpc_c::value>& retData);
 protected:
-  TranslationRequest(xmlrpc_c::paramList const& paramList,
-                     boost::condition_variable& cond,
-                     boost::mutex& mut);
+  TranslationRequest(xmlrpc_c::paramList const& paramList);
 
 public:
 
   static
   boost::shared_ptr<TranslationRequest>
   create(Translator* translator,
-	 xmlrpc_c::paramList const& paramList,
-         boost::condition_variable& cond,
-         boost::mutex& mut);
+	 xmlrpc_c::paramList const& paramList);
 
 
   virtual bool
@@ -120,6 +126,27 @@ public:
     return m_done;
   }
 
+  // wait at most timeout seconds (0: no limit) for the translation;
+  // returns false and abandons the request if it isn't done by then,
+  // giving up its place in the queue if it hasn't started
+  bool
+  Wait(double timeout);
+
+  // the "text" of the request, read before it is parsed
+  std::string
+  GetSourceText() const;
+
+  // the source sentence, parsed as the request will be when it runs;
+  // call before the request is submitted to the thread pool
+  boost::shared_ptr<Moses::InputType>
+  ParseSource();
+
+  // empty unless decoding failed
+  std::string const&
+  GetError() const {
+    return m_error;
+  }
+
   std::map<std::string, xmlrpc_c::value> const&
   GetRetData() {
     return m_retData;
@@ -20,6 +20,11 @@ Translator(Server& server)
   // system.methodHelp RPC.
   this->_signature = "S:S";
   this->_help = "Does translation";
+  
+  Moses::ServerOptions const& opts = server.options();
+  if (opts.batch_window)
+    m_batcher.reset(new Batcher(m_threadPool, opts.batch_window, 
+                                opts.batch_size));
 }
 
 void
@@ -27,17 +32,47 @@ Translator::
 execute(xmlrpc_c::paramList const& paramList,
         xmlrpc_c::value *   const  retvalP)
 {
-  boost::condition_variable cond;
-  boost::mutex mut;
+  // the deadline is checked before admission, so that malformed
+  // requests don't take a place in the queue
+  double timeout = m_server.options().request_timeout;
+  typedef std::map<std::string, xmlrpc_c::value> params_t;
+  params_t const& params = paramList.getStruct(0);
+  params_t::const_iterator si = params.find("timeout");
+  if (si != params.end()) {
+    if (si->second.type() == xmlrpc_c::value::TYPE_INT)
+      timeout = xmlrpc_c::value_int(si->second);
+    else
+      timeout = xmlrpc_c::value_double(si->second);
+  }
+
+  RequestStats& stats = m_server.request_stats();
+  if (!stats.admit())
+    throw xmlrpc_c::fault("Too many requests, try again later",
+                          xmlrpc_c::fault::code_t(429));
+
   boost::shared_ptr<TranslationRequest> task;
-  task = TranslationRequest::create(this, paramList,cond,mut);
-  m_threadPool.Submit(task);
-  boost::unique_lock<boost::mutex> lock(mut);
-  while (!task->IsDone())
-    cond.wait(lock);
+  task = TranslationRequest::create(this, paramList);
+  if (m_batcher) m_batcher->submit(task);
+  else m_threadPool.Submit(task);
+  if (!task->Wait(timeout)) {
+    // the request is dropped if it is still queued, otherwise its
+    // result is discarded
+    stats.time_out();
+    throw xmlrpc_c::fault("Translation request timed out",
+                          xmlrpc_c::fault::code_t(408));
+  }
+  if (!task->GetError().empty())
+    throw xmlrpc_c::fault(task->GetError(), xmlrpc_c::fault::CODE_INTERNAL);
   *retvalP = xmlrpc_c::value_struct(task->GetRetData());
 }
 
+RequestStats&
+Translator::
+request_stats()
+{
+  return m_server.request_stats();
+}
+
 Session const& 
 Translator::
 get_session(uint64_t const id)
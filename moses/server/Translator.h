@@ -3,6 +3,9 @@
 
 #include "moses/parameters/ServerOptions.h"
 #include "Session.h"
+#include "RequestStats.h"
+#include "Batcher.h"
+#include <boost/scoped_ptr.hpp>
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
@@ -28,8 +31,10 @@ namespace MosesServer
 		 xmlrpc_c::value *   const  retvalP);
     
     Session const& get_session(uint64_t session_id);
+    RequestStats& request_stats();
   private:
     Moses::ThreadPool m_threadPool;
+    boost::scoped_ptr<Batcher> m_batcher; // NULL unless batching
   };
 
 }
@@ -0,0 +1,358 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2015 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExtractFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "util/exception.hh"
+#include "moses/Util.h"
+#include "InputFileStream.h"
+
+namespace MosesTraining
+{
+
+namespace
+{
+
+const char kMagic[8] = { 'M','O','S','E','S','X','T','1' };
+
+enum EntryType { WORD_ENTRY = 0, PHRASE_PAIR_ENTRY = 1 };
+
+enum RecordFlags { HAS_SENTENCE_ID = 1, HAS_PCFG_SCORE = 2, HAS_PROPERTIES = 4 };
+
+// anything longer is taken for a corrupt file
+const uint64_t kMaxEntryLength = 1ULL << 30;
+
+void writeFloat(std::string &out, float value)
+{
+  out.append(reinterpret_cast<const char*>(&value), sizeof(float));
+}
+
+bool readFloat(const char *&data, const char *end, float &value)
+{
+  if (end - data < (ptrdiff_t)sizeof(float)) {
+    return false;
+  }
+  memcpy(&value, data, sizeof(float));
+  data += sizeof(float);
+  return true;
+}
+
+bool readIds(const char *&data, const char *end, std::vector<uint32_t> &ids)
+{
+  uint64_t n, id;
+  if (!ReadVarint(data, end, n) || n > (uint64_t)(end - data)) {
+    return false;
+  }
+  ids.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!ReadVarint(data, end, id)) {
+      return false;
+    }
+    ids[i] = id;
+  }
+  return true;
+}
+
+bool knownIds(const std::vector<uint32_t> &ids, size_t numberOfWords)
+{
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (ids[i] >= numberOfWords) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void writeIds(std::string &out, const std::vector<uint32_t> &ids)
+{
+  WriteVarint(out, ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    WriteVarint(out, ids[i]);
+  }
+}
+
+} // namespace
+
+bool WordOrder::operator()(const std::string &a, const std::string &b) const
+{
+  size_t n = std::min(a.size(), b.size());
+  int c = memcmp(a.data(), b.data(), n);
+  if (c) {
+    return c < 0;
+  }
+  unsigned char nextA = (a.size() > n) ? a[n] : ' ';
+  unsigned char nextB = (b.size() > n) ? b[n] : ' ';
+  return nextA < nextB;
+}
+
+void WriteVarint(std::string &out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back((char)((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+bool ReadVarint(const char *&data, const char *end, uint64_t &value)
+{
+  value = 0;
+  for (unsigned shift = 0; data != end && shift < 64; shift += 7) {
+    unsigned char c = *data++;
+    value |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void ExtractRecord::Clear()
+{
+  source.clear();
+  target.clear();
+  alignment.clear();
+  count = 1.0f;
+  hasSentenceId = false;
+  sentenceId = 0;
+  hasPcfgScore = false;
+  pcfgScore = 0.0f;
+  properties.clear();
+}
+
+void ExtractRecord::Encode(std::string &payload) const
+{
+  payload.clear();
+  writeIds(payload, source);
+  writeIds(payload, target);
+  WriteVarint(payload, alignment.size());
+  for (size_t i = 0; i < alignment.size(); ++i) {
+    WriteVarint(payload, alignment[i].first);
+    WriteVarint(payload, alignment[i].second);
+  }
+  writeFloat(payload, count);
+  payload.push_back((char)((hasSentenceId ? HAS_SENTENCE_ID : 0)
+                           | (hasPcfgScore ? HAS_PCFG_SCORE : 0)
+                           | (properties.empty() ? 0 : HAS_PROPERTIES)));
+  if (hasSentenceId) {
+    WriteVarint(payload, (uint32_t)sentenceId);
+  }
+  if (hasPcfgScore) {
+    writeFloat(payload, pcfgScore);
+  }
+  if (!properties.empty()) {
+    WriteVarint(payload, properties.size());
+    payload += properties;
+  }
+}
+
+bool ExtractRecord::Decode(const char *data, size_t size)
+{
+  const char *end = data + size;
+  uint64_t n, s, t;
+  Clear();
+  if (!readIds(data, end, source) || !readIds(data, end, target)) {
+    return false;
+  }
+  if (!ReadVarint(data, end, n) || n > (uint64_t)(end - data)) {
+    return false;
+  }
+  alignment.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!ReadVarint(data, end, s) || !ReadVarint(data, end, t)) {
+      return false;
+    }
+    alignment[i] = std::make_pair((uint32_t)s, (uint32_t)t);
+  }
+  if (!readFloat(data, end, count) || data == end) {
+    return false;
+  }
+  const unsigned char flags = *data++;
+  if (flags & HAS_SENTENCE_ID) {
+    if (!ReadVarint(data, end, n)) {
+      return false;
+    }
+    hasSentenceId = true;
+    sentenceId = (int)(uint32_t)n;
+  }
+  if (flags & HAS_PCFG_SCORE) {
+    if (!readFloat(data, end, pcfgScore)) {
+      return false;
+    }
+    hasPcfgScore = true;
+  }
+  if (flags & HAS_PROPERTIES) {
+    if (!ReadVarint(data, end, n) || n > (uint64_t)(end - data)) {
+      return false;
+    }
+    properties.assign(data, n);
+    data += n;
+  }
+  return data == end;
+}
+
+
+// The same fields as score's processLine()
+bool ParseExtractLine(const std::string &line, bool includeSentenceId,
+                      std::vector<std::string> &source, std::vector<std::string> &target,
+                      ExtractRecord &record)
+{
+  record.Clear();
+  source.clear();
+  target.clear();
+  size_t foundAdditionalProperties = line.rfind("|||");
+  foundAdditionalProperties = line.find("{{", foundAdditionalProperties);
+  if (foundAdditionalProperties != std::string::npos) {
+    record.properties = line.substr(foundAdditionalProperties);
+  }
+
+  std::vector<std::string> tokens;
+  Moses::Tokenize(tokens, line.substr(0, foundAdditionalProperties));
+  const int shift = includeSentenceId ? 1 : 0;
+  int item = 1;
+  for (size_t j = 0; j < tokens.size(); ++j) {
+    const std::string &token = tokens[j];
+    if (token == "|||") {
+      ++item;
+    } else if (item == 1) { // source phrase
+      source.push_back(token);
+    } else if (item == 2) { // target phrase
+      target.push_back(token);
+    } else if (item == 3) { // alignment
+      int s = 0, t = 0;
+      sscanf(token.c_str(), "%d-%d", &s, &t);
+      record.alignment.push_back(std::make_pair((uint32_t)s, (uint32_t)t));
+    } else if (includeSentenceId && item == 4) { // optional sentence id
+      sscanf(token.c_str(), "%d", &record.sentenceId);
+      record.hasSentenceId = true;
+    } else if (item - shift == 4) { // count
+      sscanf(token.c_str(), "%f", &record.count);
+    } else if (item - shift == 5) { // target syntax PCFG score
+      record.pcfgScore = std::atof(token.c_str());
+      record.hasPcfgScore = true;
+    }
+  }
+  return item >= 3 && item <= 6 + shift;
+}
+
+
+ExtractFileWriter::ExtractFileWriter(std::ostream &out)
+  : m_out(out)
+{
+  m_out.write(kMagic, sizeof(kMagic));
+}
+
+uint32_t ExtractFileWriter::WordId(const std::string &word)
+{
+  boost::unordered_map<std::string, uint32_t>::const_iterator found = m_ids.find(word);
+  if (found != m_ids.end()) {
+    return found->second;
+  }
+  uint32_t id = m_ids.size();
+  m_ids[word] = id;
+  m_buffer.clear();
+  WriteVarint(m_buffer, WORD_ENTRY);
+  WriteVarint(m_buffer, word.size());
+  m_buffer += word;
+  m_out.write(m_buffer.data(), m_buffer.size());
+  return id;
+}
+
+void ExtractFileWriter::Write(const ExtractRecord &record)
+{
+  record.Encode(m_payload);
+  m_buffer.clear();
+  WriteVarint(m_buffer, PHRASE_PAIR_ENTRY);
+  WriteVarint(m_buffer, m_payload.size());
+  m_buffer += m_payload;
+  m_out.write(m_buffer.data(), m_buffer.size());
+}
+
+
+ExtractFileReader::ExtractFileReader(std::istream &in)
+  : m_in(in.rdbuf())
+{
+  char magic[sizeof(kMagic)];
+  UTIL_THROW_IF2(m_in->sgetn(magic, sizeof(magic)) != sizeof(magic)
+                 || memcmp(magic, kMagic, sizeof(magic)),
+                 "Not a binary extract file");
+}
+
+bool ExtractFileReader::IsExtractFile(const std::string &fileName)
+{
+  Moses::InputFileStream in(fileName);
+  char magic[sizeof(kMagic)];
+  in.read(magic, sizeof(magic));
+  return in.gcount() == sizeof(magic) && !memcmp(magic, kMagic, sizeof(magic));
+}
+
+bool ExtractFileReader::ReadVarint(uint64_t &value)
+{
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    int c = m_in->sbumpc();
+    if (c == std::char_traits<char>::eof()) {
+      UTIL_THROW_IF2(shift, "Truncated binary extract file");
+      return false;
+    }
+    value |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return true;
+    }
+  }
+  UTIL_THROW2("Corrupt binary extract file");
+}
+
+void ExtractFileReader::ReadBytes(std::string &bytes)
+{
+  uint64_t length;
+  UTIL_THROW_IF2(!ReadVarint(length), "Truncated binary extract file");
+  UTIL_THROW_IF2(length > kMaxEntryLength, "Corrupt binary extract file");
+  bytes.resize(length);
+  UTIL_THROW_IF2(length && m_in->sgetn(&bytes[0], length) != (std::streamsize)length,
+                 "Truncated binary extract file");
+}
+
+bool ExtractFileReader::Read()
+{
+  uint64_t type;
+  while (ReadVarint(type)) {
+    if (type == WORD_ENTRY) {
+      m_words.push_back(std::string());
+      ReadBytes(m_words.back());
+    } else {
+      UTIL_THROW_IF2(type != PHRASE_PAIR_ENTRY, "Corrupt binary extract file");
+      ReadBytes(m_payload);
+      UTIL_THROW_IF2(!m_record.Decode(m_payload.data(), m_payload.size())
+                     || !knownIds(m_record.source, m_words.size())
+                     || !knownIds(m_record.target, m_words.size()),
+                     "Corrupt binary extract file");
+      return true;
+    }
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,146 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2015 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+// Binary extract files, written by extract and extract-rules with
+// --BinaryOutput, sorted by sort-extract and read by score.
+//
+// A line of a text extract file
+//   source ||| target ||| alignment [||| sentence id] ||| count [||| PCFG score] [{{properties}}]
+// has to be tokenized again by score, and each word looked up in its
+// vocabulary. The binary file holds the same fields, with words replaced by
+// ids. The file starts with a magic string, followed by entries
+//   word definition: 0, length, characters
+//   phrase pair:     1, length, payload
+// where words are numbered in the order of their definitions, which come
+// before their first use. The payload of a phrase pair is
+//   number of source words, their ids,
+//   number of target words, their ids,
+//   number of alignment points, (source position, target position) pairs,
+//   count, flags, [sentence id], [PCFG score], [length, properties]
+// where the flags say which of the optional fields are there. Integers are
+// varints, floats are in machine byte order. Like text extract files, binary
+// ones are compressed if their name ends in ".gz".
+
+namespace MosesTraining
+{
+
+// LC_ALL=C order of words followed by a space, which is the order of phrases
+// in sorted extract files if they are compared word by word, with "|||"
+// after the last word
+struct WordOrder {
+  bool operator()(const std::string &a, const std::string &b) const;
+};
+
+// varints of the payload, for code that looks at records without decoding them
+void WriteVarint(std::string &out, uint64_t value);
+bool ReadVarint(const char *&data, const char *end, uint64_t &value);
+
+struct ExtractRecord {
+  std::vector<uint32_t> source;
+  std::vector<uint32_t> target;
+  std::vector<std::pair<uint32_t, uint32_t> > alignment; // (source, target)
+  float count;
+  bool hasSentenceId;
+  int sentenceId;
+  bool hasPcfgScore;
+  float pcfgScore;
+  std::string properties; // "{{...}}", empty if there are none
+
+  ExtractRecord() {
+    Clear();
+  }
+  void Clear();
+
+  void Encode(std::string &payload) const;
+  // false if the payload is malformed
+  bool Decode(const char *data, size_t size);
+};
+
+// Splits a line of a text extract file into its fields, as score reads them:
+// the words of the phrases go to source and target, the other fields to
+// record, whose word ids are left empty. The sentence id is there if
+// includeSentenceId. False if the line has too few or too many fields.
+bool ParseExtractLine(const std::string &line, bool includeSentenceId,
+                      std::vector<std::string> &source, std::vector<std::string> &target,
+                      ExtractRecord &record);
+
+class ExtractFileWriter
+{
+public:
+  explicit ExtractFileWriter(std::ostream &out);
+
+  // Id of a word in the file, which is defined on first use.
+  uint32_t WordId(const std::string &word);
+
+  // Writes a record whose word ids come from WordId().
+  void Write(const ExtractRecord &record);
+
+private:
+  std::ostream &m_out;
+  boost::unordered_map<std::string, uint32_t> m_ids;
+  std::string m_payload;
+  std::string m_buffer;
+};
+
+class ExtractFileReader
+{
+public:
+  // Reads the magic string, throws if it isn't there.
+  explicit ExtractFileReader(std::istream &in);
+
+  // Whether the file is a binary extract file, rather than a text one.
+  static bool IsExtractFile(const std::string &fileName);
+
+  // Reads the next phrase pair, false at the end of the file.
+  bool Read();
+
+  const ExtractRecord &Record() const {
+    return m_record;
+  }
+  // encoded phrase pair, the same for phrase pairs that are the same
+  const std::string &Payload() const {
+    return m_payload;
+  }
+  // words defined so far, indexed by id
+  const std::vector<std::string> &Words() const {
+    return m_words;
+  }
+
+private:
+  std::streambuf *m_in;
+  ExtractRecord m_record;
+  std::string m_payload;
+  std::vector<std::string> m_words;
+
+  bool ReadVarint(uint64_t &value);
+  void ReadBytes(std::string &bytes);
+};
+
+}
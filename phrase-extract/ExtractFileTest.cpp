@@ -0,0 +1,320 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2015 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExtractFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#define  BOOST_TEST_MODULE MosesTrainingExtractFile
+#include <boost/test/unit_test.hpp>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+
+// lines as extract and extract-rules write them
+const char *kLines[] = {
+  "das haus ||| the house ||| 0-0 1-1 ||| 1",
+  "das ||| the ||| 0-0",
+  "das [X][X] [X] ||| the [X][X] [X] ||| 0-0 1-1 ||| 0.333333 ||| ",
+  "das [X][X] [S] ||| the [X][X] [NP] ||| 1-1 ||| 2 ||| 0.25",
+  "haus ||| house ||| 0-0 ||| 1 {{Tree [NP [NN house]]}}",
+  "x|||y ||| \xc3\xa9t\xc3\xa9 ||| ||| 1e-07",
+};
+
+const char *kLinesWithSentenceId[] = {
+  "das haus ||| the house ||| 0-0 1-1 ||| 17 ||| 1",
+  "das ||| the ||| 0-0 ||| 3 ||| 0.5",
+};
+
+void checkSame(const ExtractRecord &a, const ExtractRecord &b)
+{
+  BOOST_CHECK(a.source == b.source);
+  BOOST_CHECK(a.target == b.target);
+  BOOST_CHECK(a.alignment == b.alignment);
+  BOOST_CHECK_EQUAL(a.count, b.count);
+  BOOST_CHECK_EQUAL(a.hasSentenceId, b.hasSentenceId);
+  BOOST_CHECK_EQUAL(a.sentenceId, b.sentenceId);
+  BOOST_CHECK_EQUAL(a.hasPcfgScore, b.hasPcfgScore);
+  BOOST_CHECK_EQUAL(a.pcfgScore, b.pcfgScore);
+  BOOST_CHECK_EQUAL(a.properties, b.properties);
+}
+
+vector<string> wordsOf(const vector<uint32_t> &ids, const vector<string> &words)
+{
+  vector<string> result;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    result.push_back(words[ids[i]]);
+  }
+  return result;
+}
+
+// Writes a text line as a record, with the word ids and fields that extract
+// gives the record of the phrase pair it would have written as that line.
+void writeLine(ExtractFileWriter &writer, const string &line, bool includeSentenceId)
+{
+  vector<string> source, target;
+  ExtractRecord record;
+  BOOST_REQUIRE(ParseExtractLine(line, includeSentenceId, source, target, record));
+  for (size_t i = 0; i < source.size(); ++i) {
+    record.source.push_back(writer.WordId(source[i]));
+  }
+  for (size_t i = 0; i < target.size(); ++i) {
+    record.target.push_back(writer.WordId(target[i]));
+  }
+  writer.Write(record);
+}
+
+// Writes the lines to a binary extract file and reads them back, which has
+// to give the fields that score's processLine() reads from them.
+void checkRoundTrip(const char **lines, size_t size, bool includeSentenceId)
+{
+  ostringstream out;
+  {
+    ExtractFileWriter writer(out);
+    for (size_t i = 0; i < size; ++i) {
+      writeLine(writer, lines[i], includeSentenceId);
+    }
+  }
+
+  istringstream in(out.str());
+  ExtractFileReader reader(in);
+  for (size_t i = 0; i < size; ++i) {
+    BOOST_REQUIRE(reader.Read());
+    vector<string> source, target;
+    ExtractRecord expected;
+    BOOST_REQUIRE(ParseExtractLine(lines[i], includeSentenceId, source, target, expected));
+
+    const ExtractRecord &record = reader.Record();
+    BOOST_CHECK(wordsOf(record.source, reader.Words()) == source);
+    BOOST_CHECK(wordsOf(record.target, reader.Words()) == target);
+    expected.source = record.source;
+    expected.target = record.target;
+    checkSame(expected, record);
+  }
+  BOOST_CHECK(!reader.Read());
+}
+
+// phrases in the order of sort-extract: word by word, with "|||" after the last word
+bool phraseLess(const vector<string> &a, const vector<string> &b)
+{
+  const string end = "|||";
+  for (size_t i = 0; i <= a.size() && i <= b.size(); ++i) {
+    const string &wordA = i < a.size() ? a[i] : end;
+    const string &wordB = i < b.size() ? b[i] : end;
+    if (WordOrder()(wordA, wordB)) {
+      return true;
+    }
+    if (WordOrder()(wordB, wordA)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+struct TempDir {
+  TempDir() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directory(path);
+  }
+  ~TempDir() {
+    boost::filesystem::remove_all(path);
+  }
+  boost::filesystem::path path;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(encode_decode)
+{
+  ExtractRecord record;
+  record.source.push_back(0);
+  record.source.push_back(300);
+  record.source.push_back(0xffffffff);
+  record.target.push_back(127);
+  record.target.push_back(128);
+  record.alignment.push_back(make_pair(0u, 1u));
+  record.alignment.push_back(make_pair(2u, 0u));
+  record.count = 0.125f;
+  record.hasSentenceId = true;
+  record.sentenceId = 123456;
+  record.hasPcfgScore = true;
+  record.pcfgScore = -2.5f;
+  record.properties = "{{Tree [X a]}}";
+
+  string payload;
+  record.Encode(payload);
+  ExtractRecord decoded;
+  BOOST_REQUIRE(decoded.Decode(payload.data(), payload.size()));
+  checkSame(record, decoded);
+
+  // the optional fields are left out
+  ExtractRecord plain;
+  plain.source.push_back(1);
+  plain.Encode(payload);
+  BOOST_REQUIRE(decoded.Decode(payload.data(), payload.size()));
+  checkSame(plain, decoded);
+
+  // anything cut short, or followed by more, is malformed
+  record.Encode(payload);
+  for (size_t size = 0; size < payload.size(); ++size) {
+    BOOST_CHECK(!decoded.Decode(payload.data(), size));
+  }
+  payload.push_back(0);
+  BOOST_CHECK(!decoded.Decode(payload.data(), payload.size()));
+}
+
+BOOST_AUTO_TEST_CASE(varints)
+{
+  const uint64_t values[] = { 0, 1, 127, 128, 16383, 16384, 0xffffffffULL, 0xffffffffffffffffULL };
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+    string out;
+    WriteVarint(out, values[i]);
+    const char *data = out.data();
+    uint64_t value;
+    BOOST_REQUIRE(ReadVarint(data, out.data() + out.size(), value));
+    BOOST_CHECK_EQUAL(value, values[i]);
+    BOOST_CHECK(data == out.data() + out.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(write_line_round_trip)
+{
+  checkRoundTrip(kLines, sizeof(kLines) / sizeof(kLines[0]), false);
+  checkRoundTrip(kLinesWithSentenceId, sizeof(kLinesWithSentenceId) / sizeof(kLinesWithSentenceId[0]), true);
+
+  vector<string> source, target;
+  ExtractRecord record;
+  BOOST_CHECK(!ParseExtractLine("das haus", false, source, target, record));
+  BOOST_CHECK(!ParseExtractLine("a ||| b ||| ||| 1 ||| 2 ||| 3 ||| 4", false, source, target, record));
+}
+
+// extract and extract-rules build records from word ids, which has to give
+// the same payload as the fields of the text line
+BOOST_AUTO_TEST_CASE(records_match_lines)
+{
+  ostringstream out;
+  ExtractFileWriter writer(out);
+  writeLine(writer, "das haus ||| the house ||| 0-0 1-1 ||| 7 ||| 0.5", true);
+  writeLine(writer, "das [X][X] [S] ||| the [X][X] [NP] ||| 1-1 ||| 2 ||| 0.25", false);
+
+  ExtractRecord record;
+  record.source.push_back(writer.WordId("das"));
+  record.source.push_back(writer.WordId("haus"));
+  record.target.push_back(writer.WordId("the"));
+  record.target.push_back(writer.WordId("house"));
+  record.alignment.push_back(make_pair(0u, 0u));
+  record.alignment.push_back(make_pair(1u, 1u));
+  record.hasSentenceId = true;
+  record.sentenceId = 7;
+  record.count = 0.5f;
+  writer.Write(record);
+
+  record.Clear();
+  record.source.push_back(writer.WordId("das"));
+  record.source.push_back(writer.WordId("[X][X]"));
+  record.source.push_back(writer.WordId("[S]"));
+  record.target.push_back(writer.WordId("the"));
+  record.target.push_back(writer.WordId("[X][X]"));
+  record.target.push_back(writer.WordId("[NP]"));
+  record.alignment.push_back(make_pair(1u, 1u));
+  record.count = 2.0f;
+  record.hasPcfgScore = true;
+  record.pcfgScore = 0.25f;
+  writer.Write(record);
+
+  istringstream in(out.str());
+  ExtractFileReader reader(in);
+  vector<string> payloads;
+  while (reader.Read()) {
+    payloads.push_back(reader.Payload());
+  }
+  BOOST_REQUIRE_EQUAL(payloads.size(), 4u);
+  BOOST_CHECK(payloads[0] == payloads[2]);
+  BOOST_CHECK(payloads[1] == payloads[3]);
+}
+
+// Phrase pairs with words that are prefixes of each other, contain "|||" or
+// bytes above 0x7f, or sort around the space and "|||", have to come out of
+// sort-extract in the order that LC_ALL=C sort gives their text lines.
+BOOST_AUTO_TEST_CASE(word_order_as_sort)
+{
+  const char *words[] = {
+    "a", "ab", "a!", "a\x01", "a\x7f", "a\xc3\xa9", "a\xff", "|", "||", "||||",
+    "x|||y", "|||x", "{", "}", "~", "\xc3\xa9", "\xff", "!", "0"
+  };
+  const size_t numberOfWords = sizeof(words) / sizeof(words[0]);
+
+  // one- and two-word phrases of them, paired with a few targets
+  vector<string> lines;
+  for (size_t i = 0; i < numberOfWords; ++i) {
+    for (size_t j = 0; j <= numberOfWords; ++j) {
+      string source = words[i];
+      if (j < numberOfWords) {
+        source += string(" ") + words[j];
+      }
+      lines.push_back(source + " ||| " + words[(i + j) % numberOfWords] + " ||| 0-0 ||| 1");
+      lines.push_back(source + " ||| " + words[(i * j) % numberOfWords] + " " + words[i] + " ||| 0-0 ||| 1");
+    }
+  }
+
+  TempDir dir;
+  const string path = (dir.path / "extract").string();
+  {
+    ofstream out(path.c_str());
+    for (size_t i = lines.size(); i-- > 0;) {
+      out << lines[i] << "\n";
+    }
+  }
+  FILE *sorted = popen(("LC_ALL=C sort '" + path + "'").c_str(), "r");
+  BOOST_REQUIRE(sorted);
+  vector<vector<string> > sources, targets;
+  string line;
+  for (int c; (c = fgetc(sorted)) != EOF;) {
+    if (c != '\n') {
+      line.push_back((char)c);
+      continue;
+    }
+    ExtractRecord record;
+    sources.push_back(vector<string>());
+    targets.push_back(vector<string>());
+    BOOST_REQUIRE(ParseExtractLine(line, false, sources.back(), targets.back(), record));
+    line.clear();
+  }
+  BOOST_REQUIRE_EQUAL(pclose(sorted), 0);
+  BOOST_REQUIRE_EQUAL(sources.size(), lines.size());
+
+  for (size_t i = 1; i < sources.size(); ++i) {
+    const bool sameSource = !phraseLess(sources[i - 1], sources[i])
+                            && !phraseLess(sources[i], sources[i - 1]);
+    if (sources[i - 1] != sources[i]) {
+      BOOST_CHECK_MESSAGE(phraseLess(sources[i - 1], sources[i]), "line " << i);
+    } else if (targets[i - 1] != targets[i]) {
+      BOOST_CHECK_MESSAGE(phraseLess(targets[i - 1], targets[i]), "line " << i);
+    }
+    BOOST_CHECK_EQUAL(sameSource, sources[i - 1] == sources[i]);
+  }
+}
@@ -25,6 +25,8 @@
 #include <iostream>
 #include <sstream>
 #include <map>
+#include <utility>
+#include <vector>
 
 namespace MosesTraining
 {
@@ -37,6 +39,7 @@ public:
   std::string target;
   std::string alignment;
   std::string alignmentInv;
+  std::vector<std::pair<int, int> > alignmentPoints; // (source, target), as in alignment
   std::string orientation;
   std::string orientationForward;
   std::string sourceContextLeft;
@@ -57,6 +60,7 @@ public:
     , target()
     , alignment()
     , alignmentInv()
+    , alignmentPoints()
     , orientation()
     , orientationForward()
     , sourceContextLeft()
@@ -49,6 +49,7 @@ private:
   bool includeSentenceIdFlag; //include sentence id in extract file
   bool onlyOutputSpanInfo;
   bool gzOutput;
+  bool binaryOutput; //binary extract files, see ExtractFile.h
   std::string instanceWeightsFile; //weights for each sentence
   bool flexScoreFlag;
 
@@ -72,6 +73,7 @@ public:
     includeSentenceIdFlag(false),
     onlyOutputSpanInfo(false),
     gzOutput(false),
+    binaryOutput(false),
     flexScoreFlag(false),
     debug(false) {
   }
@@ -113,6 +115,9 @@ public:
   void initGzOutput (const bool initgzOutput) {
     gzOutput= initgzOutput;
   }
+  void initBinaryOutput (const bool initbinaryOutput) {
+    binaryOutput= initbinaryOutput;
+  }
   void initInstanceWeightsFile(const char* initInstanceWeightsFile) {
     instanceWeightsFile = std::string(initInstanceWeightsFile);
   }
@@ -157,6 +162,9 @@ public:
   bool isGzOutput () const {
     return gzOutput;
   }
+  bool isBinaryOutput () const {
+    return binaryOutput;
+  }
   std::string getInstanceWeightsFile() const {
     return instanceWeightsFile;
   }
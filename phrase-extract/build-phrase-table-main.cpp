@@ -0,0 +1,862 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2015 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+// Builds a phrase table from a word-aligned parallel corpus in one process.
+//
+// This does the work of extract, sort, score (direct and --Inverse) and
+// consolidate with their default settings, and produces the same table, but
+// the extracted phrase pairs never exist as text: they are passed as fixed
+// size records of word ids through the external sort of util/stream, and
+// the two directions are scored at the same time.
+//
+// Words are numbered in the byte order of "word ", so that comparing two
+// phrases id by id, padded with the id of "|||", gives the order in which
+// LC_ALL=C sort puts the lines of the extract files.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/scoped.hh"
+#include "util/tokenize.hh"
+#include "util/stream/chain.hh"
+#include "util/stream/io.hh"
+#include "util/stream/multi_stream.hh"
+#include "util/stream/sort.hh"
+#include "util/stream/stream.hh"
+#include "moses/Util.h"
+#include "ExtractFile.h"
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+#include "SentenceAlignment.h"
+
+#ifdef HAVE_PROBINGPT
+#include "moses/TranslationModel/ProbingPT/storing.hh"
+#endif
+
+#define COC_MAX 10
+
+using namespace MosesTraining;
+
+namespace
+{
+
+bool goodTuringFlag = false;
+bool kneserNeyFlag = false;
+
+const size_t kBatchSentences = 10000;
+
+// vocabulary of both languages, see above
+std::vector<std::string> vocabulary;
+boost::unordered_map<std::string, uint32_t> wordIds;
+uint32_t separatorId; // "|||", pads phrases
+uint32_t nullId;      // "NULL" in the lexical tables
+
+void addWords(const std::string &fileName, boost::unordered_set<std::string> &words)
+{
+  Moses::InputFileStream file(fileName);
+  UTIL_THROW_IF2(file.fail(), "could not open " << fileName);
+  std::string line;
+  while (getline(file, line)) {
+    std::vector<std::string> tokens = util::tokenize(line);
+    words.insert(tokens.begin(), tokens.end());
+  }
+  file.Close();
+}
+
+void loadVocabulary(const std::string &fileNameE, const std::string &fileNameF)
+{
+  boost::unordered_set<std::string> words;
+  words.insert("|||");
+  addWords(fileNameE, words);
+  addWords(fileNameF, words);
+
+  vocabulary.assign(words.begin(), words.end());
+  std::sort(vocabulary.begin(), vocabulary.end(), WordOrder());
+  UTIL_THROW_IF2(vocabulary.size() >= (1ULL << 32) - 1, "vocabulary too large");
+  for (size_t i = 0; i < vocabulary.size(); ++i) {
+    wordIds[vocabulary[i]] = i;
+  }
+  separatorId = wordIds["|||"];
+  boost::unordered_map<std::string, uint32_t>::const_iterator null = wordIds.find("NULL");
+  nullId = (null == wordIds.end()) ? vocabulary.size() : null->second;
+}
+
+// Where the parts of a record are, for phrases of up to length words:
+// source and target word ids, padded with separatorId, the alignment as a
+// bit matrix (bit t*length+s is set if target word t is aligned to source
+// word s) and the count of the phrase pair. Records are sorted by all but
+// the count. Scored records have three more floats: the marginal count of
+// the source phrase, the number of distinct phrase pairs with that source
+// phrase and the lexical weight.
+struct Layout {
+  explicit Layout(size_t maxLength)
+    : length(maxLength),
+      alignment(2 * maxLength * sizeof(uint32_t)),
+      count(alignment + ((maxLength * maxLength + 31) / 32) * 4),
+      size(count + sizeof(float)),
+      scoredSize(count + 4 * sizeof(float)) {}
+
+  size_t length, alignment, count, size, scoredSize;
+
+  uint32_t *Source(void *record) const {
+    return static_cast<uint32_t*>(record);
+  }
+  const uint32_t *Source(const void *record) const {
+    return static_cast<const uint32_t*>(record);
+  }
+  const uint32_t *Target(const void *record) const {
+    return Source(record) + length;
+  }
+  uint8_t *Alignment(void *record) const {
+    return static_cast<uint8_t*>(record) + alignment;
+  }
+  const uint8_t *Alignment(const void *record) const {
+    return static_cast<const uint8_t*>(record) + alignment;
+  }
+  float *Counts(void *record) const {
+    return reinterpret_cast<float*>(static_cast<uint8_t*>(record) + count);
+  }
+  const float *Counts(const void *record) const {
+    return reinterpret_cast<const float*>(static_cast<const uint8_t*>(record) + count);
+  }
+  bool Aligned(const void *record, size_t s, size_t t) const {
+    size_t bit = t * length + s;
+    return Alignment(record)[bit / 8] & (1 << (bit % 8));
+  }
+  void Align(void *record, size_t s, size_t t) const {
+    size_t bit = t * length + s;
+    Alignment(record)[bit / 8] |= (1 << (bit % 8));
+  }
+};
+
+size_t phraseLength(const uint32_t *words, size_t length)
+{
+  size_t i = 0;
+  while (i < length && words[i] != separatorId) {
+    ++i;
+  }
+  return i;
+}
+
+class PhrasePairOrder : public std::binary_function<const void *, const void *, bool>
+{
+public:
+  explicit PhrasePairOrder(const Layout &layout)
+    : m_words(2 * layout.length), m_alignmentBytes(layout.count - layout.alignment) {}
+
+  bool operator()(const void *first, const void *second) const {
+    const uint32_t *a = static_cast<const uint32_t*>(first);
+    const uint32_t *b = static_cast<const uint32_t*>(second);
+    for (size_t i = 0; i < m_words; ++i) {
+      if (a[i] != b[i]) {
+        return a[i] < b[i];
+      }
+    }
+    return memcmp(a + m_words, b + m_words, m_alignmentBytes) < 0;
+  }
+
+private:
+  size_t m_words, m_alignmentBytes;
+};
+
+// Adds up the counts of identical phrase pairs while sorted blocks are merged
+class AddCounts
+{
+public:
+  explicit AddCounts(const Layout &layout) : m_layout(layout) {}
+
+  bool operator()(void *into, const void *option, const PhrasePairOrder &order) const {
+    if (order(into, option)) {
+      return false;
+    }
+    m_layout.Counts(into)[0] += m_layout.Counts(option)[0];
+    return true;
+  }
+
+private:
+  Layout m_layout;
+};
+
+// Runs every slice in its own thread. Slices only hold pointers, so they are cheap to copy.
+template <class Slice> void runSlices(const std::vector<Slice> &slices)
+{
+  if (slices.size() == 1) {
+    Slice slice(slices[0]);
+    slice();
+    return;
+  }
+  boost::thread_group threads;
+  for (size_t i = 0; i < slices.size(); i++) {
+    threads.create_thread(slices[i]);
+  }
+  threads.join_all();
+}
+
+void toWordIds(const std::vector<std::string> &words, std::vector<uint32_t> &ids)
+{
+  ids.resize(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    ids[i] = wordIds.find(words[i])->second;
+  }
+}
+
+// Extracts the phrase pairs of the sentence pairs [begin, end) of a batch,
+// as extract does without reordering or other options, as records for the
+// direct (source, target) and the inverse (target, source) direction.
+struct ExtractSlice {
+  const std::vector<std::string> *e, *f, *a;
+  size_t begin, end;
+  int firstSentenceId;
+  const Layout *layout;
+  std::vector<uint8_t> *direct, *inverse;
+
+  void operator()() {
+    direct->clear();
+    inverse->clear();
+    std::vector<uint32_t> idsE, idsF;
+    for (size_t i = begin; i < end; i++) {
+      SentenceAlignment sentence;
+      if (sentence.create((*e)[i].c_str(), (*f)[i].c_str(), (*a)[i].c_str(), "",
+                          firstSentenceId + i, false)) {
+        toWordIds(sentence.target, idsE);
+        toWordIds(sentence.source, idsF);
+        extract(sentence, idsE, idsF);
+      }
+    }
+  }
+
+  void extract(const SentenceAlignment &sentence, const std::vector<uint32_t> &idsE,
+               const std::vector<uint32_t> &idsF) {
+    int maxPhraseLength = layout->length;
+    int countE = sentence.target.size();
+    int countF = sentence.source.size();
+
+    for (int startE=0; startE<countE; startE++) {
+      for (int endE=startE; endE<countE && endE<startE+maxPhraseLength; endE++) {
+
+        int minF = countF;
+        int maxF = -1;
+        std::vector< int > usedF = sentence.alignedCountS;
+        for (int ei=startE; ei<=endE; ei++) {
+          for (size_t i=0; i<sentence.alignedToT[ei].size(); i++) {
+            int fi = sentence.alignedToT[ei][i];
+            minF = std::min(minF, fi);
+            maxF = std::max(maxF, fi);
+            usedF[ fi ]--;
+          }
+        }
+
+        if (maxF < 0 || maxF-minF >= maxPhraseLength) {
+          continue;
+        }
+
+        // check if source words are aligned to out of bound target words
+        bool out_of_bounds = false;
+        for (int fi=minF; fi<=maxF && !out_of_bounds; fi++) {
+          out_of_bounds = (usedF[fi] > 0);
+        }
+        if (out_of_bounds) {
+          continue;
+        }
+
+        // start point of source phrase may retreat over unaligned
+        for (int startF=minF;
+             (startF>=0 &&
+              startF>maxF-maxPhraseLength && // within length limit
+              (startF==minF || sentence.alignedCountS[startF]==0)); // unaligned
+             startF--) {
+          // end point of source phrase may advance over unaligned
+          for (int endF=maxF;
+               (endF<countF &&
+                endF<startF+maxPhraseLength && // within length limit
+                (endF==maxF || sentence.alignedCountS[endF]==0)); // unaligned
+               endF++) {
+            addPhrasePair(sentence, idsE, idsF, startE, endE, startF, endF);
+          }
+        }
+      }
+    }
+  }
+
+  void addPhrasePair(const SentenceAlignment &sentence, const std::vector<uint32_t> &idsE,
+                     const std::vector<uint32_t> &idsF, int startE, int endE, int startF, int endF) {
+    size_t offset = direct->size();
+    direct->resize(offset + layout->size, 0);
+    inverse->resize(offset + layout->size, 0);
+    void *d = &(*direct)[offset];
+    void *i = &(*inverse)[offset];
+
+    uint32_t *sourceD = layout->Source(d);
+    uint32_t *sourceI = layout->Source(i);
+    std::fill(sourceD, sourceD + 2 * layout->length, separatorId);
+    std::fill(sourceI, sourceI + 2 * layout->length, separatorId);
+    std::copy(idsF.begin() + startF, idsF.begin() + endF + 1, sourceD);
+    std::copy(idsE.begin() + startE, idsE.begin() + endE + 1, sourceD + layout->length);
+    std::copy(idsE.begin() + startE, idsE.begin() + endE + 1, sourceI);
+    std::copy(idsF.begin() + startF, idsF.begin() + endF + 1, sourceI + layout->length);
+
+    for (int ei=startE; ei<=endE; ei++) {
+      for (size_t k=0; k<sentence.alignedToT[ei].size(); k++) {
+        int fi = sentence.alignedToT[ei][k];
+        layout->Align(d, fi-startF, ei-startE);
+        layout->Align(i, ei-startE, fi-startF);
+      }
+    }
+    layout->Counts(d)[0] = 1.0;
+    layout->Counts(i)[0] = 1.0;
+  }
+};
+
+// First step of both sorting chains: reads the corpus in batches and extracts
+// phrase pairs in parallel, direct ones go to the first chain, inverse ones
+// to the second.
+class ExtractPhrasePairs
+{
+public:
+  ExtractPhrasePairs(const std::string &fileNameE, const std::string &fileNameF,
+                     const std::string &fileNameA, const Layout &layout, size_t threads)
+    : m_fileNameE(fileNameE), m_fileNameF(fileNameF), m_fileNameA(fileNameA),
+      m_layout(layout), m_threads(threads) {}
+
+  void Run(const util::stream::ChainPositions &positions) {
+    util::stream::Streams streams(positions);
+    Moses::InputFileStream eFile(m_fileNameE);
+    Moses::InputFileStream fFile(m_fileNameF);
+    Moses::InputFileStream aFile(m_fileNameA);
+    UTIL_THROW_IF2(eFile.fail() || fFile.fail() || aFile.fail(),
+                   "could not open " << m_fileNameE << ", " << m_fileNameF << " or " << m_fileNameA);
+
+    std::vector<std::string> e(kBatchSentences), f(kBatchSentences), a(kBatchSentences);
+    std::vector<std::vector<uint8_t> > direct(m_threads), inverse(m_threads);
+    int sentenceId = 0;
+    while (true) {
+      size_t sentences = 0;
+      while (sentences < kBatchSentences && getline(eFile, e[sentences])) {
+        getline(fFile, f[sentences]);
+        getline(aFile, a[sentences]);
+        ++sentences;
+      }
+      if (sentences == 0) {
+        break;
+      }
+
+      std::vector<ExtractSlice> slices(m_threads);
+      for (size_t t = 0; t < m_threads; t++) {
+        slices[t].e = &e;
+        slices[t].f = &f;
+        slices[t].a = &a;
+        slices[t].begin = sentences * t / m_threads;
+        slices[t].end = sentences * (t + 1) / m_threads;
+        slices[t].firstSentenceId = sentenceId + 1;
+        slices[t].layout = &m_layout;
+        slices[t].direct = &direct[t];
+        slices[t].inverse = &inverse[t];
+      }
+      runSlices(slices);
+
+      for (size_t t = 0; t < m_threads; t++) {
+        for (size_t i = 0; i < direct[t].size(); i += m_layout.size) {
+          memcpy(streams[0].Get(), &direct[t][i], m_layout.size);
+          memcpy(streams[1].Get(), &inverse[t][i], m_layout.size);
+          ++streams[0];
+          ++streams[1];
+        }
+      }
+      sentenceId += sentences;
+      std::cerr << "." << std::flush;
+    }
+    streams[0].Poison();
+    streams[1].Poison();
+  }
+
+private:
+  std::string m_fileNameE, m_fileNameF, m_fileNameA;
+  Layout m_layout;
+  size_t m_threads;
+};
+
+// Lexical translation table as written by extract-lex: "target source probability"
+class LexicalTable
+{
+public:
+  void Load(const std::string &fileName) {
+    std::cerr << "Loading lexical translation table from " << fileName << std::endl;
+    Moses::InputFileStream inFile(fileName);
+    UTIL_THROW_IF2(inFile.fail(), "could not open lexical translation table " << fileName);
+
+    std::string line;
+    std::vector<std::string> token;
+    for (size_t i = 1; getline(inFile, line); i++) {
+      Moses::Tokenize(token, line);
+      if (token.size() != 3) {
+        std::cerr << "line " << i << " in " << fileName
+                  << " has wrong number of tokens, skipping" << std::endl;
+        token.clear();
+        continue;
+      }
+      boost::unordered_map<std::string, uint32_t>::const_iterator wordT = wordIds.find(token[0]);
+      boost::unordered_map<std::string, uint32_t>::const_iterator wordS = wordIds.find(token[1]);
+      // words that are not in the corpus are never looked up
+      if (wordT != wordIds.end() && (wordS != wordIds.end() || token[1] == "NULL")) {
+        uint64_t s = (wordS == wordIds.end()) ? nullId : wordS->second;
+        m_table[(s << 32) | wordT->second] = std::atof(token[2].c_str());
+      }
+      token.clear();
+    }
+    inFile.Close();
+  }
+
+  // like LexicalTable::permissiveLookup of score
+  double PermissiveLookup(uint32_t wordS, uint32_t wordT) const {
+    boost::unordered_map<uint64_t, double>::const_iterator i
+      = m_table.find((static_cast<uint64_t>(wordS) << 32) | wordT);
+    return (i == m_table.end()) ? 1.0 : i->second;
+  }
+
+private:
+  boost::unordered_map<uint64_t, double> m_table;
+};
+
+struct CountOfCounts {
+  CountOfCounts() : totalDistinct(0) {
+    std::fill(counts, counts + COC_MAX + 1, 0);
+  }
+  int counts[COC_MAX+1];
+  int totalDistinct;
+};
+
+// vector<set<size_t> > comparison of score's ALIGNMENT
+bool alignmentGreater(const Layout &layout, const void *a, const void *b, size_t lengthS, size_t lengthT)
+{
+  for (size_t t = 0; t < lengthT; ++t) {
+    size_t sa = 0, sb = 0;
+    while (true) {
+      while (sa < lengthS && !layout.Aligned(a, sa, t)) ++sa;
+      while (sb < lengthS && !layout.Aligned(b, sb, t)) ++sb;
+      if (sa == lengthS || sb == lengthS) {
+        if (sa != sb) {
+          return sb == lengthS;
+        }
+        break;
+      }
+      if (sa != sb) {
+        return sa > sb;
+      }
+      ++sa;
+      ++sb;
+    }
+  }
+  return false;
+}
+
+// Second step: does what score does with the sorted extract file of one
+// direction. Reads sorted phrase pairs from the first chain and writes one
+// scored record per distinct phrase pair to the second chain, with the best
+// alignment. Scored inverse records are turned around, so that they can be
+// sorted into the order of the direct ones.
+class ScorePhrasePairs
+{
+public:
+  ScorePhrasePairs(const Layout &layout, const LexicalTable &lexTable, bool inverse,
+                   CountOfCounts *countOfCounts)
+    : m_layout(layout), m_lexTable(&lexTable), m_inverse(inverse),
+      m_countOfCounts(countOfCounts) {}
+
+  void Run(const util::stream::ChainPositions &positions) {
+    util::stream::Streams streams(positions);
+    util::stream::Stream &in = streams[0];
+    std::vector<uint8_t> current(m_layout.size);
+    float runCount = 0, bestCount = 0;
+    bool first = true;
+
+    for (; in; ++in) {
+      const void *record = in.Get();
+      float count = m_layout.Counts(record)[0];
+      if (!first && !memcmp(&current[0], record, m_layout.count)) {
+        runCount += count;
+        continue;
+      }
+      bool sameSource = !first &&
+                        !memcmp(&current[0], record, m_layout.length * sizeof(uint32_t));
+      bool samePair = sameSource &&
+                      !memcmp(&current[0], record, 2 * m_layout.length * sizeof(uint32_t));
+      if (!first) {
+        EndRun(current, runCount, bestCount);
+      }
+      if (!first && !sameSource) {
+        WriteSource(streams[1]);
+      }
+      if (!samePair) {
+        m_pairs.resize(m_pairs.size() + m_layout.scoredSize);
+        memcpy(&m_pairs[m_pairs.size() - m_layout.scoredSize], record, m_layout.count);
+        bestCount = -1;
+      }
+      memcpy(&current[0], record, m_layout.size);
+      runCount = count;
+      first = false;
+    }
+    if (!first) {
+      EndRun(current, runCount, bestCount);
+      WriteSource(streams[1]);
+    }
+    streams[1].Poison();
+  }
+
+private:
+  // the count of one alignment of the last phrase pair is complete
+  void EndRun(const std::vector<uint8_t> &current, float runCount, float &bestCount) {
+    void *pair = &m_pairs[m_pairs.size() - m_layout.scoredSize];
+    m_layout.Counts(pair)[0] += runCount;
+    if (runCount > bestCount ||
+        (runCount == bestCount &&
+         alignmentGreater(m_layout, &current[0], pair,
+                          phraseLength(m_layout.Source(pair), m_layout.length),
+                          phraseLength(m_layout.Target(pair), m_layout.length)))) {
+      bestCount = runCount;
+      memcpy(m_layout.Alignment(pair), m_layout.Alignment(&current[0]), m_layout.count - m_layout.alignment);
+    }
+  }
+
+  // all phrase pairs with the same source phrase are complete
+  void WriteSource(util::stream::Stream &out) {
+    size_t distinct = m_pairs.size() / m_layout.scoredSize;
+    float totalSource = 0;
+    for (size_t i = 0; i < m_pairs.size(); i += m_layout.scoredSize) {
+      totalSource += m_layout.Counts(&m_pairs[i])[0];
+    }
+
+    for (size_t i = 0; i < m_pairs.size(); i += m_layout.scoredSize, ++out) {
+      void *pair = &m_pairs[i];
+      float *counts = m_layout.Counts(pair);
+      if (m_countOfCounts) {
+        m_countOfCounts->totalDistinct++;
+        int countInt = counts[0] + 0.99999;
+        if ((countInt <= COC_MAX) &&
+            (countInt > 0))
+          m_countOfCounts->counts[ countInt ]++;
+      }
+      counts[1] = totalSource;
+      counts[2] = distinct;
+      counts[3] = LexicalWeight(pair);
+
+      if (m_inverse) {
+        uint32_t *words = m_layout.Source(pair);
+        std::swap_ranges(words, words + m_layout.length, words + m_layout.length);
+        memset(m_layout.Alignment(pair), 0, m_layout.count - m_layout.alignment);
+      }
+      memcpy(out.Get(), pair, m_layout.scoredSize);
+    }
+    m_pairs.clear();
+  }
+
+  // computeLexicalTranslation of score
+  float LexicalWeight(const void *pair) const {
+    const uint32_t *source = m_layout.Source(pair);
+    const uint32_t *target = m_layout.Target(pair);
+    size_t lengthS = phraseLength(source, m_layout.length);
+    size_t lengthT = phraseLength(target, m_layout.length);
+    double lexScore = 1.0;
+    for (size_t t = 0; t < lengthT; ++t) {
+      double thisWordScore = 0;
+      size_t aligned = 0;
+      for (size_t s = 0; s < lengthS; ++s) {
+        if (m_layout.Aligned(pair, s, t)) {
+          thisWordScore += m_lexTable->PermissiveLookup(source[s], target[t]);
+          ++aligned;
+        }
+      }
+      if (aligned) {
+        lexScore *= thisWordScore / (double)aligned;
+      } else {
+        // explain unaligned word by NULL
+        lexScore *= m_lexTable->PermissiveLookup(nullId, target[t]);
+      }
+    }
+    return lexScore;
+  }
+
+  Layout m_layout;
+  const LexicalTable *m_lexTable;
+  bool m_inverse;
+  CountOfCounts *m_countOfCounts;
+  std::vector<uint8_t> m_pairs; // scored records with the same source phrase
+};
+
+// Discounting of consolidate
+class Discounting
+{
+public:
+  explicit Discounting(const CountOfCounts &coc) {
+    countOfCounts.push_back(0.0);
+    totalCount = coc.totalDistinct;
+    for (int i = 1; i <= COC_MAX; i++) {
+      countOfCounts.push_back(coc.counts[i]);
+    }
+
+    // compute Good Turing discounts
+    if (goodTuringFlag) {
+      goodTuringDiscount.push_back(0.01); // floor value
+      for( size_t i=1; i<countOfCounts.size()-1; i++ ) {
+        goodTuringDiscount.push_back(((float)i+1)/(float)i*((countOfCounts[i+1]+0.1) / ((float)countOfCounts[i]+0.1)));
+        if (goodTuringDiscount[i]>1)
+          goodTuringDiscount[i] = 1;
+        if (goodTuringDiscount[i]<goodTuringDiscount[i-1])
+          goodTuringDiscount[i] = goodTuringDiscount[i-1];
+      }
+    }
+
+    // compute Kneser Ney co-efficients [Chen&Goodman, 1998]
+    float Y = countOfCounts[1] / (countOfCounts[1] + 2*countOfCounts[2]);
+    kneserNey_D1 = 1 - 2*Y * countOfCounts[2] / countOfCounts[1];
+    kneserNey_D2 = 2 - 3*Y * countOfCounts[3] / countOfCounts[2];
+    kneserNey_D3 = 3 - 4*Y * countOfCounts[4] / countOfCounts[3];
+    // sanity constraints
+    if (kneserNey_D1 > 0.9) kneserNey_D1 = 0.9;
+    if (kneserNey_D2 > 1.9) kneserNey_D2 = 1.9;
+    if (kneserNey_D3 > 2.9) kneserNey_D3 = 2.9;
+  }
+
+  // adjusted counts of the phrase pair for the direct and the indirect probability
+  void Adjust(float countE, float countF, float countEF, float n1_E, float n1_F,
+              float &adjustedCountEF, float &adjustedCountEF_indirect) const {
+    // Good Turing discounting
+    adjustedCountEF = countEF;
+    if (goodTuringFlag && countEF+0.99999 < goodTuringDiscount.size()-1)
+      adjustedCountEF *= goodTuringDiscount[(int)(countEF+0.99998)];
+    adjustedCountEF_indirect = adjustedCountEF;
+
+    // Kneser Ney discounting [Foster et al, 2006]
+    if (kneserNeyFlag) {
+      float D = kneserNey_D3;
+      if (countEF < 2) D = kneserNey_D1;
+      else if (countEF < 3) D = kneserNey_D2;
+      if (D > countEF) D = countEF - 0.01; // sanity constraint
+
+      float p_b_E = n1_E / totalCount; // target phrase prob based on distinct
+      float alpha_F = D * n1_F / countF; // available mass
+      adjustedCountEF = countEF - D + countF * alpha_F * p_b_E;
+
+      // for indirect
+      float p_b_F = n1_F / totalCount; // target phrase prob based on distinct
+      float alpha_E = D * n1_E / countE; // available mass
+      adjustedCountEF_indirect = countEF - D + countE * alpha_E * p_b_F;
+    }
+  }
+
+private:
+  std::vector< float > countOfCounts;
+  std::vector< float > goodTuringDiscount;
+  float kneserNey_D1, kneserNey_D2, kneserNey_D3, totalCount;
+};
+
+void writePhrase(std::ostream &out, const uint32_t *words, size_t length)
+{
+  for (size_t i = 0; i < length; ++i) {
+    if (i) out << " ";
+    out << vocabulary[words[i]];
+  }
+}
+
+// Last step: what consolidate does with the two half tables
+void consolidate(util::stream::Stream &direct, util::stream::Stream &indirect,
+                 const Layout &layout, const Discounting &discounting,
+                 std::ostream &out)
+{
+  for (; direct && indirect; ++direct, ++indirect) {
+    const void *d = direct.Get();
+    const void *i = indirect.Get();
+    UTIL_THROW_IF2(memcmp(d, i, layout.alignment),
+                   "phrase pairs of the direct and the indirect direction do not match");
+    const uint32_t *source = layout.Source(d);
+    const uint32_t *target = layout.Target(d);
+    size_t lengthS = phraseLength(source, layout.length);
+    size_t lengthT = phraseLength(target, layout.length);
+
+    float countEF = layout.Counts(d)[0];
+    float countF = layout.Counts(d)[1];
+    float countE = layout.Counts(i)[1];
+    float adjustedCountEF, adjustedCountEF_indirect;
+    discounting.Adjust(countE, countF, countEF, layout.Counts(i)[2], layout.Counts(d)[2],
+                       adjustedCountEF, adjustedCountEF_indirect);
+
+    writePhrase(out, source, lengthS);
+    out << " ||| ";
+    writePhrase(out, target, lengthT);
+    out << " |||";
+    out << " " << adjustedCountEF_indirect/countE << " " << layout.Counts(i)[3];
+    out << " " << adjustedCountEF/countF << " " << layout.Counts(d)[3];
+
+    out << " |||";
+    for (size_t t = 0; t < lengthT; ++t) {
+      for (size_t s = 0; s < lengthS; ++s) {
+        if (layout.Aligned(d, s, t)) {
+          out << " " << s << "-" << t;
+        }
+      }
+    }
+    out << " ||| " << countE << " " << countF << " " << countEF;
+    out << " ||| |||" << std::endl;
+  }
+  UTIL_THROW_IF2(direct || indirect,
+                 "different numbers of phrase pairs in the direct and the indirect direction");
+}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  std::cerr << "Build phrase table: extract, score and consolidate in one process" << std::endl;
+
+  if (argc < 8) {
+    std::cerr <<
+              "syntax: "
+              "build-phrase-table en de align lex.f2e lex.e2f phrase-table max-length "
+              "[--GoodTuring] [--KneserNey] [--Threads n] [--Memory MB] "
+              "[--TempDir dir] [--ProbingPT dir]"
+              << std::endl;
+    exit(1);
+  }
+  const std::string fileNameE = argv[1];
+  const std::string fileNameF = argv[2];
+  const std::string fileNameA = argv[3];
+  const std::string fileNameLexF2E = argv[4];
+  const std::string fileNameLexE2F = argv[5];
+  const std::string fileNamePhraseTable = argv[6];
+  const int maxPhraseLength = atoi(argv[7]);
+  size_t threads = 1;
+  size_t memory = 1ULL << 30;
+  std::string tempPrefix = "/tmp/";
+  std::string probingDir;
+
+  for(int i=8; i<argc; i++) {
+    if (strcmp(argv[i],"--GoodTuring") == 0) {
+      goodTuringFlag = true;
+      std::cerr << "adjusting phrase translation probabilities with Good Turing discounting" << std::endl;
+    } else if (strcmp(argv[i],"--KneserNey") == 0) {
+      kneserNeyFlag = true;
+      std::cerr << "adjusting phrase translation probabilities with Kneser Ney discounting" << std::endl;
+    } else if (strcmp(argv[i],"--Threads") == 0 || strcmp(argv[i],"--threads") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the number of threads!");
+      threads = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i],"--Memory") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the memory for sorting in MB!");
+      memory = (size_t)atoi(argv[++i]) << 20;
+    } else if (strcmp(argv[i],"--TempDir") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the directory for temporary files!");
+      tempPrefix = argv[++i];
+      util::NormalizeTempPrefix(tempPrefix);
+    } else if (strcmp(argv[i],"--ProbingPT") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the directory of the ProbingPT table!");
+      probingDir = argv[++i];
+#ifndef HAVE_PROBINGPT
+      UTIL_THROW2("ProbingPT output requires compiling with --with-probing-pt");
+#endif
+    } else {
+      UTIL_THROW2("unknown option " << argv[i]);
+    }
+  }
+  UTIL_THROW_IF2(maxPhraseLength <= 0, "max-length has to be positive");
+
+  loadVocabulary(fileNameE, fileNameF);
+  std::cerr << "vocabulary size: " << vocabulary.size() << std::endl;
+  LexicalTable lexF2E, lexE2F;
+  lexF2E.Load(fileNameLexF2E);
+  lexE2F.Load(fileNameLexE2F);
+
+  // The memory goes to two sorts and four chains at a time.
+  const Layout layout(maxPhraseLength);
+  const PhrasePairOrder order(layout);
+  memory = std::max<size_t>(memory, 64 << 20);
+  util::stream::SortConfig sortConfig;
+  sortConfig.temp_prefix = tempPrefix;
+  sortConfig.total_memory = memory / 4;
+  sortConfig.buffer_size = std::min<size_t>(64 << 20, sortConfig.total_memory / 4);
+  const util::stream::ChainConfig extractedConfig(layout.size, 2, memory / 8);
+  const util::stream::ChainConfig scoredConfig(layout.scoredSize, 2, memory / 8);
+
+  // extract and sort both directions
+  util::stream::Chains extracted(2);
+  extracted.push_back(extractedConfig);
+  extracted.push_back(extractedConfig);
+  extracted >> ExtractPhrasePairs(fileNameE, fileNameF, fileNameA, layout, threads);
+  util::stream::Sort<PhrasePairOrder, AddCounts> sortDirect(extracted[0], sortConfig, order, AddCounts(layout));
+  util::stream::Sort<PhrasePairOrder, AddCounts> sortInverse(extracted[1], sortConfig, order, AddCounts(layout));
+  extracted.Wait(true);
+  std::cerr << std::endl << "extracted and sorted phrase pairs, scoring" << std::endl;
+
+  // score both directions at the same time; the direct scores stay in order
+  // of the direct phrase pairs, the inverse ones are sorted into that order
+  CountOfCounts countOfCounts;
+  util::scoped_fd scoredDirect(util::MakeTemp(tempPrefix));
+  util::stream::Chains direct(2);
+  direct.push_back(extractedConfig);
+  direct.push_back(scoredConfig);
+  sortDirect.Output(direct[0]);
+  direct >> ScorePhrasePairs(layout, lexF2E, false, &countOfCounts);
+  direct[0] >> util::stream::kRecycle;
+  direct[1] >> util::stream::WriteAndRecycle(scoredDirect.get());
+
+  util::stream::Chains inverse(2);
+  inverse.push_back(extractedConfig);
+  inverse.push_back(scoredConfig);
+  sortInverse.Output(inverse[0]);
+  inverse >> ScorePhrasePairs(layout, lexE2F, true, NULL);
+  inverse[0] >> util::stream::kRecycle;
+  util::stream::Sort<PhrasePairOrder> sortScored(inverse[1], sortConfig, order);
+
+  direct.Wait(true);
+  inverse.Wait(true);
+  std::cerr << "scored phrase pairs, consolidating" << std::endl;
+
+  // consolidate
+  Moses::OutputFileStream phraseTable;
+  UTIL_THROW_IF2(!phraseTable.Open(fileNamePhraseTable),
+                 "could not open output file " << fileNamePhraseTable);
+  util::stream::Chain directChain(scoredConfig);
+  directChain >> util::stream::PRead(scoredDirect.get());
+  util::stream::Stream directScores;
+  directChain >> directScores >> util::stream::kRecycle;
+  util::stream::Chain indirectChain(scoredConfig);
+  sortScored.Output(indirectChain);
+  util::stream::Stream indirectScores;
+  indirectChain >> indirectScores >> util::stream::kRecycle;
+  consolidate(directScores, indirectScores, layout, Discounting(countOfCounts), phraseTable);
+  directChain.Wait();
+  indirectChain.Wait();
+  phraseTable.Close();
+
+#ifdef HAVE_PROBINGPT
+  if (!probingDir.empty()) {
+    std::cerr << "creating ProbingPT table in " << probingDir << std::endl;
+    createProbingPT(fileNamePhraseTable.c_str(), probingDir.c_str(), "4", "false",
+                    threads, memory, tempPrefix);
+  }
+#endif
+}
@@ -24,6 +24,7 @@
 #include "tables-core.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
+#include "ExtractFile.h"
 #include "PhraseExtractionOptions.h"
 
 using namespace std;
@@ -93,14 +94,18 @@ public:
     Moses::OutputFileStream &extractFileInv,
     Moses::OutputFileStream &extractFileOrientation,
     Moses::OutputFileStream &extractFileContext,
-    Moses::OutputFileStream &extractFileContextInv):
+    Moses::OutputFileStream &extractFileContextInv,
+    ExtractFileWriter *extractWriter,
+    ExtractFileWriter *extractWriterInv):
     m_sentence(sentence),
     m_options(initoptions),
     m_extractFile(extractFile),
     m_extractFileInv(extractFileInv),
     m_extractFileOrientation(extractFileOrientation),
     m_extractFileContext(extractFileContext),
-    m_extractFileContextInv(extractFileContextInv) {}
+    m_extractFileContextInv(extractFileContextInv),
+    m_extractWriter(extractWriter),
+    m_extractWriterInv(extractWriterInv) {}
   void Run();
 private:
   vector< string > m_extractedPhrases;
@@ -109,9 +114,17 @@ private:
   vector< string > m_extractedPhrasesSid;
   vector< string > m_extractedPhrasesContext;
   vector< string > m_extractedPhrasesContextInv;
+  // with binary output, the phrase pairs instead of the lines of
+  // m_extractedPhrases and m_extractedPhrasesInv, and the word ids of the sentence
+  vector< ExtractRecord > m_records;
+  vector< ExtractRecord > m_recordsInv;
+  vector< uint32_t > m_sourceIds, m_targetIds;
+  vector< uint32_t > m_sourceIdsInv, m_targetIdsInv;
+  float m_weight;
   void extractBase(SentenceAlignment &);
   void extract(SentenceAlignment &);
   void addPhrase(SentenceAlignment &, int, int, int, int, string &);
+  void addRecords(SentenceAlignment &, int, int, int, int);
   void writePhrasesToFile();
   bool checkPlaceholders (const SentenceAlignment &sentence, int startE, int endE, int startF, int endF);
   bool isPlaceholder(const string &word);
@@ -123,6 +136,8 @@ private:
   Moses::OutputFileStream &m_extractFileOrientation;
   Moses::OutputFileStream &m_extractFileContext;
   Moses::OutputFileStream &m_extractFileContextInv;
+  ExtractFileWriter *m_extractWriter; // NULL unless binary output
+  ExtractFileWriter *m_extractWriterInv;
 };
 }
 
@@ -133,7 +148,7 @@ int main(int argc, char* argv[])
 
   if (argc < 6) {
     cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] ";
-    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ]\n";
+    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --BinaryOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ]\n";
     exit(1);
   }
 
@@ -167,6 +182,8 @@ int main(int argc, char* argv[])
       sentenceOffset = atoi(argv[++i]);
     } else if (strcmp(argv[i], "--GZOutput") == 0) {
       options.initGzOutput(true);
+    } else if (strcmp(argv[i], "--BinaryOutput") == 0) {
+      options.initBinaryOutput(true);
     } else if (strcmp(argv[i], "--InstanceWeights") == 0) {
       if (i+1 >= argc) {
         cerr << "extract: syntax error, used switch --InstanceWeights without file name" << endl;
@@ -262,10 +279,15 @@ int main(int argc, char* argv[])
   }
 
   // open output files
+  auto_ptr<ExtractFileWriter> extractWriter, extractWriterInv;
   if (options.isTranslationFlag()) {
     string fileNameExtractInv = fileNameExtract + ".inv" + (options.isGzOutput()?".gz":"");
     extractFile.Open( (fileNameExtract + (options.isGzOutput()?".gz":"")).c_str());
     extractFileInv.Open(fileNameExtractInv.c_str());
+    if (options.isBinaryOutput()) {
+      extractWriter.reset(new ExtractFileWriter(extractFile));
+      extractWriterInv.reset(new ExtractFileWriter(extractFileInv));
+    }
   }
   if (options.isOrientationFlag()) {
     string fileNameExtractOrientation = fileNameExtract + ".o" + (options.isGzOutput()?".gz":"");
@@ -310,7 +332,7 @@ int main(int argc, char* argv[])
       if (options.placeholders.size()) {
         sentence.invertAlignment();
       }
-      ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, extractFileContext, extractFileContextInv);
+      ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, extractFileContext, extractFileContextInv, extractWriter.get(), extractWriterInv.get());
       task->Run();
       delete task;
 
@@ -345,8 +367,28 @@ int main(int argc, char* argv[])
 
 namespace MosesTraining
 {
+// ids of the words of a sentence in a binary extract file
+void wordIds(ExtractFileWriter &writer, const vector<string> &words, vector<uint32_t> &ids)
+{
+  ids.resize(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    ids[i] = writer.WordId(words[i]);
+  }
+}
+
 void ExtractTask::Run()
 {
+  if (m_extractWriter) {
+    wordIds(*m_extractWriter, m_sentence.source, m_sourceIds);
+    wordIds(*m_extractWriter, m_sentence.target, m_targetIds);
+    wordIds(*m_extractWriterInv, m_sentence.source, m_sourceIdsInv);
+    wordIds(*m_extractWriterInv, m_sentence.target, m_targetIdsInv);
+    // the count, as score reads it from the text lines
+    m_weight = 1.0f;
+    if (m_options.getInstanceWeightsFile().length()) {
+      sscanf(m_sentence.weightString.c_str(), "%f", &m_weight);
+    }
+  }
   extract(m_sentence);
   writePhrasesToFile();
   m_extractedPhrases.clear();
@@ -355,6 +397,8 @@ void ExtractTask::Run()
   m_extractedPhrasesSid.clear();
   m_extractedPhrasesContext.clear();
   m_extractedPhrasesContextInv.clear();
+  m_records.clear();
+  m_recordsInv.clear();
 
 }
 
@@ -728,6 +772,12 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
     return;
   }
 
+  if (m_extractWriter && m_options.isTranslationFlag()) {
+    addRecords(sentence, startE, endE, startF, endF);
+  }
+  // text lines of the phrase pair, unless it went to the binary extract files
+  const bool translationText = m_options.isTranslationFlag() && !m_extractWriter;
+
   if (m_options.debug) {
     outextractstr << "sentenceID=" << sentence.sentenceID << " ";
     outextractstrInv << "sentenceID=" << sentence.sentenceID << " ";
@@ -735,32 +785,32 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
   }
 
   for(int fi=startF; fi<=endF; fi++) {
-    if (m_options.isTranslationFlag()) outextractstr << sentence.source[fi] << " ";
+    if (translationText) outextractstr << sentence.source[fi] << " ";
     if (m_options.isOrientationFlag()) outextractstrOrientation << sentence.source[fi] << " ";
   }
-  if (m_options.isTranslationFlag()) outextractstr << "||| ";
+  if (translationText) outextractstr << "||| ";
   if (m_options.isOrientationFlag()) outextractstrOrientation << "||| ";
 
   // target
   for(int ei=startE; ei<=endE; ei++) {
-    if (m_options.isTranslationFlag()) outextractstr << sentence.target[ei] << " ";
-    if (m_options.isTranslationFlag()) outextractstrInv << sentence.target[ei] << " ";
+    if (translationText) outextractstr << sentence.target[ei] << " ";
+    if (translationText) outextractstrInv << sentence.target[ei] << " ";
     if (m_options.isOrientationFlag()) outextractstrOrientation << sentence.target[ei] << " ";
   }
-  if (m_options.isTranslationFlag()) outextractstr << "|||";
-  if (m_options.isTranslationFlag()) outextractstrInv << "||| ";
+  if (translationText) outextractstr << "|||";
+  if (translationText) outextractstrInv << "||| ";
   if (m_options.isOrientationFlag()) outextractstrOrientation << "||| ";
 
   // source (for inverse)
 
-  if (m_options.isTranslationFlag()) {
+  if (translationText) {
     for(int fi=startF; fi<=endF; fi++)
       outextractstrInv << sentence.source[fi] << " ";
     outextractstrInv << "|||";
   }
 
   // alignment
-  if (m_options.isTranslationFlag()) {
+  if (translationText) {
     for(int ei=startE; ei<=endE; ei++) {
       for(unsigned int i=0; i<sentence.alignedToT[ei].size(); i++) {
         int fi = sentence.alignedToT[ei][i];
@@ -773,12 +823,12 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
   if (m_options.isOrientationFlag())
     outextractstrOrientation << orientationInfo;
 
-  if (m_options.isIncludeSentenceIdFlag()) {
+  if (!m_extractWriter && m_options.isIncludeSentenceIdFlag()) {
     outextractstr << " ||| " << sentence.sentenceID;
   }
 
   if (m_options.getInstanceWeightsFile().length()) {
-    if (m_options.isTranslationFlag()) {
+    if (translationText) {
       outextractstr << " ||| " << sentence.weightString;
       outextractstrInv << " ||| " << sentence.weightString;
     }
@@ -849,8 +899,8 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
     m_extractedPhrasesContextInv.push_back(outextractstrContextRightInv.str());
   }
 
-  if (m_options.isTranslationFlag()) outextractstr << "\n";
-  if (m_options.isTranslationFlag()) outextractstrInv << "\n";
+  if (translationText) outextractstr << "\n";
+  if (translationText) outextractstrInv << "\n";
   if (m_options.isOrientationFlag()) outextractstrOrientation << "\n";
 
 
@@ -860,6 +910,44 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
 }
 
 
+// The phrase pair for the binary extract files, with the fields that score
+// would read from its text lines.
+void ExtractTask::addRecords( SentenceAlignment &sentence, int startE, int endE, int startF, int endF )
+{
+  m_records.push_back(ExtractRecord());
+  m_recordsInv.push_back(ExtractRecord());
+  ExtractRecord &record = m_records.back();
+  ExtractRecord &recordInv = m_recordsInv.back();
+
+  if (m_options.debug) {
+    ostringstream sentenceId;
+    sentenceId << "sentenceID=" << sentence.sentenceID;
+    record.source.push_back(m_extractWriter->WordId(sentenceId.str()));
+    recordInv.source.push_back(m_extractWriterInv->WordId(sentenceId.str()));
+  }
+  record.source.insert(record.source.end(), m_sourceIds.begin() + startF, m_sourceIds.begin() + endF + 1);
+  record.target.assign(m_targetIds.begin() + startE, m_targetIds.begin() + endE + 1);
+  recordInv.source.insert(recordInv.source.end(), m_targetIdsInv.begin() + startE, m_targetIdsInv.begin() + endE + 1);
+  recordInv.target.assign(m_sourceIdsInv.begin() + startF, m_sourceIdsInv.begin() + endF + 1);
+
+  for(int ei=startE; ei<=endE; ei++) {
+    for(unsigned int i=0; i<sentence.alignedToT[ei].size(); i++) {
+      int fi = sentence.alignedToT[ei][i];
+      record.alignment.push_back(make_pair((uint32_t)(fi-startF), (uint32_t)(ei-startE)));
+      recordInv.alignment.push_back(make_pair((uint32_t)(ei-startE), (uint32_t)(fi-startF)));
+    }
+  }
+
+  // only the direct phrase pairs carry sentence ids
+  if (m_options.isIncludeSentenceIdFlag()) {
+    record.hasSentenceId = true;
+    record.sentenceId = sentence.sentenceID;
+  }
+  record.count = m_weight;
+  recordInv.count = m_weight;
+}
+
+
 void ExtractTask::writePhrasesToFile()
 {
 
@@ -885,8 +973,15 @@ void ExtractTask::writePhrasesToFile()
     outextractFileContextInv<<phrase->data();
   }
 
-  m_extractFile << outextractFile.str();
-  m_extractFileInv  << outextractFileInv.str();
+  if (m_extractWriter) {
+    for (size_t i = 0; i < m_records.size(); ++i) {
+      m_extractWriter->Write(m_records[i]);
+      m_extractWriterInv->Write(m_recordsInv[i]);
+    }
+  } else {
+    m_extractFile << outextractFile.str();
+    m_extractFileInv  << outextractFileInv.str();
+  }
   m_extractFileOrientation << outextractFileOrientation.str();
   if (m_options.isFlexScoreFlag()) {
     m_extractFileContext  << outextractFileContext.str();
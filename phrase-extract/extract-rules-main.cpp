@@ -30,6 +30,7 @@
 #include <string>
 #include <vector>
 #include <limits>
+#include <memory>
 
 #ifdef WIN32
 // Include Visual Leak Detector
@@ -44,6 +45,7 @@
 #include "SyntaxNode.h"
 #include "tables-core.h"
 #include "XmlTree.h"
+#include "ExtractFile.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 
@@ -62,6 +64,8 @@ private:
   Moses::OutputFileStream& m_extractFileInv;
   Moses::OutputFileStream& m_extractFileContext;
   Moses::OutputFileStream& m_extractFileContextInv;
+  ExtractFileWriter *m_extractWriter; // NULL unless binary output
+  ExtractFileWriter *m_extractWriterInv;
 
   vector< ExtractedRule > m_extractedRules;
 
@@ -70,6 +74,7 @@ private:
   void addRuleToCollection(ExtractedRule &rule);
   void consolidateRules();
   void writeRulesToFile();
+  void writeRecords(const ExtractedRule &rule);
 
   // subs
   void addRule( int, int, int, int, int, RuleExist &ruleExist);
@@ -94,13 +99,15 @@ private:
   }
 
 public:
-  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv, Moses::OutputFileStream &extractFileContext, Moses::OutputFileStream &extractFileContextInv):
+  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv, Moses::OutputFileStream &extractFileContext, Moses::OutputFileStream &extractFileContextInv, ExtractFileWriter *extractWriter, ExtractFileWriter *extractWriterInv):
     m_sentence(sentence),
     m_options(options),
     m_extractFile(extractFile),
     m_extractFileInv(extractFileInv),
     m_extractFileContext(extractFileContext),
-    m_extractFileContextInv(extractFileContextInv) {}
+    m_extractFileContextInv(extractFileContextInv),
+    m_extractWriter(extractWriter),
+    m_extractWriterInv(extractWriterInv) {}
   void Run();
 
 };
@@ -140,6 +147,7 @@ int main(int argc, char* argv[])
          << " | --SourceSyntax | --TargetSyntax"
          << " | --AllowOnlyUnalignedWords | --DisallowNonTermConsecTarget |--NonTermConsecSource |  --NoNonTermFirstWord | --NoFractionalCounting"
          << " | --UnpairedExtractFormat"
+         << " | --BinaryOutput"
          << " | --ConditionOnTargetLHS ]"
          << " | --BoundaryRules[" << options.boundaryRules << "]"
          << " | --FlexibilityScore\n";
@@ -217,6 +225,8 @@ int main(int argc, char* argv[])
       }
     } else if (strcmp(argv[i], "--GZOutput") == 0) {
       options.gzOutput = true;
+    } else if (strcmp(argv[i], "--BinaryOutput") == 0) {
+      options.binaryOutput = true;
     }
     // allow consecutive non-terminals (X Y | X Y)
     else if (strcmp(argv[i],"--TargetSyntax") == 0) {
@@ -310,6 +320,12 @@ int main(int argc, char* argv[])
   extractFile.Open((fileNameExtract  + (options.gzOutput?".gz":"")).c_str());
   if (!options.onlyDirectFlag)
     extractFileInv.Open(fileNameExtractInv.c_str());
+  auto_ptr<ExtractFileWriter> extractWriter, extractWriterInv;
+  if (options.binaryOutput) {
+    extractWriter.reset(new ExtractFileWriter(extractFile));
+    if (!options.onlyDirectFlag)
+      extractWriterInv.reset(new ExtractFileWriter(extractFileInv));
+  }
 
   if (options.flexScoreFlag) {
     string fileNameExtractContext = fileNameExtract + ".context" + (options.gzOutput?".gz":"");
@@ -351,7 +367,7 @@ int main(int argc, char* argv[])
       if (options.unknownWordLabelFlag) {
         collectWordLabelCounts(sentence);
       }
-      ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv, extractFileContext, extractFileContextInv);
+      ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv, extractFileContext, extractFileContextInv, extractWriter.get(), extractWriterInv.get());
       task->Run();
       delete task;
     }
@@ -641,6 +657,7 @@ void ExtractTask::saveHieroAlignment( int startT, int endT, int startS, int endS
         std::string sourceSymbolIndex = IntToString(indexS.find(si)->second);
         std::string targetSymbolIndex = IntToString(p->second);
         rule.alignment      += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
+        rule.alignmentPoints.push_back(make_pair(indexS.find(si)->second, p->second));
         if (! m_options.onlyDirectFlag)
           rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
       }
@@ -655,6 +672,7 @@ void ExtractTask::saveHieroAlignment( int startT, int endT, int startS, int endS
     std::string sourceSymbolIndex = IntToString(hole.GetPos(0));
     std::string targetSymbolIndex = IntToString(hole.GetPos(1));
     rule.alignment      += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
+    rule.alignmentPoints.push_back(make_pair(hole.GetPos(0), hole.GetPos(1)));
     if (!m_options.onlyDirectFlag)
       rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
   }
@@ -985,6 +1003,7 @@ void ExtractTask::addRule( int startT, int endT, int startS, int endS, int count
       std::string sourceSymbolIndex = IntToString(si-startS);
       std::string targetSymbolIndex = IntToString(ti-startT);
       rule.alignment += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
+      rule.alignmentPoints.push_back(make_pair(si-startS, ti-startT));
       if (!m_options.onlyDirectFlag)
         rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
     }
@@ -1063,20 +1082,24 @@ void ExtractTask::writeRulesToFile()
     if (rule->count == 0)
       continue;
 
-    out << rule->source << " ||| "
-        << rule->target << " ||| "
-        << rule->alignment << " ||| "
-        << rule->count << " ||| ";
-    if (m_options.pcfgScore) {
-      out << " ||| " << rule->pcfgScore;
-    }
-    out << "\n";
+    if (m_extractWriter) {
+      writeRecords(*rule);
+    } else {
+      out << rule->source << " ||| "
+          << rule->target << " ||| "
+          << rule->alignment << " ||| "
+          << rule->count << " ||| ";
+      if (m_options.pcfgScore) {
+        out << rule->pcfgScore;
+      }
+      out << "\n";
 
-    if (!m_options.onlyDirectFlag) {
-      outInv << rule->target << " ||| "
-             << rule->source << " ||| "
-             << rule->alignmentInv << " ||| "
-             << rule->count << "\n";
+      if (!m_options.onlyDirectFlag) {
+        outInv << rule->target << " ||| "
+               << rule->source << " ||| "
+               << rule->alignmentInv << " ||| "
+               << rule->count << "\n";
+      }
     }
 
     if (m_options.flexScoreFlag) {
@@ -1115,6 +1138,50 @@ void ExtractTask::writeRulesToFile()
   m_extractFileContextInv << outContextInv.str();
 }
 
+// ids of the words of a rule's source or target, which are separated by spaces
+void phraseIds(ExtractFileWriter &writer, const string &phrase, vector<uint32_t> &ids)
+{
+  ids.clear();
+  size_t start = 0, end;
+  do {
+    end = phrase.find(' ', start);
+    if (end != start) {
+      ids.push_back(writer.WordId(phrase.substr(start, end - start)));
+    }
+    start = end + 1;
+  } while (end != string::npos);
+}
+
+// The rule for the binary extract files, with the fields of its text lines.
+void ExtractTask::writeRecords(const ExtractedRule &rule)
+{
+  ExtractRecord record;
+  phraseIds(*m_extractWriter, rule.source, record.source);
+  phraseIds(*m_extractWriter, rule.target, record.target);
+  for (size_t i = 0; i < rule.alignmentPoints.size(); ++i) {
+    record.alignment.push_back(make_pair((uint32_t)rule.alignmentPoints[i].first,
+                                         (uint32_t)rule.alignmentPoints[i].second));
+  }
+  record.count = rule.count;
+  if (m_options.pcfgScore) {
+    record.hasPcfgScore = true;
+    record.pcfgScore = rule.pcfgScore;
+  }
+  m_extractWriter->Write(record);
+
+  if (m_extractWriterInv) {
+    record.Clear();
+    phraseIds(*m_extractWriterInv, rule.target, record.source);
+    phraseIds(*m_extractWriterInv, rule.source, record.target);
+    for (size_t i = 0; i < rule.alignmentPoints.size(); ++i) {
+      record.alignment.push_back(make_pair((uint32_t)rule.alignmentPoints[i].second,
+                                           (uint32_t)rule.alignmentPoints[i].first));
+    }
+    record.count = rule.count;
+    m_extractWriterInv->Write(record);
+  }
+}
+
 void writeGlueGrammar( const string & fileName, RuleExtractionOptions &options, set< string > &targetLabelCollection, map< string, int > &targetTopLabelCollection )
 {
   ofstream grammarFile;
@@ -74,9 +74,20 @@ protected:
     return traits_type::to_int_type(*gptr());
   }
 
+  // read multiple characters: what is left in _buff first, then the file
   std::streamsize xsgetn (char* s,
                           std::streamsize num) {
-    return gzread(_gzf,s,num);
+    std::streamsize buffered = egptr() - gptr();
+    if (buffered > num) {
+      buffered = num;
+    }
+    std::memcpy(s, gptr(), buffered);
+    gbump(buffered);
+    if (buffered == num) {
+      return num;
+    }
+    int read = gzread(_gzf, s+buffered, num-buffered);
+    return buffered + (read > 0 ? read : 0);
   }
 
 private:
@@ -21,21 +21,31 @@
 #include <assert.h>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <map>
 #include <set>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/unordered_map.hpp>
 
 #include "ScoreFeature.h"
 #include "tables-core.h"
 #include "ExtractionPhrasePair.h"
+#include "ExtractFile.h"
 #include "score.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 
 #include "moses/Util.h"
+#include "moses/ThreadPool.h"
+
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#endif
 
 using namespace boost::algorithm;
 using namespace MosesTraining;
@@ -69,8 +79,28 @@ bool ruleLength = false;
 bool nonTermContext = false;
 bool nonTermContextTarget = false;
 
-int countOfCounts[COC_MAX+1];
-int totalDistinct = 0;
+// count of counts statistics for Good Turing and Kneser Ney discounting
+struct CountOfCounts {
+  int counts[COC_MAX+1];
+  int totalDistinct;
+
+  CountOfCounts() : totalDistinct(0) {
+    std::fill(counts, counts+COC_MAX+1, 0);
+  }
+  void Add(float count) {
+    totalDistinct++;
+    int countInt = count + 0.99999;
+    if ((countInt <= COC_MAX) &&
+        (countInt > 0))
+      counts[ countInt ]++;
+  }
+  void Add(const CountOfCounts &other) {
+    totalDistinct += other.totalDistinct;
+    for(int i=1; i<=COC_MAX; i++) counts[i] += other.counts[i];
+  }
+};
+
+CountOfCounts countOfCounts;
 float minCount = 0;
 float minCountHierarchical = 0;
 bool phraseOrientationPriorsFlag = false;
@@ -94,24 +124,49 @@ std::vector<float> orientationClassPriorsR2L(4,0); // mono swap dleft dright
 
 Vocabulary vcbT;
 Vocabulary vcbS;
+WORD_ID nullWordId = 0;
+
+#ifdef WITH_THREADS
+// Scoring threads look up words in vcbS and vcbT while the main thread adds
+// new ones. Adding a word only moves the others if the vocabulary has to
+// grow, which waits until no batch is being scored (see storeWord()).
+boost::shared_mutex vocabularyMutex;
+// guards the label sets and counts collected by outputPhrasePair()
+boost::mutex labelMutex;
+#endif
+
+// vocabulary ids of the words of a binary extract file, looked up on first use
+struct ExtractFileIds {
+  std::vector<WORD_ID> source;
+  std::vector<WORD_ID> target;
+};
 
 } // namespace
 
 
+bool readPhrasePair( std::istream &extractFile, ExtractFileReader *binaryExtractFile, std::string &line );
 void processLine( std::string line,
                   int lineID, bool includeSentenceIdFlag, int &sentenceId,
                   PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
                   std::string &additionalPropertiesString,
                   float &count, float &pcfgSum );
+void processRecord( const ExtractFileReader &binaryExtractFile, ExtractFileIds &ids,
+                    int lineID, int &sentenceId,
+                    PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
+                    std::string &additionalPropertiesString,
+                    float &count, float &pcfgSum );
 void writeCountOfCounts( const std::string &fileNameCountOfCounts );
 void writeLeftHandSideLabelCounts( const boost::unordered_map<std::string,float> &countsLabelLHS,
                                    const boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > &jointCountsLabelLHS,
                                    const std::string &fileNameLeftHandSideSourceLabelCounts,
                                    const std::string &fileNameLeftHandSideTargetSourceLabelCounts );
 void writeLabelSet( const std::set<std::string> &labelSet, const std::string &fileName );
+WORD_ID storeWord( Vocabulary &vcb, const WORD &word );
 void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource, std::ostream &phraseTableFile,
-                         const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb );
-void outputPhrasePair(const ExtractionPhrasePair &phrasePair, float, int, std::ostream &phraseTableFile, const ScoreFeatureManager &featureManager, const MaybeLog &maybeLog );
+                         const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb,
+                         CountOfCounts &countOfCounts );
+void outputPhrasePair(const ExtractionPhrasePair &phrasePair, float, int, std::ostream &phraseTableFile, const ScoreFeatureManager &featureManager, const MaybeLog &maybeLog, CountOfCounts &countOfCounts );
+void deletePhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairs );
 double computeLexicalTranslation( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *alignmentTargetToSource );
 double computeUnalignedPenalty( const ALIGNMENT *alignmentTargetToSource );
 std::set<std::string> functionWordList;
@@ -124,6 +179,118 @@ void printTargetPhrase( const PHRASE *phraseSource, const PHRASE *phraseTarget,
 void invertAlignment( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *inTargetToSourceAlignment, ALIGNMENT *outSourceToTargetAlignment );
 size_t NumNonTerminal(const PHRASE *phraseSource);
 
+#ifdef WITH_THREADS
+// Phrase pairs of one or more source phrases, scored together by one thread.
+class PhrasePairBatch : public Moses::Task
+{
+public:
+  PhrasePairBatch( const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb )
+    : m_featureManager(featureManager)
+    , m_maybeLogProb(maybeLogProb)
+    , m_size(0)
+    , m_done(false) {
+  }
+
+  ~PhrasePairBatch() {
+    for (size_t i = 0; i < m_phrasePairs.size(); ++i) {
+      deletePhrasePairs( m_phrasePairs[i] );
+    }
+  }
+
+  // Takes over phrase pairs with the same source, leaving the vector empty.
+  void Add( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource ) {
+    m_size += phrasePairsWithSameSource.size();
+    m_phrasePairs.push_back( std::vector< ExtractionPhrasePair* >() );
+    m_phrasePairs.back().swap( phrasePairsWithSameSource );
+  }
+
+  size_t Size() const {
+    return m_size;
+  }
+
+  void Run() {
+    {
+      boost::shared_lock<boost::shared_mutex> lock(vocabularyMutex);
+      for (size_t i = 0; i < m_phrasePairs.size(); ++i) {
+        processPhrasePairs( m_phrasePairs[i], m_output, m_featureManager, m_maybeLogProb, m_countOfCounts );
+        deletePhrasePairs( m_phrasePairs[i] );
+      }
+    }
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_done = true;
+    m_scored.notify_all();
+  }
+
+  // Waits until the batch has been scored, then writes it.
+  void Write( std::ostream &phraseTableFile, CountOfCounts &countOfCounts ) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_done) {
+        m_scored.wait(lock);
+      }
+    }
+    phraseTableFile << m_output.str();
+    countOfCounts.Add( m_countOfCounts );
+  }
+
+private:
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLogProb;
+  std::vector< std::vector< ExtractionPhrasePair* > > m_phrasePairs;
+  size_t m_size;
+  std::ostringstream m_output;
+  CountOfCounts m_countOfCounts;
+  bool m_done;
+  boost::mutex m_mutex;
+  boost::condition_variable m_scored;
+};
+#endif
+
+// Scores the phrase pairs of the extract file, a source phrase at a time.
+// With more than one thread, the main thread goes on reading the extract
+// file while a thread pool scores batches of source phrases, and a writer
+// thread writes the batches in the order of the extract file. The output is
+// the same as with one thread.
+class PhrasePairScorer
+{
+public:
+  PhrasePairScorer( std::ostream &phraseTableFile,
+                    const ScoreFeatureManager &featureManager,
+                    const MaybeLog &maybeLogProb,
+                    size_t threads );
+  ~PhrasePairScorer() {
+    Finish();
+  }
+
+  // Scores and deletes phrase pairs with the same source, leaving the vector
+  // empty.
+  void Add( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource );
+
+  // Waits until everything added has been written.
+  void Finish();
+
+private:
+  std::ostream &m_phraseTableFile;
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLogProb;
+#ifdef WITH_THREADS
+  static const size_t phrasePairsPerBatch = 10000;
+
+  size_t m_threads;
+  Moses::ThreadPool *m_pool;
+  boost::thread *m_writer;
+  boost::shared_ptr<PhrasePairBatch> m_batch;
+  // submitted batches, in the order of the extract file, that are not yet written
+  std::deque< boost::shared_ptr<PhrasePairBatch> > m_batches;
+  bool m_finished;
+  boost::mutex m_mutex;
+  boost::condition_variable m_batchesChanged;
+
+  void Submit();
+  void Write();
+#endif
+};
+
 
 int main(int argc, char* argv[])
 {
@@ -153,7 +320,8 @@ int main(int argc, char* argv[])
               "[--TargetPreferenceLabels] "
               "[--UnpairedExtractFormat] "
               "[--ConditionOnTargetLHS] "
-              "[--CrossedNonTerm]"
+              "[--CrossedNonTerm] "
+              "[--Threads n]"
               << std::endl;
     std::cerr << featureManager.usage() << std::endl;
     exit(1);
@@ -171,6 +339,7 @@ int main(int argc, char* argv[])
   std::string fileNameLeftHandSideTargetPreferenceLabelCounts;
   std::string fileNameLeftHandSideRuleTargetTargetPreferenceLabelCounts;
   std::string fileNamePhraseOrientationPriors;
+  size_t threads = 1;
   // All unknown args are passed to feature manager.
   std::vector<std::string> featureArgs;
 
@@ -282,6 +451,18 @@ int main(int argc, char* argv[])
     } else if (strcmp(argv[i],"--NonTermContextTarget") == 0) {
       nonTermContextTarget = true;
       std::cerr << "non-term context (target)" << std::endl;
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      if (i+1==argc) {
+        std::cerr << "ERROR: specify the number of threads!" << std::endl;
+        exit(1);
+      }
+#ifdef WITH_THREADS
+      threads = std::max(1, atoi(argv[++i]));
+      std::cerr << "scoring with " << threads << " threads" << std::endl;
+#else
+      std::cerr << "thread support not compiled in." << std::endl;
+      exit(1);
+#endif
     } else {
       featureArgs.push_back(argv[i]);
       ++i;
@@ -302,6 +483,7 @@ int main(int argc, char* argv[])
   // lexical translation table
   if (lexFlag) {
     lexTable.load( fileNameLex );
+    nullWordId = vcbS.getWordID("NULL");
   }
 
   // function word list
@@ -309,16 +491,11 @@ int main(int argc, char* argv[])
     loadFunctionWords( fileNameFunctionWords );
   }
 
-  // compute count of counts for Good Turing discounting
-  if (goodTuringFlag || kneserNeyFlag) {
-    for(int i=1; i<=COC_MAX; i++) countOfCounts[i] = 0;
-  }
-
   if (phraseOrientationPriorsFlag) {
     loadOrientationPriors(fileNamePhraseOrientationPriors,orientationClassPriorsL2R,orientationClassPriorsR2L);
   }
 
-  // sorted phrase extraction file
+  // sorted phrase extraction file, text or binary (see ExtractFile.h)
   Moses::InputFileStream extractFile(fileNameExtract);
 
   if (extractFile.fail()) {
@@ -326,6 +503,13 @@ int main(int argc, char* argv[])
     exit(1);
   }
 
+  ExtractFileReader *binaryExtractFile = NULL;
+  ExtractFileIds extractFileIds;
+  if (ExtractFileReader::IsExtractFile(fileNameExtract)) {
+    std::cerr << "reading binary extract file" << std::endl;
+    binaryExtractFile = new ExtractFileReader(extractFile);
+  }
+
   // output file: phrase translation table
   std::ostream *phraseTableFile;
 
@@ -341,6 +525,7 @@ int main(int argc, char* argv[])
     }
     phraseTableFile = outputFile;
   }
+  PhrasePairScorer scorer( *phraseTableFile, featureManager, maybeLogProb, threads );
 
   // loop through all extracted phrase translations
   std::string line, lastLine;
@@ -355,16 +540,24 @@ int main(int argc, char* argv[])
   float tmpCount=0.0f, tmpPcfgSum=0.0f;
 
   int i=0;
-  if ( getline(extractFile, line) ) {
+  if ( readPhrasePair(extractFile, binaryExtractFile, line) ) {
     ++i;
     tmpPhraseSource = new PHRASE();
     tmpPhraseTarget = new PHRASE();
     tmpTargetToSourceAlignment = new ALIGNMENT();
-    processLine( std::string(line),
-                 i, featureManager.includeSentenceId(), tmpSentenceId,
-                 tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
-                 tmpAdditionalPropertiesString,
-                 tmpCount, tmpPcfgSum);
+    if (binaryExtractFile) {
+      processRecord( *binaryExtractFile, extractFileIds,
+                     i, tmpSentenceId,
+                     tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
+                     tmpAdditionalPropertiesString,
+                     tmpCount, tmpPcfgSum);
+    } else {
+      processLine( std::string(line),
+                   i, featureManager.includeSentenceId(), tmpSentenceId,
+                   tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
+                   tmpAdditionalPropertiesString,
+                   tmpCount, tmpPcfgSum);
+    }
     phrasePair = new ExtractionPhrasePair( tmpPhraseSource, tmpPhraseTarget,
                                            tmpTargetToSourceAlignment,
                                            tmpCount, tmpPcfgSum );
@@ -377,7 +570,7 @@ int main(int argc, char* argv[])
     lastLine = line;
   }
 
-  while ( getline(extractFile, line) ) {
+  while ( readPhrasePair(extractFile, binaryExtractFile, line) ) {
 
     // Print progress dots to stderr.
     if ( ++i % 100000 == 0 ) {
@@ -396,11 +589,19 @@ int main(int argc, char* argv[])
     tmpPhraseTarget = new PHRASE();
     tmpTargetToSourceAlignment = new ALIGNMENT();
     tmpAdditionalPropertiesString.clear();
-    processLine( std::string(line),
-                 i, featureManager.includeSentenceId(), tmpSentenceId,
-                 tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
-                 tmpAdditionalPropertiesString,
-                 tmpCount, tmpPcfgSum);
+    if (binaryExtractFile) {
+      processRecord( *binaryExtractFile, extractFileIds,
+                     i, tmpSentenceId,
+                     tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
+                     tmpAdditionalPropertiesString,
+                     tmpCount, tmpPcfgSum);
+    } else {
+      processLine( std::string(line),
+                   i, featureManager.includeSentenceId(), tmpSentenceId,
+                   tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
+                   tmpAdditionalPropertiesString,
+                   tmpCount, tmpPcfgSum);
+    }
 
     bool matchesPrevious = false;
     bool sourceMatch = true;
@@ -439,12 +640,7 @@ int main(int argc, char* argv[])
 
       if ( !phrasePairsWithSameSource.empty() &&
            !sourceMatch ) {
-        processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
-        for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
-              iter!=phrasePairsWithSameSource.end(); ++iter) {
-          delete *iter;
-        }
-        phrasePairsWithSameSource.clear();
+        scorer.Add( phrasePairsWithSameSource );
         if ( hierarchicalFlag ) {
           phrasePairsWithSameSourceAndTarget.clear();
         }
@@ -474,12 +670,9 @@ int main(int argc, char* argv[])
   // We've been printing progress dots to stderr.  End the line.
   std::cerr << std::endl;
 
-  processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
-  for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
-        iter!=phrasePairsWithSameSource.end(); ++iter) {
-    delete *iter;
-  }
-  phrasePairsWithSameSource.clear();
+  scorer.Add( phrasePairsWithSameSource );
+  scorer.Finish();
+  delete binaryExtractFile;
 
 
   phraseTableFile->flush();
@@ -519,74 +712,127 @@ int main(int argc, char* argv[])
 }
 
 
+// For binary extract files, line is the encoded phrase pair, which is the
+// same for phrase pairs that are the same, as with text lines.
+bool readPhrasePair( std::istream &extractFile, ExtractFileReader *binaryExtractFile, std::string &line )
+{
+  if (binaryExtractFile) {
+    if (!binaryExtractFile->Read()) {
+      return false;
+    }
+    line = binaryExtractFile->Payload();
+    return true;
+  }
+  return (bool)getline(extractFile, line);
+}
+
+
+// The fields of a phrase pair other than its words, which are the same for
+// text and binary extract files.
+void processFields( const ExtractRecord &record, int lineID, int &sentenceId,
+                    PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
+                    std::string &additionalPropertiesString,
+                    float &count, float &pcfgSum )
+{
+  targetToSourceAlignment->clear();
+
+  size_t numberOfTargetSymbols = (hierarchicalFlag ? phraseTarget->size()-1 : phraseTarget->size());
+  for ( size_t j=0; j<record.alignment.size(); ++j ) {
+    size_t s = record.alignment[j].first;
+    size_t t = record.alignment[j].second;
+    if (t >= phraseTarget->size() || s >= phraseSource->size()) {
+      std::cerr << "WARNING: phrase pair " << lineID
+                << " has alignment point (" << (int)s << ", " << (int)t << ")"
+                << " out of bounds (" << phraseSource->size() << ", " << phraseTarget->size() << ")"
+                << std::endl;
+    } else {
+      // first alignment point? -> initialize
+      if ( targetToSourceAlignment->size() == 0 ) {
+        targetToSourceAlignment->resize(numberOfTargetSymbols);
+      }
+      // add alignment point
+      targetToSourceAlignment->at(t).insert(s);
+    }
+  }
+  if ( targetToSourceAlignment->size() == 0 ) {
+    targetToSourceAlignment->resize(numberOfTargetSymbols);
+  }
+
+  if (record.hasSentenceId) {
+    sentenceId = record.sentenceId;
+  }
+  count = record.count;
+  if (record.hasPcfgScore) {
+    pcfgSum = record.pcfgScore * count;
+  }
+  additionalPropertiesString = record.properties;
+}
+
+
 void processLine( std::string line,
                   int lineID, bool includeSentenceIdFlag, int &sentenceId,
                   PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
                   std::string &additionalPropertiesString,
                   float &count, float &pcfgSum )
 {
-  size_t foundAdditionalProperties = line.rfind("|||");
-  foundAdditionalProperties = line.find("{{",foundAdditionalProperties);
-  if (foundAdditionalProperties != std::string::npos) {
-    additionalPropertiesString = line.substr(foundAdditionalProperties);
-    line = line.substr(0,foundAdditionalProperties);
-  } else {
-    additionalPropertiesString.clear();
+  ExtractRecord record;
+  std::vector<std::string> source, target;
+  if (!ParseExtractLine( line, includeSentenceIdFlag, source, target, record )) {
+    std::cerr << "ERROR: faulty line " << lineID << ": " << line << std::endl;
   }
 
   phraseSource->clear();
   phraseTarget->clear();
-  targetToSourceAlignment->clear();
-
-  std::vector<std::string> token;
-  Moses::Tokenize( token, line );
-  int item = 1;
-  for ( size_t j=0; j<token.size(); ++j ) {
-    if (token[j] == "|||") {
-      ++item;
-    } else if (item == 1) { // source phrase
-      phraseSource->push_back( vcbS.storeIfNew( token[j] ) );
-    } else if (item == 2) { // target phrase
-      phraseTarget->push_back( vcbT.storeIfNew( token[j] ) );
-    } else if (item == 3) { // alignment
-      int s,t;
-      sscanf(token[j].c_str(), "%d-%d", &s, &t);
-      if ((size_t)t >= phraseTarget->size() || (size_t)s >= phraseSource->size()) {
-        std::cerr << "WARNING: phrase pair " << lineID
-                  << " has alignment point (" << s << ", " << t << ")"
-                  << " out of bounds (" << phraseSource->size() << ", " << phraseTarget->size() << ")"
-                  << std::endl;
-      } else {
-        // first alignment point? -> initialize
-        if ( targetToSourceAlignment->size() == 0 ) {
-          size_t numberOfTargetSymbols = (hierarchicalFlag ? phraseTarget->size()-1 : phraseTarget->size());
-          targetToSourceAlignment->resize(numberOfTargetSymbols);
-        }
-        // add alignment point
-        targetToSourceAlignment->at(t).insert(s);
-      }
-    } else if (includeSentenceIdFlag && item == 4) { // optional sentence id
-      sscanf(token[j].c_str(), "%d", &sentenceId);
-    } else if (item + (includeSentenceIdFlag?-1:0) == 4) { // count
-      sscanf(token[j].c_str(), "%f", &count);
-    } else if (item + (includeSentenceIdFlag?-1:0) == 5) { // target syntax PCFG score
-      float pcfgScore = std::atof( token[j].c_str() );
-      pcfgSum = pcfgScore * count;
-    }
+  for ( size_t j=0; j<source.size(); ++j ) {
+    phraseSource->push_back( storeWord( vcbS, source[j] ) );
+  }
+  for ( size_t j=0; j<target.size(); ++j ) {
+    phraseTarget->push_back( storeWord( vcbT, target[j] ) );
   }
 
-  if ( targetToSourceAlignment->size() == 0 ) {
-    size_t numberOfTargetSymbols = (hierarchicalFlag ? phraseTarget->size()-1 : phraseTarget->size());
-    targetToSourceAlignment->resize(numberOfTargetSymbols);
+  processFields( record, lineID, sentenceId,
+                 phraseSource, phraseTarget, targetToSourceAlignment,
+                 additionalPropertiesString, count, pcfgSum );
+}
+
+
+WORD_ID lookupWord( Vocabulary &vcb, std::vector<WORD_ID> &ids,
+                    const std::vector<std::string> &words, uint32_t id )
+{
+  const WORD_ID unknown = std::numeric_limits<WORD_ID>::max();
+  if (ids.size() < words.size()) {
+    ids.resize(words.size(), unknown);
+  }
+  if (ids[id] == unknown) {
+    ids[id] = storeWord( vcb, words[id] );
   }
+  return ids[id];
+}
+
+
+// The same as processLine(), for a phrase pair of a binary extract file,
+// which has been split into its fields when it was written.
+void processRecord( const ExtractFileReader &binaryExtractFile, ExtractFileIds &ids,
+                    int lineID, int &sentenceId,
+                    PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
+                    std::string &additionalPropertiesString,
+                    float &count, float &pcfgSum )
+{
+  const ExtractRecord &record = binaryExtractFile.Record();
+  const std::vector<std::string> &words = binaryExtractFile.Words();
 
-  if (item + (includeSentenceIdFlag?-1:0) == 3) {
-    count = 1.0;
+  phraseSource->clear();
+  phraseTarget->clear();
+  for ( size_t j=0; j<record.source.size(); ++j ) {
+    phraseSource->push_back( lookupWord( vcbS, ids.source, words, record.source[j] ) );
   }
-  if (item < 3 || item > (includeSentenceIdFlag?7:6)) {
-    std::cerr << "ERROR: faulty line " << lineID << ": " << line << std::endl;
+  for ( size_t j=0; j<record.target.size(); ++j ) {
+    phraseTarget->push_back( lookupWord( vcbT, ids.target, words, record.target[j] ) );
   }
 
+  processFields( record, lineID, sentenceId,
+                 phraseSource, phraseTarget, targetToSourceAlignment,
+                 additionalPropertiesString, count, pcfgSum );
 }
 
 
@@ -602,11 +848,11 @@ void writeCountOfCounts( const std::string &fileNameCountOfCounts )
   }
 
   // Kneser-Ney needs the total number of phrase pairs
-  countOfCountsFile << totalDistinct << std::endl;
+  countOfCountsFile << countOfCounts.totalDistinct << std::endl;
 
   // write out counts
   for(int i=1; i<=COC_MAX; i++) {
-    countOfCountsFile << countOfCounts[ i ] << std::endl;
+    countOfCountsFile << countOfCounts.counts[ i ] << std::endl;
   }
   countOfCountsFile.Close();
 }
@@ -676,8 +922,139 @@ void writeLabelSet( const std::set<std::string> &labelSet, const std::string &fi
 }
 
 
+WORD_ID storeWord( Vocabulary &vcb, const WORD &word )
+{
+#ifdef WITH_THREADS
+  if (vcb.vocab.size() == vcb.vocab.capacity()) {
+    boost::unique_lock<boost::shared_mutex> lock(vocabularyMutex);
+    vcb.vocab.reserve( 2*vcb.vocab.capacity() + 1024 );
+  }
+#endif
+  return vcb.storeIfNew( word );
+}
+
+
+void deletePhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairs )
+{
+  for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairs.begin();
+        iter!=phrasePairs.end(); ++iter) {
+    delete *iter;
+  }
+  phrasePairs.clear();
+}
+
+
+PhrasePairScorer::PhrasePairScorer( std::ostream &phraseTableFile,
+                                    const ScoreFeatureManager &featureManager,
+                                    const MaybeLog &maybeLogProb,
+                                    size_t threads )
+  : m_phraseTableFile(phraseTableFile)
+  , m_featureManager(featureManager)
+  , m_maybeLogProb(maybeLogProb)
+#ifdef WITH_THREADS
+  , m_threads(threads)
+  , m_pool(NULL)
+  , m_writer(NULL)
+  , m_finished(false)
+#endif
+{
+#ifdef WITH_THREADS
+  if (threads > 1) {
+    m_pool = new Moses::ThreadPool(threads);
+    m_writer = new boost::thread(boost::bind(&PhrasePairScorer::Write, this));
+  }
+#endif
+}
+
+void PhrasePairScorer::Add( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource )
+{
+  if (phrasePairsWithSameSource.empty()) {
+    return;
+  }
+#ifdef WITH_THREADS
+  if (m_pool) {
+    if (!m_batch) {
+      m_batch.reset( new PhrasePairBatch(m_featureManager, m_maybeLogProb) );
+    }
+    m_batch->Add( phrasePairsWithSameSource );
+    if (m_batch->Size() >= phrasePairsPerBatch) {
+      Submit();
+    }
+    return;
+  }
+#endif
+  processPhrasePairs( phrasePairsWithSameSource, m_phraseTableFile, m_featureManager, m_maybeLogProb, countOfCounts );
+  deletePhrasePairs( phrasePairsWithSameSource );
+}
+
+void PhrasePairScorer::Finish()
+{
+#ifdef WITH_THREADS
+  if (!m_pool) {
+    return;
+  }
+  if (m_batch) {
+    Submit();
+  }
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_finished = true;
+    m_batchesChanged.notify_all();
+  }
+  m_writer->join();
+  delete m_writer;
+  m_writer = NULL;
+  m_pool->Stop(true);
+  delete m_pool;
+  m_pool = NULL;
+#endif
+}
+
+#ifdef WITH_THREADS
+void PhrasePairScorer::Submit()
+{
+  {
+    // bound the memory held by batches that are waiting to be written
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_batches.size() >= 4*m_threads) {
+      m_batchesChanged.wait(lock);
+    }
+    m_batches.push_back(m_batch);
+    m_batchesChanged.notify_all();
+  }
+  m_pool->Submit(m_batch);
+  m_batch.reset();
+}
+
+void PhrasePairScorer::Write()
+{
+  while (true) {
+    boost::shared_ptr<PhrasePairBatch> batch;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_batches.empty() && !m_finished) {
+        m_batchesChanged.wait(lock);
+      }
+      if (m_batches.empty()) {
+        return;
+      }
+      batch = m_batches.front();
+    }
+    // only this thread adds to the global count of counts
+    batch->Write( m_phraseTableFile, countOfCounts );
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_batches.pop_front();
+      m_batchesChanged.notify_all();
+    }
+  }
+}
+#endif
+
+
 void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource, std::ostream &phraseTableFile,
-                         const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+                         const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb,
+                         CountOfCounts &countOfCounts )
 {
   if (phrasePairsWithSameSource.size() == 0) {
     return;
@@ -698,7 +1075,7 @@ void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSa
   for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
         iter!=phrasePairsWithSameSource.end(); ++iter) {
     // add to total count
-    outputPhrasePair( **iter, totalSource, phrasePairsWithSameSource.size(), phraseTableFile, featureManager, maybeLogProb );
+    outputPhrasePair( **iter, totalSource, phrasePairsWithSameSource.size(), phraseTableFile, featureManager, maybeLogProb, countOfCounts );
   }
 }
 
@@ -706,7 +1083,8 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
                       float totalCount, int distinctCount,
                       std::ostream &phraseTableFile,
                       const ScoreFeatureManager& featureManager,
-                      const MaybeLog& maybeLogProb )
+                      const MaybeLog& maybeLogProb,
+                      CountOfCounts &countOfCounts )
 {
   assert(phrasePair.IsValid());
 
@@ -717,11 +1095,7 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
-    totalDistinct++;
-    int countInt = count + 0.99999;
-    if ((countInt <= COC_MAX) &&
-        (countInt > 0))
-      countOfCounts[ countInt ]++;
+    countOfCounts.Add( count );
   }
 
   // output phrases
@@ -866,7 +1240,12 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // parts-of-speech
   if (partsOfSpeechFlag && !inverseFlag) {
-    phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(labelMutex);
+#endif
+      phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    }
     const std::string *bestPartOfSpeech = phrasePair.FindBestPropertyValue("POS");
     if (bestPartOfSpeech) {
       phraseTableFile << " {{POS " << *bestPartOfSpeech << "}}";
@@ -883,6 +1262,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // source syntax labels
     if (sourceSyntaxLabelsFlag) {
       std::string sourceLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(labelMutex);
+#endif
       sourceLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("SourceLabels",
                           sourceLabelSet,
                           sourceLHSCounts,
@@ -900,6 +1282,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // target preference labels
     if (targetPreferenceLabelsFlag) {
       std::string targetPreferenceLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(labelMutex);
+#endif
       targetPreferenceLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("TargetPreferences",
                                     targetPreferenceLabelSet,
                                     targetPreferenceLHSCounts,
@@ -1152,13 +1537,12 @@ double computeLexicalTranslation( const PHRASE *phraseSource, const PHRASE *phra
 {
   // lexical translation probability
   double lexScore = 1.0;
-  int null = vcbS.getWordID("NULL");
   // all target words have to be explained
   for(size_t ti=0; ti<alignmentTargetToSource->size(); ti++) {
     const std::set< size_t > & srcIndices = alignmentTargetToSource->at(ti);
     if (srcIndices.empty()) {
       // explain unaligned word by NULL
-      lexScore *= lexTable.permissiveLookup( null, phraseTarget->at(ti) );
+      lexScore *= lexTable.permissiveLookup( nullWordId, phraseTarget->at(ti) );
     } else {
       // go through all the aligned words to compute average
       double thisWordScore = 0;
@@ -0,0 +1,406 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2015 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+// Sorts binary extract files (see ExtractFile.h) for score, which is what
+// LC_ALL=C sort does for text ones. The phrase pairs come out in the order of
+// their source and target phrases that sort gives the text lines, so that the
+// phrase table is in the same order as with text extract files. Identical
+// phrase pairs end up next to each other.
+//
+// Phrase pairs are sorted in memory, in runs that are written to temporary
+// files and merged if they don't fit. A run takes up to half of --Memory, its
+// sort keys the rest.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "ExtractFile.h"
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+
+using namespace MosesTraining;
+
+namespace
+{
+
+// vocabulary of all input files; word 0 is "|||", which comes after the last
+// word of a phrase
+std::vector<std::string> words;
+boost::unordered_map<std::string, uint32_t> wordIds;
+std::vector<uint32_t> ranks; // position of each word in WordOrder
+
+uint32_t globalId(const std::string &word)
+{
+  std::pair<boost::unordered_map<std::string, uint32_t>::iterator, bool> inserted
+    = wordIds.insert(std::make_pair(word, (uint32_t)words.size()));
+  if (inserted.second) {
+    words.push_back(word);
+  }
+  return inserted.first->second;
+}
+
+// words by WordOrder, given their ids
+struct IdOrder {
+  bool operator()(uint32_t a, uint32_t b) const {
+    return WordOrder()(words[a], words[b]);
+  }
+};
+
+void rankWords()
+{
+  std::vector<uint32_t> order(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), IdOrder());
+  ranks.resize(words.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    ranks[order[i]] = i;
+  }
+}
+
+// maps the word ids of one file to the ones in words
+class GlobalIds
+{
+public:
+  explicit GlobalIds(const ExtractFileReader &reader)
+    : m_reader(reader) {
+  }
+
+  void Map(ExtractRecord &record) {
+    // words are defined before their first use
+    const std::vector<std::string> &fileWords = m_reader.Words();
+    while (m_ids.size() < fileWords.size()) {
+      m_ids.push_back(globalId(fileWords[m_ids.size()]));
+    }
+    for (size_t i = 0; i < record.source.size(); ++i) {
+      record.source[i] = m_ids[record.source[i]];
+    }
+    for (size_t i = 0; i < record.target.size(); ++i) {
+      record.target[i] = m_ids[record.target[i]];
+    }
+  }
+
+private:
+  const ExtractFileReader &m_reader;
+  std::vector<uint32_t> m_ids;
+};
+
+void appendPhrase(std::string &key, const std::vector<uint32_t> &ids)
+{
+  for (size_t i = 0; i <= ids.size(); ++i) {
+    uint32_t rank = ranks[i < ids.size() ? ids[i] : 0];
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      key.push_back((char)(rank >> shift));
+    }
+  }
+}
+
+void appendNumber(std::string &key, int number, char after)
+{
+  char buffer[16];
+  char *end = buffer + sizeof(buffer), *start = end;
+  unsigned int n = number < 0 ? -(unsigned int)number : number;
+  do {
+    *--start = '0' + n % 10;
+    n /= 10;
+  } while (n);
+  if (number < 0) {
+    *--start = '-';
+  }
+  key.append(start, end);
+  key.push_back(after);
+}
+
+// as operator<< prints it
+void appendFloat(std::string &key, float number)
+{
+  if (number == (int)number && number < 1e6 && number > -1e6) {
+    appendNumber(key, (int)number, ' ');
+  } else {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%g ", number);
+    key += buffer;
+  }
+}
+
+// The key by which memcmp() sorts a phrase pair: the ranks of its words (big
+// endian, each phrase followed by "|||"), the rest of its text line, so that
+// phrase pairs with the same phrases are in the order of their lines as well
+// and score adds up their counts in the same order, and the payload, which
+// brings identical phrase pairs together.
+void sortKey(const ExtractRecord &record, const std::string &payload, std::string &key)
+{
+  key.clear();
+  appendPhrase(key, record.source);
+  appendPhrase(key, record.target);
+  for (size_t i = 0; i < record.alignment.size(); ++i) {
+    appendNumber(key, record.alignment[i].first, '-');
+    appendNumber(key, record.alignment[i].second, ' ');
+  }
+  key += "||| ";
+  if (record.hasSentenceId) {
+    appendNumber(key, record.sentenceId, ' ');
+    key += "||| ";
+  }
+  appendFloat(key, record.count);
+  if (record.hasPcfgScore) {
+    key += "||| ";
+    appendFloat(key, record.pcfgScore);
+  }
+  key += record.properties;
+  key.push_back('\0'); // end of the line
+  key += payload;
+}
+
+bool keyLess(const char *a, size_t sizeA, const char *b, size_t sizeB)
+{
+  int c = memcmp(a, b, std::min(sizeA, sizeB));
+  return c ? c < 0 : sizeA < sizeB;
+}
+
+// a phrase pair in memory
+struct Entry {
+  size_t offset;
+  uint32_t size;
+  uint32_t payloadSize; // at the end of the key, once there is one
+  uint64_t prefix;      // first bytes of the key, most comparisons need no more
+  Entry(size_t o, uint32_t s) : offset(o), size(s), payloadSize(s), prefix(0) {}
+};
+
+class EntryOrder
+{
+public:
+  explicit EntryOrder(const std::string &keys) : m_keys(keys.data()) {}
+  bool operator()(const Entry &a, const Entry &b) const {
+    if (a.prefix != b.prefix) {
+      return a.prefix < b.prefix;
+    }
+    return keyLess(m_keys + a.offset, a.size, m_keys + b.offset, b.size);
+  }
+private:
+  const char *m_keys;
+};
+
+// Sorts the payloads in data and writes them out. Their keys take about as
+// much memory again.
+void writeSorted(std::string &data, std::vector<Entry> &entries, std::ostream &out)
+{
+  rankWords();
+  std::string keys, key, payload;
+  ExtractRecord record;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    payload.assign(data, entries[i].offset, entries[i].size);
+    record.Decode(payload.data(), payload.size());
+    sortKey(record, payload, key);
+    entries[i].offset = keys.size();
+    entries[i].size = key.size();
+    entries[i].prefix = 0;
+    for (size_t j = 0; j < 8; ++j) { // keys are longer than that
+      entries[i].prefix = (entries[i].prefix << 8) | (unsigned char)key[j];
+    }
+    keys += key;
+  }
+  std::string().swap(data);
+  std::sort(entries.begin(), entries.end(), EntryOrder(keys));
+
+  ExtractFileWriter writer(out);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const Entry &entry = entries[i];
+    record.Decode(keys.data() + entry.offset + entry.size - entry.payloadSize, entry.payloadSize);
+    writer.Write(record, words);
+  }
+}
+
+// sorts and writes the phrase pairs in memory to a temporary file
+int writeRun(std::string &data, std::vector<Entry> &entries, const std::string &tempPrefix)
+{
+  util::scoped_fd file(util::MakeTemp(tempPrefix));
+  {
+    boost::iostreams::stream<boost::iostreams::file_descriptor_sink> out(file.get(), boost::iostreams::never_close_handle);
+    writeSorted(data, entries, out);
+  }
+  data.clear();
+  entries.clear();
+  return file.release();
+}
+
+int rewound(int fd)
+{
+  util::SeekOrThrow(fd, 0);
+  return fd;
+}
+
+// reads a run back, with global word ids
+class Run
+{
+public:
+  explicit Run(int fd)
+    : m_file(rewound(fd))
+    , m_in(fd, boost::iostreams::never_close_handle)
+    , m_reader(m_in)
+    , m_ids(m_reader) {
+  }
+
+  bool Next() {
+    if (!m_reader.Read()) {
+      return false;
+    }
+    m_record = m_reader.Record();
+    m_ids.Map(m_record);
+    m_record.Encode(m_payload);
+    sortKey(m_record, m_payload, m_key);
+    return true;
+  }
+
+  const ExtractRecord &Record() const {
+    return m_record;
+  }
+  const std::string &Key() const {
+    return m_key;
+  }
+
+private:
+  util::scoped_fd m_file;
+  boost::iostreams::stream<boost::iostreams::file_descriptor_source> m_in;
+  ExtractFileReader m_reader;
+  GlobalIds m_ids;
+  ExtractRecord m_record;
+  std::string m_payload;
+  std::string m_key;
+};
+
+// smallest key on top of the queue
+struct RunOrder {
+  bool operator()(const Run *a, const Run *b) const {
+    return keyLess(b->Key().data(), b->Key().size(), a->Key().data(), a->Key().size());
+  }
+};
+
+void merge(const std::vector<int> &runFiles, std::ostream &out)
+{
+  rankWords();
+  std::vector<Run*> runs;
+  std::priority_queue<Run*, std::vector<Run*>, RunOrder> queue;
+  for (size_t i = 0; i < runFiles.size(); ++i) {
+    runs.push_back(new Run(runFiles[i]));
+    if (runs.back()->Next()) {
+      queue.push(runs.back());
+    }
+  }
+  ExtractFileWriter writer(out);
+  while (!queue.empty()) {
+    Run *run = queue.top();
+    queue.pop();
+    writer.Write(run->Record(), words);
+    if (run->Next()) {
+      queue.push(run);
+    }
+  }
+  for (size_t i = 0; i < runs.size(); ++i) {
+    delete runs[i];
+  }
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+  std::cerr << "sort-extract: sorting binary extract files for score" << std::endl;
+
+  std::vector<std::string> fileNames;
+  size_t memory = 1ULL << 30;
+  std::string tempPrefix = "/tmp/";
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i],"--Memory") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the memory for sorting in MB!");
+      memory = (size_t)atoi(argv[++i]) << 20;
+    } else if (strcmp(argv[i],"--TempDir") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify the directory for temporary files!");
+      tempPrefix = argv[++i];
+      util::NormalizeTempPrefix(tempPrefix);
+    } else {
+      fileNames.push_back(argv[i]);
+    }
+  }
+  if (fileNames.size() < 2) {
+    std::cerr <<
+              "syntax: sort-extract sorted-extract extract [extract ...] "
+              "[--Memory MB] [--TempDir dir]"
+              << std::endl;
+    exit(1);
+  }
+  memory = std::max<size_t>(memory, 1 << 20);
+
+  globalId("|||");
+  std::string data;
+  std::vector<Entry> entries;
+  std::vector<int> runFiles;
+  std::string payload;
+  size_t count = 0;
+  for (size_t f = 1; f < fileNames.size(); ++f) {
+    UTIL_THROW_IF2(!ExtractFileReader::IsExtractFile(fileNames[f]),
+                   fileNames[f] << " is not a binary extract file");
+    Moses::InputFileStream in(fileNames[f]);
+    ExtractFileReader reader(in);
+    GlobalIds ids(reader);
+    ExtractRecord record;
+    while (reader.Read()) {
+      if (++count % 100000 == 0) {
+        std::cerr << "." << std::flush;
+      }
+      record = reader.Record();
+      ids.Map(record);
+      record.Encode(payload);
+      entries.push_back(Entry(data.size(), payload.size()));
+      data += payload;
+      if (data.size() + entries.size() * sizeof(Entry) >= memory / 2) {
+        runFiles.push_back(writeRun(data, entries, tempPrefix));
+      }
+    }
+    in.Close();
+  }
+  std::cerr << std::endl;
+
+  Moses::OutputFileStream out;
+  UTIL_THROW_IF2(!out.Open(fileNames[0]), "could not open " << fileNames[0]);
+  if (runFiles.empty()) {
+    writeSorted(data, entries, out);
+  } else {
+    if (!entries.empty()) {
+      runFiles.push_back(writeRun(data, entries, tempPrefix));
+    }
+    std::cerr << "merging " << runFiles.size() << " runs" << std::endl;
+    merge(runFiles, out);
+  }
+  out.Close();
+}
@@ -208,6 +208,15 @@ template <class EntryT, class HashT, class EqualT = std::equal_to<typename Entry
       return FindFromIdeal(key, out);
     }
 
+    // Hint that key is about to be looked up by bringing its ideal bucket
+    // into cache.  Issue these for a batch of keys before calling Find on
+    // them, so that the cache misses overlap.
+    template <class Key> void Prefetch(const Key key) const {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(&*Ideal(key), 0, 0);
+#endif
+    }
+
     // Like Find but we're sure it must be there.
     template <class Key> ConstIterator MustFind(const Key key) const {
       for (ConstIterator i(Ideal(key));; mod_.Next(begin_, end_, i)) {